@@ -6,6 +6,8 @@
  */
 
 #include "audio_player.h"
+#include "simd.h"
+#include "luts.h"
 #include <stdlib.h>
 #include <string.h>
 #include "esp_log.h"
@@ -24,27 +26,22 @@ struct audio_player_s {
     audio_state_t state;
     uint8_t volume;  // 0-100
     bool initialized;
+
+    // Time stretch (allocated when a rate other than 1x is first set)
+    time_stretch_t *stretch;
+    int16_t *stretch_buf;
+    size_t stretch_buf_len;     // Samples
 };
 
 /**
  * Apply volume scaling to audio samples
+ * Gains below 1.0 can't overflow, so no clamping is needed
  */
 static void apply_volume(int16_t *samples, size_t count, uint8_t volume)
 {
     if (volume >= 100) return;  // No scaling needed
 
-    uint32_t scale = (volume * 65536) / 100;  // Fixed-point scaling
-
-    for (size_t i = 0; i < count; i++) {
-        int32_t sample = samples[i];
-        sample = (sample * scale) >> 16;
-
-        // Clamp to 16-bit range
-        if (sample > 32767) sample = 32767;
-        if (sample < -32768) sample = -32768;
-
-        samples[i] = (int16_t)sample;
-    }
+    simd_scale_s16(samples, count, lut_volume_q15[volume]);
 }
 
 /**
@@ -142,6 +139,8 @@ void audio_player_deinit(audio_player_t *player)
         }
     }
 
+    time_stretch_destroy(player->stretch);
+    free(player->stretch_buf);
     free(player);
 
     ESP_LOGI(TAG, "Audio player deinitialized");
@@ -264,6 +263,35 @@ esp_err_t audio_player_write(audio_player_t *player, const uint8_t *data,
         return ESP_ERR_INVALID_STATE;
     }
 
+    // Faster playback: stretch in blocks, the scratch buffer also takes the volume
+    if (player->stretch && time_stretch_get_rate(player->stretch) != TIME_STRETCH_RATE_1X &&
+        player->config.bits_per_sample == 16 && player->config.channels == 1) {
+        const int16_t *in = (const int16_t *)data;
+        size_t remaining = size / 2;
+        esp_err_t ret = ESP_OK;
+
+        while (remaining > 0 && ret == ESP_OK) {
+            size_t n = (remaining < AUDIO_BUFFER_SIZE) ? remaining : AUDIO_BUFFER_SIZE;
+            size_t out_n = 0;
+
+            ret = time_stretch_process(player->stretch, in, n, player->stretch_buf,
+                                       player->stretch_buf_len, &out_n);
+            if (ret == ESP_OK && out_n > 0) {
+                size_t written;
+                apply_volume(player->stretch_buf, out_n, player->volume);
+                ret = i2s_channel_write(player->tx_handle, player->stretch_buf,
+                                        out_n * 2, &written, portMAX_DELAY);
+            }
+
+            in += n;
+            remaining -= n;
+        }
+
+        // Report input consumed, not samples emitted
+        if (bytes_written) *bytes_written = size - remaining * 2;
+        return ret;
+    }
+
     // Apply volume scaling if needed
     if (player->volume < 100 && player->config.bits_per_sample == 16) {
         // Create temporary buffer for volume scaling
@@ -284,6 +312,92 @@ esp_err_t audio_player_write(audio_player_t *player, const uint8_t *data,
     return i2s_channel_write(player->tx_handle, data, size, bytes_written, portMAX_DELAY);
 }
 
+/**
+ * Set sample rate
+ */
+esp_err_t audio_player_set_sample_rate(audio_player_t *player, uint32_t sample_rate)
+{
+    if (player == NULL || !player->initialized || sample_rate == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (sample_rate == player->config.sample_rate) {
+        return ESP_OK;
+    }
+
+    if (player->state != AUDIO_STATE_STOPPED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sample_rate);
+    esp_err_t ret = i2s_channel_reconfig_std_clock(player->tx_handle, &clk_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set sample rate: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    player->config.sample_rate = sample_rate;
+
+    // Stretch windows are sized for the old rate; recreated on next use
+    time_stretch_destroy(player->stretch);
+    player->stretch = NULL;
+    free(player->stretch_buf);
+    player->stretch_buf = NULL;
+
+    ESP_LOGI(TAG, "Sample rate %lu Hz", sample_rate);
+
+    return ESP_OK;
+}
+
+/**
+ * Set playback rate
+ */
+esp_err_t audio_player_set_rate(audio_player_t *player, uint16_t rate_q8)
+{
+    if (player == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (rate_q8 < TIME_STRETCH_RATE_MIN || rate_q8 > TIME_STRETCH_RATE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (player->stretch == NULL) {
+        if (rate_q8 == TIME_STRETCH_RATE_1X) {
+            return ESP_OK;
+        }
+
+        player->stretch = time_stretch_create(player->config.sample_rate);
+        if (player->stretch == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        player->stretch_buf_len = time_stretch_max_output(player->stretch, AUDIO_BUFFER_SIZE);
+        player->stretch_buf = malloc(player->stretch_buf_len * sizeof(int16_t));
+        if (player->stretch_buf == NULL) {
+            time_stretch_destroy(player->stretch);
+            player->stretch = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    esp_err_t ret = time_stretch_set_rate(player->stretch, rate_q8);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Playback rate %d.%02dx", rate_q8 >> 8, ((rate_q8 & 0xFF) * 100) >> 8);
+    }
+
+    return ret;
+}
+
+/**
+ * Get playback rate
+ */
+uint16_t audio_player_get_rate(const audio_player_t *player)
+{
+    return (player && player->stretch) ? time_stretch_get_rate(player->stretch)
+                                       : TIME_STRETCH_RATE_1X;
+}
+
 /**
  * Set volume
  */
@@ -330,6 +444,8 @@ esp_err_t audio_player_clear_buffer(audio_player_t *player)
         i2s_channel_enable(player->tx_handle);
     }
 
+    time_stretch_reset(player->stretch);
+
     return ESP_OK;
 }
 
@@ -12,6 +12,7 @@
 #include <stdbool.h>
 #include "esp_err.h"
 #include "driver/i2s_std.h"
+#include "time_stretch.h"
 
 // Audio pin definitions (I2S)
 #define PIN_AUDIO_BCLK      26  // Bit clock
@@ -119,6 +120,35 @@ esp_err_t audio_player_resume(audio_player_t *player);
 esp_err_t audio_player_write(audio_player_t *player, const uint8_t *data,
                               size_t size, size_t *bytes_written);
 
+/**
+ * Set I2S sample rate
+ * Only while stopped; the time stretcher is reset for the new rate
+ *
+ * @param player Audio player handle
+ * @param sample_rate Sample rate in Hz
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if playing or paused
+ */
+esp_err_t audio_player_set_sample_rate(audio_player_t *player, uint32_t sample_rate);
+
+/**
+ * Set playback rate with pitch-preserving time stretch
+ * Applies to 16-bit mono PCM passed to audio_player_write(); the
+ * stretcher is allocated on first use
+ *
+ * @param player Audio player handle
+ * @param rate_q8 Rate in Q8, TIME_STRETCH_RATE_1X (256) to TIME_STRETCH_RATE_MAX (512)
+ * @return ESP_OK on success
+ */
+esp_err_t audio_player_set_rate(audio_player_t *player, uint16_t rate_q8);
+
+/**
+ * Get playback rate
+ *
+ * @param player Audio player handle
+ * @return Rate in Q8
+ */
+uint16_t audio_player_get_rate(const audio_player_t *player);
+
 /**
  * Set volume (0-100)
  *
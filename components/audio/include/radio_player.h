@@ -0,0 +1,172 @@
+/**
+ * Radio Player
+ * Audio-only playback for radio shows and music channels
+ *
+ * Streams PCM from a WAV file, or the audio stream of an AVI without video,
+ * into the audio player from its own task. 8/16-bit mono or stereo input is
+ * converted to 16-bit mono, and the I2S clock follows the file's sample rate.
+ * The task spends most of its time blocked on I2S DMA buffers, so together
+ * with the panel asleep and the audio power profile the CPU idles between
+ * refills instead of decoding frames.
+ */
+
+#ifndef RADIO_PLAYER_H
+#define RADIO_PLAYER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "audio_player.h"
+
+#define RADIO_BLOCK_SAMPLES     2048    // Samples per refill (~93 ms at 22.05 kHz)
+
+/**
+ * Radio player state
+ */
+typedef enum {
+    RADIO_STATE_STOPPED,
+    RADIO_STATE_PLAYING,
+    RADIO_STATE_PAUSED,
+    RADIO_STATE_ERROR,
+} radio_state_t;
+
+/**
+ * Radio file information
+ */
+typedef struct {
+    uint32_t sample_rate;
+    uint8_t channels;
+    uint8_t bits_per_sample;
+    uint32_t duration_sec;      // 0 if unknown (AVI)
+} radio_info_t;
+
+/**
+ * Playback statistics since open
+ */
+typedef struct {
+    uint64_t busy_us;           // Reading and converting, excludes waiting on I2S
+    uint64_t audio_us;          // Audio handed to I2S
+} radio_stats_t;
+
+/**
+ * Radio event callbacks
+ * Called from the playback task, which has already stopped, so they may
+ * open and play the next file
+ */
+typedef struct {
+    void (*on_playback_complete)(void *user_data);  // After the task has let go of the file
+    void (*on_error)(void *user_data, esp_err_t error);
+} radio_callbacks_t;
+
+/**
+ * Radio player handle
+ */
+typedef struct radio_player_s radio_player_t;
+
+/**
+ * Create radio player
+ *
+ * @param audio Audio player to stream into (16-bit mono)
+ * @param callbacks Event callbacks (optional, can be NULL)
+ * @param user_data User data passed to callbacks
+ * @return Radio player handle, or NULL on failure
+ */
+radio_player_t *radio_player_create(audio_player_t *audio, const radio_callbacks_t *callbacks,
+                                    void *user_data);
+
+/**
+ * Destroy radio player
+ *
+ * @param player Radio player handle
+ */
+void radio_player_destroy(radio_player_t *player);
+
+/**
+ * Open an audio file
+ * ".wav" files are read as RIFF WAVE, anything else as AVI
+ *
+ * @param player Radio player handle
+ * @param file_path Path to file
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the audio is not
+ *         8/16-bit PCM with 1 or 2 channels
+ */
+esp_err_t radio_player_open(radio_player_t *player, const char *file_path);
+
+/**
+ * Stop playback and close the file
+ *
+ * @param player Radio player handle
+ */
+void radio_player_close(radio_player_t *player);
+
+/**
+ * Start or resume playback
+ * Starts the audio player at the file's sample rate
+ *
+ * @param player Radio player handle
+ * @return ESP_OK on success
+ */
+esp_err_t radio_player_play(radio_player_t *player);
+
+/**
+ * Pause playback
+ * I2S is disabled while paused, which lets the chip enter light sleep
+ *
+ * @param player Radio player handle
+ * @return ESP_OK on success
+ */
+esp_err_t radio_player_pause(radio_player_t *player);
+
+/**
+ * Stop playback
+ * Returns once the playback task has exited
+ *
+ * @param player Radio player handle
+ * @return ESP_OK on success
+ */
+esp_err_t radio_player_stop(radio_player_t *player);
+
+/**
+ * Seek to a position
+ *
+ * @param player Radio player handle
+ * @param position_sec Position in seconds
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED for AVI files
+ */
+esp_err_t radio_player_seek(radio_player_t *player, uint32_t position_sec);
+
+/**
+ * Get playback position
+ *
+ * @param player Radio player handle
+ * @return Position in seconds
+ */
+uint32_t radio_player_get_position(const radio_player_t *player);
+
+/**
+ * Get file information
+ *
+ * @param player Radio player handle
+ * @param info Output information
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no file is open
+ */
+esp_err_t radio_player_get_info(const radio_player_t *player, radio_info_t *info);
+
+/**
+ * Get playback statistics
+ * busy_us / audio_us is the CPU duty of the audio-only pipeline
+ *
+ * @param player Radio player handle
+ * @param stats Output statistics
+ */
+void radio_player_get_stats(const radio_player_t *player, radio_stats_t *stats);
+
+/**
+ * Get current playback state
+ *
+ * @param player Radio player handle
+ * @return Current state
+ */
+radio_state_t radio_player_get_state(const radio_player_t *player);
+
+#endif // RADIO_PLAYER_H
@@ -0,0 +1,97 @@
+/**
+ * Audio Time Stretch (WSOLA)
+ * Pitch-preserving tempo change for 1.25x-2x playback
+ *
+ * Waveform-similarity overlap-add on mono 16-bit PCM, fixed-point only.
+ * Each output sequence is taken from the input position (within a bounded
+ * search window around the nominal one) whose start best matches the tail
+ * of the previous sequence, then cross-faded in.
+ */
+
+#ifndef TIME_STRETCH_H
+#define TIME_STRETCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// Playback rate in Q8 (256 = 1.0x)
+#define TIME_STRETCH_RATE_1X        256
+#define TIME_STRETCH_RATE_MIN       256
+#define TIME_STRETCH_RATE_MAX       512
+
+// Tuned for speech: sequence, search window and overlap in milliseconds
+#define TIME_STRETCH_SEQUENCE_MS    40
+#define TIME_STRETCH_SEEK_MS        15
+#define TIME_STRETCH_OVERLAP_MS     8
+
+/**
+ * Time stretch handle
+ */
+typedef struct time_stretch_s time_stretch_t;
+
+/**
+ * Create time stretcher
+ *
+ * @param sample_rate Sample rate in Hz (mono)
+ * @return Handle, or NULL on failure
+ */
+time_stretch_t *time_stretch_create(uint32_t sample_rate);
+
+/**
+ * Destroy time stretcher
+ *
+ * @param ts Handle
+ */
+void time_stretch_destroy(time_stretch_t *ts);
+
+/**
+ * Set playback rate
+ * Buffered audio is discarded so the new rate starts cleanly
+ *
+ * @param ts Handle
+ * @param rate_q8 Rate in Q8, TIME_STRETCH_RATE_MIN..TIME_STRETCH_RATE_MAX
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if out of range
+ */
+esp_err_t time_stretch_set_rate(time_stretch_t *ts, uint16_t rate_q8);
+
+/**
+ * Get playback rate
+ *
+ * @param ts Handle
+ * @return Rate in Q8
+ */
+uint16_t time_stretch_get_rate(const time_stretch_t *ts);
+
+/**
+ * Discard buffered audio (after a seek)
+ *
+ * @param ts Handle
+ */
+void time_stretch_reset(time_stretch_t *ts);
+
+/**
+ * Output buffer size needed for an input block
+ *
+ * @param ts Handle
+ * @param in_samples Input samples per call
+ * @return Minimum output capacity in samples
+ */
+size_t time_stretch_max_output(const time_stretch_t *ts, size_t in_samples);
+
+/**
+ * Time-stretch a block of samples
+ * At 1.0x input is copied through unchanged
+ *
+ * @param ts Handle
+ * @param input Input samples
+ * @param in_samples Number of input samples
+ * @param output Output samples
+ * @param out_max Output capacity (at least time_stretch_max_output())
+ * @param out_samples Number of samples written
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if output is too small
+ */
+esp_err_t time_stretch_process(time_stretch_t *ts, const int16_t *input, size_t in_samples,
+                               int16_t *output, size_t out_max, size_t *out_samples);
+
+#endif // TIME_STRETCH_H
@@ -0,0 +1,524 @@
+/**
+ * Radio Player Implementation
+ * Audio-only streaming from WAV or AVI into the audio player
+ */
+
+#include "radio_player.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "avi_parser.h"
+
+static const char *TAG = "RADIO_PLAYER";
+
+#define RADIO_TASK_STACK_SIZE   4096
+#define RADIO_TASK_PRIORITY     9
+#define RADIO_TASK_CORE         0
+
+#define RADIO_READ_BYTES        (RADIO_BLOCK_SAMPLES * 4)   // Stereo 16-bit worst case
+#define WAV_FORMAT_PCM          1
+
+/**
+ * Radio player structure
+ */
+struct radio_player_s {
+    audio_player_t *audio;
+    radio_callbacks_t callbacks;
+    void *user_data;
+
+    // Source: a WAV data chunk, or the audio stream of an AVI
+    bool is_avi;
+    FILE *file;
+    avi_parser_t avi;
+    uint32_t data_offset;       // WAV data chunk
+    uint32_t data_size;
+    uint32_t data_pos;
+
+    radio_info_t info;
+    uint16_t block_align;       // Bytes per sample frame
+    bool opened;
+
+    uint8_t *read_buf;
+    int16_t *pcm;
+    uint32_t pending;           // Converted samples not yet accepted by I2S
+
+    volatile radio_state_t state;
+    TaskHandle_t playback_task;
+
+    uint64_t frames_played;
+    radio_stats_t stats;
+};
+
+/**
+ * Read a little-endian field
+ */
+static uint32_t read_le(FILE *f, int bytes)
+{
+    uint8_t b[4] = {0};
+    if (fread(b, 1, bytes, f) != (size_t)bytes) return 0;
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+/**
+ * Parse RIFF WAVE header up to the data chunk
+ */
+static esp_err_t parse_wav(radio_player_t *player)
+{
+    FILE *f = player->file;
+    uint16_t format = 0;
+
+    if (read_le(f, 4) != FOURCC_RIFF) return ESP_ERR_INVALID_RESPONSE;
+    read_le(f, 4);  // RIFF size
+    if (read_le(f, 4) != 0x45564157) return ESP_ERR_INVALID_RESPONSE;  // "WAVE"
+
+    while (!feof(f)) {
+        uint32_t id = read_le(f, 4);
+        uint32_t size = read_le(f, 4);
+        if (feof(f)) break;
+
+        if (id == 0x20746D66) {  // "fmt "
+            if (size < 16) return ESP_ERR_INVALID_RESPONSE;
+            format = read_le(f, 2);
+            player->info.channels = read_le(f, 2);
+            player->info.sample_rate = read_le(f, 4);
+            read_le(f, 4);  // byte rate
+            player->block_align = read_le(f, 2);
+            player->info.bits_per_sample = read_le(f, 2);
+            fseek(f, size - 16 + (size & 1), SEEK_CUR);
+        } else if (id == 0x61746164) {  // "data"
+            if (format == 0) return ESP_ERR_INVALID_RESPONSE;  // fmt must come first
+            if (format != WAV_FORMAT_PCM) return ESP_ERR_NOT_SUPPORTED;
+
+            player->data_offset = ftell(f);
+            player->data_size = size;
+            player->data_pos = 0;
+            return ESP_OK;
+        } else {
+            fseek(f, size + (size & 1), SEEK_CUR);
+        }
+    }
+
+    return ESP_ERR_INVALID_RESPONSE;
+}
+
+/**
+ * Convert 8/16-bit mono/stereo PCM to 16-bit mono
+ */
+static void to_mono16(const uint8_t *src, uint32_t frames, uint8_t channels, uint8_t bits,
+                      int16_t *dst)
+{
+    if (bits == 16) {
+        if (channels == 1) {
+            memcpy(dst, src, frames * sizeof(int16_t));
+            return;
+        }
+        for (uint32_t i = 0; i < frames; i++, src += 4) {
+            int16_t l = (int16_t)(src[0] | (src[1] << 8));
+            int16_t r = (int16_t)(src[2] | (src[3] << 8));
+            dst[i] = (int16_t)((l + r) >> 1);
+        }
+    } else {
+        // 8-bit WAV is unsigned
+        for (uint32_t i = 0; i < frames; i++, src += channels) {
+            int32_t s = (channels == 1) ? src[0] : (src[0] + src[1]) >> 1;
+            dst[i] = (int16_t)((s - 128) * 256);
+        }
+    }
+}
+
+/**
+ * Read and convert the next block
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND at end of file
+ */
+static esp_err_t read_block(radio_player_t *player, uint32_t *frames)
+{
+    uint32_t max_bytes = RADIO_BLOCK_SAMPLES * player->block_align;
+    uint32_t bytes = 0;
+
+    if (player->is_avi) {
+        // Longer chunks are truncated by the parser
+        esp_err_t ret = avi_parser_read_audio_chunk(&player->avi, player->read_buf, max_bytes, &bytes);
+        if (ret != ESP_OK) return ESP_ERR_NOT_FOUND;
+    } else {
+        uint32_t left = player->data_size - player->data_pos;
+        if (left < player->block_align) return ESP_ERR_NOT_FOUND;
+
+        bytes = fread(player->read_buf, 1, (left < max_bytes) ? left : max_bytes, player->file);
+        if (bytes == 0) return ESP_ERR_NOT_FOUND;
+        player->data_pos += bytes;
+    }
+
+    *frames = bytes / player->block_align;
+    to_mono16(player->read_buf, *frames, player->info.channels, player->info.bits_per_sample,
+              player->pcm);
+
+    return ESP_OK;
+}
+
+/**
+ * Wait for the playback task to exit
+ * The task clears playback_task itself once it is out of read_block and
+ * the I2S write; a slow card read has no upper bound
+ */
+static void wait_playback_exit(radio_player_t *player)
+{
+    while (player->playback_task != NULL && player->playback_task != xTaskGetCurrentTaskHandle()) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+/**
+ * Playback task
+ */
+static void radio_playback_task(void *pvParameters)
+{
+    radio_player_t *player = (radio_player_t *)pvParameters;
+    bool completed = false;
+    esp_err_t error = ESP_OK;
+
+    DLOGI(TAG, "Playback task started on core %d", xPortGetCoreID());
+
+    while (player->state == RADIO_STATE_PLAYING || player->state == RADIO_STATE_PAUSED) {
+        if (player->state == RADIO_STATE_PAUSED) {
+            vTaskDelay(pdMS_TO_TICKS(50));
+            continue;
+        }
+
+        uint32_t frames = player->pending;
+        esp_err_t ret = ESP_OK;
+        if (frames == 0) {
+            uint64_t t0 = esp_timer_get_time();
+            ret = read_block(player, &frames);
+            player->stats.busy_us += esp_timer_get_time() - t0;
+        }
+
+        if (ret == ESP_ERR_NOT_FOUND) {
+            DLOGI(TAG, "End of audio at %lu s", radio_player_get_position(player));
+            player->state = RADIO_STATE_STOPPED;
+            completed = true;
+            break;
+        }
+
+        // Blocks until a DMA buffer frees up; this is where the CPU idles
+        size_t written = 0;
+        ret = audio_player_write(player->audio, (const uint8_t *)player->pcm,
+                                 frames * sizeof(int16_t), &written);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            player->pending = frames;  // Paused meanwhile, resend on resume
+            continue;
+        } else if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "I2S write failed: %s", esp_err_to_name(ret));
+            player->state = RADIO_STATE_ERROR;
+            error = ret;
+            break;
+        }
+
+        player->pending = 0;
+        player->frames_played += frames;
+        player->stats.audio_us += frames * 1000000ull / player->info.sample_rate;
+    }
+
+    DLOGI(TAG, "Playback task exiting");
+    player->playback_task = NULL;
+
+    // Callbacks run last, once the file is no longer in use, so they may
+    // close it and start the next episode
+    if (completed && player->callbacks.on_playback_complete) {
+        player->callbacks.on_playback_complete(player->user_data);
+    }
+    if (error != ESP_OK && player->callbacks.on_error) {
+        player->callbacks.on_error(player->user_data, error);
+    }
+
+    vTaskDelete(NULL);
+}
+
+/**
+ * Create radio player
+ */
+radio_player_t *radio_player_create(audio_player_t *audio, const radio_callbacks_t *callbacks,
+                                    void *user_data)
+{
+    if (audio == NULL) return NULL;
+
+    radio_player_t *player = calloc(1, sizeof(radio_player_t));
+    if (player == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate radio player");
+        return NULL;
+    }
+
+    player->read_buf = malloc(RADIO_READ_BYTES);
+    player->pcm = malloc(RADIO_BLOCK_SAMPLES * sizeof(int16_t));
+    if (player->read_buf == NULL || player->pcm == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate buffers");
+        free(player->read_buf);
+        free(player->pcm);
+        free(player);
+        return NULL;
+    }
+
+    player->audio = audio;
+    player->state = RADIO_STATE_STOPPED;
+    if (callbacks) {
+        memcpy(&player->callbacks, callbacks, sizeof(radio_callbacks_t));
+    }
+    player->user_data = user_data;
+
+    return player;
+}
+
+/**
+ * Destroy radio player
+ */
+void radio_player_destroy(radio_player_t *player)
+{
+    if (player == NULL) return;
+
+    radio_player_close(player);
+    free(player->read_buf);
+    free(player->pcm);
+    free(player);
+}
+
+/**
+ * Open audio file
+ */
+esp_err_t radio_player_open(radio_player_t *player, const char *file_path)
+{
+    if (player == NULL || file_path == NULL) return ESP_ERR_INVALID_ARG;
+
+    radio_player_close(player);
+
+    const char *ext = strrchr(file_path, '.');
+    player->is_avi = (ext == NULL || strcasecmp(ext, ".wav") != 0);
+    memset(&player->info, 0, sizeof(player->info));
+
+    esp_err_t ret;
+    if (player->is_avi) {
+        ret = avi_parser_open(&player->avi, file_path);
+        if (ret != ESP_OK) return ret;
+
+        const avi_audio_info_t *a = &player->avi.audio_info;
+        if (!a->found || a->format_tag != WAV_FORMAT_PCM) {
+            ESP_LOGE(TAG, "No PCM audio stream in %s", file_path);
+            avi_parser_close(&player->avi);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        player->info.sample_rate = a->samples_per_sec;
+        player->info.channels = a->channels;
+        player->info.bits_per_sample = a->bits_per_sample;
+        player->block_align = a->block_align;
+    } else {
+        player->file = fopen(file_path, "rb");
+        if (player->file == NULL) {
+            ESP_LOGE(TAG, "Failed to open file: %s", file_path);
+            return ESP_FAIL;
+        }
+
+        ret = parse_wav(player);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Unsupported WAV file: %s", file_path);
+            fclose(player->file);
+            player->file = NULL;
+            return ret;
+        }
+    }
+
+    radio_info_t *info = &player->info;
+    if ((info->bits_per_sample != 8 && info->bits_per_sample != 16) ||
+        (info->channels != 1 && info->channels != 2) || info->sample_rate == 0 ||
+        player->block_align != info->channels * info->bits_per_sample / 8) {
+        ESP_LOGE(TAG, "Unsupported format: %lu Hz, %d-bit, %d channels",
+                 info->sample_rate, info->bits_per_sample, info->channels);
+        player->opened = true;
+        radio_player_close(player);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (!player->is_avi) {
+        info->duration_sec = player->data_size / player->block_align / info->sample_rate;
+    }
+
+    player->frames_played = 0;
+    player->pending = 0;
+    memset(&player->stats, 0, sizeof(player->stats));
+    player->opened = true;
+
+    ESP_LOGI(TAG, "Opened %s: %lu Hz, %d-bit, %s, %lu s", file_path, info->sample_rate,
+             info->bits_per_sample, info->channels == 1 ? "mono" : "stereo", info->duration_sec);
+
+    return ESP_OK;
+}
+
+/**
+ * Close file
+ */
+void radio_player_close(radio_player_t *player)
+{
+    if (player == NULL || !player->opened) return;
+
+    radio_player_stop(player);
+
+    if (player->is_avi) {
+        avi_parser_close(&player->avi);
+    } else if (player->file) {
+        fclose(player->file);
+        player->file = NULL;
+    }
+
+    // Leave I2S at the rate the video pipeline expects
+    audio_player_set_sample_rate(player->audio, AUDIO_SAMPLE_RATE);
+    player->opened = false;
+}
+
+/**
+ * Start/resume playback
+ */
+esp_err_t radio_player_play(radio_player_t *player)
+{
+    if (player == NULL || !player->opened) return ESP_ERR_INVALID_STATE;
+
+    if (player->state == RADIO_STATE_PLAYING) return ESP_OK;
+
+    if (player->state == RADIO_STATE_PAUSED && player->playback_task != NULL) {
+        ESP_LOGI(TAG, "Resuming at %lu s", radio_player_get_position(player));
+        player->state = RADIO_STATE_PLAYING;
+        return audio_player_resume(player->audio);
+    }
+
+    // A task that stopped on its own may still be on its way out
+    wait_playback_exit(player);
+
+    esp_err_t ret = audio_player_set_sample_rate(player->audio, player->info.sample_rate);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set sample rate %lu: %s", player->info.sample_rate,
+                 esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = audio_player_start(player->audio);
+    if (ret != ESP_OK) return ret;
+
+    player->state = RADIO_STATE_PLAYING;
+
+    if (xTaskCreatePinnedToCore(radio_playback_task, "radio_playback", RADIO_TASK_STACK_SIZE,
+                                player, RADIO_TASK_PRIORITY, &player->playback_task,
+                                RADIO_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create playback task");
+        player->state = RADIO_STATE_ERROR;
+        audio_player_stop(player->audio);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Pause playback
+ */
+esp_err_t radio_player_pause(radio_player_t *player)
+{
+    if (player == NULL) return ESP_ERR_INVALID_ARG;
+
+    if (player->state == RADIO_STATE_PLAYING) {
+        ESP_LOGI(TAG, "Pausing at %lu s", radio_player_get_position(player));
+        player->state = RADIO_STATE_PAUSED;
+        return audio_player_pause(player->audio);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Stop playback
+ */
+esp_err_t radio_player_stop(radio_player_t *player)
+{
+    if (player == NULL) return ESP_ERR_INVALID_ARG;
+
+    if (player->state == RADIO_STATE_PLAYING || player->state == RADIO_STATE_PAUSED) {
+        ESP_LOGI(TAG, "Stopping playback");
+        player->state = RADIO_STATE_STOPPED;
+    }
+
+    // Waits for an in-flight write, then the task sees the state. Also
+    // covers a task that stopped itself at the end of the file
+    audio_player_stop(player->audio);
+    wait_playback_exit(player);
+
+    player->state = RADIO_STATE_STOPPED;
+    return ESP_OK;
+}
+
+/**
+ * Seek
+ */
+esp_err_t radio_player_seek(radio_player_t *player, uint32_t position_sec)
+{
+    if (player == NULL || !player->opened) return ESP_ERR_INVALID_STATE;
+    if (player->is_avi) return ESP_ERR_NOT_SUPPORTED;
+    if (player->state == RADIO_STATE_PLAYING) return ESP_ERR_INVALID_STATE;
+
+    uint64_t frame = (uint64_t)position_sec * player->info.sample_rate;
+    uint64_t total = player->data_size / player->block_align;
+    if (frame > total) frame = total;
+
+    player->data_pos = frame * player->block_align;
+    if (fseek(player->file, player->data_offset + player->data_pos, SEEK_SET) != 0) {
+        return ESP_FAIL;
+    }
+    player->frames_played = frame;
+    player->pending = 0;
+
+    return ESP_OK;
+}
+
+/**
+ * Get position
+ */
+uint32_t radio_player_get_position(const radio_player_t *player)
+{
+    if (player == NULL || player->info.sample_rate == 0) return 0;
+
+    return player->frames_played / player->info.sample_rate;
+}
+
+/**
+ * Get file info
+ */
+esp_err_t radio_player_get_info(const radio_player_t *player, radio_info_t *info)
+{
+    if (player == NULL || info == NULL) return ESP_ERR_INVALID_ARG;
+    if (!player->opened) return ESP_ERR_INVALID_STATE;
+
+    *info = player->info;
+    return ESP_OK;
+}
+
+/**
+ * Get statistics
+ */
+void radio_player_get_stats(const radio_player_t *player, radio_stats_t *stats)
+{
+    if (stats == NULL) return;
+
+    if (player == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = player->stats;
+}
+
+/**
+ * Get state
+ */
+radio_state_t radio_player_get_state(const radio_player_t *player)
+{
+    return player ? player->state : RADIO_STATE_STOPPED;
+}
@@ -0,0 +1,328 @@
+/**
+ * Audio Time Stretch Implementation (WSOLA)
+ *
+ * Per iteration: find the offset in [0, seek) whose first `overlap` samples
+ * best match the saved tail of the previous sequence, cross-fade into it,
+ * copy the rest of the sequence and advance the input by rate * (seq - overlap).
+ *
+ * The similarity search is the hot loop. It runs on samples pre-shifted so a
+ * full-overlap dot product fits in 32 bits, uses a 4-lane unrolled kernel
+ * (independent accumulators map onto the MAC pipeline), and searches coarse
+ * then fine, which evaluates ~1/3 of the candidate offsets.
+ */
+
+#include "time_stretch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "esp_log.h"
+
+static const char *TAG = "TIME_STRETCH";
+
+#define COARSE_STEP     4   // Coarse search stride, refined +/- (COARSE_STEP - 1)
+
+/**
+ * Time stretch structure
+ */
+struct time_stretch_s {
+    uint16_t rate_q8;
+    uint16_t seq_len;           // Samples per output sequence (incl. overlap)
+    uint16_t seek_len;          // Candidate offsets searched
+    uint16_t overlap_len;       // Cross-fade length, multiple of 4
+    uint8_t corr_shift;         // Pre-shift keeping correlation sums in 32 bits
+    uint32_t need_max;          // Input required for one iteration
+
+    // Input FIFO
+    int16_t *in_buf;
+    uint32_t in_len;
+    uint32_t in_cap;
+    uint32_t skip_fract;        // Fractional input position, Q8
+
+    // Previous sequence tail
+    int16_t *mid;
+    int16_t *ref;               // mid >> corr_shift
+    bool have_mid;
+
+    // Search scratch
+    int16_t *scaled;            // Search region >> corr_shift
+    uint32_t *energy;           // Prefix sums of scaled^2
+    uint16_t *fade;             // Cross-fade ramp, Q15
+};
+
+/**
+ * Dot product, 4 lanes with independent accumulators
+ * len must be a multiple of 4
+ */
+static int32_t dot_s16(const int16_t *a, const int16_t *b, int len)
+{
+    int32_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+
+    for (int i = 0; i < len; i += 4) {
+        acc0 += a[i] * b[i];
+        acc1 += a[i + 1] * b[i + 1];
+        acc2 += a[i + 2] * b[i + 2];
+        acc3 += a[i + 3] * b[i + 3];
+    }
+
+    return acc0 + acc1 + acc2 + acc3;
+}
+
+/**
+ * Normalized similarity of candidate offset: corr * |corr| / energy
+ */
+static int64_t score_at(const time_stretch_t *ts, int offset)
+{
+    int32_t corr = dot_s16(ts->ref, &ts->scaled[offset], ts->overlap_len);
+    uint32_t norm = ts->energy[offset + ts->overlap_len] - ts->energy[offset];
+
+    int64_t mag = (int64_t)corr * (corr < 0 ? -corr : corr);
+    return mag / ((int64_t)norm + 1);
+}
+
+/**
+ * Find input offset best matching the previous tail
+ */
+static int seek_best_offset(time_stretch_t *ts, const int16_t *x)
+{
+    int region = ts->seek_len + ts->overlap_len;
+
+    ts->energy[0] = 0;
+    for (int i = 0; i < region; i++) {
+        int16_t s = x[i] >> ts->corr_shift;
+        ts->scaled[i] = s;
+        ts->energy[i + 1] = ts->energy[i] + (uint32_t)(s * s);
+    }
+
+    int best = 0;
+    int64_t best_score = INT64_MIN;
+
+    for (int o = 0; o < ts->seek_len; o += COARSE_STEP) {
+        int64_t score = score_at(ts, o);
+        if (score > best_score) {
+            best_score = score;
+            best = o;
+        }
+    }
+
+    int center = best;
+    for (int o = center - (COARSE_STEP - 1); o <= center + (COARSE_STEP - 1); o++) {
+        if (o < 0 || o >= ts->seek_len || o == center) continue;
+
+        int64_t score = score_at(ts, o);
+        if (score > best_score) {
+            best_score = score;
+            best = o;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Save sequence tail for the next cross-fade
+ */
+static void save_tail(time_stretch_t *ts, const int16_t *tail)
+{
+    memcpy(ts->mid, tail, ts->overlap_len * sizeof(int16_t));
+    for (int i = 0; i < ts->overlap_len; i++) {
+        ts->ref[i] = tail[i] >> ts->corr_shift;
+    }
+    ts->have_mid = true;
+}
+
+/**
+ * Run one WSOLA iteration on the head of the input FIFO
+ *
+ * @return Samples written to output
+ */
+static size_t stretch_iteration(time_stretch_t *ts, int16_t *out, uint32_t advance)
+{
+    const int16_t *x = ts->in_buf;
+    int L = ts->overlap_len;
+    int body = ts->seq_len - 2 * L;
+
+    if (ts->have_mid) {
+        x += seek_best_offset(ts, x);
+
+        for (int i = 0; i < L; i++) {
+            int32_t w = ts->fade[i];
+            out[i] = (int16_t)((ts->mid[i] * (32768 - w) + x[i] * w) >> 15);
+        }
+    } else {
+        memcpy(out, x, L * sizeof(int16_t));
+    }
+
+    memcpy(&out[L], &x[L], body * sizeof(int16_t));
+    save_tail(ts, &x[L + body]);
+
+    ts->in_len -= advance;
+    memmove(ts->in_buf, &ts->in_buf[advance], ts->in_len * sizeof(int16_t));
+
+    return L + body;
+}
+
+/**
+ * Create time stretcher
+ */
+time_stretch_t *time_stretch_create(uint32_t sample_rate)
+{
+    time_stretch_t *ts = malloc(sizeof(time_stretch_t));
+    if (ts == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate time stretch");
+        return NULL;
+    }
+
+    memset(ts, 0, sizeof(time_stretch_t));
+    ts->rate_q8 = TIME_STRETCH_RATE_1X;
+    ts->seq_len = sample_rate * TIME_STRETCH_SEQUENCE_MS / 1000;
+    ts->seek_len = sample_rate * TIME_STRETCH_SEEK_MS / 1000;
+    ts->overlap_len = (sample_rate * TIME_STRETCH_OVERLAP_MS / 1000) & ~7u;
+    if (ts->overlap_len < 8) ts->overlap_len = 8;
+
+    // Smallest shift keeping energy sums in 32 bits and correlations in 31
+    uint32_t region = ts->seek_len + ts->overlap_len;
+    while ((uint64_t)region * (1u << (15 - ts->corr_shift)) * (1u << (15 - ts->corr_shift)) > UINT32_MAX ||
+           (uint64_t)ts->overlap_len * (1u << (15 - ts->corr_shift)) * (1u << (15 - ts->corr_shift)) > INT32_MAX) {
+        ts->corr_shift++;
+    }
+
+    uint32_t max_advance = (TIME_STRETCH_RATE_MAX * (uint32_t)(ts->seq_len - ts->overlap_len) >> 8) + 1;
+    ts->need_max = ts->seek_len + ts->seq_len;
+    if (max_advance > ts->need_max) ts->need_max = max_advance;
+    ts->in_cap = ts->need_max * 2;
+
+    ts->in_buf = malloc(ts->in_cap * sizeof(int16_t));
+    ts->mid = malloc(ts->overlap_len * sizeof(int16_t));
+    ts->ref = malloc(ts->overlap_len * sizeof(int16_t));
+    ts->scaled = malloc(region * sizeof(int16_t));
+    ts->energy = malloc((region + 1) * sizeof(uint32_t));
+    ts->fade = malloc(ts->overlap_len * sizeof(uint16_t));
+
+    if (!ts->in_buf || !ts->mid || !ts->ref || !ts->scaled || !ts->energy || !ts->fade) {
+        ESP_LOGE(TAG, "Failed to allocate buffers");
+        time_stretch_destroy(ts);
+        return NULL;
+    }
+
+    for (int i = 0; i < ts->overlap_len; i++) {
+        ts->fade[i] = (uint16_t)(((uint32_t)i << 15) / ts->overlap_len);
+    }
+
+    ESP_LOGI(TAG, "WSOLA: seq %u, seek %u, overlap %u samples, shift %u",
+             ts->seq_len, ts->seek_len, ts->overlap_len, ts->corr_shift);
+
+    return ts;
+}
+
+/**
+ * Destroy time stretcher
+ */
+void time_stretch_destroy(time_stretch_t *ts)
+{
+    if (ts == NULL) return;
+
+    free(ts->in_buf);
+    free(ts->mid);
+    free(ts->ref);
+    free(ts->scaled);
+    free(ts->energy);
+    free(ts->fade);
+    free(ts);
+}
+
+/**
+ * Set playback rate
+ */
+esp_err_t time_stretch_set_rate(time_stretch_t *ts, uint16_t rate_q8)
+{
+    if (ts == NULL || rate_q8 < TIME_STRETCH_RATE_MIN || rate_q8 > TIME_STRETCH_RATE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (rate_q8 != ts->rate_q8) {
+        ts->rate_q8 = rate_q8;
+        time_stretch_reset(ts);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Get playback rate
+ */
+uint16_t time_stretch_get_rate(const time_stretch_t *ts)
+{
+    return ts ? ts->rate_q8 : TIME_STRETCH_RATE_1X;
+}
+
+/**
+ * Reset state
+ */
+void time_stretch_reset(time_stretch_t *ts)
+{
+    if (ts == NULL) return;
+
+    ts->in_len = 0;
+    ts->skip_fract = 0;
+    ts->have_mid = false;
+}
+
+/**
+ * Output bound for one call
+ */
+size_t time_stretch_max_output(const time_stretch_t *ts, size_t in_samples)
+{
+    if (ts == NULL || ts->rate_q8 == TIME_STRETCH_RATE_1X) return in_samples;
+
+    // Each iteration emits seq - overlap and consumes at least as much
+    return in_samples + ts->need_max;
+}
+
+/**
+ * Process samples
+ */
+esp_err_t time_stretch_process(time_stretch_t *ts, const int16_t *input, size_t in_samples,
+                               int16_t *output, size_t out_max, size_t *out_samples)
+{
+    if (ts == NULL || input == NULL || output == NULL || out_samples == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (out_max < time_stretch_max_output(ts, in_samples)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (ts->rate_q8 == TIME_STRETCH_RATE_1X) {
+        memcpy(output, input, in_samples * sizeof(int16_t));
+        *out_samples = in_samples;
+        return ESP_OK;
+    }
+
+    size_t produced = 0;
+    uint32_t hop = ts->seq_len - ts->overlap_len;
+
+    while (in_samples > 0) {
+        uint32_t n = ts->in_cap - ts->in_len;
+        if (n > in_samples) n = in_samples;
+
+        memcpy(&ts->in_buf[ts->in_len], input, n * sizeof(int16_t));
+        ts->in_len += n;
+        input += n;
+        in_samples -= n;
+
+        for (;;) {
+            uint32_t pos = ts->skip_fract + (uint32_t)ts->rate_q8 * hop;
+            uint32_t advance = pos >> 8;
+            uint32_t need = ts->seek_len + ts->seq_len;
+            if (advance > need) need = advance;
+
+            if (ts->in_len < need) break;
+
+            ts->skip_fract = pos & 0xFF;
+            produced += stretch_iteration(ts, &output[produced], advance);
+        }
+    }
+
+    *out_samples = produced;
+    return ESP_OK;
+}
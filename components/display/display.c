@@ -5,9 +5,11 @@
 
 #include "display.h"
 #include "st7789.h"
+#include "luts.h"
 #include <stdlib.h>
 #include <string.h>
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 
@@ -16,17 +18,51 @@ static const char *TAG = "DISPLAY";
 // Global ST7789 handle
 static st7789_handle_t g_st7789;
 static bool g_initialized = false;
+static display_clock_check_t g_clock_check;
+
+// Window open for display_queue_strip_dma
+static struct {
+    uint16_t width;
+    uint16_t rows_left;         // 0: no window open
+    display_format_t format;
+} g_strips;
+
+/**
+ * Switch panel pixel format if needed (COLMOD is only sent on change)
+ * Every write goes through here first, and any command ends a strip window
+ */
+static void use_format(display_format_t format)
+{
+    g_strips.rows_left = 0;
+
+    st7789_pixel_format_t pf = (format == DISPLAY_FORMAT_RGB444) ? ST7789_PIXEL_RGB444
+                                                                 : ST7789_PIXEL_RGB565;
+    if (g_st7789.pixel_format != pf) {
+        st7789_set_pixel_format(&g_st7789, pf);
+    }
+}
+
+/**
+ * Reduce an 8-bit channel to 4 bits with a dither threshold (0-15)
+ */
+static inline uint8_t dither4(uint8_t v, uint8_t d)
+{
+    return (v - (v >> 4) + d) >> 4;
+}
 
 // SPI bus configuration
-static void init_spi_bus(void)
+static void init_spi_bus(const display_config_t *config)
 {
     spi_bus_config_t buscfg = {
-        .miso_io_num = -1,  // Not used for display
-        .mosi_io_num = PIN_DISPLAY_MOSI,
-        .sclk_io_num = PIN_DISPLAY_CLK,
+        .miso_io_num = config->pin_miso,    // Panel SDO, readback only
+        .mosi_io_num = config->pin_mosi,
+        .sclk_io_num = config->pin_clk,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
         .max_transfer_sz = DISPLAY_WIDTH * DISPLAY_HEIGHT * 2 + 8,  // Full frame + overhead
+#if CONFIG_WATCHMAN_DISPLAY_PINS_IOMUX
+        .flags = SPICOMMON_BUSFLAG_IOMUX_PINS,  // Fail rather than fall back to the GPIO matrix
+#endif
     };
 
     esp_err_t ret = spi_bus_initialize(DISPLAY_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO);
@@ -50,6 +86,7 @@ esp_err_t display_init(const display_config_t *config)
     // Use default config if none provided
     display_config_t default_config = {
         .pin_mosi = PIN_DISPLAY_MOSI,
+        .pin_miso = PIN_DISPLAY_MISO,
         .pin_clk = PIN_DISPLAY_CLK,
         .pin_cs = PIN_DISPLAY_CS,
         .pin_dc = PIN_DISPLAY_DC,
@@ -64,7 +101,7 @@ esp_err_t display_init(const display_config_t *config)
     }
 
     // Initialize SPI bus
-    init_spi_bus();
+    init_spi_bus(config);
 
     // Initialize ST7789 controller
     esp_err_t ret = st7789_init(&g_st7789, DISPLAY_SPI_HOST,
@@ -82,6 +119,12 @@ esp_err_t display_init(const display_config_t *config)
 
     g_initialized = true;
 
+#if CONFIG_WATCHMAN_DISPLAY_READBACK
+    if (config->pin_miso >= 0) {
+        display_validate_spi_clock(config->spi_clock_hz, NULL);
+    }
+#endif
+
     ESP_LOGI(TAG, "Display initialized successfully (%dx%d)",
              g_st7789.width, g_st7789.height);
 
@@ -95,6 +138,7 @@ void display_clear(uint16_t color)
 {
     if (!g_initialized) return;
 
+    use_format(DISPLAY_FORMAT_RGB565);
     st7789_fill_rect(&g_st7789, 0, 0, g_st7789.width, g_st7789.height, color);
 }
 
@@ -106,6 +150,7 @@ void display_draw_pixel(uint16_t x, uint16_t y, uint16_t color)
     if (!g_initialized) return;
     if (x >= g_st7789.width || y >= g_st7789.height) return;
 
+    use_format(DISPLAY_FORMAT_RGB565);
     st7789_set_window(&g_st7789, x, y, x, y);
 
     // Swap bytes for big-endian
@@ -125,6 +170,7 @@ void display_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t
     if (x + w > g_st7789.width) w = g_st7789.width - x;
     if (y + h > g_st7789.height) h = g_st7789.height - y;
 
+    use_format(DISPLAY_FORMAT_RGB565);
     st7789_fill_rect(&g_st7789, x, y, w, h, color);
 }
 
@@ -142,6 +188,7 @@ void display_write_buffer(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const
     if (x + w > g_st7789.width) w = g_st7789.width - x;
     if (y + h > g_st7789.height) h = g_st7789.height - y;
 
+    use_format(DISPLAY_FORMAT_RGB565);
     st7789_set_window(&g_st7789, x, y, x + w - 1, y + h - 1);
 
     // Note: Buffer should already be in RGB565 format
@@ -161,20 +208,174 @@ esp_err_t display_write_frame_dma(const frame_buffer_t *fb)
     uint16_t x = (g_st7789.width - fb->width) / 2;
     uint16_t y = (g_st7789.height - fb->height) / 2;
 
+    use_format(fb->format);
     st7789_set_window(&g_st7789, x, y, x + fb->width - 1, y + fb->height - 1);
 
     return st7789_write_pixels_dma(&g_st7789, fb->buffer, fb->width * fb->height);
 }
 
 /**
- * Wait for DMA transfer to complete
+ * Write a band of frame buffer rows using DMA
+ */
+esp_err_t display_write_rows_dma(const frame_buffer_t *fb, uint16_t y, uint16_t rows)
+{
+    if (!g_initialized) return ESP_FAIL;
+    if (fb == NULL || fb->buffer == NULL) return ESP_ERR_INVALID_ARG;
+    if (rows == 0 || y >= fb->height) return ESP_ERR_INVALID_ARG;
+    if (y + rows > fb->height) rows = fb->height - y;
+
+    uint16_t x0 = (g_st7789.width - fb->width) / 2;
+    uint16_t y0 = (g_st7789.height - fb->height) / 2 + y;
+
+    // Row stride in bytes is even in both formats for even widths
+    uint32_t row_bytes = display_frame_bytes(fb) / fb->height;
+    const uint8_t *data = (const uint8_t *)fb->buffer + (uint32_t)y * row_bytes;
+
+    use_format(fb->format);
+    st7789_set_window(&g_st7789, x0, y0, x0 + fb->width - 1, y0 + rows - 1);
+
+    return st7789_write_pixels_dma(&g_st7789, (const uint16_t *)data, (uint32_t)fb->width * rows);
+}
+
+/**
+ * Write a strip buffer using DMA
+ */
+esp_err_t display_write_strip_dma(const frame_buffer_t *strip, uint16_t x, uint16_t y)
+{
+    if (!g_initialized) return ESP_FAIL;
+    if (strip == NULL || strip->buffer == NULL) return ESP_ERR_INVALID_ARG;
+    if (x + strip->width > g_st7789.width || y + strip->height > g_st7789.height) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    use_format(strip->format);
+    st7789_set_window(&g_st7789, x, y, x + strip->width - 1, y + strip->height - 1);
+
+    return st7789_write_pixels_dma(&g_st7789, strip->buffer, (uint32_t)strip->width * strip->height);
+}
+
+/**
+ * Open a strip window
+ */
+esp_err_t display_begin_strips_dma(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                                   display_format_t format)
+{
+    if (!g_initialized) return ESP_FAIL;
+    if (w == 0 || h == 0) return ESP_ERR_INVALID_ARG;
+    if (x + w > g_st7789.width || y + h > g_st7789.height) return ESP_ERR_INVALID_SIZE;
+
+    // The window commands must not overtake pixels still on their way
+    st7789_wait_dma(&g_st7789);
+
+    use_format(format);
+    st7789_set_window(&g_st7789, x, y, x + w - 1, y + h - 1);
+
+    g_strips.width = w;
+    g_strips.rows_left = h;
+    g_strips.format = format;
+    return ESP_OK;
+}
+
+/**
+ * Queue the next strip
+ */
+esp_err_t display_queue_strip_dma(const frame_buffer_t *strip)
+{
+    if (!g_initialized) return ESP_FAIL;
+    if (strip == NULL || strip->buffer == NULL) return ESP_ERR_INVALID_ARG;
+    if (g_strips.rows_left == 0) return ESP_ERR_INVALID_STATE;
+    if (strip->width != g_strips.width || strip->format != g_strips.format ||
+        strip->height == 0 || strip->height > g_strips.rows_left) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = st7789_write_pixels_dma(&g_st7789, strip->buffer, (uint32_t)strip->width * strip->height);
+    if (ret == ESP_OK) {
+        g_strips.rows_left -= strip->height;
+    }
+    return ret;
+}
+
+/**
+ * Wait for DMA transfers to complete
  */
 void display_wait_dma(void)
 {
     if (!g_initialized) return;
 
-    spi_transaction_t *trans;
-    spi_device_get_trans_result(g_st7789.spi, &trans, portMAX_DELAY);
+    st7789_wait_dma(&g_st7789);
+}
+
+/**
+ * Get transfers in flight
+ */
+uint32_t display_dma_in_flight(void)
+{
+    return g_initialized ? st7789_dma_in_flight(&g_st7789) : 0;
+}
+
+/**
+ * Set transfer done callback
+ */
+void display_set_done_callback(display_done_cb_t cb, void *arg)
+{
+    st7789_set_done_callback(&g_st7789, cb, arg);
+}
+
+/**
+ * Pack RGB565 frame to RGB444 in place
+ * Each pixel pair is read (4 bytes) before its 3 output bytes are written,
+ * and the write position never passes the read position
+ */
+esp_err_t display_pack_rgb444(frame_buffer_t *fb)
+{
+    if (fb == NULL || fb->buffer == NULL) return ESP_ERR_INVALID_ARG;
+    if (fb->format == DISPLAY_FORMAT_RGB444) return ESP_OK;
+    if (fb->width & 1) return ESP_ERR_INVALID_SIZE;
+
+    const uint8_t *src = (const uint8_t *)fb->buffer;
+    uint8_t *dst = (uint8_t *)fb->buffer;
+
+    for (uint16_t y = 0; y < fb->height; y++) {
+        const uint8_t *bayer = lut_bayer4[y & 3];
+
+        for (uint16_t x = 0; x < fb->width; x += 2) {
+            uint8_t c[2][3];
+
+            for (int i = 0; i < 2; i++) {
+                uint16_t v = (src[0] << 8) | src[1];
+                src += 2;
+
+                uint8_t r = (v >> 11) & 0x1F;
+                uint8_t g = (v >> 5) & 0x3F;
+                uint8_t b = v & 0x1F;
+                uint8_t d = bayer[(x + i) & 3];
+
+                c[i][0] = dither4((r << 3) | (r >> 2), d);
+                c[i][1] = dither4((g << 2) | (g >> 4), d);
+                c[i][2] = dither4((b << 3) | (b >> 2), d);
+            }
+
+            dst[0] = (c[0][0] << 4) | c[0][1];
+            dst[1] = (c[0][2] << 4) | c[1][0];
+            dst[2] = (c[1][1] << 4) | c[1][2];
+            dst += 3;
+        }
+    }
+
+    fb->format = DISPLAY_FORMAT_RGB444;
+    return ESP_OK;
+}
+
+/**
+ * Frame transfer size
+ */
+uint32_t display_frame_bytes(const frame_buffer_t *fb)
+{
+    if (fb == NULL) return 0;
+
+    uint32_t pixels = (uint32_t)fb->width * fb->height;
+    return (fb->format == DISPLAY_FORMAT_RGB444) ? pixels * 3 / 2 : pixels * 2;
 }
 
 /**
@@ -188,6 +389,187 @@ void display_set_brightness(uint8_t brightness)
     st7789_set_backlight(&g_st7789, brightness);
 }
 
+/**
+ * Set SPI clock
+ */
+esp_err_t display_set_spi_clock(int clock_hz)
+{
+    if (!g_initialized) return ESP_ERR_INVALID_STATE;
+    if (clock_hz <= 0) return ESP_ERR_INVALID_ARG;
+
+    return st7789_set_spi_clock(&g_st7789, clock_hz);
+}
+
+/**
+ * Get SPI clock
+ */
+int display_get_spi_clock(int *requested_hz)
+{
+    if (requested_hz) *requested_hz = g_initialized ? g_st7789.spi_clock : 0;
+    if (!g_initialized) return 0;
+
+    // The bus divides its source clock, so the result is at or below the request
+    return st7789_get_actual_clock(&g_st7789);
+}
+
+/**
+ * Next pseudo-random test pixel (xorshift32)
+ */
+static inline uint16_t check_pixel(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x >> 16;
+}
+
+/**
+ * FNV-1a over RGB565 values
+ */
+static inline uint32_t check_sum(uint32_t sum, uint16_t v)
+{
+    sum = (sum ^ (v & 0xFF)) * 16777619u;
+    return (sum ^ (v >> 8)) * 16777619u;
+}
+
+/**
+ * Check SPI clock by readback
+ * All bands are written at the clock under test, then read back in one
+ * pass at the read clock: two clock changes per check
+ */
+esp_err_t display_check_spi_clock(int clock_hz)
+{
+    if (!g_initialized) return ESP_ERR_INVALID_STATE;
+
+    const uint16_t w = g_st7789.width;
+    const uint32_t band = (uint32_t)w * DISPLAY_CHECK_ROWS;
+    uint16_t *px = heap_caps_malloc(band * sizeof(uint16_t), MALLOC_CAP_DMA);
+    uint8_t *rgb = heap_caps_malloc(1 + band * 3, MALLOC_CAP_DMA);
+    uint32_t want[DISPLAY_CHECK_ROUNDS];
+    int previous = g_st7789.spi_clock;
+    uint32_t id = 0;
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    if (px == NULL || rgb == NULL) goto done;
+
+    ret = st7789_set_spi_clock(&g_st7789, ST7789_READ_CLOCK);
+    if (ret != ESP_OK) goto done;
+    if (st7789_read_id(&g_st7789, &id) != ESP_OK || id == 0 || id == 0xFFFFFF) {
+        ret = ESP_ERR_NOT_SUPPORTED;
+        goto restore;
+    }
+
+    ret = st7789_set_spi_clock(&g_st7789, clock_hz);
+    if (ret != ESP_OK) goto restore;
+
+    // Fresh pattern per call, so a band left from an earlier check cannot pass
+    static uint32_t seed = 0x9E3779B9;
+    use_format(DISPLAY_FORMAT_RGB565);
+    for (int r = 0; r < DISPLAY_CHECK_ROUNDS; r++) {
+        uint32_t sum = 2166136261u;
+        for (uint32_t i = 0; i < band; i++) {
+            uint16_t c = check_pixel(&seed);
+            sum = check_sum(sum, c);
+            px[i] = (c >> 8) | (c << 8);
+        }
+        want[r] = sum;
+
+        uint16_t y = r * DISPLAY_CHECK_ROWS;
+        st7789_set_window(&g_st7789, 0, y, w - 1, y + DISPLAY_CHECK_ROWS - 1);
+        ret = st7789_write_pixels_dma(&g_st7789, px, band);
+        if (ret != ESP_OK) goto restore;
+        display_wait_dma();
+    }
+
+    ret = st7789_set_spi_clock(&g_st7789, ST7789_READ_CLOCK);
+    if (ret != ESP_OK) goto restore;
+
+    for (int r = 0; r < DISPLAY_CHECK_ROUNDS && ret == ESP_OK; r++) {
+        uint16_t y = r * DISPLAY_CHECK_ROWS;
+        ret = st7789_read_pixels(&g_st7789, 0, y, w - 1, y + DISPLAY_CHECK_ROWS - 1, rgb);
+        if (ret != ESP_OK) break;
+
+        // 6-bit channels back to RGB565 (the panel extends red and blue)
+        uint32_t sum = 2166136261u;
+        for (uint32_t i = 0; i < band; i++) {
+            const uint8_t *p = &rgb[1 + i * 3];
+            sum = check_sum(sum, ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3));
+        }
+        if (sum != want[r]) ret = ESP_ERR_INVALID_CRC;
+    }
+
+restore:
+    st7789_set_spi_clock(&g_st7789, previous);
+done:
+    heap_caps_free(px);
+    heap_caps_free(rgb);
+    return ret;
+}
+
+/**
+ * Validate SPI clock
+ */
+esp_err_t display_validate_spi_clock(int max_hz, display_clock_check_t *result)
+{
+    static const int clocks[] = DISPLAY_CHECK_CLOCKS;
+    const int count = sizeof(clocks) / sizeof(clocks[0]);
+
+    if (!g_initialized) return ESP_ERR_INVALID_STATE;
+
+    display_clock_check_t check = {0};
+    esp_err_t ret = ESP_ERR_INVALID_CRC;
+    int chosen = max_hz;
+
+    // Panel ID first: no answer means no readback, so nothing to validate
+    if (st7789_set_spi_clock(&g_st7789, ST7789_READ_CLOCK) == ESP_OK) {
+        check.readback = (st7789_read_id(&g_st7789, &check.panel_id) == ESP_OK &&
+                          check.panel_id != 0 && check.panel_id != 0xFFFFFF);
+    }
+
+    // max_hz itself, then every candidate below it
+    for (int i = -1; i < count && check.readback; i++) {
+        int hz = (i < 0) ? max_hz : clocks[i];
+        if (i >= 0 && hz >= max_hz) continue;
+
+        check.clocks_tried++;
+        chosen = hz;
+        esp_err_t err = display_check_spi_clock(hz);
+        if (err == ESP_OK) {
+            ret = ESP_OK;
+            break;
+        }
+        ESP_LOGW(TAG, "SPI clock %d kHz failed readback (%s)", hz / 1000, esp_err_to_name(err));
+    }
+
+    if (!check.readback) {
+        ret = ESP_ERR_NOT_SUPPORTED;
+        chosen = max_hz;
+        ESP_LOGW(TAG, "No panel readback (MISO not wired?), SPI clock %d kHz unverified", max_hz / 1000);
+    }
+
+    st7789_set_spi_clock(&g_st7789, chosen);
+    if (check.readback) {
+        check.clock_hz = chosen;
+        st7789_fill_rect(&g_st7789, 0, 0, g_st7789.width, DISPLAY_CHECK_ROUNDS * DISPLAY_CHECK_ROWS, COLOR_BLACK);
+        ESP_LOGI(TAG, "Panel ID %06lX, SPI clock %d kHz %s", check.panel_id, chosen / 1000,
+                 (ret == ESP_OK) ? "verified" : "(every candidate failed, slowest kept)");
+    }
+
+    g_clock_check = check;
+    if (result) *result = check;
+    return ret;
+}
+
+/**
+ * Get clock validation result
+ */
+void display_get_clock_check(display_clock_check_t *result)
+{
+    *result = g_clock_check;
+}
+
 /**
  * Put display to sleep
  */
@@ -195,6 +577,7 @@ void display_sleep(void)
 {
     if (!g_initialized) return;
 
+    g_strips.rows_left = 0;
     st7789_sleep(&g_st7789);
     st7789_set_backlight(&g_st7789, 0);  // Turn off backlight
 }
@@ -237,8 +620,9 @@ frame_buffer_t *display_alloc_frame_buffer(uint16_t width, uint16_t height)
         return NULL;
     }
 
-    // Allocate buffer (RGB565 = 2 bytes per pixel)
-    fb->buffer = heap_caps_malloc(width * height * sizeof(uint16_t), MALLOC_CAP_DMA);
+    // Allocate buffer (RGB565 = 2 bytes per pixel), 16-byte aligned so
+    // the PIE kernels can read and write it directly
+    fb->buffer = heap_caps_aligned_alloc(16, width * height * sizeof(uint16_t), MALLOC_CAP_DMA);
     if (fb->buffer == NULL) {
         ESP_LOGE(TAG, "Failed to allocate frame buffer memory (%d bytes)",
                  width * height * 2);
@@ -248,6 +632,7 @@ frame_buffer_t *display_alloc_frame_buffer(uint16_t width, uint16_t height)
 
     fb->width = width;
     fb->height = height;
+    fb->format = DISPLAY_FORMAT_RGB565;
     fb->ready = false;
 
     ESP_LOGI(TAG, "Allocated frame buffer: %dx%d (%d bytes)",
@@ -10,6 +10,7 @@
 #include <stdbool.h>
 #include "esp_err.h"
 #include "driver/spi_master.h"
+#include "sdkconfig.h"
 
 // Display configuration based on 2" ST7789 IPS display (240x320)
 #define DISPLAY_WIDTH       240
@@ -17,16 +18,51 @@
 #define DISPLAY_ORIENTATION 0  // 0=portrait, 1=landscape, 2=portrait inverted, 3=landscape inverted
 
 // Pin definitions (adjust these for your specific wiring)
+#if CONFIG_WATCHMAN_DISPLAY_PINS_IOMUX
+// Native pins of the SPI host: signals skip the GPIO matrix, whose input
+// delay holds spi_master to 26.67 MHz, so the bus can run at up to 80 MHz
+#if CONFIG_IDF_TARGET_ESP32S3
+#define PIN_DISPLAY_MOSI    11  // FSPID
+#define PIN_DISPLAY_CLK     12  // FSPICLK
+#define PIN_DISPLAY_MISO    13  // FSPIQ, panel SDO (optional, for readback)
+#define PIN_DISPLAY_CS      10  // FSPICS0
+#define DISPLAY_SPI_HOST    SPI2_HOST
+#define DISPLAY_SPI_CLOCK   80000000
+#else
+#define PIN_DISPLAY_MOSI    23  // VSPID
+#define PIN_DISPLAY_CLK     18  // VSPICLK
+#define PIN_DISPLAY_MISO    19  // VSPIQ, panel SDO (optional, for readback)
+#define PIN_DISPLAY_CS      5   // VSPICS0
+#define DISPLAY_SPI_HOST    SPI3_HOST
+#define DISPLAY_SPI_CLOCK   40000000  // ST7789 write cycle is 16 ns minimum (62.5 MHz)
+#endif
+#else
 #define PIN_DISPLAY_MOSI    19  // Changed from 23 to avoid board labeling issues
 #define PIN_DISPLAY_CLK     18
+#define PIN_DISPLAY_MISO    -1  // Write only
 #define PIN_DISPLAY_CS      5
+#define DISPLAY_SPI_HOST    SPI2_HOST
+#define DISPLAY_SPI_CLOCK   26000000  // 26MHz (ESP32 limit is 26.666MHz for this configuration)
+#endif
 #define PIN_DISPLAY_DC      16
 #define PIN_DISPLAY_RST     4
 #define PIN_DISPLAY_BL      15  // Backlight (optional, can use PWM)
 
-// SPI configuration
-#define DISPLAY_SPI_HOST    SPI2_HOST
-#define DISPLAY_SPI_CLOCK   26000000  // 26MHz (ESP32 limit is 26.666MHz for this configuration)
+// Bus backend (CONFIG_WATCHMAN_DISPLAY_BACKEND)
+#if CONFIG_WATCHMAN_DISPLAY_BACKEND_ESP_LCD
+#define DISPLAY_BACKEND_NAME    "esp_lcd panel IO"
+#else
+#define DISPLAY_BACKEND_NAME    "spi_master"
+#endif
+
+// Strips display_queue_strip_dma may have in flight (below ST7789_QUEUE_DEPTH)
+#define DISPLAY_MAX_IN_FLIGHT   4
+
+// Clock validation by readback: fallback clocks fastest first, rows per
+// test band, bands per check
+#define DISPLAY_CHECK_CLOCKS    {80000000, 40000000, 26666666, 20000000}
+#define DISPLAY_CHECK_ROWS      8
+#define DISPLAY_CHECK_ROUNDS    3
 
 // RGB565 color definitions
 #define COLOR_BLACK         0x0000
@@ -45,11 +81,22 @@
  */
 #define RGB565(r, g, b) ((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3))
 
+/**
+ * Frame buffer pixel format
+ * RGB444 sends 12 bits per pixel (COLMOD 0x53), 25% fewer SPI bytes per
+ * frame than RGB565 at the cost of 4 bits per channel (ordered dithered)
+ */
+typedef enum {
+    DISPLAY_FORMAT_RGB565 = 0,  // Big-endian RGB565, 2 bytes per pixel
+    DISPLAY_FORMAT_RGB444,      // Packed RGB444, 3 bytes per 2 pixels
+} display_format_t;
+
 /**
  * Display initialization configuration
  */
 typedef struct {
     int pin_mosi;
+    int pin_miso;             // -1 if the panel SDO is not wired
     int pin_clk;
     int pin_cs;
     int pin_dc;
@@ -63,9 +110,10 @@ typedef struct {
  * Frame buffer structure for double buffering
  */
 typedef struct {
-    uint16_t *buffer;         // RGB565 pixel data
+    uint16_t *buffer;         // Pixel data (RGB565 capacity, packed RGB444 fits)
     uint16_t width;
     uint16_t height;
+    display_format_t format;  // Format of the current contents
     bool ready;               // True when buffer is ready for display
 } frame_buffer_t;
 
@@ -119,7 +167,7 @@ void display_write_buffer(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const
 
 /**
  * Write frame buffer to display using DMA
- * Non-blocking operation
+ * Non-blocking operation. The panel pixel format follows fb->format.
  *
  * @param fb Frame buffer to display
  * @return ESP_OK on success
@@ -127,10 +175,106 @@ void display_write_buffer(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const
 esp_err_t display_write_frame_dma(const frame_buffer_t *fb);
 
 /**
- * Wait for DMA transfer to complete
+ * Write a band of frame buffer rows to display using DMA
+ * Non-blocking; the rest of the panel keeps its contents. Used to push only
+ * the rows a partial-update codec changed.
+ *
+ * @param fb Frame buffer (positioned as for display_write_frame_dma)
+ * @param y First row in the frame buffer
+ * @param rows Number of rows
+ * @return ESP_OK on success
+ */
+esp_err_t display_write_rows_dma(const frame_buffer_t *fb, uint16_t y, uint16_t rows);
+
+/**
+ * Write a strip buffer to a panel position using DMA
+ * Non-blocking; for pipelines that produce a frame a few rows at a time.
+ * The panel pixel format follows strip->format.
+ *
+ * @param strip Strip pixels (width x height rows)
+ * @param x Panel X coordinate (top-left)
+ * @param y Panel Y coordinate (top-left)
+ * @return ESP_OK on success
+ */
+esp_err_t display_write_strip_dma(const frame_buffer_t *strip, uint16_t x, uint16_t y);
+
+/**
+ * Open a window for strips queued with display_queue_strip_dma
+ * Waits for transfers still in flight, then sets the window once; the
+ * strips stream into it top to bottom with no command in between, so up to
+ * DISPLAY_MAX_IN_FLIGHT of them can be queued at a time. The panel pixel
+ * format is set here and every strip must be in it.
+ *
+ * @param x Panel X coordinate (top-left)
+ * @param y Panel Y coordinate (top-left)
+ * @param w Width, every strip's width
+ * @param h Height, the strips' rows in total
+ * @param format Strip pixel format
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if off the panel
+ */
+esp_err_t display_begin_strips_dma(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                                   display_format_t format);
+
+/**
+ * Queue the next strip of the window opened by display_begin_strips_dma
+ * Non-blocking while fewer than DISPLAY_MAX_IN_FLIGHT transfers are in
+ * flight; the strip buffer must stay untouched until its transfer is done
+ * (display_dma_in_flight, or the done callback)
+ *
+ * @param strip Strip pixels (window width x any rows left)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no window is open,
+ *         ESP_ERR_INVALID_SIZE if the strip does not fit what is left of it
+ */
+esp_err_t display_queue_strip_dma(const frame_buffer_t *strip);
+
+/**
+ * Wait until every queued DMA transfer is complete
  */
 void display_wait_dma(void);
 
+/**
+ * Get the number of queued DMA transfers not yet complete
+ *
+ * @return Transfers in flight
+ */
+uint32_t display_dma_in_flight(void);
+
+/**
+ * DMA transfer done callback, called from the SPI interrupt
+ *
+ * @param arg Argument given with the callback
+ * @return true if a higher priority task was woken (FromISR calls)
+ */
+typedef bool (*display_done_cb_t)(void *arg);
+
+/**
+ * Set the DMA transfer done callback
+ * Called once per queued transfer, in queue order, when its last byte is
+ * out; keep it short and use FromISR calls only. Set it while nothing is
+ * in flight.
+ *
+ * @param cb Callback, NULL to remove
+ * @param arg Argument for the callback
+ */
+void display_set_done_callback(display_done_cb_t cb, void *arg);
+
+/**
+ * Convert a big-endian RGB565 frame buffer to packed RGB444 in place
+ * Uses 4x4 ordered dithering. Width must be even.
+ *
+ * @param fb Frame buffer (format becomes DISPLAY_FORMAT_RGB444)
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE for odd widths
+ */
+esp_err_t display_pack_rgb444(frame_buffer_t *fb);
+
+/**
+ * Bytes sent over SPI for a frame buffer in its current format
+ *
+ * @param fb Frame buffer
+ * @return Transfer size in bytes
+ */
+uint32_t display_frame_bytes(const frame_buffer_t *fb);
+
 /**
  * Set display backlight brightness
  *
@@ -138,6 +282,67 @@ void display_wait_dma(void);
  */
 void display_set_brightness(uint8_t brightness);
 
+/**
+ * Change the display SPI clock
+ * Every DMA transfer must have been waited for (stop video playback first)
+ *
+ * @param clock_hz SPI clock in Hz
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a transfer is pending
+ */
+esp_err_t display_set_spi_clock(int clock_hz);
+
+/**
+ * Get the display SPI clock
+ *
+ * @param requested_hz Output clock asked for (optional, can be NULL)
+ * @return Clock the SPI peripheral actually runs at in Hz, 0 if not initialized
+ */
+int display_get_spi_clock(int *requested_hz);
+
+/**
+ * SPI clock validation result
+ */
+typedef struct {
+    bool readback;            // Panel answered RDDID over MISO
+    uint32_t panel_id;        // RDDID: manufacturer, version, driver
+    int clock_hz;             // Requested clock kept (0 if not validated)
+    int clocks_tried;
+} display_clock_check_t;
+
+/**
+ * Check one SPI clock by frame memory readback
+ * Writes DISPLAY_CHECK_ROUNDS pseudo-random bands at clock_hz, reads them
+ * back at ST7789_READ_CLOCK and compares checksums. Overwrites the top
+ * DISPLAY_CHECK_ROUNDS * DISPLAY_CHECK_ROWS rows; the clock in use before
+ * the call is restored. Every DMA transfer must have been waited for.
+ *
+ * @param clock_hz Clock to check
+ * @return ESP_OK if every band read back intact, ESP_ERR_INVALID_CRC on a
+ *         mismatch, ESP_ERR_NOT_SUPPORTED without readback (no MISO, or
+ *         the panel does not answer)
+ */
+esp_err_t display_check_spi_clock(int clock_hz);
+
+/**
+ * Pick the fastest SPI clock that passes display_check_spi_clock
+ * Tries max_hz, then each of DISPLAY_CHECK_CLOCKS below it, keeps the
+ * first that passes and clears the test band. Without readback max_hz is
+ * used unverified; if every candidate fails the slowest is kept.
+ *
+ * @param max_hz Fastest clock to try
+ * @param result Output (optional, also kept for display_get_clock_check)
+ * @return ESP_OK if a clock passed, ESP_ERR_NOT_SUPPORTED without readback,
+ *         ESP_ERR_INVALID_CRC if none did
+ */
+esp_err_t display_validate_spi_clock(int max_hz, display_clock_check_t *result);
+
+/**
+ * Get the result of the last clock validation
+ *
+ * @param result Output (zeroed if validation never ran)
+ */
+void display_get_clock_check(display_clock_check_t *result);
+
 /**
  * Put display to sleep (low power mode)
  */
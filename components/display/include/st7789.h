@@ -8,8 +8,16 @@
 
 #include <stdint.h>
 #include "esp_err.h"
+#include <stdbool.h>
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
+#include "sdkconfig.h"
+
+#if CONFIG_WATCHMAN_DISPLAY_BACKEND_ESP_LCD
+#include "esp_lcd_panel_io.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#endif
 
 // ST7789 Commands
 #define ST7789_NOP          0x00
@@ -29,6 +37,9 @@
 #define ST7789_RAMWR        0x2C
 #define ST7789_RAMRD        0x2E
 #define ST7789_PTLAR        0x30
+#define ST7789_VSCRDEF      0x33
+#define ST7789_VSCSAD       0x37
+#define ST7789_RAMWRC       0x3C
 #define ST7789_COLMOD       0x3A
 #define ST7789_MADCTL       0x36
 #define ST7789_FRMCTR1      0xB1
@@ -59,17 +70,62 @@
 #define ST7789_MADCTL_BGR   0x08
 #define ST7789_MADCTL_MH    0x04
 
+// Serial read cycle is 150 ns minimum: reads run at 80 MHz / 16
+#define ST7789_READ_CLOCK   5000000
+
+// Pixel transfers that can be queued at once
+#define ST7789_QUEUE_DEPTH  7
+
+// COLMOD values (RGB interface 65K/4K colors, 16/12 bits per pixel)
+#define ST7789_COLMOD_16BIT 0x55
+#define ST7789_COLMOD_12BIT 0x53
+
+/**
+ * Pixel format on the wire
+ */
+typedef enum {
+    ST7789_PIXEL_RGB565 = 0,    // 2 bytes per pixel
+    ST7789_PIXEL_RGB444,        // 3 bytes per 2 pixels, packed R0G0 B0R1 G1B1
+} st7789_pixel_format_t;
+
+/**
+ * Pixel transfer done callback, called from the SPI interrupt
+ *
+ * @param arg Argument given with the callback
+ * @return true if a higher priority task was woken
+ */
+typedef bool (*st7789_done_cb_t)(void *arg);
+
 /**
  * ST7789 device handle
+ * The bus fields depend on the backend (CONFIG_WATCHMAN_DISPLAY_BACKEND):
+ * st7789_spi.c drives spi_master directly, st7789_lcd.c goes through an
+ * esp_lcd SPI panel IO
  */
 typedef struct {
+#if CONFIG_WATCHMAN_DISPLAY_BACKEND_ESP_LCD
+    esp_lcd_panel_io_handle_t io;
+    SemaphoreHandle_t done_sem;     // Given on every completed pixel transfer
+    StaticSemaphore_t done_sem_buf;
+#else
     spi_device_handle_t spi;
+    spi_transaction_t trans[ST7789_QUEUE_DEPTH];    // Queued pixel transfers, by sequence
+    uint32_t collected;             // Pixel transfer results taken off the queue
+#endif
+    uint32_t queued;                // Pixel transfers queued
+    volatile uint32_t completed;    // Pixel transfers done (interrupt side)
+    st7789_done_cb_t done_cb;
+    void *done_arg;
+    spi_host_device_t spi_host;
+    int pin_cs;
+    int spi_clock;              // Requested clock, Hz
     int pin_dc;
     int pin_rst;
     int pin_bl;
     uint16_t width;
     uint16_t height;
     uint8_t orientation;
+    st7789_pixel_format_t pixel_format;
 } st7789_handle_t;
 
 /**
@@ -88,6 +144,17 @@ esp_err_t st7789_init(st7789_handle_t *handle, spi_host_device_t spi_host,
                        int pin_cs, int pin_dc, int pin_rst, int pin_bl,
                        int spi_clock);
 
+/**
+ * Change the SPI clock
+ * Re-adds the SPI device, so no transfer may be queued or in flight
+ *
+ * @param handle ST7789 handle
+ * @param spi_clock SPI clock speed in Hz
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a transfer is pending
+ *         (the old clock stays in use on any error)
+ */
+esp_err_t st7789_set_spi_clock(st7789_handle_t *handle, int spi_clock);
+
 /**
  * Set display orientation
  *
@@ -96,6 +163,15 @@ esp_err_t st7789_init(st7789_handle_t *handle, spi_host_device_t spi_host,
  */
 void st7789_set_orientation(st7789_handle_t *handle, uint8_t orientation);
 
+/**
+ * Set interface pixel format (COLMOD)
+ * Pixel counts passed to the write functions are interpreted in this format
+ *
+ * @param handle ST7789 handle
+ * @param format Pixel format
+ */
+void st7789_set_pixel_format(st7789_handle_t *handle, st7789_pixel_format_t format);
+
 /**
  * Set drawing window (address window)
  *
@@ -112,21 +188,88 @@ void st7789_set_window(st7789_handle_t *handle, uint16_t x0, uint16_t y0,
  * Write pixel data to display
  *
  * @param handle ST7789 handle
- * @param data RGB565 pixel data
- * @param len Number of pixels
+ * @param data Pixel data in the current pixel format
+ * @param len Number of pixels (even in RGB444 mode)
  */
 void st7789_write_pixels(st7789_handle_t *handle, const uint16_t *data, uint32_t len);
 
 /**
  * Write pixel data using DMA (non-blocking)
+ * Transfers queued back to back with no command in between continue the
+ * same memory write, so up to ST7789_QUEUE_DEPTH of them can be in flight;
+ * the buffer must stay untouched until the transfer is done
  *
  * @param handle ST7789 handle
- * @param data RGB565 pixel data
- * @param len Number of pixels
+ * @param data Pixel data in the current pixel format, DMA capable
+ * @param len Number of pixels (even in RGB444 mode)
  * @return ESP_OK on success
  */
 esp_err_t st7789_write_pixels_dma(st7789_handle_t *handle, const uint16_t *data, uint32_t len);
 
+/**
+ * Wait until every queued pixel transfer is done
+ *
+ * @param handle ST7789 handle
+ * @return ESP_OK on success
+ */
+esp_err_t st7789_wait_dma(st7789_handle_t *handle);
+
+/**
+ * Get the number of queued pixel transfers not yet done
+ *
+ * @param handle ST7789 handle
+ * @return Transfers in flight
+ */
+uint32_t st7789_dma_in_flight(const st7789_handle_t *handle);
+
+/**
+ * Set the pixel transfer done callback
+ * Called from the SPI interrupt once per queued transfer, in queue order,
+ * after its last byte; keep it short and use FromISR calls only. Set it
+ * while nothing is in flight.
+ *
+ * @param handle ST7789 handle
+ * @param cb Callback, NULL to remove
+ * @param arg Argument for the callback
+ */
+void st7789_set_done_callback(st7789_handle_t *handle, st7789_done_cb_t cb, void *arg);
+
+/**
+ * Get the SPI clock the bus actually runs at
+ *
+ * @param handle ST7789 handle
+ * @return Clock in Hz (the source clock divided down, at or below the request)
+ */
+int st7789_get_actual_clock(st7789_handle_t *handle);
+
+/**
+ * Read the display ID (RDDID)
+ * Needs the panel's SDO on the bus MISO and a clock the panel can drive
+ * its output at (ST7789_READ_CLOCK)
+ *
+ * @param handle ST7789 handle
+ * @param id Output: manufacturer << 16 | version << 8 | driver
+ * @return ESP_OK on success (an unwired MISO reads 0x000000 or 0xFFFFFF)
+ */
+esp_err_t st7789_read_id(st7789_handle_t *handle, uint32_t *id);
+
+/**
+ * Read frame memory (RAMRD) from a window
+ * Pixels come back as three bytes, six bits per channel left aligned,
+ * whatever the COLMOD; same clock limit as st7789_read_id
+ *
+ * @param handle ST7789 handle
+ * @param x0 Start X coordinate
+ * @param y0 Start Y coordinate
+ * @param x1 End X coordinate
+ * @param y1 End Y coordinate
+ * @param rgb Output, 1 + 3 bytes per pixel, DMA capable (byte 0 is the
+ *            dummy byte the panel sends first)
+ * @return ESP_OK on success
+ */
+esp_err_t st7789_read_pixels(st7789_handle_t *handle, uint16_t x0, uint16_t y0,
+                             uint16_t x1, uint16_t y1, uint8_t *rgb);
+
 /**
  * Fill rectangle with solid color
  *
@@ -1,9 +1,10 @@
 /**
  * ST7789 Display Controller Driver Implementation
+ * Controller commands; bus access is in st7789_spi.c or st7789_lcd.c
  */
 
-#include <string.h>
 #include "st7789.h"
+#include "st7789_bus.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/gpio.h"
@@ -16,45 +17,6 @@ static const char *TAG = "ST7789";
 #define RESET_DELAY_MS      10
 #define INIT_DELAY_MS       120
 
-/**
- * Send command to ST7789
- */
-void st7789_write_command(st7789_handle_t *handle, uint8_t cmd)
-{
-    gpio_set_level(handle->pin_dc, 0);  // Command mode
-
-    spi_transaction_t trans = {
-        .length = 8,
-        .tx_buffer = &cmd,
-        .flags = SPI_TRANS_USE_TXDATA,
-    };
-    trans.tx_data[0] = cmd;
-
-    spi_device_polling_transmit(handle->spi, &trans);
-}
-
-/**
- * Send data to ST7789
- */
-void st7789_write_data(st7789_handle_t *handle, const uint8_t *data, size_t len)
-{
-    if (len == 0) return;
-
-    gpio_set_level(handle->pin_dc, 1);  // Data mode
-
-    spi_transaction_t trans = {
-        .length = len * 8,
-        .tx_buffer = data,
-    };
-
-    if (len <= 4) {
-        trans.flags = SPI_TRANS_USE_TXDATA;
-        memcpy(trans.tx_data, data, len);
-    }
-
-    spi_device_polling_transmit(handle->spi, &trans);
-}
-
 /**
  * Hardware reset
  */
@@ -77,12 +39,20 @@ esp_err_t st7789_init(st7789_handle_t *handle, spi_host_device_t spi_host,
 {
     ESP_LOGI(TAG, "Initializing ST7789 display driver");
 
+    handle->spi_host = spi_host;
+    handle->pin_cs = pin_cs;
+    handle->spi_clock = spi_clock;
     handle->pin_dc = pin_dc;
     handle->pin_rst = pin_rst;
     handle->pin_bl = pin_bl;
     handle->width = 240;
     handle->height = 320;
     handle->orientation = 0;
+    handle->pixel_format = ST7789_PIXEL_RGB565;
+    handle->queued = 0;
+    handle->completed = 0;
+    handle->done_cb = NULL;
+    handle->done_arg = NULL;
 
     // Configure GPIO pins
     gpio_config_t io_conf = {
@@ -127,16 +97,7 @@ esp_err_t st7789_init(st7789_handle_t *handle, spi_host_device_t spi_host,
     }
 
     // Configure SPI bus
-    spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = spi_clock,
-        .mode = 0,                          // SPI mode 0
-        .spics_io_num = pin_cs,
-        .queue_size = 7,
-        .pre_cb = NULL,
-        .flags = 0,  // No special flags - removed SPI_DEVICE_NO_DUMMY to fix multi-line/half-duplex conflict
-    };
-
-    esp_err_t ret = spi_bus_add_device(spi_host, &devcfg, &handle->spi);
+    esp_err_t ret = st7789_bus_open(handle, spi_clock);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to add SPI device");
         return ret;
@@ -154,7 +115,7 @@ esp_err_t st7789_init(st7789_handle_t *handle, spi_host_device_t spi_host,
 
     // Color mode - 16-bit RGB565
     st7789_write_command(handle, ST7789_COLMOD);
-    uint8_t colmod = 0x55;  // 16-bit/pixel
+    uint8_t colmod = ST7789_COLMOD_16BIT;
     st7789_write_data(handle, &colmod, 1);
 
     // Porch settings (PORCTRL - 0xB2)
@@ -228,6 +189,28 @@ esp_err_t st7789_init(st7789_handle_t *handle, spi_host_device_t spi_host,
     return ESP_OK;
 }
 
+/**
+ * Change SPI clock
+ */
+esp_err_t st7789_set_spi_clock(st7789_handle_t *handle, int spi_clock)
+{
+    // Fails while transfers are in flight
+    esp_err_t ret = st7789_bus_close(handle);
+    if (ret != ESP_OK) return ret;
+
+    ret = st7789_bus_open(handle, spi_clock);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SPI clock %d Hz rejected, keeping %d Hz", spi_clock, handle->spi_clock);
+        st7789_bus_open(handle, handle->spi_clock);
+        return ret;
+    }
+
+    handle->spi_clock = spi_clock;
+    ESP_LOGI(TAG, "SPI clock %d Hz", spi_clock);
+
+    return ESP_OK;
+}
+
 /**
  * Set display orientation
  */
@@ -264,6 +247,19 @@ void st7789_set_orientation(st7789_handle_t *handle, uint8_t orientation)
     st7789_write_data(handle, &madctl, 1);
 }
 
+/**
+ * Set interface pixel format
+ */
+void st7789_set_pixel_format(st7789_handle_t *handle, st7789_pixel_format_t format)
+{
+    uint8_t colmod = (format == ST7789_PIXEL_RGB444) ? ST7789_COLMOD_12BIT : ST7789_COLMOD_16BIT;
+
+    st7789_write_command(handle, ST7789_COLMOD);
+    st7789_write_data(handle, &colmod, 1);
+
+    handle->pixel_format = format;
+}
+
 /**
  * Set drawing window
  */
@@ -292,40 +288,42 @@ void st7789_set_window(st7789_handle_t *handle, uint16_t x0, uint16_t y0,
 }
 
 /**
- * Write pixel data
+ * Read display ID
  */
-void st7789_write_pixels(st7789_handle_t *handle, const uint16_t *data, uint32_t len)
+esp_err_t st7789_read_id(st7789_handle_t *handle, uint32_t *id)
 {
-    if (len == 0) return;
+    // One dummy clock, then 24 bits
+    uint8_t rx[4];
 
-    gpio_set_level(handle->pin_dc, 1);  // Data mode
-
-    // ST7789 expects big-endian RGB565, ESP32 is little-endian
-    // Bytes are already swapped by caller (e.g., st7789_fill_rect)
-    spi_transaction_t trans = {
-        .length = len * 16,  // bits
-        .tx_buffer = data,
-        .flags = 0,  // Standard SPI mode
-    };
+    esp_err_t ret = st7789_bus_read(handle, ST7789_RDDID, rx, sizeof(rx));
+    if (ret != ESP_OK) return ret;
 
-    spi_device_polling_transmit(handle->spi, &trans);
+    uint32_t bits = ((uint32_t)rx[0] << 24) | ((uint32_t)rx[1] << 16) |
+                    ((uint32_t)rx[2] << 8) | rx[3];
+    *id = (bits >> 7) & 0xFFFFFF;
+    return ESP_OK;
 }
 
 /**
- * Write pixel data using DMA
+ * Read frame memory
  */
-esp_err_t st7789_write_pixels_dma(st7789_handle_t *handle, const uint16_t *data, uint32_t len)
+esp_err_t st7789_read_pixels(st7789_handle_t *handle, uint16_t x0, uint16_t y0,
+                             uint16_t x1, uint16_t y1, uint8_t *rgb)
 {
-    if (len == 0) return ESP_OK;
-
-    gpio_set_level(handle->pin_dc, 1);  // Data mode
+    uint32_t pixels = (uint32_t)(x1 - x0 + 1) * (y1 - y0 + 1);
 
-    spi_transaction_t trans = {
-        .length = len * 16,  // bits
-        .tx_buffer = data,
-    };
+    // Window only: RAMRD replaces the RAMWR st7789_set_window ends with
+    uint8_t data[4] = {x0 >> 8, x0 & 0xFF, x1 >> 8, x1 & 0xFF};
+    st7789_write_command(handle, ST7789_CASET);
+    st7789_write_data(handle, data, 4);
+    data[0] = y0 >> 8;
+    data[1] = y0 & 0xFF;
+    data[2] = y1 >> 8;
+    data[3] = y1 & 0xFF;
+    st7789_write_command(handle, ST7789_RASET);
+    st7789_write_data(handle, data, 4);
 
-    return spi_device_queue_trans(handle->spi, &trans, portMAX_DELAY);
+    return st7789_bus_read(handle, ST7789_RAMRD, rgb, 1 + pixels * 3);
 }
 
 /**
@@ -342,8 +340,6 @@ void st7789_fill_rect(st7789_handle_t *handle, uint16_t x, uint16_t y,
     // Swap bytes for big-endian
     uint16_t color_be = (color >> 8) | (color << 8);
 
-    gpio_set_level(handle->pin_dc, 1);  // Data mode
-
     // Send color in chunks
     const uint32_t chunk_size = 1024;
     uint16_t buffer[chunk_size];
@@ -359,6 +355,23 @@ void st7789_fill_rect(st7789_handle_t *handle, uint16_t x, uint16_t y,
     }
 }
 
+/**
+ * Set transfer done callback
+ */
+void st7789_set_done_callback(st7789_handle_t *handle, st7789_done_cb_t cb, void *arg)
+{
+    handle->done_arg = arg;
+    handle->done_cb = cb;
+}
+
+/**
+ * Get transfers in flight
+ */
+uint32_t st7789_dma_in_flight(const st7789_handle_t *handle)
+{
+    return handle->queued - handle->completed;
+}
+
 /**
  * Set backlight brightness
  */
@@ -0,0 +1,42 @@
+/**
+ * ST7789 Bus Backend
+ * What st7789.c needs from the SPI driver beyond the public write and
+ * transfer functions; implemented by st7789_spi.c (spi_master) or
+ * st7789_lcd.c (esp_lcd panel IO), per CONFIG_WATCHMAN_DISPLAY_BACKEND
+ */
+
+#ifndef ST7789_BUS_H
+#define ST7789_BUS_H
+
+#include "st7789.h"
+
+/**
+ * Attach the panel to the SPI bus at a clock
+ *
+ * @param handle ST7789 handle (spi_host, pin_cs and pin_dc set)
+ * @param spi_clock SPI clock speed in Hz
+ * @return ESP_OK on success
+ */
+esp_err_t st7789_bus_open(st7789_handle_t *handle, int spi_clock);
+
+/**
+ * Detach the panel from the SPI bus
+ *
+ * @param handle ST7789 handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while a transfer is in flight
+ */
+esp_err_t st7789_bus_close(st7789_handle_t *handle);
+
+/**
+ * Send a read command and clock in its response with CS held low
+ * The panel drives SDO only while CS stays asserted after the command
+ *
+ * @param handle ST7789 handle
+ * @param cmd Command byte
+ * @param rx Output, DMA capable when longer than 4 bytes
+ * @param len Bytes to read
+ * @return ESP_OK on success
+ */
+esp_err_t st7789_bus_read(st7789_handle_t *handle, uint8_t cmd, uint8_t *rx, size_t len);
+
+#endif // ST7789_BUS_H
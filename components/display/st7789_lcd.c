@@ -0,0 +1,151 @@
+/**
+ * ST7789 esp_lcd Panel IO Backend
+ * The same controller commands through esp_lcd_panel_io_spi: parameters go
+ * out with esp_lcd_panel_io_tx_param, pixel data is queued with
+ * esp_lcd_panel_io_tx_color and completes through on_color_trans_done. On
+ * ESP32-S3 the panel IO feeds GDMA descriptor lists, so queued strips run
+ * back to back without the CPU. Color transfers carry no command (-1): the
+ * RAMWR sent by st7789_set_window stays open across them, which is what
+ * lets several be queued at once.
+ */
+
+#include "st7789.h"
+#include "st7789_bus.h"
+
+#if CONFIG_WATCHMAN_DISPLAY_BACKEND_ESP_LCD
+
+#include "esp_lcd_panel_io.h"
+#include "driver/spi_master.h"
+#include "soc/soc.h"
+#include "esp_attr.h"
+
+// Bytes on the wire for a pixel count
+#define PIXEL_BYTES(h, len) ((h)->pixel_format == ST7789_PIXEL_RGB444 ? (len) * 3 / 2 : (len) * 2)
+
+/**
+ * Color transfer done (SPI interrupt)
+ */
+static bool IRAM_ATTR color_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata,
+                                 void *user_ctx)
+{
+    st7789_handle_t *handle = user_ctx;
+    BaseType_t woken = pdFALSE;
+
+    handle->completed++;
+    xSemaphoreGiveFromISR(handle->done_sem, &woken);
+
+    bool yield = (woken == pdTRUE);
+    if (handle->done_cb && handle->done_cb(handle->done_arg)) {
+        yield = true;
+    }
+    return yield;
+}
+
+/**
+ * Create the panel IO at a clock
+ */
+esp_err_t st7789_bus_open(st7789_handle_t *handle, int spi_clock)
+{
+    if (handle->done_sem == NULL) {
+        handle->done_sem = xSemaphoreCreateBinaryStatic(&handle->done_sem_buf);
+    }
+
+    esp_lcd_panel_io_spi_config_t io_config = {
+        .cs_gpio_num = handle->pin_cs,
+        .dc_gpio_num = handle->pin_dc,
+        .spi_mode = 0,
+        .pclk_hz = spi_clock,
+        .trans_queue_depth = ST7789_QUEUE_DEPTH,
+        .on_color_trans_done = color_done,
+        .user_ctx = handle,
+        .lcd_cmd_bits = 8,
+        .lcd_param_bits = 8,
+    };
+
+    return esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)handle->spi_host, &io_config, &handle->io);
+}
+
+/**
+ * Delete the panel IO
+ */
+esp_err_t st7789_bus_close(st7789_handle_t *handle)
+{
+    if (handle->completed != handle->queued) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t ret = esp_lcd_panel_io_del(handle->io);
+    if (ret == ESP_OK) handle->io = NULL;
+    return ret;
+}
+
+/**
+ * Send command to ST7789
+ */
+void st7789_write_command(st7789_handle_t *handle, uint8_t cmd)
+{
+    esp_lcd_panel_io_tx_param(handle->io, cmd, NULL, 0);
+}
+
+/**
+ * Send data to ST7789 (parameters of the last command)
+ */
+void st7789_write_data(st7789_handle_t *handle, const uint8_t *data, size_t len)
+{
+    if (len == 0) return;
+
+    esp_lcd_panel_io_tx_param(handle->io, -1, data, len);
+}
+
+/**
+ * Write pixel data
+ */
+void st7789_write_pixels(st7789_handle_t *handle, const uint16_t *data, uint32_t len)
+{
+    if (st7789_write_pixels_dma(handle, data, len) == ESP_OK) {
+        st7789_wait_dma(handle);
+    }
+}
+
+/**
+ * Write pixel data using DMA
+ */
+esp_err_t st7789_write_pixels_dma(st7789_handle_t *handle, const uint16_t *data, uint32_t len)
+{
+    if (len == 0) return ESP_OK;
+
+    // Blocks only when every transaction in the panel IO pool is in flight
+    esp_err_t ret = esp_lcd_panel_io_tx_color(handle->io, -1, data, PIXEL_BYTES(handle, len));
+    if (ret == ESP_OK) handle->queued++;
+    return ret;
+}
+
+/**
+ * Wait for queued transfers
+ */
+esp_err_t st7789_wait_dma(st7789_handle_t *handle)
+{
+    while (handle->completed != handle->queued) {
+        xSemaphoreTake(handle->done_sem, portMAX_DELAY);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Read command (the panel IO holds CS between command and response)
+ */
+esp_err_t st7789_bus_read(st7789_handle_t *handle, uint8_t cmd, uint8_t *rx, size_t len)
+{
+    return esp_lcd_panel_io_rx_param(handle->io, cmd, rx, len);
+}
+
+/**
+ * Get actual SPI clock
+ * The panel IO keeps its SPI device private; the divider is the one
+ * spi_master picks for the requested clock
+ */
+int st7789_get_actual_clock(st7789_handle_t *handle)
+{
+    return spi_get_actual_clock(APB_CLK_FREQ, handle->spi_clock, 128);
+}
+
+#endif // CONFIG_WATCHMAN_DISPLAY_BACKEND_ESP_LCD
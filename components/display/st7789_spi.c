@@ -0,0 +1,230 @@
+/**
+ * ST7789 spi_master Backend
+ * Hand-built transactions: commands and parameters polled with D/C set by
+ * GPIO, pixel data queued from a ring of transactions whose results are
+ * collected lazily, so several transfers can be in flight
+ */
+
+#include <string.h>
+#include "st7789.h"
+#include "st7789_bus.h"
+
+#if !CONFIG_WATCHMAN_DISPLAY_BACKEND_ESP_LCD
+
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+
+// Bits on the wire per pixel
+#define PIXEL_BITS(h)       ((h)->pixel_format == ST7789_PIXEL_RGB444 ? 12 : 16)
+
+/**
+ * Send command to ST7789
+ */
+void st7789_write_command(st7789_handle_t *handle, uint8_t cmd)
+{
+    gpio_set_level(handle->pin_dc, 0);  // Command mode
+
+    spi_transaction_t trans = {
+        .length = 8,
+        .tx_buffer = &cmd,
+        .flags = SPI_TRANS_USE_TXDATA,
+    };
+    trans.tx_data[0] = cmd;
+
+    spi_device_polling_transmit(handle->spi, &trans);
+}
+
+/**
+ * Send data to ST7789
+ */
+void st7789_write_data(st7789_handle_t *handle, const uint8_t *data, size_t len)
+{
+    if (len == 0) return;
+
+    gpio_set_level(handle->pin_dc, 1);  // Data mode
+
+    spi_transaction_t trans = {
+        .length = len * 8,
+        .tx_buffer = data,
+    };
+
+    if (len <= 4) {
+        trans.flags = SPI_TRANS_USE_TXDATA;
+        memcpy(trans.tx_data, data, len);
+    }
+
+    spi_device_polling_transmit(handle->spi, &trans);
+}
+
+/**
+ * Transaction end (SPI interrupt for queued transfers, caller for polled ones)
+ * Only queued pixel transfers carry the handle
+ */
+static void IRAM_ATTR transfer_done(spi_transaction_t *trans)
+{
+    st7789_handle_t *handle = trans->user;
+    if (handle == NULL) return;
+
+    handle->completed++;
+    if (handle->done_cb && handle->done_cb(handle->done_arg)) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/**
+ * Add the panel to the SPI bus at a clock
+ */
+esp_err_t st7789_bus_open(st7789_handle_t *handle, int spi_clock)
+{
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = spi_clock,
+        .mode = 0,                          // SPI mode 0
+        .spics_io_num = handle->pin_cs,
+        .queue_size = ST7789_QUEUE_DEPTH,
+        .pre_cb = NULL,
+        .post_cb = transfer_done,
+        .flags = 0,  // No special flags - removed SPI_DEVICE_NO_DUMMY to fix multi-line/half-duplex conflict
+    };
+
+    return spi_bus_add_device(handle->spi_host, &devcfg, &handle->spi);
+}
+
+/**
+ * Take the results of finished transfers off the queue without blocking
+ */
+static void collect_done(st7789_handle_t *handle)
+{
+    spi_transaction_t *trans;
+
+    while (handle->collected != handle->queued &&
+           spi_device_get_trans_result(handle->spi, &trans, 0) == ESP_OK) {
+        handle->collected++;
+    }
+}
+
+/**
+ * Remove the panel from the SPI bus
+ */
+esp_err_t st7789_bus_close(st7789_handle_t *handle)
+{
+    // Uncollected results keep the device on the bus
+    collect_done(handle);
+    if (handle->collected != handle->queued) return ESP_ERR_INVALID_STATE;
+
+    return spi_bus_remove_device(handle->spi);
+}
+
+/**
+ * Write pixel data
+ */
+void st7789_write_pixels(st7789_handle_t *handle, const uint16_t *data, uint32_t len)
+{
+    if (len == 0) return;
+
+    gpio_set_level(handle->pin_dc, 1);  // Data mode
+
+    // ST7789 expects big-endian RGB565, ESP32 is little-endian
+    // Bytes are already swapped by caller (e.g., st7789_fill_rect)
+    spi_transaction_t trans = {
+        .length = len * PIXEL_BITS(handle),
+        .tx_buffer = data,
+        .flags = 0,  // Standard SPI mode
+    };
+
+    spi_device_polling_transmit(handle->spi, &trans);
+}
+
+/**
+ * Write pixel data using DMA
+ */
+esp_err_t st7789_write_pixels_dma(st7789_handle_t *handle, const uint16_t *data, uint32_t len)
+{
+    if (len == 0) return ESP_OK;
+
+    // A ring slot is free once the result of its last transfer is collected
+    collect_done(handle);
+    if (handle->queued - handle->collected >= ST7789_QUEUE_DEPTH) {
+        spi_transaction_t *done;
+        esp_err_t ret = spi_device_get_trans_result(handle->spi, &done, portMAX_DELAY);
+        if (ret != ESP_OK) return ret;
+        handle->collected++;
+    }
+
+    spi_transaction_t *trans = &handle->trans[handle->queued % ST7789_QUEUE_DEPTH];
+    memset(trans, 0, sizeof(*trans));
+    trans->length = len * PIXEL_BITS(handle);
+    trans->tx_buffer = data;
+    trans->user = handle;
+
+    gpio_set_level(handle->pin_dc, 1);  // Data mode
+
+    esp_err_t ret = spi_device_queue_trans(handle->spi, trans, portMAX_DELAY);
+    if (ret == ESP_OK) handle->queued++;
+    return ret;
+}
+
+/**
+ * Wait for queued transfers
+ */
+esp_err_t st7789_wait_dma(st7789_handle_t *handle)
+{
+    while (handle->collected != handle->queued) {
+        spi_transaction_t *trans;
+        esp_err_t ret = spi_device_get_trans_result(handle->spi, &trans, portMAX_DELAY);
+        if (ret != ESP_OK) return ret;
+        handle->collected++;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Read command with CS held low
+ */
+esp_err_t st7789_bus_read(st7789_handle_t *handle, uint8_t cmd, uint8_t *rx, size_t len)
+{
+    esp_err_t ret = spi_device_acquire_bus(handle->spi, portMAX_DELAY);
+    if (ret != ESP_OK) return ret;
+
+    gpio_set_level(handle->pin_dc, 0);  // Command mode
+
+    spi_transaction_t trans = {
+        .length = 8,
+        .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_CS_KEEP_ACTIVE,
+    };
+    trans.tx_data[0] = cmd;
+
+    ret = spi_device_polling_transmit(handle->spi, &trans);
+    if (ret == ESP_OK) {
+        spi_transaction_t in = {
+            .length = len * 8,
+            .rx_buffer = rx,
+        };
+        if (len <= 4) {
+            in.flags = SPI_TRANS_USE_RXDATA;
+        }
+
+        gpio_set_level(handle->pin_dc, 1);  // Data mode
+        ret = spi_device_polling_transmit(handle->spi, &in);
+        if (ret == ESP_OK && len <= 4) {
+            memcpy(rx, in.rx_data, len);
+        }
+    }
+
+    spi_device_release_bus(handle->spi);
+    return ret;
+}
+
+/**
+ * Get actual SPI clock
+ */
+int st7789_get_actual_clock(st7789_handle_t *handle)
+{
+    int khz = 0;
+    if (spi_device_get_actual_freq(handle->spi, &khz) != ESP_OK) return handle->spi_clock;
+
+    return khz * 1000;
+}
+
+#endif // !CONFIG_WATCHMAN_DISPLAY_BACKEND_ESP_LCD
@@ -0,0 +1,519 @@
+/**
+ * Golden Decode Checksums Implementation
+ */
+
+#include "golden.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "avi_parser.h"
+#include "jpeg_sw.h"
+#include "lz565.h"
+#include "crb.h"
+#include "pal8.h"
+#include "time_stretch.h"
+#include "simd.h"
+#include "luts.h"
+
+static const char *TAG = "GOLDEN";
+
+#define GOLDEN_VOLUME           80          // main.c's playback volume
+#define GOLDEN_STRETCH_RATE     384         // 1.5x in Q8
+#define GOLDEN_STRETCH_BLOCK    1024        // Samples per stretch call (AUDIO_BUFFER_SIZE)
+#define GOLDEN_PCM_CHUNK_MAX    16384       // Largest audio chunk, bytes
+
+/**
+ * File header, little-endian as on every target
+ * Followed by count records of a u64 frame hash and tiles_x * tiles_y u32
+ * tile hashes (PCM records are the hash alone)
+ */
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t mode;
+    uint8_t tile;               // Tile edge in output pixels, 0 for PCM
+    uint8_t reserved;
+    uint16_t width;             // Output size; channels and 0 for PCM
+    uint16_t height;
+    uint32_t count;
+} golden_header_t;
+
+/**
+ * Decode state of one pass over a clip
+ */
+typedef struct {
+    avi_parser_t avi;
+    golden_mode_t mode;
+    uint32_t codec;
+    jpeg_scale_t scale;
+
+    uint16_t width;             // Output size
+    uint16_t height;
+    uint32_t stride;            // Output row bytes
+    uint8_t tile;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+
+    jpeg_sw_t *jpeg;
+    uint16_t *out;              // Output frame (canvas for CRB)
+    uint16_t *mosaic;           // CRB JPEG tiles
+    uint32_t mosaic_pixels;
+    uint8_t *indices;           // PAL8 indices
+    uint16_t lut[PAL8_COLORS];
+
+    time_stretch_t *stretch;
+    int16_t *pcm;
+    int16_t *stretched;
+    size_t stretched_max;
+
+    uint64_t hash;              // Hash of the last frame or block
+    uint32_t *tile_hash;
+} golden_run_t;
+
+static const char *g_mode_names[GOLDEN_MODE_COUNT] = {
+    [GOLDEN_MODE_RGB565] = "rgb565",
+    [GOLDEN_MODE_RGB444] = "rgb444",
+    [GOLDEN_MODE_SCALE_1_2] = "scale2",
+    [GOLDEN_MODE_SCALE_1_4] = "scale4",
+    [GOLDEN_MODE_SCALE_1_8] = "scale8",
+    [GOLDEN_MODE_PCM] = "pcm",
+    [GOLDEN_MODE_PCM_STRETCH] = "pcm_x1.5",
+};
+
+static inline uint32_t rotl32(uint32_t x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline uint32_t fmix32(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85EBCA6B;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * Hash a buffer (murmur3 body and finalizer per lane)
+ */
+uint64_t golden_hash(const void *data, size_t size, uint64_t seed)
+{
+    const uint8_t *p = data;
+    uint32_t a = (uint32_t)seed ^ 0x9E3779B9;
+    uint32_t b = (uint32_t)(seed >> 32) ^ 0x7F4A7C15;
+    uint32_t k[2];
+    size_t n = size / 8;
+
+    for (size_t i = 0; i < n; i++, p += 8) {
+        memcpy(k, p, 8);
+        a ^= rotl32(k[0] * 0xCC9E2D51, 15) * 0x1B873593;
+        a = rotl32(a, 13) * 5 + 0xE6546B64;
+        b ^= rotl32(k[1] * 0x1B873593, 17) * 0xCC9E2D51;
+        b = rotl32(b, 15) * 5 + 0x561CCD1B;
+    }
+
+    size_t rest = size & 7;
+    if (rest) {
+        k[0] = k[1] = 0;
+        memcpy(k, p, rest);
+        a ^= rotl32(k[0] * 0xCC9E2D51, 15) * 0x1B873593;
+        b ^= rotl32(k[1] * 0x1B873593, 17) * 0xCC9E2D51;
+    }
+
+    a = fmix32(a ^ (uint32_t)size);
+    b = fmix32(b ^ (uint32_t)size);
+    a += b;
+    b += a;
+    return ((uint64_t)b << 32) | a;
+}
+
+const char *golden_mode_name(golden_mode_t mode)
+{
+    return (mode < GOLDEN_MODE_COUNT) ? g_mode_names[mode] : "unknown";
+}
+
+golden_mode_t golden_mode_find(const char *name)
+{
+    for (int m = 0; m < GOLDEN_MODE_COUNT; m++) {
+        if (strcmp(g_mode_names[m], name) == 0) return (golden_mode_t)m;
+    }
+    return GOLDEN_MODE_COUNT;
+}
+
+bool golden_mode_exact(golden_mode_t mode)
+{
+    return mode == GOLDEN_MODE_RGB565 || mode == GOLDEN_MODE_PCM;
+}
+
+/**
+ * Build golden file path
+ */
+void golden_path(const char *clip_path, golden_mode_t mode, char *path, size_t size)
+{
+    const char *slash = strrchr(clip_path, '/');
+    const char *dot = strrchr(clip_path, '.');
+    int len = (dot && (!slash || dot > slash)) ? (int)(dot - clip_path) : (int)strlen(clip_path);
+
+    snprintf(path, size, "%.*s.%s" GOLDEN_EXT, len, clip_path, golden_mode_name(mode));
+}
+
+static bool mode_is_pcm(golden_mode_t mode)
+{
+    return mode == GOLDEN_MODE_PCM || mode == GOLDEN_MODE_PCM_STRETCH;
+}
+
+/** Release a run */
+static void run_close(golden_run_t *run)
+{
+    avi_parser_close(&run->avi);
+    if (run->jpeg) jpeg_sw_destroy(run->jpeg);
+    if (run->stretch) time_stretch_destroy(run->stretch);
+    free(run->out);
+    free(run->mosaic);
+    free(run->indices);
+    free(run->pcm);
+    free(run->stretched);
+    free(run->tile_hash);
+    memset(run, 0, sizeof(*run));
+}
+
+/** Open a clip for one mode and allocate its buffers */
+static esp_err_t run_open(golden_run_t *run, const char *clip_path, golden_mode_t mode)
+{
+    memset(run, 0, sizeof(*run));
+    run->mode = mode;
+
+    if (mode >= GOLDEN_MODE_COUNT) return ESP_ERR_INVALID_ARG;
+    if (avi_parser_open(&run->avi, clip_path) != ESP_OK) return ESP_ERR_NOT_FOUND;
+
+    if (mode_is_pcm(mode)) {
+        const avi_audio_info_t *a = &run->avi.audio_info;
+        if (!a->found || a->format_tag != 1 || a->bits_per_sample != 16 ||
+            (mode == GOLDEN_MODE_PCM_STRETCH && a->channels != 1)) {
+            run_close(run);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+
+        run->width = a->channels;
+        run->pcm = malloc(GOLDEN_PCM_CHUNK_MAX);
+        if (mode == GOLDEN_MODE_PCM_STRETCH) {
+            run->stretch = time_stretch_create(a->samples_per_sec);
+            if (run->stretch) {
+                time_stretch_set_rate(run->stretch, GOLDEN_STRETCH_RATE);
+                run->stretched_max = time_stretch_max_output(run->stretch, GOLDEN_STRETCH_BLOCK);
+                run->stretched = malloc(run->stretched_max * sizeof(int16_t));
+            }
+        }
+        if (run->pcm == NULL || (mode == GOLDEN_MODE_PCM_STRETCH && run->stretched == NULL)) {
+            run_close(run);
+            return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+    }
+
+    const avi_video_info_t *v = &run->avi.video_info;
+    run->codec = v->compression;
+    bool mjpeg = (run->codec == FOURCC_MJPG);
+    if (!v->found || v->width == 0 || v->height == 0 ||
+        (!mjpeg && run->codec != FOURCC_L565 && run->codec != FOURCC_CRB1 && run->codec != FOURCC_PAL8) ||
+        (!mjpeg && mode != GOLDEN_MODE_RGB565)) {
+        run_close(run);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    run->scale = (mode >= GOLDEN_MODE_SCALE_1_2 && mode <= GOLDEN_MODE_SCALE_1_8)
+                     ? (jpeg_scale_t)(JPEG_SCALE_1_2 + (mode - GOLDEN_MODE_SCALE_1_2))
+                     : JPEG_SCALE_1_1;
+    run->width = (v->width + (1 << run->scale) - 1) >> run->scale;
+    run->height = (v->height + (1 << run->scale) - 1) >> run->scale;
+    run->stride = (mode == GOLDEN_MODE_RGB444) ? run->width * 3 / 2 : run->width * 2;
+    run->tile = GOLDEN_TILE >> run->scale;
+    run->tiles_x = (run->width + run->tile - 1) / run->tile;
+    run->tiles_y = (run->height + run->tile - 1) / run->tile;
+
+    // Zeroed: the CRB canvas starts black, as the player's frame buffer
+    run->out = calloc((uint32_t)v->width * v->height, sizeof(uint16_t));
+    run->tile_hash = malloc(run->tiles_x * run->tiles_y * sizeof(uint32_t));
+    if (run->out == NULL || run->tile_hash == NULL) {
+        run_close(run);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (mjpeg || run->codec == FOURCC_CRB1) {
+        run->jpeg = jpeg_sw_create();
+        if (run->jpeg == NULL) {
+            run_close(run);
+            return ESP_ERR_NO_MEM;
+        }
+        if (mode == GOLDEN_MODE_RGB444) {
+            jpeg_sw_set_pixel_format(run->jpeg, JPEG_PIXEL_RGB444);
+        }
+    }
+    if (run->codec == FOURCC_PAL8) {
+        run->indices = malloc((uint32_t)v->width * v->height);
+        if (run->indices == NULL) {
+            run_close(run);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+/** Decode one video frame into run->out */
+static esp_err_t decode_frame(golden_run_t *run, const mjpeg_frame_t *frame)
+{
+    uint32_t pixels = (uint32_t)run->width * run->height;
+    uint16_t w, h;
+    esp_err_t ret;
+
+    switch (run->codec) {
+    case FOURCC_MJPG:
+        ret = jpeg_sw_decode(run->jpeg, frame->data, frame->size, run->scale, run->out,
+                             (uint32_t)run->avi.video_info.width * run->avi.video_info.height, &w, &h);
+        if (ret == ESP_OK && (w != run->width || h != run->height)) ret = ESP_ERR_INVALID_SIZE;
+        return ret;
+
+    case FOURCC_L565:
+        return lz565_decode(frame->data, frame->size, (uint8_t *)run->out, pixels * sizeof(uint16_t));
+
+    case FOURCC_PAL8:
+        ret = pal8_decode(frame->data, frame->size, run->lut, run->indices, pixels, NULL);
+        if (ret == ESP_OK) pal8_expand(run->indices, run->lut, run->out, pixels);
+        return ret;
+
+    case FOURCC_CRB1: {
+        crb_frame_t crb;
+        uint64_t dirty = 0;
+
+        ret = crb_parse(frame->data, frame->size, &crb);
+        if (ret != ESP_OK) return ret;
+
+        if (crb.jpeg && crb.tile_count > 0) {
+            uint16_t mw, mh;
+            crb_mosaic_size(&crb, run->width, &mw, &mh);
+            if ((uint32_t)mw * mh > run->mosaic_pixels) {
+                free(run->mosaic);
+                run->mosaic_pixels = (uint32_t)mw * mh;
+                run->mosaic = malloc(run->mosaic_pixels * sizeof(uint16_t));
+                if (run->mosaic == NULL) {
+                    run->mosaic_pixels = 0;
+                    return ESP_ERR_NO_MEM;
+                }
+            }
+            ret = jpeg_sw_decode(run->jpeg, crb.payload, crb.payload_size, JPEG_SCALE_1_1,
+                                 run->mosaic, run->mosaic_pixels, &w, &h);
+            if (ret != ESP_OK) return ret;
+            if (w != mw || h != mh) return ESP_ERR_INVALID_SIZE;
+        }
+        return crb_apply(&crb, (crb.jpeg && crb.tile_count > 0) ? run->mosaic : NULL,
+                         run->out, run->width, run->height, &dirty);
+    }
+
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+/** Hash run->out as a whole and per tile */
+static void hash_frame(golden_run_t *run)
+{
+    const uint8_t *base = (const uint8_t *)run->out;
+    uint32_t tile_bytes = (run->mode == GOLDEN_MODE_RGB444) ? run->tile * 3 / 2 : run->tile * 2;
+
+    run->hash = golden_hash(base, (size_t)run->stride * run->height, 0);
+
+    for (uint32_t ty = 0; ty < run->tiles_y; ty++) {
+        uint32_t y0 = ty * run->tile;
+        uint32_t rows = (run->height - y0 < run->tile) ? run->height - y0 : run->tile;
+
+        for (uint32_t tx = 0; tx < run->tiles_x; tx++) {
+            uint32_t x0 = tx * tile_bytes;
+            uint32_t bytes = (run->stride - x0 < tile_bytes) ? run->stride - x0 : tile_bytes;
+            uint64_t h = 0;
+
+            for (uint32_t y = 0; y < rows; y++) {
+                h = golden_hash(base + (size_t)(y0 + y) * run->stride + x0, bytes, h);
+            }
+            run->tile_hash[ty * run->tiles_x + tx] = (uint32_t)(h ^ (h >> 32));
+        }
+    }
+}
+
+/** Process one audio chunk into run->hash */
+static esp_err_t next_block(golden_run_t *run)
+{
+    uint32_t bytes = 0;
+    esp_err_t ret = avi_parser_read_audio_chunk(&run->avi, (uint8_t *)run->pcm, GOLDEN_PCM_CHUNK_MAX, &bytes);
+    if (ret != ESP_OK) return ret;
+    if (bytes >= GOLDEN_PCM_CHUNK_MAX) return ESP_ERR_INVALID_SIZE;
+
+    size_t samples = bytes / sizeof(int16_t);
+    int16_t gain = lut_volume_q15[GOLDEN_VOLUME];
+
+    if (run->stretch == NULL) {
+        simd_scale_s16(run->pcm, samples, gain);
+        run->hash = golden_hash(run->pcm, samples * sizeof(int16_t), 0);
+        return ESP_OK;
+    }
+
+    // As audio_player_write: stretch in blocks, then the volume
+    run->hash = 0;
+    for (size_t i = 0; i < samples; i += GOLDEN_STRETCH_BLOCK) {
+        size_t n = (samples - i < GOLDEN_STRETCH_BLOCK) ? samples - i : GOLDEN_STRETCH_BLOCK;
+        size_t out_n = 0;
+
+        ret = time_stretch_process(run->stretch, run->pcm + i, n, run->stretched, run->stretched_max, &out_n);
+        if (ret != ESP_OK) return ret;
+        simd_scale_s16(run->stretched, out_n, gain);
+        run->hash = golden_hash(run->stretched, out_n * sizeof(int16_t), run->hash);
+    }
+    return ESP_OK;
+}
+
+/**
+ * Produce the next frame or PCM block
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND at the end of the clip
+ */
+static esp_err_t run_next(golden_run_t *run, uint32_t index)
+{
+    if (mode_is_pcm(run->mode)) return next_block(run);
+
+    mjpeg_frame_t frame;
+    esp_err_t ret = avi_parser_read_video_frame(&run->avi, &frame);
+    if (ret != ESP_OK) return ESP_ERR_NOT_FOUND;
+
+    ret = decode_frame(run, &frame);
+    avi_parser_free_frame(&frame);
+
+    if (ret != ESP_OK) {
+        // A frame the decoder rejects is recorded as hash 0, never a match
+        ESP_LOGW(TAG, "Frame %lu decode failed: %s", (unsigned long)index, esp_err_to_name(ret));
+        run->hash = 0;
+        memset(run->tile_hash, 0, run->tiles_x * run->tiles_y * sizeof(uint32_t));
+        return ESP_OK;
+    }
+
+    hash_frame(run);
+    return ESP_OK;
+}
+
+static uint32_t run_tiles(const golden_run_t *run)
+{
+    return mode_is_pcm(run->mode) ? 0 : run->tiles_x * run->tiles_y;
+}
+
+static void run_header(const golden_run_t *run, golden_header_t *hdr, uint32_t count)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = GOLDEN_MAGIC;
+    hdr->version = GOLDEN_VERSION;
+    hdr->mode = run->mode;
+    hdr->tile = mode_is_pcm(run->mode) ? 0 : run->tile;
+    hdr->width = run->width;
+    hdr->height = run->height;
+    hdr->count = count;
+}
+
+/**
+ * Record golden file
+ */
+esp_err_t golden_record(const char *clip_path, golden_mode_t mode, FILE *out, uint32_t *count)
+{
+    golden_run_t run;
+    golden_header_t hdr;
+    uint32_t n = 0;
+
+    esp_err_t ret = run_open(&run, clip_path, mode);
+    if (ret != ESP_OK) return ret;
+
+    // Count is filled in at the end
+    run_header(&run, &hdr, 0);
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, out) == 1;
+
+    while (ok && (ret = run_next(&run, n)) == ESP_OK) {
+        ok = fwrite(&run.hash, sizeof(run.hash), 1, out) == 1 &&
+             fwrite(run.tile_hash, sizeof(uint32_t), run_tiles(&run), out) == run_tiles(&run);
+        n++;
+    }
+
+    if (ok && ret == ESP_ERR_NOT_FOUND) {
+        run_header(&run, &hdr, n);
+        ok = fseek(out, 0, SEEK_SET) == 0 && fwrite(&hdr, sizeof(hdr), 1, out) == 1;
+        ret = ok ? ESP_OK : ESP_FAIL;
+    } else if (!ok) {
+        ret = ESP_FAIL;
+    }
+
+    run_close(&run);
+    if (count) *count = n;
+    return ret;
+}
+
+/**
+ * Compare with golden file
+ */
+esp_err_t golden_check(const char *clip_path, golden_mode_t mode, FILE *golden,
+                       golden_result_t *result)
+{
+    golden_run_t run;
+    golden_header_t hdr, want;
+    uint32_t *expect = NULL;
+
+    memset(result, 0, sizeof(*result));
+    result->first = result->tile_x = result->tile_y = GOLDEN_NONE;
+
+    esp_err_t ret = run_open(&run, clip_path, mode);
+    if (ret != ESP_OK) return ret;
+
+    run_header(&run, &want, 0);
+    if (fread(&hdr, sizeof(hdr), 1, golden) != 1 || hdr.magic != want.magic ||
+        hdr.version != want.version || hdr.mode != want.mode || hdr.tile != want.tile ||
+        hdr.width != want.width || hdr.height != want.height) {
+        run_close(&run);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    result->expected = hdr.count;
+
+    uint32_t tiles = run_tiles(&run);
+    if (tiles && (expect = malloc(tiles * sizeof(uint32_t))) == NULL) {
+        run_close(&run);
+        return ESP_ERR_NO_MEM;
+    }
+
+    while ((ret = run_next(&run, result->count)) == ESP_OK) {
+        uint32_t i = result->count++;
+        uint64_t hash;
+
+        if (i >= hdr.count) continue;
+        if (fread(&hash, sizeof(hash), 1, golden) != 1 ||
+            fread(expect, sizeof(uint32_t), tiles, golden) != tiles) {
+            ret = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        if (hash == run.hash) continue;
+
+        result->mismatches++;
+        if (result->first != GOLDEN_NONE) continue;
+
+        result->first = i;
+        for (uint32_t t = 0; t < tiles; t++) {
+            if (expect[t] == run.tile_hash[t]) continue;
+            if (result->tiles++ == 0) {
+                result->tile_x = t % run.tiles_x;
+                result->tile_y = t / run.tiles_x;
+            }
+        }
+    }
+
+    free(expect);
+    run_close(&run);
+    if (ret != ESP_ERR_NOT_FOUND) return ret;
+
+    if (result->count != result->expected && result->first == GOLDEN_NONE) {
+        result->first = (result->count < result->expected) ? result->count : result->expected;
+    }
+    return (result->first == GOLDEN_NONE) ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
@@ -0,0 +1,140 @@
+/**
+ * Golden Decode Checksums
+ * Bit-exact regression check of decoder output against stored hashes
+ *
+ * Every decoded frame and every PCM block of a reference clip is hashed
+ * with a 64-bit hash and compared with a golden file recorded from a known
+ * good build. Frames are also hashed per 16x16 tile (one MCU of 4:2:0
+ * content at full scale, scaled with the output), so a mismatch is reported
+ * as the first differing frame and MCU rather than just "changed".
+ *
+ * Each output mode has its own golden file, <clip>.<mode>.gld next to the
+ * clip. Exact modes (RGB565, PCM) must never change; approximate modes
+ * (dithered RGB444, reduced-scale decodes, time-stretched PCM) change
+ * whenever their rounding does, and are re-recorded deliberately.
+ *
+ * The same code runs in the host build (tools/host/golden.c) and on target
+ * (GOLDEN_MODE in main.c, report over UART), so a SIMD or IRAM change can be
+ * checked on the hardware it targets against goldens recorded on the host.
+ * Decoding goes through the in-tree decoders directly: jpeg_sw for MJPEG,
+ * whether or not mjpeg_decoder would pick esp_jpeg on the target.
+ */
+
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#define GOLDEN_MAGIC        0x444C4757  // "WGLD"
+#define GOLDEN_VERSION      1
+#define GOLDEN_TILE         16          // Tile edge at full scale, pixels
+#define GOLDEN_EXT          ".gld"
+#define GOLDEN_NONE         UINT32_MAX  // No mismatch / no tile
+
+/**
+ * Output mode, one golden file each
+ */
+typedef enum {
+    GOLDEN_MODE_RGB565 = 0,     // Full-scale RGB565 (every codec)
+    GOLDEN_MODE_RGB444,         // MJPEG straight to dithered RGB444
+    GOLDEN_MODE_SCALE_1_2,      // MJPEG trick-play decodes, RGB565
+    GOLDEN_MODE_SCALE_1_4,
+    GOLDEN_MODE_SCALE_1_8,
+    GOLDEN_MODE_PCM,            // Audio chunks at 80% volume
+    GOLDEN_MODE_PCM_STRETCH,    // Audio chunks time-stretched to 1.5x, 80% volume
+    GOLDEN_MODE_COUNT,
+} golden_mode_t;
+
+/**
+ * Result of a check
+ */
+typedef struct {
+    uint32_t count;             // Frames or PCM blocks produced
+    uint32_t expected;          // Frames or PCM blocks in the golden file
+    uint32_t mismatches;        // Differing frames or blocks
+    uint32_t first;             // First differing frame or block, GOLDEN_NONE if all match
+    uint32_t tile_x;            // First differing MCU of that frame, GOLDEN_NONE for PCM
+    uint32_t tile_y;
+    uint32_t tiles;             // Differing MCUs in that frame
+} golden_result_t;
+
+/**
+ * Hash a buffer
+ * Two 32-bit multiply-rotate lanes (ESP32 has no 64-bit multiplier), the
+ * same value on every little-endian target
+ *
+ * @param data Data
+ * @param size Size in bytes
+ * @param seed Seed (chain calls by passing the previous hash)
+ * @return 64-bit hash
+ */
+uint64_t golden_hash(const void *data, size_t size, uint64_t seed);
+
+/**
+ * Get mode name as used in golden file names
+ *
+ * @param mode Mode
+ * @return Name ("rgb565", "rgb444", "scale2", "scale4", "scale8", "pcm", "pcm_x1.5")
+ */
+const char *golden_mode_name(golden_mode_t mode);
+
+/**
+ * Find a mode by name
+ *
+ * @param name Mode name
+ * @return Mode, GOLDEN_MODE_COUNT if no such name
+ */
+golden_mode_t golden_mode_find(const char *name);
+
+/**
+ * Check whether a mode is bit-exact by design
+ *
+ * @param mode Mode
+ * @return false for dithered, scaled and time-stretched output
+ */
+bool golden_mode_exact(golden_mode_t mode);
+
+/**
+ * Build the golden file path of a clip
+ *
+ * @param clip_path Clip path
+ * @param mode Mode
+ * @param path Output path ("<clip without extension>.<mode>.gld")
+ * @param size Output capacity
+ */
+void golden_path(const char *clip_path, golden_mode_t mode, char *path, size_t size);
+
+/**
+ * Decode a clip and write its golden file
+ *
+ * @param clip_path AVI file
+ * @param mode Mode
+ * @param out Golden file, opened "wb"
+ * @param count Output frames or PCM blocks written (optional)
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the mode does not
+ *         apply to the clip (no audio, or a non-MJPEG codec for the MJPEG
+ *         modes), ESP_ERR_NOT_FOUND if the clip cannot be opened
+ */
+esp_err_t golden_record(const char *clip_path, golden_mode_t mode, FILE *out, uint32_t *count);
+
+/**
+ * Decode a clip and compare it with its golden file
+ * Decoding continues past mismatches, so the result counts all of them
+ *
+ * @param clip_path AVI file
+ * @param mode Mode
+ * @param golden Golden file, opened "rb"
+ * @param result Output result
+ * @return ESP_OK if every frame or block matches, ESP_ERR_INVALID_CRC on any
+ *         mismatch or count difference, ESP_ERR_INVALID_VERSION if the golden
+ *         file is not one for this mode and clip size, other errors as
+ *         golden_record()
+ */
+esp_err_t golden_check(const char *clip_path, golden_mode_t mode, FILE *golden,
+                       golden_result_t *result);
+
+#endif // GOLDEN_H
@@ -81,6 +81,19 @@ encoder_t *encoder_init(const encoder_config_t *config);
  */
 void encoder_deinit(encoder_t *encoder);
 
+/**
+ * Let the button wake the chip from automatic light sleep
+ * GPIO wakeup only works with level triggers, so while enabled the button
+ * interrupt is a level trigger re-armed for the opposite level on every
+ * change; press and release events are unchanged. Disabling restores the
+ * edge trigger.
+ *
+ * @param encoder Encoder handle
+ * @param enable true to wake on the button
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if there is no button pin
+ */
+esp_err_t encoder_set_wakeup(encoder_t *encoder, bool enable);
+
 /**
  * Get current encoder position
  *
@@ -36,6 +36,7 @@ struct encoder_s {
     uint64_t button_press_time;
     uint32_t long_press_threshold;
     bool long_press_fired;
+    volatile bool level_wakeup;     // Button on a level trigger for light sleep wakeup
 
     // Event queue
     QueueHandle_t event_queue;
@@ -109,6 +110,12 @@ static void IRAM_ATTR button_isr_handler(void *arg)
     uint64_t now = esp_timer_get_time();
     bool button_state = !gpio_get_level(encoder->config.pin_sw);  // Active low
 
+    // A level trigger fires for as long as the level holds: arm the
+    // opposite level, so it fires once per press and once per release
+    if (encoder->level_wakeup) {
+        gpio_set_intr_type(encoder->config.pin_sw, button_state ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    }
+
     if (button_state && !encoder->button_pressed) {
         // Button pressed
         encoder->button_pressed = true;
@@ -282,6 +289,31 @@ void encoder_deinit(encoder_t *encoder)
     ESP_LOGI(TAG, "Rotary encoder deinitialized");
 }
 
+/**
+ * Set button wakeup
+ */
+esp_err_t encoder_set_wakeup(encoder_t *encoder, bool enable)
+{
+    if (encoder == NULL || encoder->config.pin_sw < 0) return ESP_ERR_INVALID_ARG;
+
+    int pin = encoder->config.pin_sw;
+    esp_err_t ret;
+
+    gpio_intr_disable(pin);
+    if (enable) {
+        // Wake on whichever level the button changes to next
+        ret = gpio_wakeup_enable(pin, gpio_get_level(pin) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+        encoder->level_wakeup = (ret == ESP_OK);
+    } else {
+        encoder->level_wakeup = false;
+        gpio_wakeup_disable(pin);
+        ret = gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+    }
+    gpio_intr_enable(pin);
+
+    return ret;
+}
+
 /**
  * Get position
  */
@@ -0,0 +1,394 @@
+#!/usr/bin/env python3
+"""
+Lookup Table Generator
+
+Emits luts.h and luts.c: every table the firmware would otherwise build at
+startup or carry as hand-typed literals, computed here from its defining
+math. Run by the luts component (ESP-IDF build) and tools/host/CMakeLists.txt;
+tools/host/check_luts.c recomputes each table independently in C.
+
+Placement per table:
+  flash  const rodata, read through the flash cache, no RAM cost (default)
+  dram   DRAM_ATTR, for per-pixel tables that must not miss in the cache
+  hot    DRAM with CONFIG_WATCHMAN_HOT_CODE_IN_IRAM, else flash: tables read
+         by the code that option moves to IRAM
+  iram   IRAM_ATTR, 32-bit element types only (IRAM is word-addressed)
+
+Usage: gen_luts.py OUT_DIR
+"""
+
+import math
+import os
+import sys
+
+# ============================================================================
+# Table definitions
+# ============================================================================
+
+HUFF_LOOKAHEAD = 9
+
+# Standard Huffman tables (ITU-T T.81 Annex K.3) for AVI1 frames without DHT
+STD_HUFF = {
+    "dc_lum": ([0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0], list(range(12))),
+    "dc_chr": ([0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0], list(range(12))),
+    "ac_lum": ([0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D], [
+        0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+        0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+        0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+        0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+        0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+        0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+        0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+        0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+        0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+        0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+        0xF9, 0xFA,
+    ]),
+    "ac_chr": ([0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77], [
+        0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+        0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+        0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+        0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+        0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+        0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+        0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+        0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+        0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+        0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+        0xF9, 0xFA,
+    ]),
+}
+
+# BT.601 full-range chroma terms, Q14 with floor rounding (simd.h)
+CHROMA_Q14 = {
+    "cr_r": (22970, "R += 1.402 (Cr - 128)"),
+    "cb_b": (29032, "B += 1.772 (Cb - 128)"),
+    "cb_g": (-5638, "G -= 0.344 (Cb - 128)"),
+    "cr_g": (-11700, "G -= 0.714 (Cr - 128)"),
+}
+
+# islow IDCT constants, 13-bit (jpeg_sw.c)
+CONST_BITS = 13
+
+# Battery: 2S Li-ion, percentage linear in voltage (power_manager.h limits)
+BATTERY_EMPTY_MV = 6000
+BATTERY_FULL_MV = 8400
+BATTERY_STEP_MV = 8
+
+# Volume 0-100 as a Q15 gain, linear in amplitude
+VOLUME_STEPS = 101
+
+
+# ============================================================================
+# Table math
+# ============================================================================
+
+def huff_table(bits, vals):
+    """Lookahead and slow-path tables from BITS/HUFFVAL (canonical codes)"""
+    look_len = [0] * (1 << HUFF_LOOKAHEAD)
+    look_sym = [0] * (1 << HUFF_LOOKAHEAD)
+    maxcode = [0] * 18
+    valoffset = [0] * 17
+    code = 0
+    k = 0
+
+    for length in range(1, 17):
+        valoffset[length] = k - code
+        for _ in range(bits[length - 1]):
+            if length <= HUFF_LOOKAHEAD:
+                shift = HUFF_LOOKAHEAD - length
+                for j in range(1 << shift):
+                    look_len[(code << shift) + j] = length
+                    look_sym[(code << shift) + j] = vals[k]
+            k += 1
+            code += 1
+        maxcode[length] = code - 1 if bits[length - 1] else -1
+        code <<= 1
+
+    maxcode[17] = 0x7FFFFFFF    # Sentinel
+    return {
+        "look_len": look_len,
+        "look_sym": look_sym,
+        "maxcode": maxcode,
+        "valoffset": valoffset,
+        "vals": vals + [0] * (256 - len(vals)),
+    }
+
+
+def chroma_term(coef):
+    return [((i - 128) * coef) >> 14 for i in range(256)]
+
+
+def bayer(n):
+    """n x n ordered dither thresholds, recursive Bayer construction"""
+    if n == 1:
+        return [[0]]
+    m = bayer(n // 2)
+    h = n // 2
+    return [[4 * m[y % h][x % h] + [[0, 2], [3, 1]][y // h][x // h] for x in range(n)]
+            for y in range(n)]
+
+
+def zigzag():
+    """Zigzag scan position -> natural (row-major) index"""
+    order = sorted(((x + y, y if (x + y) % 2 else x, y * 8 + x)
+                    for y in range(8) for x in range(8)))
+    return [natural for _, _, natural in order]
+
+
+def idct_llm_matrix():
+    """
+    islow LL&M 1-D IDCT as a matrix: row i = response to input frequency i.
+    Runs the integer butterflies on unit inputs, so the matrix form is
+    bit-exact with them (they are linear before descaling).
+    """
+    fix = {
+        "0_298631336": 2446, "0_390180644": 3196, "0_541196100": 4433,
+        "0_765366865": 6270, "0_899976223": 7373, "1_175875602": 9633,
+        "1_501321110": 12299, "1_847759065": 15137, "1_961570560": 16069,
+        "2_053119869": 16819, "2_562915447": 20995, "3_072711026": 25172,
+    }
+    for name, value in fix.items():
+        assert value == int(float(name.replace("_", ".")) * (1 << CONST_BITS) + 0.5), name
+
+    def butterflies(x):
+        x0, x1, x2, x3, x4, x5, x6, x7 = x
+        z1 = (x2 + x6) * fix["0_541196100"]
+        tmp2 = z1 - x6 * fix["1_847759065"]
+        tmp3 = z1 + x2 * fix["0_765366865"]
+        tmp0 = (x0 + x4) << CONST_BITS
+        tmp1 = (x0 - x4) << CONST_BITS
+        tmp10, tmp13 = tmp0 + tmp3, tmp0 - tmp3
+        tmp11, tmp12 = tmp1 + tmp2, tmp1 - tmp2
+
+        tmp0, tmp1, tmp2, tmp3 = x7, x5, x3, x1
+        z1, z2, z3, z4 = tmp0 + tmp3, tmp1 + tmp2, tmp0 + tmp2, tmp1 + tmp3
+        z5 = (z3 + z4) * fix["1_175875602"]
+        tmp0 *= fix["0_298631336"]
+        tmp1 *= fix["2_053119869"]
+        tmp2 *= fix["3_072711026"]
+        tmp3 *= fix["1_501321110"]
+        z1 *= -fix["0_899976223"]
+        z2 *= -fix["2_562915447"]
+        z3 = z3 * -fix["1_961570560"] + z5
+        z4 = z4 * -fix["0_390180644"] + z5
+        tmp0 += z1 + z3
+        tmp1 += z2 + z4
+        tmp2 += z2 + z3
+        tmp3 += z1 + z4
+        return [tmp10 + tmp3, tmp11 + tmp2, tmp12 + tmp1, tmp13 + tmp0,
+                tmp13 - tmp0, tmp12 - tmp1, tmp11 - tmp2, tmp10 - tmp3]
+
+    return [butterflies([1 if k == i else 0 for k in range(8)]) for i in range(8)]
+
+
+def idct_reduced_matrix(n):
+    """N-point IDCT, Q13: C(u)/2 * cos((2x+1)u*pi/2N), [x][u]"""
+    def c(u):
+        return math.sqrt(0.5) if u == 0 else 1.0
+    return [[int(round(c(u) / 2 * math.cos((2 * x + 1) * u * math.pi / (2 * n)) * (1 << CONST_BITS)))
+             for u in range(n)] for x in range(n)]
+
+
+def battery_percent():
+    """Percentage at each step from empty to full; exact at every mV in between"""
+    span = BATTERY_FULL_MV - BATTERY_EMPTY_MV
+    table = [(mv - BATTERY_EMPTY_MV) * 100 // span
+             for mv in range(BATTERY_EMPTY_MV, BATTERY_FULL_MV + 1, BATTERY_STEP_MV)]
+    for mv in range(BATTERY_EMPTY_MV, BATTERY_FULL_MV + 1):
+        exact = (mv - BATTERY_EMPTY_MV) * 100 // span
+        assert table[(mv - BATTERY_EMPTY_MV) // BATTERY_STEP_MV] == exact, \
+            "BATTERY_STEP_MV must not skip a percentage boundary"
+    return table
+
+
+def volume_q15():
+    return [min(v * 32768 // 100, 32767) for v in range(VOLUME_STEPS)]
+
+
+# ============================================================================
+# C emission
+# ============================================================================
+
+C_TYPES = {
+    "uint8_t": 1, "int8_t": 1, "uint16_t": 2, "int16_t": 2, "uint32_t": 4, "int32_t": 4,
+}
+
+
+def c_values(values, indent, per_line):
+    """Flat or nested list as C initializer lines"""
+    if isinstance(values[0], list):
+        rows = []
+        for row in values:
+            rows.append(" " * indent + "{" + ", ".join(str(v) for v in row) + "},")
+        return "\n".join(rows)
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append(" " * indent + ", ".join(str(v) for v in values[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def dims(values):
+    if isinstance(values[0], list):
+        return "[%d][%d]" % (len(values), len(values[0]))
+    return "[%d]" % len(values)
+
+
+def placement(ctype, place, align):
+    attrs = []
+    if place == "dram":
+        attrs.append("DRAM_ATTR")
+    elif place == "hot":
+        attrs.append("LUT_HOT_ATTR")
+    elif place == "iram":
+        if C_TYPES[ctype] != 4:
+            raise SystemExit("IRAM tables need 32-bit elements (%s)" % ctype)
+        attrs.append("IRAM_ATTR")
+    elif place != "flash":
+        raise SystemExit("Unknown placement %s" % place)
+    if align:
+        attrs.append("__attribute__((aligned(%d)))" % align)
+    return (" " + " ".join(attrs)) if attrs else ""
+
+
+class Emitter:
+    def __init__(self):
+        self.decls = []
+        self.defs = []
+
+    def array(self, name, ctype, values, doc, place="flash", align=0, per_line=16):
+        d = dims(values)
+        self.decls.append("extern const %s %s%s;%s" % (ctype, name, d, "  // " + doc if doc else ""))
+        self.defs.append("const %s %s%s%s = {\n%s\n};\n" % (
+            ctype, name, d, placement(ctype, place, align), c_values(values, 4, per_line)))
+
+    def huff(self, name, table, doc, place="flash"):
+        self.decls.append("extern const lut_huff_t %s;%s" % (name, "  // " + doc if doc else ""))
+        fields = []
+        for field in ("look_len", "look_sym", "maxcode", "valoffset", "vals"):
+            fields.append("    .%s = {\n%s\n    }," % (field, c_values(table[field], 8, 16)))
+        self.defs.append("const lut_huff_t %s%s = {\n%s\n};\n" % (
+            name, placement("uint8_t", place, 0), "\n".join(fields)))
+
+
+HEADER = """/**
+ * Generated Lookup Tables
+ * Written by components/luts/gen_luts.py at build time, do not edit
+ *
+ * Tables the firmware would otherwise build at startup or carry as
+ * hand-typed literals. All are const; most stay in flash rodata, per-pixel
+ * ones are placed in DRAM, and the decoder's per-symbol tables follow the
+ * hot code into internal RAM with CONFIG_WATCHMAN_HOT_CODE_IN_IRAM.
+ * tools/host/check_luts recomputes every table from its reference math.
+ */
+
+#ifndef LUTS_H
+#define LUTS_H
+
+#include <stdint.h>
+
+#define LUT_HUFF_LOOKAHEAD      %(lookahead)d
+
+#define LUT_BATTERY_EMPTY_MV    %(empty)d
+#define LUT_BATTERY_FULL_MV     %(full)d
+#define LUT_BATTERY_STEP_MV     %(step)d
+
+/**
+ * Huffman table with lookahead: codes up to LUT_HUFF_LOOKAHEAD bits decode
+ * with one lookup, longer ones through maxcode/valoffset
+ */
+typedef struct {
+    uint8_t look_len[1 << LUT_HUFF_LOOKAHEAD];  // Code length, 0 = use slow path
+    uint8_t look_sym[1 << LUT_HUFF_LOOKAHEAD];
+    int32_t maxcode[18];                        // Largest code of each length, -1 if none
+    int32_t valoffset[17];                      // vals index = code + valoffset[len]
+    uint8_t vals[256];
+} lut_huff_t;
+
+%(decls)s
+
+#endif // LUTS_H
+"""
+
+SOURCE = """/**
+ * Generated Lookup Tables
+ * Written by components/luts/gen_luts.py at build time, do not edit
+ */
+
+#include "luts.h"
+
+#if defined(ESP_PLATFORM)
+#include "esp_attr.h"
+#include "sdkconfig.h"
+#else
+#define DRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#ifdef CONFIG_WATCHMAN_HOT_CODE_IN_IRAM
+#define LUT_HOT_ATTR    DRAM_ATTR
+#else
+#define LUT_HOT_ATTR
+#endif
+
+%(defs)s"""
+
+
+def generate():
+    e = Emitter()
+
+    for name, (bits, vals) in STD_HUFF.items():
+        e.huff("lut_huff_std_" + name, huff_table(bits, vals), None, place="hot")
+    e.decls.append("")
+
+    # Read per pixel by the JPEG color kernels
+    for name, (coef, doc) in CHROMA_Q14.items():
+        e.array("lut_" + name, "int16_t", chroma_term(coef), doc, place="dram")
+    e.decls.append("")
+
+    e.array("lut_bayer4", "uint8_t", bayer(4), "Ordered dither thresholds, 0-15", place="hot")
+    e.array("lut_zigzag", "uint8_t", zigzag(), "Zigzag position -> natural order", place="hot")
+    e.array("lut_idct_llm", "int16_t", idct_llm_matrix(),
+            "islow butterflies as a matrix, [input][output]", place="hot", align=16)
+    e.array("lut_idct4", "int16_t", idct_reduced_matrix(4), "Q13 4-point IDCT, [x][u]", place="hot")
+    e.array("lut_idct2", "int16_t", idct_reduced_matrix(2), "Q13 2-point IDCT, [x][u]", place="hot")
+    e.decls.append("")
+
+    e.array("lut_volume_q15", "int16_t", volume_q15(), "Volume 0-100 -> Q15 gain", per_line=11)
+    e.array("lut_battery_pct", "uint8_t", battery_percent(),
+            "Percentage per LUT_BATTERY_STEP_MV above empty", per_line=20)
+
+    header = HEADER % {
+        "lookahead": HUFF_LOOKAHEAD,
+        "empty": BATTERY_EMPTY_MV,
+        "full": BATTERY_FULL_MV,
+        "step": BATTERY_STEP_MV,
+        "decls": "\n".join(e.decls),
+    }
+    source = SOURCE % {"defs": "\n".join(e.defs)}
+    return header, source
+
+
+def write_if_changed(path, text):
+    """Leave unchanged files alone so dependents don't rebuild"""
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("Usage: gen_luts.py OUT_DIR")
+
+    out_dir = sys.argv[1]
+    os.makedirs(out_dir, exist_ok=True)
+    header, source = generate()
+    write_if_changed(os.path.join(out_dir, "luts.h"), header)
+    write_if_changed(os.path.join(out_dir, "luts.c"), source)
+
+
+if __name__ == "__main__":
+    main()
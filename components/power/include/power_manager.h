@@ -27,6 +27,11 @@
 #define AUTO_SLEEP_IDLE_MS      300000  // 5 minutes
 #define AUTO_DIM_IDLE_MS        120000  // 2 minutes
 
+// CPU clock per power profile (MHz)
+#define POWER_VIDEO_CPU_MHZ     240
+#define POWER_AUDIO_CPU_MHZ     80
+#define POWER_AUDIO_MIN_MHZ     40     // XTAL, while idle
+
 // Voltage divider ratio (R1=10k, R2=10k = 2:1 ratio)
 #define VOLTAGE_DIVIDER_RATIO   2.0f
 
@@ -52,6 +57,14 @@ typedef enum {
     POWER_STATE_DEEP_SLEEP,     // Deep sleep (longer wake)
 } power_state_t;
 
+/**
+ * Power profile
+ */
+typedef enum {
+    POWER_PROFILE_VIDEO,        // CPU fixed at 240 MHz, no automatic sleep
+    POWER_PROFILE_AUDIO,        // CPU at 80 MHz, scales down and light sleeps when idle
+} power_profile_t;
+
 /**
  * Power manager configuration
  */
@@ -154,6 +167,30 @@ esp_err_t power_manager_light_sleep(power_manager_t *pm, uint32_t duration_ms);
  */
 esp_err_t power_manager_deep_sleep(power_manager_t *pm, int wakeup_pin, uint32_t duration_ms);
 
+/**
+ * Select a power profile
+ * The audio profile lets the power management framework lower the clock
+ * and enter light sleep whenever every task is blocked. Drivers hold locks
+ * while they need the clocks, so I2S keeps APB at 80 MHz while it streams
+ * and light sleep only happens while audio is paused or stopped. GPIO
+ * wakeup is enabled for the audio profile; the pins that wake the chip are
+ * armed by their drivers (encoder_set_wakeup).
+ * Requires CONFIG_PM_ENABLE.
+ *
+ * @param pm Power manager handle
+ * @param profile Power profile
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED without CONFIG_PM_ENABLE
+ */
+esp_err_t power_manager_set_profile(power_manager_t *pm, power_profile_t profile);
+
+/**
+ * Get current power profile
+ *
+ * @param pm Power manager handle
+ * @return Current profile
+ */
+power_profile_t power_manager_get_profile(const power_manager_t *pm);
+
 /**
  * Set battery level change callback
  *
@@ -5,12 +5,15 @@
  */
 
 #include "power_manager.h"
+#include "luts.h"
+#include "dlog.h"
 #include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_sleep.h"
+#include "esp_pm.h"
 #include "esp_timer.h"
 #include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_cali.h"
@@ -23,6 +26,11 @@ static const char *TAG = "POWER_MGR";
 #define ADC_CHANNEL         ADC_CHANNEL_6    // GPIO34
 #define VOLTAGE_SAMPLES     10               // Average over multiple samples
 
+// The percentage curve is generated for these limits (gen_luts.py)
+_Static_assert(LUT_BATTERY_EMPTY_MV == BATTERY_VOLTAGE_EMPTY &&
+               LUT_BATTERY_FULL_MV == BATTERY_VOLTAGE_FULL,
+               "gen_luts.py battery limits differ from power_manager.h");
+
 /**
  * Power manager structure
  */
@@ -34,6 +42,7 @@ struct power_manager_s {
     uint32_t battery_voltage_mv;
     battery_level_t battery_level;
     power_state_t state;
+    power_profile_t profile;
 
     uint64_t last_activity_time;
     bool auto_sleep_enabled;
@@ -57,11 +66,7 @@ static uint8_t voltage_to_percentage(uint32_t voltage_mv)
         return 0;
     }
 
-    // Linear interpolation between empty and full
-    uint32_t range = BATTERY_VOLTAGE_FULL - BATTERY_VOLTAGE_EMPTY;
-    uint32_t value = voltage_mv - BATTERY_VOLTAGE_EMPTY;
-
-    return (value * 100) / range;
+    return lut_battery_pct[(voltage_mv - BATTERY_VOLTAGE_EMPTY) / LUT_BATTERY_STEP_MV];
 }
 
 /**
@@ -391,12 +396,62 @@ esp_err_t power_manager_deep_sleep(power_manager_t *pm, int wakeup_pin, uint32_t
         esp_sleep_enable_ext0_wakeup(wakeup_pin, 0);  // Wake on LOW
     }
 
+    // Print deferred log records before RAM is lost
+    dlog_flush();
+
     // Enter deep sleep (will not return)
     esp_deep_sleep_start();
 
     return ESP_OK;  // Never reached
 }
 
+/**
+ * Set power profile
+ */
+esp_err_t power_manager_set_profile(power_manager_t *pm, power_profile_t profile)
+{
+    if (!pm) return ESP_ERR_INVALID_ARG;
+
+#if CONFIG_PM_ENABLE
+    bool audio = (profile == POWER_PROFILE_AUDIO);
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = audio ? POWER_AUDIO_CPU_MHZ : POWER_VIDEO_CPU_MHZ,
+        .min_freq_mhz = audio ? POWER_AUDIO_MIN_MHZ : POWER_VIDEO_CPU_MHZ,
+        .light_sleep_enable = audio,
+    };
+
+    // Input must still wake the chip once it sleeps on its own; drivers
+    // arm their pins (encoder_set_wakeup)
+    if (audio) {
+        esp_sleep_enable_gpio_wakeup();
+    }
+
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure power management: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    pm->profile = profile;
+    ESP_LOGI(TAG, "Power profile: %s (%d-%d MHz%s)", audio ? "audio" : "video",
+             pm_config.min_freq_mhz, pm_config.max_freq_mhz,
+             audio ? ", light sleep" : "");
+
+    return ESP_OK;
+#else
+    ESP_LOGW(TAG, "Power profiles need CONFIG_PM_ENABLE");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * Get power profile
+ */
+power_profile_t power_manager_get_profile(const power_manager_t *pm)
+{
+    return pm ? pm->profile : POWER_PROFILE_VIDEO;
+}
+
 /**
  * Set callback
  */
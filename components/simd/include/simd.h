@@ -0,0 +1,112 @@
+/**
+ * SIMD Kernels
+ * Hot inner loops with ESP32-S3 PIE (128-bit vector) implementations
+ *
+ * Each kernel has a scalar version that defines its exact result. On S3
+ * builds the PIE versions are checked against the scalar ones on first use
+ * and only enabled if every kernel matches bit for bit; ESP32 builds and the
+ * host always run the scalar versions.
+ *
+ * Kernels work on 16-bit lanes, so their arithmetic is defined to fit them:
+ * gains are Q15, color coefficients Q14 with floor rounding, and the IDCT is
+ * the integer islow transform written as an 8x8 integer matrix (exact,
+ * because its butterflies are linear before descaling).
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Chroma sampling of one row of 8 pixels
+ */
+typedef enum {
+    SIMD_CHROMA_NONE = 0,   // Grayscale, chroma pointers unused
+    SIMD_CHROMA_FULL,       // 8 chroma samples (4:4:4)
+    SIMD_CHROMA_HALF,       // 4 chroma samples, one per pixel pair (4:2:2, 4:2:0)
+} simd_chroma_t;
+
+/**
+ * Check whether the PIE kernels are usable
+ * Runs the self-test on first call
+ *
+ * @return true on S3 builds whose PIE kernels match the scalar versions
+ */
+bool simd_available(void);
+
+/**
+ * Enable or disable the PIE kernels (enabled by default when available)
+ * Results are identical either way; disabling is for benchmarking
+ *
+ * @param enable true to use PIE when available
+ */
+void simd_set_enabled(bool enable);
+
+/**
+ * Check whether the PIE kernels are in use
+ *
+ * @return true if available and enabled
+ */
+bool simd_enabled(void);
+
+/**
+ * Scale 16-bit samples in place: s = (s * gain) >> 15
+ *
+ * @param samples Samples
+ * @param count Sample count
+ * @param gain_q15 Gain, 0-32767 (Q15)
+ */
+void simd_scale_s16(int16_t *samples, size_t count, int16_t gain_q15);
+
+/**
+ * Compare two buffers
+ *
+ * @param a First buffer
+ * @param b Second buffer
+ * @param bytes Length in bytes
+ * @return true if identical
+ */
+bool simd_equal(const void *a, const void *b, size_t bytes);
+
+/**
+ * Convert 8 pixels of YCbCr to big-endian RGB565 (BT.601 full range, Q14)
+ * PIE needs y 8-byte aligned, chroma 8-byte (FULL) or 4-byte (HALF)
+ * aligned and out 16-byte aligned; other pointers take the scalar path
+ *
+ * @param y 8 luma samples
+ * @param cb Cb samples (8, 4 or none per chroma)
+ * @param cr Cr samples
+ * @param chroma Chroma sampling
+ * @param out 16 output bytes
+ */
+void simd_ycc_row8_rgb565(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                          simd_chroma_t chroma, uint8_t *out);
+
+// Largest sum of |coefficient| for which the IDCT's 16-bit intermediate
+// rows cannot overflow (11363 * sum / 2048 < 32768)
+#define SIMD_IDCT_MAX_ABS_SUM   5900
+
+/**
+ * Full 8x8 islow IDCT, bit-exact with the LL&M implementation in jpeg_sw
+ * The sum of |coef| must not exceed SIMD_IDCT_MAX_ABS_SUM; real frames stay
+ * far below it, callers take their own IDCT for the rare block that doesn't
+ * PIE needs coef and out 16-byte aligned
+ *
+ * @param coef Dequantized coefficients, natural order
+ * @param out 64 samples, stride 8
+ */
+void simd_idct_8x8(const int32_t *coef, uint8_t *out);
+
+/**
+ * Scalar color conversion terms, shared with the LUT-based JPEG kernels
+ * so every path produces the same pixels
+ */
+static inline int simd_cr_r(int cr) { return ((cr - 128) * 22970) >> 14; }
+static inline int simd_cb_b(int cb) { return ((cb - 128) * 29032) >> 14; }
+static inline int simd_cb_g(int cb) { return ((cb - 128) * -5638) >> 14; }
+static inline int simd_cr_g(int cr) { return ((cr - 128) * -11700) >> 14; }
+
+#endif // SIMD_H
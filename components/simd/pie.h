@@ -0,0 +1,179 @@
+/**
+ * PIE Instruction Layer
+ * One macro per ESP32-S3 PIE instruction used by simd_pie.c
+ *
+ * On S3 each macro is a single inline-asm instruction on a fixed q register
+ * (q0-q7 are never allocated by the compiler, so values carry across
+ * statements). With SIMD_PIE_EMULATE the same kernels run on the host
+ * against a C model of the registers, which is how the lane arithmetic is
+ * checked against the scalar kernels without hardware. The model asserts
+ * alignment, and that VMUL results fit 16 bits, so nothing depends on
+ * saturation or wraparound details.
+ *
+ * Register arguments are plain digits: PIE_VMUL(2, 0, 1) is
+ * "ee.vmul.s16 q2, q0, q1". SAR is shared with the compiler's variable
+ * shifts, so it is set right before each group that uses it.
+ */
+
+#ifndef PIE_H
+#define PIE_H
+
+#include <stdint.h>
+
+#if SIMD_PIE_EMULATE
+
+#include <assert.h>
+#include <string.h>
+
+typedef union {
+    uint8_t u8[16];
+    int16_t s16[8];
+    uint32_t u32[4];
+} pie_vec_t;
+
+static pie_vec_t pie_q[8];
+static int64_t pie_qacc[8];     // 40-bit accumulators per 16-bit lane
+static uint32_t pie_sar;
+
+static inline int16_t pie_sat16(int64_t v)
+{
+    return (v > 32767) ? 32767 : (v < -32768) ? -32768 : (int16_t)v;
+}
+
+static inline void pie_load(pie_vec_t *q, const void *p, int bytes)
+{
+    assert(((uintptr_t)p & (bytes - 1)) == 0);
+    memcpy(q->u8, p, bytes);
+}
+
+static inline void pie_store(const pie_vec_t *q, void *p, int bytes)
+{
+    assert(((uintptr_t)p & (bytes - 1)) == 0);
+    memcpy(p, q->u8, bytes);
+}
+
+static inline void pie_bcast(pie_vec_t *q, const void *p, int bytes)
+{
+    assert(((uintptr_t)p & (bytes - 1)) == 0);
+    for (int i = 0; i < 16; i += bytes) memcpy(&q->u8[i], p, bytes);
+}
+
+static inline void pie_vmul(pie_vec_t *z, const pie_vec_t *x, const pie_vec_t *y)
+{
+    pie_vec_t r;
+    for (int i = 0; i < 8; i++) {
+        int32_t v = ((int32_t)x->s16[i] * y->s16[i]) >> pie_sar;
+        assert(v >= -32768 && v <= 32767);
+        r.s16[i] = (int16_t)v;
+    }
+    *z = r;
+}
+
+/**
+ * Interleave a and b by element: a gets the low halves, b the high halves
+ */
+static inline void pie_zip(pie_vec_t *a, pie_vec_t *b, int size)
+{
+    pie_vec_t lo, hi;
+    int n = 16 / size;
+    for (int i = 0; i < n / 2; i++) {
+        memcpy(&lo.u8[(2 * i) * size], &a->u8[i * size], size);
+        memcpy(&lo.u8[(2 * i + 1) * size], &b->u8[i * size], size);
+        memcpy(&hi.u8[(2 * i) * size], &a->u8[(i + n / 2) * size], size);
+        memcpy(&hi.u8[(2 * i + 1) * size], &b->u8[(i + n / 2) * size], size);
+    }
+    *a = lo;
+    *b = hi;
+}
+
+/**
+ * Inverse of pie_zip: a gets the even elements of a:b, b the odd ones
+ */
+static inline void pie_unzip(pie_vec_t *a, pie_vec_t *b, int size)
+{
+    pie_vec_t ev, od;
+    int n = 16 / size;
+    for (int i = 0; i < n; i++) {
+        const pie_vec_t *src = (i < n / 2) ? a : b;
+        int j = (i % (n / 2)) * 2;
+        memcpy(&ev.u8[i * size], &src->u8[j * size], size);
+        memcpy(&od.u8[i * size], &src->u8[(j + 1) * size], size);
+    }
+    *a = ev;
+    *b = od;
+}
+
+#define PIE_LANES(z, expr) do {                                         \
+        pie_vec_t r_;                                                   \
+        for (int i = 0; i < 8; i++) r_.s16[i] = (expr);                 \
+        pie_q[z] = r_;                                                  \
+    } while (0)
+
+#define PIE_WORDS(z, expr) do {                                         \
+        pie_vec_t r_;                                                   \
+        for (int i = 0; i < 4; i++) r_.u32[i] = (expr);                 \
+        pie_q[z] = r_;                                                  \
+    } while (0)
+
+#define PIE_SET_SAR(n)          (pie_sar = (n))
+#define PIE_ZERO(q)             memset(&pie_q[q], 0, sizeof(pie_vec_t))
+#define PIE_ZERO_QACC()         memset(pie_qacc, 0, sizeof(pie_qacc))
+#define PIE_LD128(q, p)         do { pie_load(&pie_q[q], (p), 16); (p) += 16 / sizeof(*(p)); } while (0)
+#define PIE_LD64(q, p)          do { pie_load(&pie_q[q], (p), 8); (p) += 8 / sizeof(*(p)); } while (0)
+#define PIE_ST128(q, p)         do { pie_store(&pie_q[q], (p), 16); (p) += 16 / sizeof(*(p)); } while (0)
+#define PIE_ST64(q, p)          do { pie_store(&pie_q[q], (p), 8); (p) += 8 / sizeof(*(p)); } while (0)
+#define PIE_BCAST16(q, p)       pie_bcast(&pie_q[q], (p), 2)
+#define PIE_BCAST32(q, p)       pie_bcast(&pie_q[q], (p), 4)
+#define PIE_VMUL(z, x, y)       pie_vmul(&pie_q[z], &pie_q[x], &pie_q[y])
+#define PIE_VADDS(z, x, y)      PIE_LANES(z, pie_sat16((int32_t)pie_q[x].s16[i] + pie_q[y].s16[i]))
+#define PIE_VSUBS(z, x, y)      PIE_LANES(z, pie_sat16((int32_t)pie_q[x].s16[i] - pie_q[y].s16[i]))
+#define PIE_VMAX(z, x, y)       PIE_LANES(z, pie_q[x].s16[i] > pie_q[y].s16[i] ? pie_q[x].s16[i] : pie_q[y].s16[i])
+#define PIE_VMIN(z, x, y)       PIE_LANES(z, pie_q[x].s16[i] < pie_q[y].s16[i] ? pie_q[x].s16[i] : pie_q[y].s16[i])
+#define PIE_AND(z, x, y)        PIE_WORDS(z, pie_q[x].u32[i] & pie_q[y].u32[i])
+#define PIE_OR(z, x, y)         PIE_WORDS(z, pie_q[x].u32[i] | pie_q[y].u32[i])
+#define PIE_XOR(z, x, y)        PIE_WORDS(z, pie_q[x].u32[i] ^ pie_q[y].u32[i])
+#define PIE_SL32(z, x)          PIE_WORDS(z, pie_q[x].u32[i] << pie_sar)
+#define PIE_SR32(z, x)          PIE_WORDS(z, (uint32_t)((int32_t)pie_q[x].u32[i] >> pie_sar))
+#define PIE_ZIP8(a, b)          pie_zip(&pie_q[a], &pie_q[b], 1)
+#define PIE_ZIP16(a, b)         pie_zip(&pie_q[a], &pie_q[b], 2)
+#define PIE_UNZIP8(a, b)        pie_unzip(&pie_q[a], &pie_q[b], 1)
+#define PIE_MOVI32(q, v, sel)   ((v) = pie_q[q].u32[sel])
+#define PIE_MULAS(x, y)         do {                                    \
+        for (int i = 0; i < 8; i++) pie_qacc[i] += (int32_t)pie_q[x].s16[i] * pie_q[y].s16[i]; \
+    } while (0)
+#define PIE_SRCMB(z, shift)     PIE_LANES(z, pie_sat16(pie_qacc[i] >> (shift)))
+
+#else // S3 hardware
+
+#define PIE_STR_(x)             #x
+#define PIE_Q(n)                "q" PIE_STR_(n)
+
+#define PIE_SET_SAR(n)          __asm__ volatile("wsr.sar %0" :: "r"(n))
+#define PIE_ZERO(q)             __asm__ volatile("ee.zero.q " PIE_Q(q))
+#define PIE_ZERO_QACC()         __asm__ volatile("ee.zero.qacc")
+#define PIE_LD128(q, p)         __asm__ volatile("ee.vld.128.ip " PIE_Q(q) ", %0, 16" : "+r"(p) :: "memory")
+#define PIE_LD64(q, p)          __asm__ volatile("ee.vld.l.64.ip " PIE_Q(q) ", %0, 8" : "+r"(p) :: "memory")
+#define PIE_ST128(q, p)         __asm__ volatile("ee.vst.128.ip " PIE_Q(q) ", %0, 16" : "+r"(p) :: "memory")
+#define PIE_ST64(q, p)          __asm__ volatile("ee.vst.l.64.ip " PIE_Q(q) ", %0, 8" : "+r"(p) :: "memory")
+#define PIE_BCAST16(q, p)       __asm__ volatile("ee.vldbc.16 " PIE_Q(q) ", %0" :: "r"(p) : "memory")
+#define PIE_BCAST32(q, p)       __asm__ volatile("ee.vldbc.32 " PIE_Q(q) ", %0" :: "r"(p) : "memory")
+#define PIE_VMUL(z, x, y)       __asm__ volatile("ee.vmul.s16 " PIE_Q(z) ", " PIE_Q(x) ", " PIE_Q(y))
+#define PIE_VADDS(z, x, y)      __asm__ volatile("ee.vadds.s16 " PIE_Q(z) ", " PIE_Q(x) ", " PIE_Q(y))
+#define PIE_VSUBS(z, x, y)      __asm__ volatile("ee.vsubs.s16 " PIE_Q(z) ", " PIE_Q(x) ", " PIE_Q(y))
+#define PIE_VMAX(z, x, y)       __asm__ volatile("ee.vmax.s16 " PIE_Q(z) ", " PIE_Q(x) ", " PIE_Q(y))
+#define PIE_VMIN(z, x, y)       __asm__ volatile("ee.vmin.s16 " PIE_Q(z) ", " PIE_Q(x) ", " PIE_Q(y))
+#define PIE_AND(z, x, y)        __asm__ volatile("ee.andq " PIE_Q(z) ", " PIE_Q(x) ", " PIE_Q(y))
+#define PIE_OR(z, x, y)         __asm__ volatile("ee.orq " PIE_Q(z) ", " PIE_Q(x) ", " PIE_Q(y))
+#define PIE_XOR(z, x, y)        __asm__ volatile("ee.xorq " PIE_Q(z) ", " PIE_Q(x) ", " PIE_Q(y))
+#define PIE_SL32(z, x)          __asm__ volatile("ee.vsl.32 " PIE_Q(z) ", " PIE_Q(x))
+#define PIE_SR32(z, x)          __asm__ volatile("ee.vsr.32 " PIE_Q(z) ", " PIE_Q(x))
+#define PIE_ZIP8(a, b)          __asm__ volatile("ee.vzip.8 " PIE_Q(a) ", " PIE_Q(b))
+#define PIE_ZIP16(a, b)         __asm__ volatile("ee.vzip.16 " PIE_Q(a) ", " PIE_Q(b))
+#define PIE_UNZIP8(a, b)        __asm__ volatile("ee.vunzip.8 " PIE_Q(a) ", " PIE_Q(b))
+#define PIE_MOVI32(q, v, sel)   __asm__ volatile("ee.movi.32.a " PIE_Q(q) ", %0, " PIE_STR_(sel) : "=r"(v))
+#define PIE_MULAS(x, y)         __asm__ volatile("ee.vmulas.s16.qacc " PIE_Q(x) ", " PIE_Q(y))
+#define PIE_SRCMB(z, shift)     __asm__ volatile("ee.srcmb.s16.qacc " PIE_Q(z) ", %0, 0" :: "r"(shift))
+
+#endif
+
+#endif // PIE_H
@@ -0,0 +1,327 @@
+/**
+ * SIMD Kernels Implementation
+ *
+ * The scalar kernels here define every result. Public entry points hand the
+ * aligned bulk of the work to the PIE kernels in simd_pie.c and finish
+ * unaligned heads and tails with the scalar code. Before PIE is first used,
+ * a self-test runs each PIE kernel on pseudo-random input (including the
+ * range limits) and compares it with the scalar kernel; any difference
+ * keeps the whole module scalar.
+ */
+
+#include "simd.h"
+#include "simd_pie.h"
+#include <string.h>
+#include "esp_log.h"
+
+static const char *TAG = "SIMD";
+
+typedef enum {
+    PIE_UNCHECKED = 0,
+    PIE_USABLE,
+    PIE_UNUSABLE,           // Not on this target, or the self-test failed
+} pie_state_t;
+
+static pie_state_t g_pie = PIE_UNCHECKED;
+static bool g_enabled = true;
+static bool g_use_pie = false;      // Self-test passed and enabled
+
+// ============================================================================
+// Scalar kernels
+// ============================================================================
+
+static inline uint8_t clamp_u8(int32_t v)
+{
+    return (v < 0) ? 0 : (v > 255) ? 255 : v;
+}
+
+static void scale_s16_scalar(int16_t *samples, size_t count, int16_t gain_q15)
+{
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = ((int32_t)samples[i] * gain_q15) >> 15;
+    }
+}
+
+static void ycc_row8_scalar(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                            simd_chroma_t chroma, uint8_t *out)
+{
+    for (int x = 0; x < 8; x++) {
+        int r = y[x], g = y[x], b = y[x];
+
+        if (chroma != SIMD_CHROMA_NONE) {
+            int ci = (chroma == SIMD_CHROMA_HALF) ? x >> 1 : x;
+            r += simd_cr_r(cr[ci]);
+            g += simd_cb_g(cb[ci]) + simd_cr_g(cr[ci]);
+            b += simd_cb_b(cb[ci]);
+        }
+
+        r = clamp_u8(r);
+        g = clamp_u8(g);
+        b = clamp_u8(b);
+        out[x * 2] = (r & 0xF8) | (g >> 5);
+        out[x * 2 + 1] = ((g << 3) & 0xE0) | (b >> 3);
+    }
+}
+
+/**
+ * Same descaling as islow: pass 1 keeps PASS1_BITS (2) fraction bits,
+ * pass 2 removes them plus CONST_BITS and the 1/8 normalization
+ */
+static void idct_8x8_scalar(const int32_t *coef, uint8_t *out)
+{
+    int32_t ws[64];
+
+    for (int c = 0; c < 8; c++) {
+        for (int k = 0; k < 8; k++) {
+            int32_t acc = 1 << 10;
+            for (int i = 0; i < 8; i++) acc += coef[i * 8 + c] * lut_idct_llm[i][k];
+            ws[k * 8 + c] = acc >> 11;
+        }
+    }
+
+    for (int r = 0; r < 8; r++) {
+        for (int x = 0; x < 8; x++) {
+            int32_t acc = 1 << 17;
+            for (int u = 0; u < 8; u++) acc += ws[r * 8 + u] * lut_idct_llm[u][x];
+            out[r * 8 + x] = clamp_u8((acc >> 18) + 128);
+        }
+    }
+}
+
+// ============================================================================
+// Self-test
+// ============================================================================
+
+#if SIMD_HAVE_PIE
+
+static uint32_t g_rng = 0x12345678;
+
+static uint32_t rng_next(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static bool test_scale(void)
+{
+    static const int16_t gains[] = {0, 1, 16384, 26214, 32767};
+    int16_t ref[64] __attribute__((aligned(16)));
+    int16_t vec[64] __attribute__((aligned(16)));
+
+    for (size_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++) {
+        for (int i = 0; i < 64; i++) ref[i] = (int16_t)rng_next();
+        ref[0] = -32768;
+        ref[1] = 32767;
+        memcpy(vec, ref, sizeof(vec));
+
+        scale_s16_scalar(ref, 64, gains[g]);
+        simd_pie_scale_s16(vec, 64, gains[g]);
+        if (memcmp(ref, vec, sizeof(vec)) != 0) return false;
+    }
+    return true;
+}
+
+static bool test_equal(void)
+{
+    uint8_t a[256] __attribute__((aligned(16)));
+    uint8_t b[256] __attribute__((aligned(16)));
+
+    for (int i = 0; i < 256; i++) a[i] = rng_next();
+    memcpy(b, a, sizeof(b));
+    if (!simd_pie_equal(a, b, sizeof(a))) return false;
+
+    for (int i = 0; i < 16; i++) {
+        int pos = (i < 2) ? i * 255 : (int)(rng_next() & 255);
+        uint8_t bit = 1 << (rng_next() & 7);
+
+        b[pos] ^= bit;
+        bool same = simd_pie_equal(a, b, sizeof(a));
+        b[pos] ^= bit;
+        if (same) return false;
+    }
+    return true;
+}
+
+static bool test_ycc(void)
+{
+    uint8_t y[8] __attribute__((aligned(16)));
+    uint8_t cb[8] __attribute__((aligned(16)));
+    uint8_t cr[8] __attribute__((aligned(16)));
+    uint8_t vec[16] __attribute__((aligned(16)));
+    uint8_t ref[16];
+
+    for (int chroma = SIMD_CHROMA_NONE; chroma <= SIMD_CHROMA_HALF; chroma++) {
+        for (int n = 0; n < 64; n++) {
+            for (int i = 0; i < 8; i++) {
+                // Extremes first: full-scale chroma against black and white
+                y[i] = (n == 0) ? 0 : (n == 1) ? 255 : rng_next();
+                cb[i] = (n < 2) ? ((i & 1) ? 255 : 0) : rng_next();
+                cr[i] = (n < 2) ? ((i & 2) ? 255 : 0) : rng_next();
+            }
+            ycc_row8_scalar(y, cb, cr, chroma, ref);
+            simd_pie_ycc_row8_rgb565(y, cb, cr, chroma, vec);
+            if (memcmp(ref, vec, sizeof(vec)) != 0) return false;
+        }
+    }
+    return true;
+}
+
+static bool test_idct(void)
+{
+    int32_t coef[64] __attribute__((aligned(16)));
+    uint8_t vec[64] __attribute__((aligned(16)));
+    uint8_t ref[64];
+
+    for (int n = 0; n < 32; n++) {
+        memset(coef, 0, sizeof(coef));
+        if (n < 16) {
+            // One coefficient at the overflow limit, either sign
+            coef[n * 4 + (n & 3)] = (n & 1) ? -SIMD_IDCT_MAX_ABS_SUM : SIMD_IDCT_MAX_ABS_SUM;
+        } else {
+            // Dense block, sum of |coef| within 64 * 92 < SIMD_IDCT_MAX_ABS_SUM
+            for (int i = 0; i < 64; i++) coef[i] = (int32_t)(rng_next() % 185) - 92;
+        }
+        idct_8x8_scalar(coef, ref);
+        simd_pie_idct_8x8(coef, vec);
+        if (memcmp(ref, vec, sizeof(vec)) != 0) return false;
+    }
+    return true;
+}
+
+static bool selftest(void)
+{
+    const char *failed = !test_scale() ? "scale" :
+                         !test_equal() ? "compare" :
+                         !test_ycc()   ? "color" :
+                         !test_idct()  ? "IDCT" : NULL;
+
+    if (failed != NULL) {
+        ESP_LOGW(TAG, "PIE %s kernel differs from scalar, using scalar kernels", failed);
+        return false;
+    }
+    ESP_LOGI(TAG, "PIE kernels verified");
+    return true;
+}
+
+#endif // SIMD_HAVE_PIE
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+static inline bool use_pie(void)
+{
+    if (g_pie == PIE_UNCHECKED) simd_available();
+    return g_use_pie;
+}
+
+static inline bool aligned(const void *p, uintptr_t n)
+{
+    return ((uintptr_t)p & (n - 1)) == 0;
+}
+
+/**
+ * Check availability
+ */
+bool simd_available(void)
+{
+    if (g_pie == PIE_UNCHECKED) {
+#if SIMD_HAVE_PIE
+        g_pie = selftest() ? PIE_USABLE : PIE_UNUSABLE;
+#else
+        ESP_LOGD(TAG, "No PIE unit on this target, using scalar kernels");
+        g_pie = PIE_UNUSABLE;
+#endif
+        g_use_pie = g_enabled && g_pie == PIE_USABLE;
+    }
+    return g_pie == PIE_USABLE;
+}
+
+/**
+ * Enable or disable
+ */
+void simd_set_enabled(bool enable)
+{
+    g_enabled = enable;
+    g_use_pie = enable && simd_available();
+}
+
+/**
+ * Check if in use
+ */
+bool simd_enabled(void)
+{
+    return use_pie();
+}
+
+/**
+ * Scale samples
+ */
+void simd_scale_s16(int16_t *samples, size_t count, int16_t gain_q15)
+{
+#if SIMD_HAVE_PIE
+    if (use_pie() && aligned(samples, 2)) {
+        size_t head = ((0u - (uintptr_t)samples) & 15) / sizeof(int16_t);
+        if (head > count) head = count;
+
+        scale_s16_scalar(samples, head, gain_q15);
+        samples += head;
+        count -= head;
+
+        size_t body = count & ~(size_t)7;
+        if (body) simd_pie_scale_s16(samples, body, gain_q15);
+        samples += body;
+        count -= body;
+    }
+#endif
+    scale_s16_scalar(samples, count, gain_q15);
+}
+
+/**
+ * Compare buffers
+ */
+bool simd_equal(const void *a, const void *b, size_t bytes)
+{
+#if SIMD_HAVE_PIE
+    if (use_pie() && aligned(a, 16) && aligned(b, 16)) {
+        size_t body = bytes & ~(size_t)63;
+        if (body && !simd_pie_equal(a, b, body)) return false;
+        return memcmp((const uint8_t *)a + body, (const uint8_t *)b + body, bytes - body) == 0;
+    }
+#endif
+    return memcmp(a, b, bytes) == 0;
+}
+
+/**
+ * Convert a row of 8 pixels
+ */
+void simd_ycc_row8_rgb565(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                          simd_chroma_t chroma, uint8_t *out)
+{
+#if SIMD_HAVE_PIE
+    uintptr_t ca = (chroma == SIMD_CHROMA_HALF) ? 4 : 8;
+    bool chroma_ok = (chroma == SIMD_CHROMA_NONE) || (aligned(cb, ca) && aligned(cr, ca));
+
+    if (use_pie() && aligned(y, 8) && aligned(out, 16) && chroma_ok) {
+        simd_pie_ycc_row8_rgb565(y, cb, cr, chroma, out);
+        return;
+    }
+#endif
+    ycc_row8_scalar(y, cb, cr, chroma, out);
+}
+
+/**
+ * 8x8 IDCT
+ */
+void simd_idct_8x8(const int32_t *coef, uint8_t *out)
+{
+#if SIMD_HAVE_PIE
+    if (use_pie() && aligned(coef, 16) && aligned(out, 16)) {
+        simd_pie_idct_8x8(coef, out);
+        return;
+    }
+#endif
+    idct_8x8_scalar(coef, out);
+}
@@ -0,0 +1,235 @@
+/**
+ * ESP32-S3 PIE Kernels
+ *
+ * Every kernel keeps its lanes at 16 bits: 8-bit samples are widened by
+ * zipping with a zero register, products go through VMUL (with SAR as the
+ * fixed-point shift) or the 40-bit QACC accumulators, and results are
+ * narrowed again by unzipping. Built on S3, and on the host with
+ * SIMD_PIE_EMULATE for the bit-exactness checks in tools/host.
+ */
+
+#include "simd_pie.h"
+
+#if SIMD_HAVE_PIE
+
+#include "pie.h"
+
+// Broadcast constants (VLDBC needs them in memory)
+enum {
+    K_128, K_255, K_CR_R, K_CB_B, K_CB_G, K_CR_G,
+    K_MASK_F8, K_MASK_07, K_MASK_E0, K_MASK_1F,
+    K_32, K_256, K_512,
+    K_COUNT
+};
+
+static const int16_t k_const[K_COUNT] __attribute__((aligned(16))) = {
+    [K_128] = 128,
+    [K_255] = 255,
+    [K_CR_R] = 22970,       // Q14, as simd_cr_r() and friends
+    [K_CB_B] = 29032,
+    [K_CB_G] = -5638,
+    [K_CR_G] = -11700,
+    [K_MASK_F8] = 0xF8,
+    [K_MASK_07] = 0x07,
+    [K_MASK_E0] = 0xE0,
+    [K_MASK_1F] = 0x1F,
+    [K_32] = 32,            // 32 * 32: IDCT pass 1 rounding
+    [K_256] = 256,          // 256 * 512: IDCT pass 2 rounding
+    [K_512] = 512,
+};
+
+/**
+ * Scale samples
+ */
+void simd_pie_scale_s16(int16_t *samples, size_t count, int16_t gain_q15)
+{
+    int16_t *dst = samples;
+
+    PIE_SET_SAR(15);
+    PIE_BCAST16(1, &gain_q15);
+    for (size_t i = 0; i < count; i += 8) {
+        PIE_LD128(0, samples);
+        PIE_VMUL(0, 0, 1);
+        PIE_ST128(0, dst);
+    }
+}
+
+/**
+ * Compare buffers, 64 bytes per check
+ */
+bool simd_pie_equal(const void *a, const void *b, size_t bytes)
+{
+    const uint8_t *pa = a;
+    const uint8_t *pb = b;
+
+    for (size_t i = 0; i < bytes; i += 64) {
+        uint32_t w0, w1, w2, w3;
+
+        PIE_LD128(0, pa);
+        PIE_LD128(1, pb);
+        PIE_LD128(2, pa);
+        PIE_LD128(3, pb);
+        PIE_XOR(4, 0, 1);
+        PIE_XOR(5, 2, 3);
+        PIE_LD128(0, pa);
+        PIE_LD128(1, pb);
+        PIE_LD128(2, pa);
+        PIE_LD128(3, pb);
+        PIE_XOR(6, 0, 1);
+        PIE_XOR(7, 2, 3);
+        PIE_OR(4, 4, 5);
+        PIE_OR(6, 6, 7);
+        PIE_OR(4, 4, 6);
+
+        PIE_MOVI32(4, w0, 0);
+        PIE_MOVI32(4, w1, 1);
+        PIE_MOVI32(4, w2, 2);
+        PIE_MOVI32(4, w3, 3);
+        if (w0 | w1 | w2 | w3) return false;
+    }
+    return true;
+}
+
+/**
+ * Convert a row of 8 pixels
+ * q0 = Y, q1 = Cb, q2 = Cr, then q4/q6/q5 = R/G/B, all as 16-bit lanes
+ */
+void simd_pie_ycc_row8_rgb565(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                              simd_chroma_t chroma, uint8_t *out)
+{
+    PIE_ZERO(1);
+    PIE_LD64(0, y);
+    PIE_ZIP8(0, 1);
+
+    if (chroma == SIMD_CHROMA_NONE) {
+        PIE_OR(4, 0, 0);
+        PIE_OR(5, 0, 0);
+        PIE_OR(6, 0, 0);
+    } else {
+        if (chroma == SIMD_CHROMA_FULL) {
+            PIE_ZERO(3);
+            PIE_LD64(1, cb);
+            PIE_ZIP8(1, 3);
+            PIE_ZERO(3);
+            PIE_LD64(2, cr);
+            PIE_ZIP8(2, 3);
+        } else {
+            // 4 samples, widened, then each lane doubled for its pixel pair
+            PIE_ZERO(3);
+            PIE_BCAST32(1, cb);
+            PIE_ZIP8(1, 3);
+            PIE_OR(3, 1, 1);
+            PIE_ZIP16(1, 3);
+            PIE_ZERO(3);
+            PIE_BCAST32(2, cr);
+            PIE_ZIP8(2, 3);
+            PIE_OR(3, 2, 2);
+            PIE_ZIP16(2, 3);
+        }
+
+        PIE_BCAST16(3, &k_const[K_128]);
+        PIE_VSUBS(1, 1, 3);
+        PIE_VSUBS(2, 2, 3);
+
+        PIE_SET_SAR(14);
+        PIE_BCAST16(3, &k_const[K_CR_R]);
+        PIE_VMUL(4, 2, 3);
+        PIE_VADDS(4, 4, 0);
+        PIE_BCAST16(3, &k_const[K_CB_B]);
+        PIE_VMUL(5, 1, 3);
+        PIE_VADDS(5, 5, 0);
+        PIE_BCAST16(3, &k_const[K_CB_G]);
+        PIE_VMUL(6, 1, 3);
+        PIE_BCAST16(3, &k_const[K_CR_G]);
+        PIE_VMUL(7, 2, 3);
+        PIE_VADDS(6, 6, 7);
+        PIE_VADDS(6, 6, 0);
+
+        PIE_ZERO(3);
+        PIE_VMAX(4, 4, 3);
+        PIE_VMAX(5, 5, 3);
+        PIE_VMAX(6, 6, 3);
+        PIE_BCAST16(3, &k_const[K_255]);
+        PIE_VMIN(4, 4, 3);
+        PIE_VMIN(5, 5, 3);
+        PIE_VMIN(6, 6, 3);
+    }
+
+    // Big-endian RGB565 per lane: low byte (R5 G3), high byte (G3 B5).
+    // The 32-bit shifts move bits between lane pairs; the masks drop them.
+    PIE_BCAST16(3, &k_const[K_MASK_F8]);
+    PIE_AND(4, 4, 3);
+    PIE_SET_SAR(5);
+    PIE_SR32(7, 6);
+    PIE_BCAST16(3, &k_const[K_MASK_07]);
+    PIE_AND(7, 7, 3);
+    PIE_OR(4, 4, 7);
+
+    PIE_SET_SAR(3);
+    PIE_SL32(7, 6);
+    PIE_BCAST16(3, &k_const[K_MASK_E0]);
+    PIE_AND(7, 7, 3);
+    PIE_SR32(5, 5);
+    PIE_BCAST16(3, &k_const[K_MASK_1F]);
+    PIE_AND(5, 5, 3);
+    PIE_OR(5, 5, 7);
+
+    PIE_SET_SAR(8);
+    PIE_SL32(5, 5);
+    PIE_OR(4, 4, 5);
+    PIE_ST128(4, out);
+}
+
+/**
+ * 8x8 IDCT as two matrix passes
+ * Pass 1 computes one column per iteration (8 output rows in the lanes) and
+ * stores it as a row of the transposed workspace, so pass 2 can broadcast
+ * each row's inputs from consecutive columns of ws.
+ */
+void simd_pie_idct_8x8(const int32_t *coef, uint8_t *out)
+{
+    int16_t ws[64] __attribute__((aligned(16)));    // ws[c * 8 + r]
+    int16_t *w = ws;
+
+    for (int c = 0; c < 8; c++) {
+        const int16_t *m = &lut_idct_llm[0][0];
+
+        PIE_ZERO_QACC();
+        PIE_BCAST16(1, &k_const[K_32]);
+        PIE_MULAS(1, 1);
+        for (int i = 0; i < 8; i++) {
+            PIE_LD128(0, m);
+            PIE_BCAST16(1, (const int16_t *)&coef[i * 8 + c]);  // Low half
+            PIE_MULAS(0, 1);
+        }
+        PIE_SRCMB(2, 11);
+        PIE_ST128(2, w);
+    }
+
+    for (int r = 0; r < 8; r++) {
+        const int16_t *m = &lut_idct_llm[0][0];
+
+        PIE_ZERO_QACC();
+        PIE_BCAST16(1, &k_const[K_256]);
+        PIE_BCAST16(2, &k_const[K_512]);
+        PIE_MULAS(1, 2);
+        for (int u = 0; u < 8; u++) {
+            PIE_LD128(0, m);
+            PIE_BCAST16(1, &ws[u * 8 + r]);
+            PIE_MULAS(0, 1);
+        }
+        PIE_SRCMB(2, 18);
+
+        PIE_BCAST16(3, &k_const[K_128]);
+        PIE_VADDS(2, 2, 3);
+        PIE_ZERO(3);
+        PIE_VMAX(2, 2, 3);
+        PIE_BCAST16(3, &k_const[K_255]);
+        PIE_VMIN(2, 2, 3);
+        PIE_ZERO(3);
+        PIE_UNZIP8(2, 3);
+        PIE_ST64(2, out);
+    }
+}
+
+#endif // SIMD_HAVE_PIE
@@ -0,0 +1,46 @@
+/**
+ * PIE Kernel Entry Points (private)
+ *
+ * SIMD_HAVE_PIE is set on S3 builds, and on the host when SIMD_PIE_EMULATE
+ * runs the same kernels against the register model in pie.h. Callers have
+ * already checked the alignment each kernel needs.
+ */
+
+#ifndef SIMD_PIE_H
+#define SIMD_PIE_H
+
+#include "simd.h"
+#include "luts.h"
+
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3) || SIMD_PIE_EMULATE
+#define SIMD_HAVE_PIE 1
+#else
+#define SIMD_HAVE_PIE 0
+#endif
+
+// The 8x8 IDCT runs as a matrix: lut_idct_llm row i holds input frequency
+// i's contribution to outputs 0-7 (the LL&M butterflies multiplied out,
+// 13-bit constants, 16-byte aligned rows)
+
+#if SIMD_HAVE_PIE
+
+/** Scale count samples (multiple of 8, 16-byte aligned) */
+void simd_pie_scale_s16(int16_t *samples, size_t count, int16_t gain_q15);
+
+/** Compare bytes (multiple of 64) of two 16-byte aligned buffers */
+bool simd_pie_equal(const void *a, const void *b, size_t bytes);
+
+/** Convert one row of 8 pixels */
+void simd_pie_ycc_row8_rgb565(const uint8_t *y, const uint8_t *cb, const uint8_t *cr,
+                              simd_chroma_t chroma, uint8_t *out);
+
+/** Full 8x8 IDCT */
+void simd_pie_idct_8x8(const int32_t *coef, uint8_t *out);
+
+#endif
+
+#endif // SIMD_PIE_H
@@ -3,26 +3,32 @@
  */
 
 #include "channel_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include "esp_log.h"
+#include "dlog.h"
 
 static const char *TAG = "CHANNEL_MGR";
 
-// Supported video file extensions
-static const char *video_extensions[] = {".avi", ".mjpeg", ".mjpg", NULL};
+// Supported media file extensions (.wav is audio only)
+static const char *media_extensions[] = {".avi", ".mjpeg", ".mjpg", ".wav", NULL};
+
+// Stream headers sit at the start of an AVI, ahead of 'movi'
+#define AVI_PROBE_BYTES     4096
 
 /**
- * Check if file has video extension
+ * Check if file has a supported media extension
  */
-static bool is_video_file(const char *filename)
+static bool is_media_file(const char *filename)
 {
     const char *ext = strrchr(filename, '.');
     if (ext == NULL) return false;
 
-    for (int i = 0; video_extensions[i] != NULL; i++) {
-        if (strcasecmp(ext, video_extensions[i]) == 0) {
+    for (int i = 0; media_extensions[i] != NULL; i++) {
+        if (strcasecmp(ext, media_extensions[i]) == 0) {
             return true;
         }
     }
@@ -30,6 +36,46 @@ static bool is_video_file(const char *filename)
     return false;
 }
 
+/**
+ * Check whether an AVI file carries only audio
+ * Looks for stream headers in the first bytes of the file; files whose
+ * headers can't be read are treated as video
+ */
+static bool avi_is_audio_only(const char *path)
+{
+    uint8_t *buf = malloc(AVI_PROBE_BYTES);
+    if (buf == NULL) return false;
+
+    FILE *f = fopen(path, "rb");
+    size_t n = f ? fread(buf, 1, AVI_PROBE_BYTES, f) : 0;
+    if (f) fclose(f);
+
+    bool audio = false, video = false;
+    for (size_t i = 12; i + 12 <= n; i++) {
+        if (memcmp(&buf[i], "movi", 4) == 0) break;
+        if (memcmp(&buf[i], "strh", 4) != 0) continue;
+
+        // strh: fourcc, size, then the stream type
+        if (memcmp(&buf[i + 8], "vids", 4) == 0) video = true;
+        if (memcmp(&buf[i + 8], "auds", 4) == 0) audio = true;
+    }
+
+    free(buf);
+    return audio && !video;
+}
+
+/**
+ * Check whether an episode file has no video
+ */
+static bool is_audio_only(const char *path)
+{
+    const char *ext = strrchr(path, '.');
+    if (ext != NULL && strcasecmp(ext, ".wav") == 0) return true;
+    if (ext != NULL && strcasecmp(ext, ".avi") == 0) return avi_is_audio_only(path);
+
+    return false;
+}
+
 /**
  * Scan directory for episodes
  */
@@ -47,7 +93,7 @@ static esp_err_t scan_channel_episodes(channel_t *channel, const char *channel_p
     while ((entry = readdir(dir)) != NULL && channel->episode_count < MAX_EPISODES) {
         if (entry->d_type != DT_REG) continue;  // Skip non-files
 
-        if (!is_video_file(entry->d_name)) continue;
+        if (!is_media_file(entry->d_name)) continue;
 
         episode_t *ep = &channel->episodes[channel->episode_count];
 
@@ -72,10 +118,11 @@ static esp_err_t scan_channel_episodes(channel_t *channel, const char *channel_p
 
         // Duration will be determined during playback
         ep->duration_sec = 0;
+        ep->audio_only = is_audio_only(ep->path);
 
-        ESP_LOGI(TAG, "  Episode %d: %s (%.2f MB)",
-                 channel->episode_count + 1, ep->name,
-                 ep->file_size / (1024.0 * 1024.0));
+        DLOGI(TAG, "  Episode %d: %s (%.2f MB%s)",
+              channel->episode_count + 1, ep->name,
+              ep->file_size / (1024.0 * 1024.0), ep->audio_only ? ", audio only" : "");
 
         channel->episode_count++;
     }
@@ -83,8 +130,8 @@ static esp_err_t scan_channel_episodes(channel_t *channel, const char *channel_p
     closedir(dir);
 
     if (channel->episode_count > 0) {
-        ESP_LOGI(TAG, "Found %d episodes in channel '%s'",
-                 channel->episode_count, channel->name);
+        DLOGI(TAG, "Found %d episodes in channel '%s'",
+              channel->episode_count, channel->name);
     }
 
     return ESP_OK;
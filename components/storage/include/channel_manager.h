@@ -23,6 +23,7 @@ typedef struct {
     char path[MAX_PATH_LEN];
     uint32_t duration_sec;  // Duration in seconds
     uint32_t file_size;     // File size in bytes
+    bool audio_only;        // WAV, or AVI without a video stream (radio)
 } episode_t;
 
 /**
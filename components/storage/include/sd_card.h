@@ -9,13 +9,29 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "sdkconfig.h"
 #include "esp_vfs_fat.h"
 #include "sdmmc_cmd.h"
+#include "sd_profile.h"
 
-// SD card pin definitions (SPI mode)
+// SD card pin definitions (SPI mode), on the bus the display driver
+// initializes; the host follows the display pin profile
+#if CONFIG_WATCHMAN_DISPLAY_PINS_IOMUX && CONFIG_IDF_TARGET_ESP32S3
+#define PIN_SD_MISO     13
+#define PIN_SD_MOSI     11
+#define PIN_SD_CLK      12
+#define SD_SPI_HOST     SPI2_HOST
+#elif CONFIG_WATCHMAN_DISPLAY_PINS_IOMUX
 #define PIN_SD_MISO     19
 #define PIN_SD_MOSI     23
 #define PIN_SD_CLK      18
+#define SD_SPI_HOST     SPI3_HOST
+#else
+#define PIN_SD_MISO     19
+#define PIN_SD_MOSI     23
+#define PIN_SD_CLK      18
+#define SD_SPI_HOST     SPI2_HOST
+#endif
 #define PIN_SD_CS       17
 
 // SD card mount point
@@ -33,10 +49,14 @@ typedef struct {
     bool mounted;
     uint64_t total_bytes;
     uint64_t free_bytes;
+    sd_perf_profile_t profile;  // Measured read performance
+    sd_io_tuning_t tuning;      // I/O parameters derived from profile
+    bool profiled;
 } sd_card_handle_t;
 
 /**
  * Initialize and mount SD card
+ * Profiles read performance on first mount of a card (cached per CID)
  *
  * @param handle SD card handle to initialize
  * @return ESP_OK on success
@@ -68,6 +88,33 @@ bool sd_card_is_mounted(const sd_card_handle_t *handle);
  */
 esp_err_t sd_card_get_info(sd_card_handle_t *handle, uint32_t *total_mb, uint32_t *free_mb);
 
+/**
+ * Get measured card performance
+ *
+ * @param handle SD card handle
+ * @param profile Output profile
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the card was not profiled
+ */
+esp_err_t sd_card_get_profile(const sd_card_handle_t *handle, sd_perf_profile_t *profile);
+
+/**
+ * Get I/O tuning for the mounted card
+ * Falls back to conservative defaults when no profile is available
+ *
+ * @param handle SD card handle
+ * @param tuning Output tuning
+ * @return ESP_OK on success
+ */
+esp_err_t sd_card_get_tuning(const sd_card_handle_t *handle, sd_io_tuning_t *tuning);
+
+/**
+ * Re-run the performance probe and update the cached profile
+ *
+ * @param handle SD card handle
+ * @return ESP_OK on success
+ */
+esp_err_t sd_card_reprofile(sd_card_handle_t *handle);
+
 /**
  * Check if file exists
  *
@@ -0,0 +1,70 @@
+/**
+ * SD Card Performance Profile
+ * Short read benchmark run on first mount of each card, cached in NVS by CID
+ *
+ * The probe only reads raw sectors (sequential run plus random 4 KB reads),
+ * so it is safe on any card. Results drive I/O tuning: read size,
+ * frame prefetch depth and the highest bitrate the card can sustain.
+ */
+
+#ifndef SD_PROFILE_H
+#define SD_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdmmc_cmd.h"
+
+#define SD_PROFILE_NVS_NAMESPACE    "sd_profile"
+#define SD_PROFILE_VERSION          1
+
+#define SD_PROFILE_SEQ_BYTES        (512 * 1024)    // Sequential run length
+#define SD_PROFILE_SEQ_CHUNK        (32 * 1024)     // Bytes per sequential request
+#define SD_PROFILE_RANDOM_READS     100             // Random 4 KB samples
+
+/**
+ * Measured card performance
+ */
+typedef struct {
+    uint32_t seq_read_kbps;     // Sequential read throughput, KB/s
+    uint32_t rand_p50_us;       // Random 4 KB read latency, median
+    uint32_t rand_p99_us;       // Random 4 KB read latency, 99th percentile
+} sd_perf_profile_t;
+
+/**
+ * I/O parameters derived from a profile
+ */
+typedef struct {
+    uint8_t prefetch_depth;     // Video frames to read ahead
+    uint32_t read_block_size;   // Bytes per file read
+    uint32_t max_bitrate_kbps;  // Highest stream bitrate (kbit/s) with headroom
+} sd_io_tuning_t;
+
+/**
+ * Load the cached profile for a card, probing and caching on first use
+ *
+ * @param card Initialized card
+ * @param force Re-run the probe even if a cached profile exists
+ * @param profile Output profile
+ * @return ESP_OK on success (caching failures are only logged)
+ */
+esp_err_t sd_profile_get(sdmmc_card_t *card, bool force, sd_perf_profile_t *profile);
+
+/**
+ * Run the read benchmark (~0.5-1 s)
+ *
+ * @param card Initialized card
+ * @param profile Output profile
+ * @return ESP_OK on success
+ */
+esp_err_t sd_profile_probe(sdmmc_card_t *card, sd_perf_profile_t *profile);
+
+/**
+ * Derive I/O tuning from a profile
+ *
+ * @param profile Measured profile (NULL for conservative defaults)
+ * @param tuning Output tuning
+ */
+void sd_profile_tune(const sd_perf_profile_t *profile, sd_io_tuning_t *tuning);
+
+#endif // SD_PROFILE_H
@@ -36,7 +36,7 @@ esp_err_t sd_card_init(sd_card_handle_t *handle)
 
     sdspi_device_config_t slot_config = SDSPI_DEVICE_CONFIG_DEFAULT();
     slot_config.gpio_cs = PIN_SD_CS;
-    slot_config.host_id = SPI2_HOST;  // Same host as display
+    slot_config.host_id = SD_SPI_HOST;  // Same host as display
 
     ESP_LOGI(TAG, "Mounting filesystem...");
     esp_err_t ret = esp_vfs_fat_sdspi_mount(SD_MOUNT_POINT, &host, &slot_config,
@@ -73,6 +73,14 @@ esp_err_t sd_card_init(sd_card_handle_t *handle)
                  handle->free_bytes / (1024.0 * 1024.0 * 1024.0));
     }
 
+    // Performance profile (probe runs once per card)
+    handle->profiled = (sd_profile_get(handle->card, false, &handle->profile) == ESP_OK);
+    sd_profile_tune(handle->profiled ? &handle->profile : NULL, &handle->tuning);
+
+    ESP_LOGI(TAG, "I/O tuning: prefetch %d frames, %lu KB reads, max %lu kbit/s",
+             handle->tuning.prefetch_depth, handle->tuning.read_block_size / 1024,
+             handle->tuning.max_bitrate_kbps);
+
     return ESP_OK;
 }
 
@@ -113,6 +121,44 @@ esp_err_t sd_card_get_info(sd_card_handle_t *handle, uint32_t *total_mb, uint32_
     return ESP_OK;
 }
 
+/**
+ * Get performance profile
+ */
+esp_err_t sd_card_get_profile(const sd_card_handle_t *handle, sd_perf_profile_t *profile)
+{
+    if (!sd_card_is_mounted(handle) || profile == NULL) return ESP_ERR_INVALID_STATE;
+    if (!handle->profiled) return ESP_ERR_NOT_FOUND;
+
+    *profile = handle->profile;
+    return ESP_OK;
+}
+
+/**
+ * Get I/O tuning
+ */
+esp_err_t sd_card_get_tuning(const sd_card_handle_t *handle, sd_io_tuning_t *tuning)
+{
+    if (!sd_card_is_mounted(handle) || tuning == NULL) return ESP_ERR_INVALID_STATE;
+
+    *tuning = handle->tuning;
+    return ESP_OK;
+}
+
+/**
+ * Re-run performance probe
+ */
+esp_err_t sd_card_reprofile(sd_card_handle_t *handle)
+{
+    if (!sd_card_is_mounted(handle)) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t ret = sd_profile_get(handle->card, true, &handle->profile);
+    if (ret == ESP_OK) {
+        handle->profiled = true;
+        sd_profile_tune(&handle->profile, &handle->tuning);
+    }
+    return ret;
+}
+
 /**
  * Check if file exists
  */
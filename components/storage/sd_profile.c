@@ -0,0 +1,220 @@
+/**
+ * SD Card Performance Profile Implementation
+ */
+
+#include "sd_profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "nvs.h"
+
+static const char *TAG = "SD_PROFILE";
+
+// Tuning limits
+#define BLOCK_SIZE_MIN          (4 * 1024)
+#define BLOCK_SIZE_MAX          (32 * 1024)
+#define PREFETCH_DEPTH_MIN      2
+#define PREFETCH_DEPTH_MAX      8
+#define STALL_FRAME_US          33333   // Frame interval at 30 fps
+#define BITRATE_HEADROOM_PCT    70      // Leave room for seeks and FAT lookups
+
+/**
+ * Cached profile record
+ */
+typedef struct {
+    uint32_t version;
+    sd_perf_profile_t profile;
+} profile_record_t;
+
+/**
+ * NVS key from CID (FNV-1a hash, keys are limited to 15 characters)
+ */
+static void cid_key(const sdmmc_card_t *card, char *key, size_t len)
+{
+    const uint8_t *cid = (const uint8_t *)card->raw_cid;
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < sizeof(card->raw_cid); i++) {
+        hash = (hash ^ cid[i]) * 16777619u;
+    }
+
+    snprintf(key, len, "c%08lx", (unsigned long)hash);
+}
+
+/**
+ * Small deterministic PRNG for random sector addresses
+ */
+static uint32_t probe_rand(uint32_t *state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return *state;
+}
+
+/**
+ * Sort latencies (insertion sort, 100 samples)
+ */
+static void sort_u32(uint32_t *v, int n)
+{
+    for (int i = 1; i < n; i++) {
+        uint32_t x = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > x) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = x;
+    }
+}
+
+/**
+ * Run read benchmark
+ */
+esp_err_t sd_profile_probe(sdmmc_card_t *card, sd_perf_profile_t *profile)
+{
+    if (card == NULL || profile == NULL) return ESP_ERR_INVALID_ARG;
+
+    uint32_t sector_size = card->csd.sector_size;
+    uint32_t sectors = card->csd.capacity;
+    uint32_t chunk_sectors = SD_PROFILE_SEQ_CHUNK / sector_size;
+    uint32_t rand_sectors = 4096 / sector_size;
+
+    if (sectors < 2 * (SD_PROFILE_SEQ_BYTES / sector_size)) return ESP_ERR_INVALID_SIZE;
+
+    uint8_t *buf = heap_caps_malloc(SD_PROFILE_SEQ_CHUNK, MALLOC_CAP_DMA);
+    uint32_t *lat = malloc(SD_PROFILE_RANDOM_READS * sizeof(uint32_t));
+    if (buf == NULL || lat == NULL) {
+        free(buf);
+        free(lat);
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret;
+
+    // Sequential: middle of the card, first request untimed (wake-up)
+    uint32_t start = (sectors / 2) & ~(chunk_sectors - 1);
+    ret = sdmmc_read_sectors(card, buf, start, chunk_sectors);
+    if (ret != ESP_OK) goto done;
+
+    uint64_t t0 = esp_timer_get_time();
+    for (uint32_t s = 0; s < SD_PROFILE_SEQ_BYTES / sector_size; s += chunk_sectors) {
+        ret = sdmmc_read_sectors(card, buf, start + chunk_sectors + s, chunk_sectors);
+        if (ret != ESP_OK) goto done;
+    }
+    uint64_t seq_us = esp_timer_get_time() - t0;
+    profile->seq_read_kbps = (uint32_t)((uint64_t)SD_PROFILE_SEQ_BYTES * 1000000 / 1024 / (seq_us ? seq_us : 1));
+
+    // Random 4 KB reads across the whole card
+    uint32_t seed = card->cid.serial ^ 0x5D5EED;
+    for (int i = 0; i < SD_PROFILE_RANDOM_READS; i++) {
+        uint32_t sector = (probe_rand(&seed) % (sectors - rand_sectors)) & ~(rand_sectors - 1);
+
+        uint64_t r0 = esp_timer_get_time();
+        ret = sdmmc_read_sectors(card, buf, sector, rand_sectors);
+        if (ret != ESP_OK) goto done;
+        lat[i] = esp_timer_get_time() - r0;
+    }
+
+    sort_u32(lat, SD_PROFILE_RANDOM_READS);
+    profile->rand_p50_us = lat[(SD_PROFILE_RANDOM_READS * 50 + 99) / 100 - 1];
+    profile->rand_p99_us = lat[(SD_PROFILE_RANDOM_READS * 99 + 99) / 100 - 1];
+
+    ESP_LOGI(TAG, "Probe: seq %lu KB/s, random 4K p50 %lu us, p99 %lu us",
+             profile->seq_read_kbps, profile->rand_p50_us, profile->rand_p99_us);
+
+done:
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Probe read failed: %s", esp_err_to_name(ret));
+    }
+    free(lat);
+    free(buf);
+    return ret;
+}
+
+/**
+ * Load or probe profile
+ */
+esp_err_t sd_profile_get(sdmmc_card_t *card, bool force, sd_perf_profile_t *profile)
+{
+    if (card == NULL || profile == NULL) return ESP_ERR_INVALID_ARG;
+
+    char key[16];
+    cid_key(card, key, sizeof(key));
+
+    nvs_handle_t nvs;
+    bool have_nvs = (nvs_open(SD_PROFILE_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK);
+
+    if (have_nvs && !force) {
+        profile_record_t rec;
+        size_t len = sizeof(rec);
+        if (nvs_get_blob(nvs, key, &rec, &len) == ESP_OK && len == sizeof(rec) &&
+            rec.version == SD_PROFILE_VERSION) {
+            *profile = rec.profile;
+            nvs_close(nvs);
+            ESP_LOGI(TAG, "Cached profile for card %s: seq %lu KB/s, p50 %lu us, p99 %lu us",
+                     key, profile->seq_read_kbps, profile->rand_p50_us, profile->rand_p99_us);
+            return ESP_OK;
+        }
+    }
+
+    ESP_LOGI(TAG, "Profiling card %s...", key);
+    esp_err_t ret = sd_profile_probe(card, profile);
+
+    if (ret == ESP_OK && have_nvs) {
+        profile_record_t rec = {
+            .version = SD_PROFILE_VERSION,
+            .profile = *profile,
+        };
+        if (nvs_set_blob(nvs, key, &rec, sizeof(rec)) != ESP_OK || nvs_commit(nvs) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to cache profile");
+        }
+    } else if (!have_nvs) {
+        ESP_LOGW(TAG, "NVS unavailable, profile not cached");
+    }
+
+    if (have_nvs) nvs_close(nvs);
+    return ret;
+}
+
+/**
+ * Derive tuning
+ */
+void sd_profile_tune(const sd_perf_profile_t *profile, sd_io_tuning_t *tuning)
+{
+    if (tuning == NULL) return;
+
+    if (profile == NULL || profile->seq_read_kbps == 0) {
+        // Unknown card: assume a slow one
+        tuning->prefetch_depth = PREFETCH_DEPTH_MIN;
+        tuning->read_block_size = 8 * 1024;
+        tuning->max_bitrate_kbps = 4000;
+        return;
+    }
+
+    uint64_t kbps = profile->seq_read_kbps;
+
+    // Fixed per-request cost: 4 KB random latency minus its transfer time
+    uint64_t xfer_4k_us = 4ull * 1000000 / kbps;
+    uint64_t overhead_us = (profile->rand_p50_us > xfer_4k_us) ? profile->rand_p50_us - xfer_4k_us : 0;
+
+    // Smallest block whose transfer takes >= 3x the request overhead
+    uint32_t block = BLOCK_SIZE_MIN;
+    while (block < BLOCK_SIZE_MAX && (uint64_t)block * 1000000 / 1024 / kbps < 3 * overhead_us) {
+        block <<= 1;
+    }
+
+    // Throughput when reading in such blocks, converted to kbit/s with headroom
+    uint64_t block_us = overhead_us + (uint64_t)block * 1000000 / 1024 / kbps;
+    uint64_t eff_kbytes = (uint64_t)block * 1000000 / 1024 / (block_us ? block_us : 1);
+    uint32_t bitrate = (uint32_t)(eff_kbytes * 8 * 1024 / 1000 * BITRATE_HEADROOM_PCT / 100);
+
+    // Enough queued frames to ride out a p99 stall at 30 fps
+    uint32_t depth = PREFETCH_DEPTH_MIN + profile->rand_p99_us / STALL_FRAME_US;
+    if (depth > PREFETCH_DEPTH_MAX) depth = PREFETCH_DEPTH_MAX;
+
+    tuning->prefetch_depth = depth;
+    tuning->read_block_size = block;
+    tuning->max_bitrate_kbps = bitrate;
+}
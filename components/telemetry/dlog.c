@@ -0,0 +1,333 @@
+/**
+ * Deferred Binary Log Implementation
+ *
+ * One ring per core, written only by code running on that core with its
+ * interrupts masked, so a writer can be neither preempted nor migrated
+ * mid-record and needs no lock. The drain task is the only reader; head and
+ * tail are free-running byte counters published with release stores.
+ *
+ * Record: fmt pointer, tag pointer, timestamp (ms), level | nargs << 8, then
+ * nargs 8-byte arguments. A zero fmt word marks the rest of the ring as
+ * padding, so records never wrap.
+ */
+
+#include "dlog.h"
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_cpu.h"
+
+static const char *TAG = "DLOG";
+
+#if CONFIG_WATCHMAN_DLOG
+
+#define RING_SIZE       CONFIG_WATCHMAN_DLOG_RING_SIZE
+#define RING_MASK       (RING_SIZE - 1)
+#define HEADER_WORDS    4
+#define RECORD_MAX      (HEADER_WORDS * 4 + DLOG_MAX_ARGS * sizeof(dlog_arg_t))
+#define WRAP_MARK       0
+
+_Static_assert((RING_SIZE & RING_MASK) == 0, "CONFIG_WATCHMAN_DLOG_RING_SIZE must be a power of two");
+
+typedef struct {
+    uint32_t head;              // Bytes written, owning core only
+    uint32_t tail;              // Bytes drained, drain only
+    uint32_t records;
+    uint32_t dropped;
+    uint32_t max_used;
+    uint32_t buf[RING_SIZE / 4];
+} ring_t;
+
+static ring_t g_rings[portNUM_PROCESSORS];
+static TaskHandle_t g_task = NULL;
+static SemaphoreHandle_t g_drain_lock = NULL;
+static StaticSemaphore_t g_drain_lock_buf;
+static uint32_t g_reported_drops;
+
+static const char g_level_chars[] = "NEWIDV";
+
+/**
+ * Write a record
+ */
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                const dlog_arg_t *args, uint32_t nargs)
+{
+    if (nargs > DLOG_MAX_ARGS) nargs = DLOG_MAX_ARGS;
+
+    uint32_t need = HEADER_WORDS * 4 + nargs * sizeof(dlog_arg_t);
+    uint32_t now = esp_log_timestamp();
+
+    // Masked: no preemption, no migration, no ISR on this core until restored
+    uint32_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+    ring_t *r = &g_rings[esp_cpu_get_core_id()];
+    uint32_t head = r->head;
+    uint32_t used = head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    uint32_t pos = head & RING_MASK;
+    uint32_t pad = (pos + need > RING_SIZE) ? RING_SIZE - pos : 0;
+
+    if (used + pad + need > RING_SIZE) {
+        r->dropped++;
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+        return;
+    }
+    if (pad) {
+        r->buf[pos / 4] = WRAP_MARK;
+        head += pad;
+        pos = 0;
+    }
+
+    uint32_t *w = &r->buf[pos / 4];
+    w[0] = (uint32_t)(uintptr_t)fmt;
+    w[1] = (uint32_t)(uintptr_t)tag;
+    w[2] = now;
+    w[3] = (uint32_t)level | (nargs << 8);
+    memcpy(&w[HEADER_WORDS], args, nargs * sizeof(dlog_arg_t));
+
+    head += need;
+    used += pad + need;
+    if (used > r->max_used) r->max_used = used;
+    r->records++;
+    __atomic_store_n(&r->head, head, __ATOMIC_RELEASE);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+}
+
+#if !CONFIG_WATCHMAN_DLOG_HOST_DECODE
+/**
+ * Format a record's arguments with its format string
+ * Each conversion is printed on its own with the argument type the capture
+ * used; length modifiers in the format only select 64-bit integers
+ */
+static void format_record(const char *fmt, const dlog_arg_t *args, uint32_t nargs,
+                          char *out, size_t size)
+{
+    size_t n = 0;
+    uint32_t a = 0;
+
+    while (*fmt && n + 1 < size) {
+        if (*fmt != '%') {
+            out[n++] = *fmt++;
+            continue;
+        }
+        if (fmt[1] == '%') {
+            out[n++] = '%';
+            fmt += 2;
+            continue;
+        }
+
+        char spec[16];
+        size_t len = 0;
+        int longs = 0;
+
+        spec[len++] = *fmt++;
+        while (*fmt && strchr("-+ #0123456789.", *fmt) && len < sizeof(spec) - 4) spec[len++] = *fmt++;
+        while (*fmt && strchr("hlLqjzt", *fmt)) {
+            if (*fmt == 'l' || *fmt == 'q' || *fmt == 'j') longs++;
+            fmt++;
+        }
+        char conv = *fmt;
+        if (conv == '\0' || a >= nargs) break;
+        fmt++;
+
+        const dlog_arg_t *arg = &args[a++];
+        bool wide = (longs >= 2);
+        int w;
+
+        if (wide && strchr("diouxX", conv)) {
+            spec[len++] = 'l';
+            spec[len++] = 'l';
+        }
+        spec[len++] = conv;
+        spec[len] = '\0';
+
+        switch (conv) {
+        case 'd': case 'i':
+            w = wide ? snprintf(out + n, size - n, spec, (long long)arg->u64)
+                     : snprintf(out + n, size - n, spec, (int)(int32_t)arg->u32);
+            break;
+        case 'o': case 'u': case 'x': case 'X':
+            w = wide ? snprintf(out + n, size - n, spec, (unsigned long long)arg->u64)
+                     : snprintf(out + n, size - n, spec, (unsigned)arg->u32);
+            break;
+        case 'c':
+            w = snprintf(out + n, size - n, spec, (int)arg->u32);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            w = snprintf(out + n, size - n, spec, arg->f64);
+            break;
+        case 's':
+            w = snprintf(out + n, size - n, spec, arg->ptr ? (const char *)arg->ptr : "(null)");
+            break;
+        case 'p':
+            w = snprintf(out + n, size - n, spec, arg->ptr);
+            break;
+        default:
+            w = snprintf(out + n, size - n, "%s", spec);
+            break;
+        }
+        if (w > 0) n += ((size_t)w < size - n) ? (size_t)w : size - n - 1;
+    }
+    out[n] = '\0';
+}
+#endif
+
+/** Print one record as ESP_LOG would, or as a DLOG line for tools/dlog.py */
+static void emit(int core, const uint32_t *w)
+{
+    esp_log_level_t level = (esp_log_level_t)(w[3] & 0xFF);
+    uint32_t nargs = (w[3] >> 8) & 0xFF;
+    const char *tag = (const char *)(uintptr_t)w[1];
+    char c = (level < sizeof(g_level_chars) - 1) ? g_level_chars[level] : '?';
+
+#if CONFIG_WATCHMAN_DLOG_HOST_DECODE
+    char line[DLOG_LINE_MAX];
+    int n = snprintf(line, sizeof(line), "DLOG %c %d %lu %08lx %08lx", c, core,
+                     (unsigned long)w[2], (unsigned long)w[0], (unsigned long)w[1]);
+    const uint32_t *arg = &w[HEADER_WORDS];
+    for (uint32_t i = 0; i < nargs && n < (int)sizeof(line); i++, arg += 2) {
+        n += snprintf(line + n, sizeof(line) - n, " %08lx%08lx", (unsigned long)arg[1], (unsigned long)arg[0]);
+    }
+    esp_log_write(level, tag, "%s\n", line);
+#else
+    dlog_arg_t args[DLOG_MAX_ARGS];
+    char text[DLOG_LINE_MAX];
+
+    (void)core;
+    memcpy(args, &w[HEADER_WORDS], nargs * sizeof(dlog_arg_t));
+    format_record((const char *)(uintptr_t)w[0], args, nargs, text, sizeof(text));
+    esp_log_write(level, tag, "%c (%lu) %s: %s\n", c, (unsigned long)w[2], tag, text);
+#endif
+}
+
+/** Drain one ring; each record is copied out before its space is released */
+static void drain_ring(int core)
+{
+    ring_t *r = &g_rings[core];
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = r->tail;
+    uint32_t rec[RECORD_MAX / 4];
+
+    while (tail != head) {
+        const uint32_t *w = &r->buf[(tail & RING_MASK) / 4];
+
+        if (w[0] == WRAP_MARK) {
+            tail += RING_SIZE - (tail & RING_MASK);
+            __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        uint32_t size = HEADER_WORDS * 4 + ((w[3] >> 8) & 0xFF) * sizeof(dlog_arg_t);
+        memcpy(rec, w, size);
+        tail += size;
+        __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+
+        emit(core, rec);
+    }
+}
+
+static void drain_all(void)
+{
+    if (g_drain_lock == NULL) return;
+
+    xSemaphoreTake(g_drain_lock, portMAX_DELAY);
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        drain_ring(core);
+    }
+
+    uint32_t dropped = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) dropped += g_rings[core].dropped;
+    if (dropped != g_reported_drops) {
+        ESP_LOGW(TAG, "%lu records dropped (ring full)", (unsigned long)(dropped - g_reported_drops));
+        g_reported_drops = dropped;
+    }
+    xSemaphoreGive(g_drain_lock);
+}
+
+/**
+ * Drain task
+ */
+static void dlog_task(void *arg)
+{
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(DLOG_TASK_PERIOD_MS));
+        drain_all();
+    }
+}
+
+/**
+ * Start drain task
+ */
+esp_err_t dlog_start(void)
+{
+    if (g_task != NULL) return ESP_ERR_INVALID_STATE;
+
+    if (g_drain_lock == NULL) {
+        g_drain_lock = xSemaphoreCreateMutexStatic(&g_drain_lock_buf);
+    }
+
+    if (xTaskCreate(dlog_task, "dlog", 3072, NULL, DLOG_TASK_PRIORITY, &g_task) != pdPASS) {
+        g_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+#if CONFIG_WATCHMAN_DLOG_HOST_DECODE
+    ESP_LOGI(TAG, "Deferred log: %d byte ring per core, decode with tools/dlog.py", RING_SIZE);
+#else
+    ESP_LOGI(TAG, "Deferred log: %d byte ring per core", RING_SIZE);
+#endif
+    return ESP_OK;
+}
+
+/**
+ * Flush
+ */
+void dlog_flush(void)
+{
+    if (g_drain_lock == NULL) {
+        g_drain_lock = xSemaphoreCreateMutexStatic(&g_drain_lock_buf);
+    }
+    drain_all();
+}
+
+/**
+ * Get statistics
+ */
+void dlog_get_stats(dlog_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        stats->records += g_rings[core].records;
+        stats->dropped += g_rings[core].dropped;
+        if (g_rings[core].max_used > stats->max_used) stats->max_used = g_rings[core].max_used;
+    }
+}
+
+#else
+
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                const dlog_arg_t *args, uint32_t nargs)
+{
+    (void)level;
+    (void)tag;
+    (void)fmt;
+    (void)args;
+    (void)nargs;
+}
+
+esp_err_t dlog_start(void)
+{
+    (void)TAG;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void dlog_flush(void)
+{
+}
+
+void dlog_get_stats(dlog_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif // CONFIG_WATCHMAN_DLOG
@@ -0,0 +1,143 @@
+/**
+ * Deferred Binary Log
+ * ESP_LOG replacement for hot paths: record now, format later
+ *
+ * ESP_LOGI formats on the calling task and then waits for the UART, which
+ * costs milliseconds on the decode core per line, more with %f. DLOGI only
+ * copies the format string pointer, the tag pointer, a timestamp and the raw
+ * arguments into a per-core ring (interrupts masked for a few dozen cycles,
+ * no locks), and returns. A low-priority task drains the rings and either
+ * formats each record as the usual "I (ms) TAG: text" line, or, with
+ * CONFIG_WATCHMAN_DLOG_HOST_DECODE, prints the record as a hex "DLOG" line
+ * that tools/dlog.py turns back into text against the build's ELF, so the
+ * target never formats at all.
+ *
+ * Arguments are captured by value at the call, up to DLOG_MAX_ARGS of them:
+ * integers and pointers up to 32 bits, 64-bit integers, and float or double.
+ * A %s argument is captured as its pointer and read when the record is
+ * drained, so it must outlive the drain: string literals, tags,
+ * esp_err_to_name(), names held in static tables. Records are dropped, not
+ * waited for, when a ring is full.
+ *
+ * With CONFIG_WATCHMAN_DLOG off (and in the host build) DLOGx is ESP_LOGx.
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#define DLOG_MAX_ARGS           8
+#define DLOG_TASK_PERIOD_MS     50      // Drain interval
+#define DLOG_TASK_PRIORITY      1       // Just above idle
+#define DLOG_LINE_MAX           192     // Formatted or DLOG line length (drain side)
+
+/**
+ * One captured argument
+ */
+typedef union {
+    uint32_t u32;
+    uint64_t u64;
+    double f64;
+    const void *ptr;
+} dlog_arg_t;
+
+/**
+ * Ring statistics since boot
+ */
+typedef struct {
+    uint32_t records;           // Records written
+    uint32_t dropped;           // Records lost to a full ring
+    uint32_t max_used;          // Highest fill of any ring, bytes
+} dlog_stats_t;
+
+/**
+ * Start the drain task
+ * Records written before this are kept until the ring fills
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already running,
+ *         ESP_ERR_NOT_SUPPORTED if CONFIG_WATCHMAN_DLOG is off
+ */
+esp_err_t dlog_start(void);
+
+/**
+ * Drain every ring now, on the calling task
+ * For shutdown and before deliberate resets
+ */
+void dlog_flush(void);
+
+/**
+ * Get ring statistics
+ *
+ * @param stats Output statistics
+ */
+void dlog_get_stats(dlog_stats_t *stats);
+
+/**
+ * Write a record (use the DLOGx macros)
+ *
+ * @param level Log level
+ * @param tag Tag, must outlive the drain
+ * @param fmt printf format, must outlive the drain
+ * @param args Captured arguments
+ * @param nargs Number of arguments
+ */
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                const dlog_arg_t *args, uint32_t nargs);
+
+static inline dlog_arg_t dlog_u32(uint32_t v) { dlog_arg_t a = {.u64 = 0}; a.u32 = v; return a; }
+static inline dlog_arg_t dlog_u64(uint64_t v) { dlog_arg_t a = {.u64 = v}; return a; }
+static inline dlog_arg_t dlog_f64(double v) { dlog_arg_t a = {.f64 = v}; return a; }
+static inline dlog_arg_t dlog_ptr(const void *v) { dlog_arg_t a = {.u64 = 0}; a.ptr = v; return a; }
+
+// Argument capture by type
+#define DLOG_ARG(x) _Generic((x),                                           \
+    float: dlog_f64, double: dlog_f64,                                      \
+    long long: dlog_u64, unsigned long long: dlog_u64,                      \
+    char *: dlog_ptr, const char *: dlog_ptr,                               \
+    void *: dlog_ptr, const void *: dlog_ptr,                               \
+    default: dlog_u32)(x)
+
+// Argument count and per-argument expansion, 0 to DLOG_MAX_ARGS
+#define DLOG_NARGS(...) DLOG_NARGS_(_, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_, a1, a2, a3, a4, a5, a6, a7, a8, n, ...) n
+#define DLOG_CAT(a, b) DLOG_CAT_(a, b)
+#define DLOG_CAT_(a, b) a##b
+#define DLOG_MAP(...) DLOG_CAT(DLOG_MAP_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define DLOG_MAP_0()
+#define DLOG_MAP_1(a) , DLOG_ARG(a)
+#define DLOG_MAP_2(a, ...) , DLOG_ARG(a) DLOG_MAP_1(__VA_ARGS__)
+#define DLOG_MAP_3(a, ...) , DLOG_ARG(a) DLOG_MAP_2(__VA_ARGS__)
+#define DLOG_MAP_4(a, ...) , DLOG_ARG(a) DLOG_MAP_3(__VA_ARGS__)
+#define DLOG_MAP_5(a, ...) , DLOG_ARG(a) DLOG_MAP_4(__VA_ARGS__)
+#define DLOG_MAP_6(a, ...) , DLOG_ARG(a) DLOG_MAP_5(__VA_ARGS__)
+#define DLOG_MAP_7(a, ...) , DLOG_ARG(a) DLOG_MAP_6(__VA_ARGS__)
+#define DLOG_MAP_8(a, ...) , DLOG_ARG(a) DLOG_MAP_7(__VA_ARGS__)
+
+#if CONFIG_WATCHMAN_DLOG
+
+#define DLOG_LEVEL(level, tag, fmt, ...) do {                               \
+    if (LOG_LOCAL_LEVEL >= (level)) {                                       \
+        const dlog_arg_t dlog_args_[] = {{.u64 = 0} DLOG_MAP(__VA_ARGS__)}; \
+        dlog_write((level), (tag), (fmt), &dlog_args_[1],                   \
+                   DLOG_NARGS(__VA_ARGS__));                                \
+    }                                                                       \
+} while (0)
+
+#define DLOGW(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+#else
+
+#define DLOGW(tag, fmt, ...) ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) ESP_LOGD(tag, fmt, ##__VA_ARGS__)
+
+#endif // CONFIG_WATCHMAN_DLOG
+
+#endif // DLOG_H
@@ -0,0 +1,166 @@
+/**
+ * Memory Monitor
+ * Heap fragmentation and task stack telemetry with early-warning alarms
+ *
+ * Free heap alone says nothing about fragmentation: a JPEG or frame buffer
+ * malloc can fail with plenty of free heap left. This monitor tracks the
+ * largest free block per heap capability, the stack high-water mark of every
+ * registered task, and raises an event before the largest DMA-capable block
+ * drops below the configured threshold (normally one frame buffer).
+ */
+
+#ifndef MEM_MONITOR_H
+#define MEM_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#define MEM_MONITOR_MAX_TASKS           10
+#define MEM_MONITOR_TASK_NAME_LEN       16
+
+// Defaults
+#define MEM_MONITOR_SAMPLE_PERIOD_MS    2000
+#define MEM_MONITOR_HORIZON_SEC         120     // Warn if threshold is reached within 2 minutes
+#define MEM_MONITOR_STACK_WARN_BYTES    512     // Warn when less than this stack is left
+
+/**
+ * Heap capability classes tracked by the monitor
+ */
+typedef enum {
+    MEM_CAP_CLASS_DMA,          // MALLOC_CAP_DMA (frame buffers, SPI transfers)
+    MEM_CAP_CLASS_INTERNAL,     // MALLOC_CAP_INTERNAL
+    MEM_CAP_CLASS_SPIRAM,       // MALLOC_CAP_SPIRAM (0 when no PSRAM fitted)
+    MEM_CAP_CLASS_COUNT,
+} mem_cap_class_t;
+
+/**
+ * Per-capability heap statistics
+ */
+typedef struct {
+    size_t free_bytes;          // Current free size
+    size_t largest_block;       // Current largest free block
+    size_t min_free_bytes;      // Lowest free size seen since boot
+    size_t min_largest_block;   // Lowest largest block seen since init
+    int32_t trend_bytes_per_min; // Smoothed largest-block slope (negative = shrinking)
+} mem_cap_stats_t;
+
+/**
+ * Per-task stack statistics
+ */
+typedef struct {
+    char name[MEM_MONITOR_TASK_NAME_LEN];
+    bool running;               // Task currently exists
+    uint32_t stack_free_bytes;  // Last high-water mark (bytes never used)
+    uint32_t stack_min_bytes;   // Lowest high-water mark seen
+} mem_task_stats_t;
+
+/**
+ * Memory event type
+ */
+typedef enum {
+    MEM_EVENT_DMA_BLOCK_TRENDING,   // Largest DMA block predicted to cross threshold soon
+    MEM_EVENT_DMA_BLOCK_LOW,        // Largest DMA block is below threshold now
+    MEM_EVENT_DMA_BLOCK_RECOVERED,  // Largest DMA block back above threshold
+    MEM_EVENT_STACK_LOW,            // Task stack high-water mark below warning level
+} mem_event_type_t;
+
+/**
+ * Memory event
+ */
+typedef struct {
+    mem_event_type_t type;
+    size_t value;               // Largest block, or stack bytes left
+    size_t threshold;           // Threshold the value is compared against
+    uint32_t eta_sec;           // Predicted seconds until threshold (TRENDING only)
+    const char *task_name;      // Task name (STACK_LOW only)
+} mem_event_t;
+
+/**
+ * Memory event callback
+ * Runs in the monitor task context - keep it short
+ */
+typedef void (*mem_event_callback_t)(const mem_event_t *event, void *user_data);
+
+/**
+ * Memory monitor configuration
+ */
+typedef struct {
+    uint32_t sample_period_ms;      // Sampling interval
+    size_t dma_block_threshold;     // Minimum acceptable largest DMA block (e.g. frame size)
+    uint32_t predict_horizon_sec;   // Raise TRENDING when threshold is this close
+    uint32_t stack_warn_bytes;      // Raise STACK_LOW below this many free bytes
+    mem_event_callback_t callback;
+    void *user_data;
+} mem_monitor_config_t;
+
+/**
+ * Memory monitor handle
+ */
+typedef struct mem_monitor_s mem_monitor_t;
+
+/**
+ * Initialize memory monitor and start its sampling task
+ *
+ * @param config Monitor configuration (NULL for defaults, no threshold alarms)
+ * @return Monitor handle, or NULL on failure
+ */
+mem_monitor_t *mem_monitor_init(const mem_monitor_config_t *config);
+
+/**
+ * Stop sampling task and free monitor
+ *
+ * @param mon Monitor handle
+ */
+void mem_monitor_deinit(mem_monitor_t *mon);
+
+/**
+ * Track stack usage of a task by name
+ * Tasks are looked up by name on every sample, so tasks that are created and
+ * deleted repeatedly (e.g. the video playback task) can be registered once.
+ *
+ * @param mon Monitor handle
+ * @param task_name FreeRTOS task name
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the task table is full
+ */
+esp_err_t mem_monitor_watch_task(mem_monitor_t *mon, const char *task_name);
+
+/**
+ * Get statistics for one heap capability class
+ *
+ * @param mon Monitor handle
+ * @param cls Capability class
+ * @param stats Output statistics
+ * @return ESP_OK on success
+ */
+esp_err_t mem_monitor_get_heap_stats(const mem_monitor_t *mon, mem_cap_class_t cls,
+                                     mem_cap_stats_t *stats);
+
+/**
+ * Get stack statistics for a watched task
+ *
+ * @param mon Monitor handle
+ * @param index Task index (0 .. mem_monitor_get_task_count()-1)
+ * @param stats Output statistics
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if index is out of range
+ */
+esp_err_t mem_monitor_get_task_stats(const mem_monitor_t *mon, uint8_t index,
+                                     mem_task_stats_t *stats);
+
+/**
+ * Get number of watched tasks
+ *
+ * @param mon Monitor handle
+ * @return Number of watched tasks
+ */
+uint8_t mem_monitor_get_task_count(const mem_monitor_t *mon);
+
+/**
+ * Log a one-shot report of heap and stack statistics
+ *
+ * @param mon Monitor handle
+ */
+void mem_monitor_log_report(const mem_monitor_t *mon);
+
+#endif // MEM_MONITOR_H
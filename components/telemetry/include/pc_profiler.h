@@ -0,0 +1,89 @@
+/**
+ * PC Sampling Profiler
+ * Statistical profile of where one core spends its time, split by the memory
+ * the code runs from
+ *
+ * On every FreeRTOS tick of the sampled core the profiler records the
+ * program counter the tick interrupted, in 32-byte buckets. Code in IRAM
+ * never misses; code in flash runs through the cache, which SD and SPI flash
+ * traffic evicts mid-frame. The report splits the samples by region and logs
+ * the hottest buckets as "PCPROF" lines for tools/pcprof.py, which resolves
+ * them to function names against the build's ELF. Flash functions near the
+ * top are the candidates for the IRAM placement in the components'
+ * linker.lf files.
+ */
+
+#ifndef PC_PROFILER_H
+#define PC_PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define PC_PROFILER_BUCKETS         1024    // Distinct code ranges tracked (8 KB)
+#define PC_PROFILER_BUCKET_BITS     5       // 32-byte ranges
+#define PC_PROFILER_TOP             20      // Hottest ranges in the report
+
+/**
+ * Memory region of a sampled PC
+ */
+typedef enum {
+    PC_REGION_IRAM,         // Internal instruction RAM
+    PC_REGION_FLASH,        // Flash, through the cache
+    PC_REGION_ROM,          // Mask ROM (libc, boot helpers)
+    PC_REGION_OTHER,
+    PC_REGION_COUNT,
+} pc_region_t;
+
+/**
+ * Sample totals
+ */
+typedef struct {
+    uint32_t samples;                   // Ticks sampled since start or reset
+    uint32_t region[PC_REGION_COUNT];   // Samples per region
+    uint32_t dropped;                   // Not bucketed because the table was full
+} pc_profile_t;
+
+/**
+ * Start sampling one core
+ * Only one profile runs at a time. On targets without the Xtensa interrupt
+ * frame layout this returns ESP_ERR_NOT_SUPPORTED.
+ *
+ * @param core Core to sample (the one running the code of interest)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already running
+ */
+esp_err_t pc_profiler_start(int core);
+
+/**
+ * Stop sampling and free the bucket table
+ */
+void pc_profiler_stop(void);
+
+/**
+ * Check if sampling
+ *
+ * @return true between start and stop
+ */
+bool pc_profiler_running(void);
+
+/**
+ * Clear all samples (keeps sampling)
+ */
+void pc_profiler_reset(void);
+
+/**
+ * Get sample totals
+ *
+ * @param profile Output totals
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running
+ */
+esp_err_t pc_profiler_get(pc_profile_t *profile);
+
+/**
+ * Log IRAM use, the region split and the hottest PC ranges
+ *
+ * @param fps Frame rate achieved over the sampled interval (0 if unknown)
+ */
+void pc_profiler_log_report(float fps);
+
+#endif // PC_PROFILER_H
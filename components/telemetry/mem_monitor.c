@@ -0,0 +1,361 @@
+/**
+ * Memory Monitor Implementation
+ */
+
+#include "mem_monitor.h"
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "MEM_MON";
+
+#define MONITOR_TASK_STACK_SIZE     3072
+#define MONITOR_TASK_PRIORITY       2   // Below everything in the playback path
+
+// Trend smoothing: slope = slope + (delta - slope) / 2^TREND_SHIFT
+#define TREND_SHIFT                 2
+
+static const uint32_t cap_flags[MEM_CAP_CLASS_COUNT] = {
+    [MEM_CAP_CLASS_DMA]      = MALLOC_CAP_DMA,
+    [MEM_CAP_CLASS_INTERNAL] = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+    [MEM_CAP_CLASS_SPIRAM]   = MALLOC_CAP_SPIRAM,
+};
+
+static const char *cap_names[MEM_CAP_CLASS_COUNT] = {
+    [MEM_CAP_CLASS_DMA]      = "DMA",
+    [MEM_CAP_CLASS_INTERNAL] = "INTERNAL",
+    [MEM_CAP_CLASS_SPIRAM]   = "PSRAM",
+};
+
+/**
+ * Memory monitor structure
+ */
+struct mem_monitor_s {
+    mem_monitor_config_t config;
+
+    mem_cap_stats_t heap[MEM_CAP_CLASS_COUNT];
+    int32_t dma_slope;          // Smoothed largest-block delta per sample (bytes)
+    bool have_sample;
+
+    mem_task_stats_t tasks[MEM_MONITOR_MAX_TASKS];
+    bool stack_warned[MEM_MONITOR_MAX_TASKS];
+    uint8_t task_count;
+
+    // Alarm latches (hysteresis so each condition fires once)
+    bool trending_raised;
+    bool low_raised;
+
+    TaskHandle_t monitor_task;
+};
+
+/**
+ * Deliver event to callback
+ */
+static void raise_event(mem_monitor_t *mon, const mem_event_t *event)
+{
+    if (mon->config.callback) {
+        mon->config.callback(event, mon->config.user_data);
+    }
+}
+
+/**
+ * Sample all heap capability classes
+ */
+static void sample_heap(mem_monitor_t *mon)
+{
+    for (int i = 0; i < MEM_CAP_CLASS_COUNT; i++) {
+        mem_cap_stats_t *s = &mon->heap[i];
+        size_t prev_largest = s->largest_block;
+
+        s->free_bytes = heap_caps_get_free_size(cap_flags[i]);
+        s->largest_block = heap_caps_get_largest_free_block(cap_flags[i]);
+        s->min_free_bytes = heap_caps_get_minimum_free_size(cap_flags[i]);
+
+        if (!mon->have_sample || s->largest_block < s->min_largest_block) {
+            s->min_largest_block = s->largest_block;
+        }
+
+        if (i == MEM_CAP_CLASS_DMA && mon->have_sample) {
+            int32_t delta = (int32_t)s->largest_block - (int32_t)prev_largest;
+            mon->dma_slope += (delta - mon->dma_slope) >> TREND_SHIFT;
+        }
+
+        s->trend_bytes_per_min = (i == MEM_CAP_CLASS_DMA)
+            ? (int32_t)(((int64_t)mon->dma_slope * 60000) / mon->config.sample_period_ms)
+            : 0;
+    }
+
+    mon->have_sample = true;
+}
+
+/**
+ * Check DMA largest-block threshold and trend
+ */
+static void check_dma_threshold(mem_monitor_t *mon)
+{
+    size_t threshold = mon->config.dma_block_threshold;
+    if (threshold == 0) return;
+
+    size_t largest = mon->heap[MEM_CAP_CLASS_DMA].largest_block;
+
+    if (largest < threshold) {
+        if (!mon->low_raised) {
+            mon->low_raised = true;
+            ESP_LOGE(TAG, "Largest DMA block %u < %u bytes", largest, threshold);
+            mem_event_t event = {
+                .type = MEM_EVENT_DMA_BLOCK_LOW,
+                .value = largest,
+                .threshold = threshold,
+            };
+            raise_event(mon, &event);
+        }
+        return;
+    }
+
+    if (mon->low_raised) {
+        mon->low_raised = false;
+        mon->trending_raised = false;
+        ESP_LOGI(TAG, "Largest DMA block recovered: %u bytes", largest);
+        mem_event_t event = {
+            .type = MEM_EVENT_DMA_BLOCK_RECOVERED,
+            .value = largest,
+            .threshold = threshold,
+        };
+        raise_event(mon, &event);
+        return;
+    }
+
+    // Shrinking: extrapolate time until the threshold is crossed
+    if (mon->dma_slope < 0) {
+        uint64_t headroom = largest - threshold;
+        uint64_t samples_left = headroom / (uint32_t)(-mon->dma_slope);
+        uint32_t eta_sec = (samples_left * mon->config.sample_period_ms) / 1000;
+
+        if (eta_sec <= mon->config.predict_horizon_sec && !mon->trending_raised) {
+            mon->trending_raised = true;
+            ESP_LOGW(TAG, "Largest DMA block %u bytes shrinking, threshold in ~%lu s",
+                     largest, eta_sec);
+            mem_event_t event = {
+                .type = MEM_EVENT_DMA_BLOCK_TRENDING,
+                .value = largest,
+                .threshold = threshold,
+                .eta_sec = eta_sec,
+            };
+            raise_event(mon, &event);
+        }
+    } else {
+        // Trend flattened out - re-arm
+        mon->trending_raised = false;
+    }
+}
+
+/**
+ * Sample stack high-water marks of watched tasks
+ */
+static void sample_tasks(mem_monitor_t *mon)
+{
+    for (int i = 0; i < mon->task_count; i++) {
+        mem_task_stats_t *t = &mon->tasks[i];
+
+        // Look up and read under a suspended scheduler so a self-deleting
+        // task (video_playback, radio_playback) can't be freed in between
+        vTaskSuspendAll();
+        TaskHandle_t handle = xTaskGetHandle(t->name);
+        t->running = (handle != NULL);
+        if (t->running) {
+            // ESP-IDF reports the high-water mark in bytes
+            t->stack_free_bytes = uxTaskGetStackHighWaterMark(handle);
+        }
+        xTaskResumeAll();
+        if (!t->running) continue;
+
+        if (t->stack_min_bytes == 0 || t->stack_free_bytes < t->stack_min_bytes) {
+            t->stack_min_bytes = t->stack_free_bytes;
+        }
+
+        if (t->stack_free_bytes < mon->config.stack_warn_bytes && !mon->stack_warned[i]) {
+            mon->stack_warned[i] = true;
+            ESP_LOGW(TAG, "Task '%s' stack low: %lu bytes left", t->name, t->stack_free_bytes);
+            mem_event_t event = {
+                .type = MEM_EVENT_STACK_LOW,
+                .value = t->stack_free_bytes,
+                .threshold = mon->config.stack_warn_bytes,
+                .task_name = t->name,
+            };
+            raise_event(mon, &event);
+        }
+    }
+}
+
+/**
+ * Monitoring task
+ */
+static void mem_monitor_task(void *pvParameters)
+{
+    mem_monitor_t *mon = (mem_monitor_t *)pvParameters;
+
+    ESP_LOGI(TAG, "Memory monitor task started");
+
+    while (1) {
+        sample_heap(mon);
+        check_dma_threshold(mon);
+        sample_tasks(mon);
+
+        vTaskDelay(pdMS_TO_TICKS(mon->config.sample_period_ms));
+    }
+}
+
+/**
+ * Initialize memory monitor
+ */
+mem_monitor_t *mem_monitor_init(const mem_monitor_config_t *config)
+{
+    ESP_LOGI(TAG, "Initializing memory monitor...");
+
+    mem_monitor_t *mon = malloc(sizeof(mem_monitor_t));
+    if (mon == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory monitor");
+        return NULL;
+    }
+
+    memset(mon, 0, sizeof(mem_monitor_t));
+
+    // Use default config if none provided
+    if (config) {
+        memcpy(&mon->config, config, sizeof(mem_monitor_config_t));
+    } else {
+        mon->config.predict_horizon_sec = MEM_MONITOR_HORIZON_SEC;
+        mon->config.stack_warn_bytes = MEM_MONITOR_STACK_WARN_BYTES;
+    }
+
+    if (mon->config.sample_period_ms == 0) {
+        mon->config.sample_period_ms = MEM_MONITOR_SAMPLE_PERIOD_MS;
+    }
+
+    // Take a first sample so stats are valid before the task runs
+    sample_heap(mon);
+
+    BaseType_t ret = xTaskCreate(mem_monitor_task, "mem_monitor", MONITOR_TASK_STACK_SIZE,
+                                 mon, MONITOR_TASK_PRIORITY, &mon->monitor_task);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create monitor task");
+        free(mon);
+        return NULL;
+    }
+
+    // The monitor watches itself too
+    mem_monitor_watch_task(mon, "mem_monitor");
+
+    ESP_LOGI(TAG, "Memory monitor initialized (period %lu ms, DMA threshold %u bytes)",
+             mon->config.sample_period_ms, mon->config.dma_block_threshold);
+
+    return mon;
+}
+
+/**
+ * Deinitialize memory monitor
+ */
+void mem_monitor_deinit(mem_monitor_t *mon)
+{
+    if (mon == NULL) return;
+
+    if (mon->monitor_task) {
+        vTaskDelete(mon->monitor_task);
+    }
+
+    free(mon);
+
+    ESP_LOGI(TAG, "Memory monitor deinitialized");
+}
+
+/**
+ * Watch task stack by name
+ */
+esp_err_t mem_monitor_watch_task(mem_monitor_t *mon, const char *task_name)
+{
+    if (mon == NULL || task_name == NULL) return ESP_ERR_INVALID_ARG;
+
+    for (int i = 0; i < mon->task_count; i++) {
+        if (strncmp(mon->tasks[i].name, task_name, MEM_MONITOR_TASK_NAME_LEN - 1) == 0) {
+            return ESP_OK;  // Already watched
+        }
+    }
+
+    if (mon->task_count >= MEM_MONITOR_MAX_TASKS) {
+        ESP_LOGW(TAG, "Task table full, not watching '%s'", task_name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    mem_task_stats_t *t = &mon->tasks[mon->task_count];
+    memset(t, 0, sizeof(mem_task_stats_t));
+    strncpy(t->name, task_name, MEM_MONITOR_TASK_NAME_LEN - 1);
+    mon->stack_warned[mon->task_count] = false;
+    mon->task_count++;
+
+    return ESP_OK;
+}
+
+/**
+ * Get heap stats
+ */
+esp_err_t mem_monitor_get_heap_stats(const mem_monitor_t *mon, mem_cap_class_t cls,
+                                     mem_cap_stats_t *stats)
+{
+    if (mon == NULL || stats == NULL || cls >= MEM_CAP_CLASS_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memcpy(stats, &mon->heap[cls], sizeof(mem_cap_stats_t));
+
+    return ESP_OK;
+}
+
+/**
+ * Get task stats
+ */
+esp_err_t mem_monitor_get_task_stats(const mem_monitor_t *mon, uint8_t index,
+                                     mem_task_stats_t *stats)
+{
+    if (mon == NULL || stats == NULL) return ESP_ERR_INVALID_ARG;
+    if (index >= mon->task_count) return ESP_ERR_NOT_FOUND;
+
+    memcpy(stats, &mon->tasks[index], sizeof(mem_task_stats_t));
+
+    return ESP_OK;
+}
+
+/**
+ * Get task count
+ */
+uint8_t mem_monitor_get_task_count(const mem_monitor_t *mon)
+{
+    return mon ? mon->task_count : 0;
+}
+
+/**
+ * Log report
+ */
+void mem_monitor_log_report(const mem_monitor_t *mon)
+{
+    if (mon == NULL) return;
+
+    for (int i = 0; i < MEM_CAP_CLASS_COUNT; i++) {
+        const mem_cap_stats_t *s = &mon->heap[i];
+        if (s->free_bytes == 0 && s->largest_block == 0) continue;  // e.g. no PSRAM
+
+        ESP_LOGI(TAG, "%-8s free %6u (min %6u)  largest %6u (min %6u)  trend %ld B/min",
+                 cap_names[i], s->free_bytes, s->min_free_bytes,
+                 s->largest_block, s->min_largest_block, s->trend_bytes_per_min);
+    }
+
+    for (int i = 0; i < mon->task_count; i++) {
+        const mem_task_stats_t *t = &mon->tasks[i];
+        if (!t->running) continue;
+
+        ESP_LOGI(TAG, "  task %-16s stack free %5lu (min %5lu)",
+                 t->name, t->stack_free_bytes, t->stack_min_bytes);
+    }
+}
@@ -0,0 +1,253 @@
+/**
+ * PC Sampling Profiler Implementation
+ *
+ * The Xtensa FreeRTOS port saves the interrupted task's stack pointer in its
+ * TCB (pxTopOfStack, the first TCB field) on entry to a non-nested
+ * interrupt, and the interrupt frame (XtExcFrame) starts at that SP, so the
+ * tick hook reads the interrupted PC from there. A tick nested inside
+ * another interrupt sees the outer frame, which attributes handler time to
+ * the task code it interrupted. With tickless idle the core takes no ticks
+ * while idle, so the profile covers busy time.
+ */
+
+#include "pc_profiler.h"
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_freertos_hooks.h"
+#include "soc/soc.h"
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+#include "xtensa_context.h"
+#endif
+
+static const char *TAG = "PC_PROF";
+
+#define HASH_BITS       10      // log2(PC_PROFILER_BUCKETS)
+#define PROBE_LIMIT     16      // Slots tried before a sample is dropped
+
+_Static_assert((1 << HASH_BITS) == PC_PROFILER_BUCKETS, "HASH_BITS must match PC_PROFILER_BUCKETS");
+
+/**
+ * One code range
+ */
+typedef struct {
+    uint32_t base;      // PC >> PC_PROFILER_BUCKET_BITS, 0 = empty slot
+    uint32_t count;
+} pc_bucket_t;
+
+static const char *region_names[PC_REGION_COUNT] = {
+    [PC_REGION_IRAM]  = "iram",
+    [PC_REGION_FLASH] = "flash",
+    [PC_REGION_ROM]   = "rom",
+    [PC_REGION_OTHER] = "other",
+};
+
+// Shared with the tick hook, which runs in ISR context on the sampled core
+static portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+static pc_bucket_t *g_buckets = NULL;
+static pc_profile_t g_totals;
+static int g_core = -1;
+
+// IRAM text bounds from the linker script
+extern int _iram_text_start;
+extern int _iram_text_end;
+
+static inline __attribute__((always_inline)) pc_region_t region_of(uint32_t pc)
+{
+    if (pc >= SOC_IRAM_LOW && pc < SOC_IRAM_HIGH) return PC_REGION_IRAM;
+    if (pc >= SOC_IROM_LOW && pc < SOC_IROM_HIGH) return PC_REGION_FLASH;
+    if (pc >= SOC_IROM_MASK_LOW && pc < SOC_IROM_MASK_HIGH) return PC_REGION_ROM;
+    return PC_REGION_OTHER;
+}
+
+/**
+ * Record the interrupted PC (tick ISR, must stay in IRAM)
+ */
+static void IRAM_ATTR tick_hook(void)
+{
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+    const XtExcFrame *frame = *(XtExcFrame * const *)xTaskGetCurrentTaskHandle();
+    uint32_t pc = frame->pc;
+    uint32_t base = pc >> PC_PROFILER_BUCKET_BITS;
+    uint32_t slot = (base * 2654435761u) >> (32 - HASH_BITS);   // Fibonacci hash
+
+    portENTER_CRITICAL_ISR(&g_lock);
+    if (g_buckets != NULL) {
+        g_totals.samples++;
+        g_totals.region[region_of(pc)]++;
+
+        int i;
+        for (i = 0; i < PROBE_LIMIT; i++) {
+            pc_bucket_t *b = &g_buckets[(slot + i) & (PC_PROFILER_BUCKETS - 1)];
+            if (b->base == base || b->base == 0) {
+                b->base = base;
+                b->count++;
+                break;
+            }
+        }
+        if (i == PROBE_LIMIT) g_totals.dropped++;
+    }
+    portEXIT_CRITICAL_ISR(&g_lock);
+#endif
+}
+
+/**
+ * Start sampling
+ */
+esp_err_t pc_profiler_start(int core)
+{
+#if !CONFIG_IDF_TARGET_ARCH_XTENSA
+    (void)core;
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    if (core < 0 || core >= portNUM_PROCESSORS) return ESP_ERR_INVALID_ARG;
+    if (g_buckets != NULL) return ESP_ERR_INVALID_STATE;
+
+    // Internal RAM: the hook writes it from the tick ISR
+    pc_bucket_t *buckets = heap_caps_calloc(PC_PROFILER_BUCKETS, sizeof(pc_bucket_t),
+                                            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (buckets == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate bucket table");
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&g_lock);
+    g_buckets = buckets;
+    memset(&g_totals, 0, sizeof(g_totals));
+    portEXIT_CRITICAL(&g_lock);
+
+    esp_err_t ret = esp_register_freertos_tick_hook_for_cpu(tick_hook, core);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register tick hook: %s", esp_err_to_name(ret));
+        portENTER_CRITICAL(&g_lock);
+        g_buckets = NULL;
+        portEXIT_CRITICAL(&g_lock);
+        free(buckets);
+        return ret;
+    }
+
+    g_core = core;
+    ESP_LOGI(TAG, "Sampling core %d at %d Hz", core, configTICK_RATE_HZ);
+    return ESP_OK;
+#endif
+}
+
+/**
+ * Stop sampling
+ */
+void pc_profiler_stop(void)
+{
+    if (g_buckets == NULL) return;
+
+    esp_deregister_freertos_tick_hook_for_cpu(tick_hook, g_core);
+
+    portENTER_CRITICAL(&g_lock);
+    pc_bucket_t *buckets = g_buckets;
+    g_buckets = NULL;
+    portEXIT_CRITICAL(&g_lock);
+
+    free(buckets);
+    g_core = -1;
+}
+
+/**
+ * Check if sampling
+ */
+bool pc_profiler_running(void)
+{
+    return g_buckets != NULL;
+}
+
+/**
+ * Clear samples
+ */
+void pc_profiler_reset(void)
+{
+    portENTER_CRITICAL(&g_lock);
+    if (g_buckets != NULL) {
+        memset(g_buckets, 0, PC_PROFILER_BUCKETS * sizeof(pc_bucket_t));
+        memset(&g_totals, 0, sizeof(g_totals));
+    }
+    portEXIT_CRITICAL(&g_lock);
+}
+
+/**
+ * Get sample totals
+ */
+esp_err_t pc_profiler_get(pc_profile_t *profile)
+{
+    if (profile == NULL) return ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL(&g_lock);
+    bool running = (g_buckets != NULL);
+    *profile = g_totals;
+    portEXIT_CRITICAL(&g_lock);
+
+    return running ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+/**
+ * Log report
+ */
+void pc_profiler_log_report(float fps)
+{
+    uint32_t iram_text = (uintptr_t)&_iram_text_end - (uintptr_t)&_iram_text_start;
+    uint32_t iram_size = SOC_IRAM_HIGH - SOC_IRAM_LOW;
+
+#ifdef CONFIG_WATCHMAN_HOT_CODE_IN_IRAM
+    const char *placement = "in IRAM";
+#else
+    const char *placement = "in flash";
+#endif
+    ESP_LOGI(TAG, "IRAM code %lu of %lu bytes (%lu%%), playback hot paths %s",
+             iram_text, iram_size, iram_text * 100 / iram_size, placement);
+
+    if (g_buckets == NULL) return;
+
+    // Snapshot, so the ranking runs outside the critical section
+    pc_bucket_t *snap = malloc(PC_PROFILER_BUCKETS * sizeof(pc_bucket_t));
+    if (snap == NULL) {
+        ESP_LOGE(TAG, "Out of memory for report");
+        return;
+    }
+
+    pc_profile_t totals;
+    portENTER_CRITICAL(&g_lock);
+    bool running = (g_buckets != NULL);
+    if (running) memcpy(snap, g_buckets, PC_PROFILER_BUCKETS * sizeof(pc_bucket_t));
+    totals = g_totals;
+    portEXIT_CRITICAL(&g_lock);
+
+    if (!running || totals.samples == 0) {
+        free(snap);
+        return;
+    }
+
+    // Parsed by tools/pcprof.py: one header line, then one line per range
+    ESP_LOGI(TAG, "PCPROF samples %lu fps %.2f iram %lu flash %lu rom %lu other %lu dropped %lu",
+             totals.samples, fps, totals.region[PC_REGION_IRAM], totals.region[PC_REGION_FLASH],
+             totals.region[PC_REGION_ROM], totals.region[PC_REGION_OTHER], totals.dropped);
+    ESP_LOGI(TAG, "  %lu%% of busy time in flash code",
+             totals.region[PC_REGION_FLASH] * 100 / totals.samples);
+
+    for (int n = 0; n < PC_PROFILER_TOP; n++) {
+        pc_bucket_t *top = NULL;
+        for (int i = 0; i < PC_PROFILER_BUCKETS; i++) {
+            if (snap[i].count && (top == NULL || snap[i].count > top->count)) top = &snap[i];
+        }
+        if (top == NULL) break;
+
+        uint32_t pc = top->base << PC_PROFILER_BUCKET_BITS;
+        ESP_LOGI(TAG, "PCPROF 0x%08lx %6lu %5.1f%% %s", pc, top->count,
+                 top->count * 100.0f / totals.samples, region_names[region_of(pc)]);
+        top->count = 0;
+    }
+
+    free(snap);
+}
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "esp_log.h"
+#include "dlog.h"
 
 static const char *TAG = "AVI_PARSER";
 
@@ -49,9 +50,9 @@ static esp_err_t parse_avih(avi_parser_t *parser, uint32_t size)
     parser->main_header.width = read_le32(parser->file);
     parser->main_header.height = read_le32(parser->file);
 
-    ESP_LOGI(TAG, "AVI Header: %lux%lu, %lu frames, %lu streams",
-             parser->main_header.width, parser->main_header.height,
-             parser->main_header.total_frames, parser->main_header.streams);
+    DLOGI(TAG, "AVI Header: %lux%lu, %lu frames, %lu streams",
+          parser->main_header.width, parser->main_header.height,
+          parser->main_header.total_frames, parser->main_header.streams);
 
     parser->total_frames = parser->main_header.total_frames;
 
@@ -85,12 +86,18 @@ static esp_err_t parse_strh(avi_parser_t *parser, uint32_t size)
     strh.quality = read_le32(parser->file);
     strh.sample_size = read_le32(parser->file);
 
+    parser->strh_type = strh.fourcc_type;
+
     if (strh.fourcc_type == FOURCC_VIDS) {
-        ESP_LOGI(TAG, "Video stream: %lu frames, rate=%lu/%lu fps",
-                 strh.length, strh.rate, strh.scale);
+        DLOGI(TAG, "Video stream: %lu frames, rate=%lu/%lu fps",
+              strh.length, strh.rate, strh.scale);
+        if (parser->video_info.rate == 0) {
+            parser->video_info.rate = strh.rate;
+            parser->video_info.scale = strh.scale;
+        }
     } else if (strh.fourcc_type == FOURCC_AUDS) {
-        ESP_LOGI(TAG, "Audio stream: rate=%lu/%lu",
-                 strh.rate, strh.scale);
+        DLOGI(TAG, "Audio stream: rate=%lu/%lu",
+              strh.rate, strh.scale);
         parser->audio_info.found = true;
     }
 
@@ -110,15 +117,16 @@ static esp_err_t parse_strf_video(avi_parser_t *parser, uint32_t size)
 {
     fseek(parser->file, 4, SEEK_CUR);  // size
     parser->video_info.width = read_le32(parser->file);
-    parser->video_info.height = read_le32(parser->file);
+    int32_t height = (int32_t)read_le32(parser->file);  // Negative = top-down
+    parser->video_info.height = (height < 0) ? -height : height;
     fseek(parser->file, 2, SEEK_CUR);  // planes
     parser->video_info.bit_count = read_le16(parser->file);
     parser->video_info.compression = read_fourcc(parser->file);
     parser->video_info.found = true;
 
-    ESP_LOGI(TAG, "Video format: %dx%d, %d-bit, compression=0x%08lX",
-             parser->video_info.width, parser->video_info.height,
-             parser->video_info.bit_count, parser->video_info.compression);
+    DLOGI(TAG, "Video format: %dx%d, %d-bit, compression=0x%08lX",
+          parser->video_info.width, parser->video_info.height,
+          parser->video_info.bit_count, parser->video_info.compression);
 
     // Skip remaining format data
     long remaining = size - 20;
@@ -141,9 +149,9 @@ static esp_err_t parse_strf_audio(avi_parser_t *parser, uint32_t size)
     parser->audio_info.block_align = read_le16(parser->file);
     parser->audio_info.bits_per_sample = read_le16(parser->file);
 
-    ESP_LOGI(TAG, "Audio format: %d Hz, %d ch, %d-bit, format=0x%04X",
-             parser->audio_info.samples_per_sec, parser->audio_info.channels,
-             parser->audio_info.bits_per_sample, parser->audio_info.format_tag);
+    DLOGI(TAG, "Audio format: %d Hz, %d ch, %d-bit, format=0x%04X",
+          parser->audio_info.samples_per_sec, parser->audio_info.channels,
+          parser->audio_info.bits_per_sample, parser->audio_info.format_tag);
 
     // Skip remaining format data
     long remaining = size - 16;
@@ -166,8 +174,8 @@ static esp_err_t parse_list(avi_parser_t *parser, uint32_t list_size)
         // Found movie data - save offset and return
         parser->movi_offset = ftell(parser->file);
         parser->movi_size = list_size - 4;
-        ESP_LOGI(TAG, "Found 'movi' chunk at offset %lu, size %lu",
-                 parser->movi_offset, parser->movi_size);
+        DLOGI(TAG, "Found 'movi' chunk at offset %lu, size %lu",
+              parser->movi_offset, parser->movi_size);
         return ESP_OK;
     }
 
@@ -182,11 +190,13 @@ static esp_err_t parse_list(avi_parser_t *parser, uint32_t list_size)
         } else if (fourcc == FOURCC_STRH) {
             parse_strh(parser, size);
         } else if (fourcc == FOURCC_STRF) {
-            // Determine if video or audio based on previous strh
-            if (parser->video_info.found) {
+            // Format layout depends on the preceding strh
+            if (parser->strh_type == FOURCC_VIDS) {
                 parse_strf_video(parser, size);
-            } else {
+            } else if (parser->strh_type == FOURCC_AUDS) {
                 parse_strf_audio(parser, size);
+            } else {
+                fseek(parser->file, size, SEEK_CUR);
             }
         } else if (fourcc == FOURCC_LIST) {
             parse_list(parser, size);
@@ -219,14 +229,14 @@ static esp_err_t parse_avi_header(avi_parser_t *parser)
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint32_t file_size = read_le32(parser->file);
+    fseek(parser->file, 4, SEEK_CUR);  // RIFF size
     fourcc = read_fourcc(parser->file);
     if (fourcc != FOURCC_AVI) {
         ESP_LOGE(TAG, "Not an AVI file");
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "Parsing AVI file, size: %lu bytes", file_size);
+    DLOGI(TAG, "Parsing AVI file");
 
     // Parse chunks
     while (!feof(parser->file)) {
@@ -265,6 +275,14 @@ static esp_err_t parse_avi_header(avi_parser_t *parser)
  * Open AVI file
  */
 esp_err_t avi_parser_open(avi_parser_t *parser, const char *file_path)
+{
+    return avi_parser_open_buffered(parser, file_path, 0);
+}
+
+/**
+ * Open AVI file with read buffer
+ */
+esp_err_t avi_parser_open_buffered(avi_parser_t *parser, const char *file_path, uint32_t buffer_size)
 {
     if (parser == NULL || file_path == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -280,27 +298,59 @@ esp_err_t avi_parser_open(avi_parser_t *parser, const char *file_path)
         return ESP_FAIL;
     }
 
+    // Must be set before the first read
+    if (buffer_size > 0) {
+        parser->io_buffer = malloc(buffer_size);
+        if (parser->io_buffer == NULL ||
+            setvbuf(parser->file, (char *)parser->io_buffer, _IOFBF, buffer_size) != 0) {
+            ESP_LOGW(TAG, "Using default read buffer");
+            free(parser->io_buffer);
+            parser->io_buffer = NULL;
+        }
+    }
+
     // Parse AVI structure
     esp_err_t ret = parse_avi_header(parser);
     if (ret != ESP_OK) {
         fclose(parser->file);
         parser->file = NULL;
+        free(parser->io_buffer);
+        parser->io_buffer = NULL;
         return ret;
     }
 
+    // Stream rate/scale is exact; the main header period is rounded to 1 us
+    if (parser->video_info.rate != 0 && parser->video_info.scale != 0) {
+        timebase_init(&parser->timebase, parser->video_info.rate, parser->video_info.scale);
+    } else {
+        timebase_init(&parser->timebase, 1000000, parser->main_header.micro_sec_per_frame);
+    }
+
+    // Load or build the sparse frame index (cached on card next to the file)
+    ret = frame_index_open(&parser->index, file_path, parser->file,
+                           parser->movi_offset, parser->movi_size, parser->total_frames);
+    if (ret == ESP_OK) {
+        parser->has_index = true;
+        if (parser->total_frames == 0) {
+            parser->total_frames = parser->index.total_frames;
+        }
+    } else {
+        ESP_LOGW(TAG, "No frame index, seeking will be linear");
+    }
+
     // Seek to start of movie data
     fseek(parser->file, parser->movi_offset, SEEK_SET);
     parser->current_frame = 0;
     parser->initialized = true;
 
-    ESP_LOGI(TAG, "AVI file opened successfully");
-    ESP_LOGI(TAG, "Video: %dx%d, %lu frames",
-             parser->video_info.width, parser->video_info.height,
-             parser->total_frames);
+    DLOGI(TAG, "AVI file opened successfully");
+    DLOGI(TAG, "Video: %dx%d, %lu frames",
+          parser->video_info.width, parser->video_info.height,
+          parser->total_frames);
     if (parser->audio_info.found) {
-        ESP_LOGI(TAG, "Audio: %lu Hz, %d channels",
-                 parser->audio_info.samples_per_sec,
-                 parser->audio_info.channels);
+        DLOGI(TAG, "Audio: %lu Hz, %d channels",
+              parser->audio_info.samples_per_sec,
+              parser->audio_info.channels);
     }
 
     return ESP_OK;
@@ -318,9 +368,18 @@ void avi_parser_close(avi_parser_t *parser)
         parser->file = NULL;
     }
 
+    // Buffer is in use by the stream until fclose
+    free(parser->io_buffer);
+    parser->io_buffer = NULL;
+
+    if (parser->has_index) {
+        frame_index_close(&parser->index);
+        parser->has_index = false;
+    }
+
     parser->initialized = false;
 
-    ESP_LOGI(TAG, "AVI file closed");
+    DLOGI(TAG, "AVI file closed");
 }
 
 /**
@@ -342,7 +401,7 @@ esp_err_t avi_parser_read_video_frame(avi_parser_t *parser, mjpeg_frame_t *frame
         uint32_t size = read_le32(parser->file);
 
         // Check if this is a video chunk (00dc = compressed, 00db = uncompressed)
-        if ((fourcc & 0xFFFF) == 0x6364 || (fourcc & 0xFFFF) == 0x6264) {  // "dc" or "db"
+        if (AVI_CHUNK_IS_VIDEO(fourcc)) {
             // Allocate buffer for frame data
             frame->data = malloc(size);
             if (frame->data == NULL) {
@@ -360,7 +419,7 @@ esp_err_t avi_parser_read_video_frame(avi_parser_t *parser, mjpeg_frame_t *frame
 
             frame->size = size;
             frame->frame_num = parser->current_frame;
-            frame->timestamp_ms = (parser->current_frame * parser->main_header.micro_sec_per_frame) / 1000;
+            frame->timestamp_ms = timebase_frame_to_us(&parser->timebase, parser->current_frame) / 1000;
 
             parser->current_frame++;
 
@@ -402,7 +461,7 @@ esp_err_t avi_parser_read_audio_chunk(avi_parser_t *parser, uint8_t *buffer,
         uint32_t size = read_le32(parser->file);
 
         // Check if this is an audio chunk (01wb)
-        if ((fourcc & 0xFFFF) == 0x6277) {  // "wb"
+        if (AVI_CHUNK_IS_AUDIO(fourcc)) {
             uint32_t read_size = (size < max_size) ? size : max_size;
 
             size_t read = fread(buffer, 1, read_size, parser->file);
@@ -442,8 +501,19 @@ esp_err_t avi_parser_seek(avi_parser_t *parser, uint32_t frame_num)
         return ESP_ERR_INVALID_ARG;
     }
 
-    // Simple implementation: seek to start and skip frames
-    // TODO: Build index for faster seeking
+    // Indexed seek: one page block read plus a bounded scan in RAM
+    if (parser->has_index) {
+        uint32_t offset;
+        esp_err_t ret = frame_index_lookup(&parser->index, frame_num, &offset, NULL);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        fseek(parser->file, offset, SEEK_SET);
+        parser->current_frame = frame_num;
+        return ESP_OK;
+    }
+
+    // No index: seek to start and skip frames
     fseek(parser->file, parser->movi_offset, SEEK_SET);
     parser->current_frame = 0;
 
@@ -480,11 +550,23 @@ uint32_t avi_parser_get_total_frames(const avi_parser_t *parser)
  */
 float avi_parser_get_fps(const avi_parser_t *parser)
 {
-    if (!parser || parser->main_header.micro_sec_per_frame == 0) {
+    if (!parser || !parser->initialized) {
         return 0.0f;
     }
 
-    return 1000000.0f / parser->main_header.micro_sec_per_frame;
+    return (float)parser->timebase.rate / parser->timebase.scale;
+}
+
+/**
+ * Get timebase
+ */
+void avi_parser_get_timebase(const avi_parser_t *parser, timebase_t *tb)
+{
+    if (parser && parser->initialized) {
+        *tb = parser->timebase;
+    } else {
+        timebase_init(tb, 0, 0);
+    }
 }
 
 /**
@@ -0,0 +1,146 @@
+/**
+ * CRB Video Codec Implementation
+ *
+ * Every opcode, color and tile reference is bounds checked, so a corrupt
+ * chunk can only produce a bad frame, never a write outside the buffer.
+ */
+
+#include "crb.h"
+#include <string.h>
+
+/**
+ * Read a little-endian field
+ */
+static inline uint32_t read_le(const uint8_t *p, int bytes)
+{
+    uint32_t v = 0;
+
+    for (int i = bytes - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/**
+ * Parse frame header
+ */
+esp_err_t crb_parse(const uint8_t *src, uint32_t size, crb_frame_t *frame)
+{
+    if (src == NULL || frame == NULL) return ESP_ERR_INVALID_ARG;
+    if (size < CRB_HEADER_SIZE) return ESP_ERR_INVALID_SIZE;
+
+    frame->keyframe = (src[0] & CRB_FLAG_KEYFRAME) != 0;
+    frame->jpeg = (src[0] & CRB_FLAG_JPEG) != 0;
+    frame->block_size = src[1];
+    frame->tile_count = (uint16_t)read_le(&src[2], 2);
+    frame->map_size = read_le(&src[4], 4);
+
+    if (frame->block_size != 8 && frame->block_size != 16) return ESP_ERR_INVALID_SIZE;
+    if (frame->map_size > size - CRB_HEADER_SIZE) return ESP_ERR_INVALID_SIZE;
+
+    frame->map = src + CRB_HEADER_SIZE;
+    frame->payload = frame->map + frame->map_size;
+    frame->payload_size = size - CRB_HEADER_SIZE - frame->map_size;
+
+    uint32_t tile_bytes = (uint32_t)frame->block_size * frame->block_size * sizeof(uint16_t);
+    if (!frame->jpeg && frame->payload_size < frame->tile_count * tile_bytes) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (frame->jpeg && frame->tile_count > 0 && frame->payload_size == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Mosaic size
+ */
+void crb_mosaic_size(const crb_frame_t *frame, uint16_t width,
+                     uint16_t *mosaic_width, uint16_t *mosaic_height)
+{
+    uint16_t bs = frame->block_size;
+    uint16_t cols = (width + bs - 1) / bs;
+
+    *mosaic_width = cols * bs;
+    *mosaic_height = (frame->tile_count + cols - 1) / cols * bs;
+}
+
+/**
+ * Apply frame
+ */
+esp_err_t crb_apply(const crb_frame_t *frame, const uint16_t *mosaic,
+                    uint16_t *canvas, uint16_t width, uint16_t height,
+                    uint64_t *dirty_rows)
+{
+    if (frame == NULL || canvas == NULL || dirty_rows == NULL) return ESP_ERR_INVALID_ARG;
+    if (frame->jpeg && frame->tile_count > 0 && mosaic == NULL) return ESP_ERR_INVALID_ARG;
+
+    uint16_t bs = frame->block_size;
+    uint16_t cols = (width + bs - 1) / bs;
+    uint16_t rows = (height + bs - 1) / bs;
+    uint32_t blocks = (uint32_t)cols * rows;
+
+    if (rows > CRB_MAX_BLOCK_ROWS) return ESP_ERR_INVALID_SIZE;
+
+    const uint8_t *ip = frame->map;
+    const uint8_t *iend = frame->map + frame->map_size;
+    uint32_t block = 0;
+    uint32_t tile = 0;
+
+    while (ip < iend) {
+        uint8_t op = *ip++;
+        uint32_t count = (op & 0x80) ? (op & 0x3F) + 1 : (op & 0x7F) + 1;
+
+        if (count > blocks - block) return ESP_ERR_INVALID_SIZE;
+
+        if ((op & 0x80) == CRB_OP_SKIP) {
+            block += count;
+            continue;
+        }
+
+        for (uint32_t n = 0; n < count; n++, block++) {
+            uint16_t bx = block % cols;
+            uint16_t by = block / cols;
+            uint16_t w = (bx * bs + bs <= width) ? bs : width - bx * bs;
+            uint16_t h = (by * bs + bs <= height) ? bs : height - by * bs;
+            uint16_t *dst = &canvas[(uint32_t)by * bs * width + bx * bs];
+
+            if ((op & 0xC0) == CRB_OP_FILL) {
+                if (iend - ip < 2) return ESP_ERR_INVALID_SIZE;
+
+                // Stored in panel byte order, so copy the bytes as they are
+                uint16_t color;
+                memcpy(&color, ip, sizeof(color));
+                ip += 2;
+
+                for (uint16_t x = 0; x < w; x++) dst[x] = color;
+                for (uint16_t y = 1; y < h; y++) {
+                    memcpy(&dst[y * width], dst, w * sizeof(uint16_t));
+                }
+            } else {
+                if (tile >= frame->tile_count) return ESP_ERR_INVALID_SIZE;
+
+                if (frame->jpeg) {
+                    uint16_t mosaic_width = cols * bs;
+                    const uint16_t *src = &mosaic[(uint32_t)(tile / cols) * bs * mosaic_width +
+                                                  (tile % cols) * bs];
+                    for (uint16_t y = 0; y < h; y++) {
+                        memcpy(&dst[y * width], &src[y * mosaic_width], w * sizeof(uint16_t));
+                    }
+                } else {
+                    // Raw tiles may sit at odd offsets in the chunk
+                    const uint8_t *src = frame->payload + tile * bs * bs * sizeof(uint16_t);
+                    for (uint16_t y = 0; y < h; y++) {
+                        memcpy(&dst[y * width], &src[y * bs * sizeof(uint16_t)], w * sizeof(uint16_t));
+                    }
+                }
+                tile++;
+            }
+
+            *dirty_rows |= 1ull << by;
+        }
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,623 @@
+/**
+ * Sparse Frame Index Implementation
+ *
+ * Cache file layout (little-endian):
+ *   0   magic        u32  "FIDX"
+ *   4   version      u16
+ *   6   page_shift   u8
+ *   7   reserved     u8
+ *   8   total_frames u32
+ *   12  page_count   u32
+ *   16  table_offset u32  (also end of page blocks)
+ *   20  avi_size     u32  (staleness check)
+ *   24  reserved     8 bytes
+ *   32  page blocks  varint((offset_delta << 1) | keyframe) per frame
+ *   ..  page table   page_count x { first_offset u32, block_offset u32 }
+ */
+
+#include "frame_index.h"
+#include "avi_parser.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "dlog.h"
+
+static const char *TAG = "FRAME_INDEX";
+
+#define HEADER_SIZE         32
+#define IDX1_BATCH          64      // idx1 entries read per fread (1 KB)
+#define AVIIF_KEYFRAME      0x10
+#define FOURCC_IDX1         0x31786469  // "idx1"
+#define MAX_VARINT_BYTES    5
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Decode one LEB128 varint, returns bytes consumed (0 on overrun)
+ */
+static uint32_t varint_decode(const uint8_t *p, uint32_t avail, uint64_t *value)
+{
+    uint64_t v = 0;
+    for (uint32_t i = 0; i < avail && i < MAX_VARINT_BYTES; i++) {
+        v |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+        if ((p[i] & 0x80) == 0) {
+            *value = v;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Derive cache path
+ */
+void frame_index_cache_path(const char *avi_path, char *cache_path, size_t len)
+{
+    snprintf(cache_path, len, "%s%s", avi_path, FRAME_INDEX_EXTENSION);
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+/**
+ * Start cache file
+ */
+esp_err_t frame_index_writer_begin(frame_index_writer_t *writer, const char *cache_path,
+                                   uint32_t frames_hint, uint32_t avi_size)
+{
+    if (writer == NULL || cache_path == NULL) return ESP_ERR_INVALID_ARG;
+
+    memset(writer, 0, sizeof(frame_index_writer_t));
+
+    // Smallest page that keeps the resident table within budget
+    uint8_t shift = FRAME_INDEX_MIN_PAGE_SHIFT;
+    if (frames_hint == 0) frames_hint = 1 << 16;
+    while (shift < FRAME_INDEX_MAX_PAGE_SHIFT &&
+           ((frames_hint >> shift) + 1) * sizeof(frame_index_page_t) > FRAME_INDEX_MAX_RESIDENT) {
+        shift++;
+    }
+
+    writer->page_shift = shift;
+    writer->avi_size = avi_size;
+    writer->page_capacity = (frames_hint >> shift) + 1;
+    writer->pages = malloc(writer->page_capacity * sizeof(frame_index_page_t));
+    if (writer->pages == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    writer->cache = fopen(cache_path, "wb");
+    if (writer->cache == NULL) {
+        ESP_LOGE(TAG, "Failed to create cache file: %s", cache_path);
+        free(writer->pages);
+        writer->pages = NULL;
+        return ESP_FAIL;
+    }
+
+    // Header is written last; reserve space for it
+    uint8_t header[HEADER_SIZE] = {0};
+    fwrite(header, 1, HEADER_SIZE, writer->cache);
+
+    return ESP_OK;
+}
+
+/**
+ * Append frame
+ */
+esp_err_t frame_index_writer_add(frame_index_writer_t *writer, uint32_t offset, bool is_keyframe)
+{
+    if (writer == NULL || writer->cache == NULL) return ESP_ERR_INVALID_STATE;
+
+    uint32_t delta = 0;
+
+    if ((writer->frame_count & ((1 << writer->page_shift) - 1)) == 0) {
+        // First frame of a new page
+        if (writer->page_count >= writer->page_capacity) {
+            uint32_t capacity = writer->page_capacity * 2;
+            frame_index_page_t *pages = realloc(writer->pages, capacity * sizeof(frame_index_page_t));
+            if (pages == NULL) return ESP_ERR_NO_MEM;
+            writer->pages = pages;
+            writer->page_capacity = capacity;
+        }
+
+        frame_index_page_t *page = &writer->pages[writer->page_count++];
+        page->first_offset = offset;
+        page->block_offset = ftell(writer->cache);
+    } else {
+        if (offset <= writer->last_offset) {
+            ESP_LOGE(TAG, "Frame offsets not increasing at frame %lu", writer->frame_count);
+            return ESP_ERR_INVALID_ARG;
+        }
+        delta = offset - writer->last_offset;
+    }
+
+    // varint((delta << 1) | keyframe)
+    uint64_t v = ((uint64_t)delta << 1) | (is_keyframe ? 1 : 0);
+    uint8_t buf[MAX_VARINT_BYTES];
+    int n = 0;
+    do {
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        buf[n++] = b | (v ? 0x80 : 0);
+    } while (v);
+
+    if (fwrite(buf, 1, n, writer->cache) != (size_t)n) {
+        return ESP_FAIL;
+    }
+
+    writer->last_offset = offset;
+    writer->frame_count++;
+
+    return ESP_OK;
+}
+
+/**
+ * Finish cache file
+ */
+esp_err_t frame_index_writer_finish(frame_index_writer_t *writer)
+{
+    if (writer == NULL || writer->cache == NULL) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t ret = ESP_OK;
+    uint32_t table_offset = ftell(writer->cache);
+
+    for (uint32_t i = 0; i < writer->page_count; i++) {
+        uint8_t entry[8];
+        put_le32(&entry[0], writer->pages[i].first_offset);
+        put_le32(&entry[4], writer->pages[i].block_offset);
+        if (fwrite(entry, 1, sizeof(entry), writer->cache) != sizeof(entry)) {
+            ret = ESP_FAIL;
+            break;
+        }
+    }
+
+    if (ret == ESP_OK) {
+        uint8_t header[HEADER_SIZE] = {0};
+        put_le32(&header[0], FRAME_INDEX_MAGIC);
+        header[4] = FRAME_INDEX_VERSION & 0xFF;
+        header[5] = FRAME_INDEX_VERSION >> 8;
+        header[6] = writer->page_shift;
+        put_le32(&header[8], writer->frame_count);
+        put_le32(&header[12], writer->page_count);
+        put_le32(&header[16], table_offset);
+        put_le32(&header[20], writer->avi_size);
+
+        fseek(writer->cache, 0, SEEK_SET);
+        if (fwrite(header, 1, HEADER_SIZE, writer->cache) != HEADER_SIZE) {
+            ret = ESP_FAIL;
+        }
+    }
+
+    if (fclose(writer->cache) != 0) {
+        ret = ESP_FAIL;
+    }
+    writer->cache = NULL;
+
+    DLOGI(TAG, "Index written: %lu frames, %lu pages of %d frames, %lu bytes",
+          writer->frame_count, writer->page_count, 1 << writer->page_shift,
+          table_offset + writer->page_count * 8);
+
+    free(writer->pages);
+    writer->pages = NULL;
+
+    return ret;
+}
+
+/**
+ * Abort cache file
+ */
+void frame_index_writer_abort(frame_index_writer_t *writer)
+{
+    if (writer == NULL) return;
+
+    if (writer->cache) {
+        fclose(writer->cache);
+        writer->cache = NULL;
+    }
+
+    free(writer->pages);
+    writer->pages = NULL;
+}
+
+// ============================================================================
+// Building from AVI
+// ============================================================================
+
+/**
+ * Build from the idx1 chunk that follows movi
+ */
+static esp_err_t build_from_idx1(frame_index_writer_t *writer, FILE *avi,
+                                 uint32_t movi_offset, uint32_t movi_size)
+{
+    uint32_t idx1_pos = movi_offset + movi_size + (movi_size & 1);
+    uint8_t hdr[8];
+
+    if (fseek(avi, idx1_pos, SEEK_SET) != 0 || fread(hdr, 1, 8, avi) != 8) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (get_le32(hdr) != FOURCC_IDX1) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t entries = get_le32(&hdr[4]) / 16;
+    uint8_t *batch = malloc(IDX1_BATCH * 16);
+    if (batch == NULL) return ESP_ERR_NO_MEM;
+
+    // idx1 offsets are usually relative to the 'movi' FOURCC, but some
+    // writers store absolute file offsets - decided on the first video entry
+    int32_t base = -1;
+    esp_err_t ret = ESP_OK;
+
+    for (uint32_t done = 0; done < entries && ret == ESP_OK; ) {
+        uint32_t n = entries - done;
+        if (n > IDX1_BATCH) n = IDX1_BATCH;
+
+        if (fread(batch, 16, n, avi) != n) {
+            ret = ESP_FAIL;
+            break;
+        }
+
+        for (uint32_t i = 0; i < n; i++) {
+            const uint8_t *e = &batch[i * 16];
+            uint32_t ckid = get_le32(&e[0]);
+            if (!AVI_CHUNK_IS_VIDEO(ckid)) continue;
+
+            uint32_t flags = get_le32(&e[4]);
+            uint32_t offset = get_le32(&e[8]);
+
+            if (base < 0) {
+                base = (offset < movi_offset) ? (int32_t)(movi_offset - 4) : 0;
+            }
+
+            ret = frame_index_writer_add(writer, base + offset, (flags & AVIIF_KEYFRAME) != 0);
+            if (ret != ESP_OK) break;
+        }
+
+        done += n;
+    }
+
+    free(batch);
+    return ret;
+}
+
+/**
+ * Build by walking the movi list chunk by chunk
+ */
+static esp_err_t build_from_scan(frame_index_writer_t *writer, FILE *avi,
+                                 uint32_t movi_offset, uint32_t movi_size)
+{
+    uint32_t pos = movi_offset;
+    uint32_t end = movi_offset + movi_size;
+    uint8_t hdr[8];
+
+    while (pos + 8 <= end) {
+        if (fseek(avi, pos, SEEK_SET) != 0 || fread(hdr, 1, 8, avi) != 8) {
+            break;
+        }
+
+        uint32_t fourcc = get_le32(hdr);
+        uint32_t size = get_le32(&hdr[4]);
+
+        if (fourcc == FOURCC_LIST) {
+            pos += 12;  // Descend into 'rec ' lists
+            continue;
+        }
+
+        if (AVI_CHUNK_IS_VIDEO(fourcc)) {
+            // Without idx1 there are no flags; MJPEG frames are all keyframes
+            esp_err_t ret = frame_index_writer_add(writer, pos, true);
+            if (ret != ESP_OK) return ret;
+        }
+
+        pos += 8 + size + (size & 1);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Open (or build) index
+ */
+esp_err_t frame_index_open(frame_index_t *index, const char *avi_path, FILE *avi,
+                           uint32_t movi_offset, uint32_t movi_size, uint32_t frames_hint)
+{
+    if (index == NULL || avi_path == NULL || avi == NULL) return ESP_ERR_INVALID_ARG;
+
+    char cache_path[300];
+    frame_index_cache_path(avi_path, cache_path, sizeof(cache_path));
+
+    struct stat st;
+    uint32_t avi_size = (stat(avi_path, &st) == 0) ? st.st_size : 0;
+
+    esp_err_t ret = frame_index_load(index, cache_path, avi_size);
+    if (ret == ESP_OK) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Building frame index: %s", cache_path);
+
+    long saved_pos = ftell(avi);
+    frame_index_writer_t writer;
+
+    ret = frame_index_writer_begin(&writer, cache_path, frames_hint, avi_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = build_from_idx1(&writer, avi, movi_offset, movi_size);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        ESP_LOGW(TAG, "No idx1 chunk, scanning movi list");
+        ret = build_from_scan(&writer, avi, movi_offset, movi_size);
+    }
+
+    fseek(avi, saved_pos, SEEK_SET);
+
+    if (ret != ESP_OK || writer.frame_count == 0) {
+        ESP_LOGE(TAG, "Failed to build frame index");
+        frame_index_writer_abort(&writer);
+        remove(cache_path);
+        return (ret != ESP_OK) ? ret : ESP_ERR_NOT_FOUND;
+    }
+
+    ret = frame_index_writer_finish(&writer);
+    if (ret != ESP_OK) {
+        remove(cache_path);
+        return ret;
+    }
+
+    return frame_index_load(index, cache_path, avi_size);
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+/**
+ * Load cache file
+ */
+esp_err_t frame_index_load(frame_index_t *index, const char *cache_path, uint32_t avi_size)
+{
+    if (index == NULL || cache_path == NULL) return ESP_ERR_INVALID_ARG;
+
+    memset(index, 0, sizeof(frame_index_t));
+    index->loaded_page = -1;
+
+    index->cache = fopen(cache_path, "rb");
+    if (index->cache == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t header[HEADER_SIZE];
+    if (fread(header, 1, HEADER_SIZE, index->cache) != HEADER_SIZE ||
+        get_le32(&header[0]) != FRAME_INDEX_MAGIC ||
+        (header[4] | (header[5] << 8)) != FRAME_INDEX_VERSION ||
+        (avi_size != 0 && get_le32(&header[20]) != avi_size)) {
+        ESP_LOGW(TAG, "Stale or invalid index: %s", cache_path);
+        frame_index_close(index);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    index->page_shift = header[6];
+    index->total_frames = get_le32(&header[8]);
+    index->page_count = get_le32(&header[12]);
+    index->cache_size = get_le32(&header[16]);
+
+    // A corrupt or foreign file must not reach the shifts and lengths below
+    if (index->page_shift < FRAME_INDEX_MIN_PAGE_SHIFT || index->page_shift > FRAME_INDEX_MAX_PAGE_SHIFT ||
+        index->total_frames == 0 || index->page_count == 0 ||
+        index->page_count != ((index->total_frames - 1) >> index->page_shift) + 1) {
+        ESP_LOGW(TAG, "Stale or invalid index: %s", cache_path);
+        frame_index_close(index);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    index->pages = malloc(index->page_count * sizeof(frame_index_page_t));
+    if (index->pages == NULL) {
+        frame_index_close(index);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Read resident table, track the largest page block for the buffer size
+    fseek(index->cache, index->cache_size, SEEK_SET);
+    uint32_t max_block = 0;
+    for (uint32_t i = 0; i < index->page_count; i++) {
+        uint8_t entry[8];
+        if (fread(entry, 1, sizeof(entry), index->cache) != sizeof(entry)) {
+            frame_index_close(index);
+            return ESP_ERR_INVALID_VERSION;
+        }
+        index->pages[i].first_offset = get_le32(&entry[0]);
+        index->pages[i].block_offset = get_le32(&entry[4]);
+
+        // Blocks follow the header in page order, each at least one byte
+        uint32_t min_offset = (i > 0) ? index->pages[i - 1].block_offset + 1 : HEADER_SIZE;
+        if (index->pages[i].block_offset < min_offset || index->pages[i].block_offset >= index->cache_size) {
+            ESP_LOGW(TAG, "Stale or invalid index: %s", cache_path);
+            frame_index_close(index);
+            return ESP_ERR_INVALID_VERSION;
+        }
+
+        if (i > 0) {
+            uint32_t len = index->pages[i].block_offset - index->pages[i - 1].block_offset;
+            if (len > max_block) max_block = len;
+        }
+    }
+    uint32_t last_len = index->cache_size - index->pages[index->page_count - 1].block_offset;
+    if (last_len > max_block) max_block = last_len;
+
+    index->block_capacity = max_block;
+    index->block = malloc(max_block);
+    if (index->block == NULL) {
+        frame_index_close(index);
+        return ESP_ERR_NO_MEM;
+    }
+
+    DLOGI(TAG, "Frame index loaded: %lu frames, %lu pages, %lu bytes resident",
+          index->total_frames, index->page_count, frame_index_get_resident_bytes(index));
+
+    return ESP_OK;
+}
+
+/**
+ * Close index
+ */
+void frame_index_close(frame_index_t *index)
+{
+    if (index == NULL) return;
+
+    if (index->cache) {
+        fclose(index->cache);
+        index->cache = NULL;
+    }
+
+    free(index->pages);
+    index->pages = NULL;
+    free(index->block);
+    index->block = NULL;
+    index->page_count = 0;
+    index->total_frames = 0;
+    index->loaded_page = -1;
+}
+
+/**
+ * Make sure the page block for a page is in RAM (one read at most)
+ */
+static esp_err_t load_page(frame_index_t *index, uint32_t page)
+{
+    if ((int32_t)page == index->loaded_page) return ESP_OK;
+
+    uint32_t start = index->pages[page].block_offset;
+    uint32_t end = (page + 1 < index->page_count)
+                   ? index->pages[page + 1].block_offset : index->cache_size;
+    uint32_t len = end - start;
+
+    if (len > index->block_capacity ||
+        fseek(index->cache, start, SEEK_SET) != 0 ||
+        fread(index->block, 1, len, index->cache) != len) {
+        index->loaded_page = -1;
+        return ESP_FAIL;
+    }
+
+    index->block_len = len;
+    index->loaded_page = page;
+    index->page_loads++;
+
+    return ESP_OK;
+}
+
+/**
+ * Look up frame
+ */
+esp_err_t frame_index_lookup(frame_index_t *index, uint32_t frame_num,
+                             uint32_t *offset, bool *is_keyframe)
+{
+    if (index == NULL || index->pages == NULL || offset == NULL) return ESP_ERR_INVALID_ARG;
+    if (frame_num >= index->total_frames) return ESP_ERR_NOT_FOUND;
+
+    uint32_t page = frame_num >> index->page_shift;
+    uint32_t within = frame_num & ((1 << index->page_shift) - 1);
+
+    esp_err_t ret = load_page(index, page);
+    if (ret != ESP_OK) return ret;
+
+    // Bounded scan: at most 2^page_shift varints
+    uint32_t pos = 0;
+    uint32_t off = index->pages[page].first_offset;
+    uint64_t v = 0;
+
+    for (uint32_t i = 0; i <= within; i++) {
+        uint32_t n = varint_decode(&index->block[pos], index->block_len - pos, &v);
+        if (n == 0) return ESP_FAIL;
+        pos += n;
+        off += (uint32_t)(v >> 1);
+    }
+
+    *offset = off;
+    if (is_keyframe) *is_keyframe = (v & 1) != 0;
+
+    return ESP_OK;
+}
+
+/**
+ * Find previous keyframe
+ */
+uint32_t frame_index_prev_keyframe(frame_index_t *index, uint32_t frame_num)
+{
+    if (index == NULL || index->pages == NULL || index->total_frames == 0) return 0;
+    if (frame_num >= index->total_frames) frame_num = index->total_frames - 1;
+
+    for (int32_t page = frame_num >> index->page_shift; page >= 0; page--) {
+        if (load_page(index, page) != ESP_OK) return 0;
+
+        uint32_t first = (uint32_t)page << index->page_shift;
+        uint32_t last = (frame_num < first + (1u << index->page_shift))
+                        ? frame_num : first + (1u << index->page_shift) - 1;
+        int64_t found = -1;
+        uint32_t pos = 0;
+        uint64_t v;
+
+        for (uint32_t f = first; f <= last; f++) {
+            uint32_t n = varint_decode(&index->block[pos], index->block_len - pos, &v);
+            if (n == 0) return 0;
+            pos += n;
+            if (v & 1) found = f;
+        }
+
+        if (found >= 0) return (uint32_t)found;
+    }
+
+    return 0;
+}
+
+/**
+ * Find next keyframe
+ */
+uint32_t frame_index_next_keyframe(frame_index_t *index, uint32_t frame_num)
+{
+    if (index == NULL || index->pages == NULL || frame_num >= index->total_frames) {
+        return index ? index->total_frames : 0;
+    }
+
+    for (uint32_t page = frame_num >> index->page_shift; page < index->page_count; page++) {
+        if (load_page(index, page) != ESP_OK) break;
+
+        uint32_t first = page << index->page_shift;
+        uint32_t last = first + (1u << index->page_shift) - 1;
+        if (last >= index->total_frames) last = index->total_frames - 1;
+        uint32_t pos = 0;
+        uint64_t v;
+
+        for (uint32_t f = first; f <= last; f++) {
+            uint32_t n = varint_decode(&index->block[pos], index->block_len - pos, &v);
+            if (n == 0) return index->total_frames;
+            pos += n;
+            if ((v & 1) && f >= frame_num) return f;
+        }
+    }
+
+    return index->total_frames;
+}
+
+/**
+ * Resident RAM usage
+ */
+uint32_t frame_index_get_resident_bytes(const frame_index_t *index)
+{
+    if (index == NULL) return 0;
+
+    return sizeof(frame_index_t) +
+           index->page_count * sizeof(frame_index_page_t) +
+           index->block_capacity;
+}
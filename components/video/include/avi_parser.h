@@ -13,6 +13,8 @@
 #include <stdio.h>
 #include "esp_err.h"
 #include "mjpeg_decoder.h"
+#include "frame_index.h"
+#include "timebase.h"
 
 // AVI FOURCC codes
 #define FOURCC_RIFF     0x46464952  // "RIFF"
@@ -27,9 +29,18 @@
 #define FOURCC_VIDS     0x73646976  // "vids"
 #define FOURCC_AUDS     0x73647561  // "auds"
 #define FOURCC_MJPG     0x47504A4D  // "MJPG"
+#define FOURCC_L565     0x3536354C  // "L565" - LZ4-compressed RGB565 (lz565.h)
+#define FOURCC_CRB1     0x31425243  // "CRB1" - conditional replenishment blocks (crb.h)
+#define FOURCC_PAL8     0x384C4150  // "PAL8" - palettized 8-bit frames (pal8.h)
 #define FOURCC_00DC     0x63643030  // "00dc" - video chunk
 #define FOURCC_01WB     0x62773130  // "01wb" - audio chunk
 
+// Chunk type is the two characters after the stream number ("##dc", "##wb")
+#define AVI_CHUNK_TYPE(fourcc)      ((fourcc) >> 16)
+#define AVI_CHUNK_IS_VIDEO(fourcc)  (AVI_CHUNK_TYPE(fourcc) == 0x6364 || \
+                                     AVI_CHUNK_TYPE(fourcc) == 0x6264)  // "dc" or "db"
+#define AVI_CHUNK_IS_AUDIO(fourcc)  (AVI_CHUNK_TYPE(fourcc) == 0x6277)  // "wb"
+
 /**
  * AVI main header structure
  */
@@ -66,6 +77,8 @@ typedef struct {
     uint16_t height;
     uint16_t bit_count;
     uint32_t compression;
+    uint32_t rate;              // Frame rate = rate / scale (video strh)
+    uint32_t scale;
     bool found;
 } avi_video_info_t;
 
@@ -101,11 +114,19 @@ typedef struct {
     avi_video_info_t video_info;
     avi_audio_info_t audio_info;
 
+    uint32_t strh_type;         // Type of the last stream header (selects strf parser)
+
     uint32_t movi_offset;       // File offset of 'movi' chunk
     uint32_t movi_size;
 
     uint32_t current_frame;
     uint32_t total_frames;
+    timebase_t timebase;        // Video frame timing
+
+    frame_index_t index;        // Sparse frame index (seeking)
+    bool has_index;
+
+    uint8_t *io_buffer;         // stdio buffer (NULL = libc default)
 
     bool initialized;
 } avi_parser_t;
@@ -119,6 +140,17 @@ typedef struct {
  */
 esp_err_t avi_parser_open(avi_parser_t *parser, const char *file_path);
 
+/**
+ * Open AVI file with a read buffer of the given size
+ * Larger buffers turn frame reads into fewer, bigger card requests
+ *
+ * @param parser Parser handle
+ * @param file_path Path to AVI file
+ * @param buffer_size stdio buffer size in bytes (0 = libc default)
+ * @return ESP_OK on success
+ */
+esp_err_t avi_parser_open_buffered(avi_parser_t *parser, const char *file_path, uint32_t buffer_size);
+
 /**
  * Close AVI file and cleanup
  *
@@ -174,12 +206,23 @@ uint32_t avi_parser_get_total_frames(const avi_parser_t *parser);
 
 /**
  * Get video frame rate
+ * For estimates only; use avi_parser_get_timebase() for timing
  *
  * @param parser Parser handle
  * @return Frame rate in FPS
  */
 float avi_parser_get_fps(const avi_parser_t *parser);
 
+/**
+ * Get exact video timebase
+ * From the video stream's rate/scale, else the main header's frame period,
+ * else TIMEBASE_DEFAULT_FPS
+ *
+ * @param parser Parser handle
+ * @param tb Output timebase
+ */
+void avi_parser_get_timebase(const avi_parser_t *parser, timebase_t *tb);
+
 /**
  * Free MJPEG frame data allocated by parser
  *
@@ -0,0 +1,106 @@
+/**
+ * CRB Video Codec
+ * Block-based conditional replenishment for mostly static content
+ *
+ * The frame is divided into 8x8 or 16x16 blocks and each frame only carries
+ * the blocks that changed since the previous one; everything else is kept
+ * from the frame buffer. Animation and talk shows leave most blocks untouched,
+ * so decode work and panel traffic scale with the changed area instead of the
+ * frame size. Frames are stored in AVI 00dc chunks with FOURCC "CRB1".
+ *
+ * Chunk layout (multi-byte fields little-endian, like AVI):
+ *
+ *   u8  flags        CRB_FLAG_KEYFRAME, CRB_FLAG_JPEG
+ *   u8  block_size   8 or 16
+ *   u16 tile_count   coded tiles in the payload
+ *   u32 map_size     block map length in bytes
+ *   u8  map[map_size]
+ *   u8  payload[]    tiles
+ *
+ * The block map is a run of opcodes over the blocks in raster order; blocks
+ * past the end of the map are skipped:
+ *
+ *   0x00-0x7F  skip n + 1 blocks
+ *   0x80-0xBF  n + 1 blocks from the next tiles in the payload
+ *   0xC0-0xFF  n + 1 solid blocks, each followed by its big-endian color
+ *
+ * Raw payloads are tile_count tiles of block_size^2 big-endian RGB565 pixels.
+ * JPEG payloads (CRB_FLAG_JPEG) are one baseline JPEG holding the tiles as a
+ * mosaic, cols * block_size wide, tile i at column i % cols, row i / cols.
+ * Tiles are intra coded, so decoder differences never accumulate; a keyframe
+ * codes every block and is flagged in idx1 for seeking.
+ *
+ * Encoder: tools/host/crb_encode.c
+ */
+
+#ifndef CRB_H
+#define CRB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define CRB_FLAG_KEYFRAME   0x01
+#define CRB_FLAG_JPEG       0x02
+
+#define CRB_HEADER_SIZE     8
+#define CRB_MAX_BLOCK_ROWS  64      // Dirty row mask width
+
+#define CRB_OP_SKIP         0x00
+#define CRB_OP_TILE         0x80
+#define CRB_OP_FILL         0xC0
+
+/**
+ * Parsed frame (pointers into the chunk)
+ */
+typedef struct {
+    bool keyframe;
+    bool jpeg;                  // Payload is a JPEG mosaic
+    uint8_t block_size;
+    uint16_t tile_count;
+    const uint8_t *map;
+    uint32_t map_size;
+    const uint8_t *payload;
+    uint32_t payload_size;
+} crb_frame_t;
+
+/**
+ * Parse a frame header
+ *
+ * @param src Chunk data
+ * @param size Chunk size in bytes
+ * @param frame Output frame
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the chunk is malformed
+ */
+esp_err_t crb_parse(const uint8_t *src, uint32_t size, crb_frame_t *frame);
+
+/**
+ * Size of the JPEG mosaic for a frame
+ *
+ * @param frame Parsed frame
+ * @param width Frame width
+ * @param mosaic_width Output mosaic width in pixels
+ * @param mosaic_height Output mosaic height in pixels
+ */
+void crb_mosaic_size(const crb_frame_t *frame, uint16_t width,
+                     uint16_t *mosaic_width, uint16_t *mosaic_height);
+
+/**
+ * Apply a frame to the frame buffer
+ * Only coded blocks are written; partial blocks at the right and bottom
+ * edges are clipped.
+ *
+ * @param frame Parsed frame
+ * @param mosaic Decoded JPEG mosaic (big-endian RGB565), NULL for raw tiles
+ * @param canvas Frame buffer holding the previous frame (big-endian RGB565)
+ * @param width Frame width
+ * @param height Frame height
+ * @param dirty_rows Block rows written are ORed in (bit n = block row n)
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the map or payload is
+ *         inconsistent (blocks before the error are already written)
+ */
+esp_err_t crb_apply(const crb_frame_t *frame, const uint16_t *mosaic,
+                    uint16_t *canvas, uint16_t width, uint16_t height,
+                    uint64_t *dirty_rows);
+
+#endif // CRB_H
@@ -0,0 +1,197 @@
+/**
+ * Sparse Frame Index
+ * Two-level, paged video frame index for feature-length AVI files
+ *
+ * A full idx1 for a 2-hour film is ~170k entries (megabytes), far too big for
+ * internal RAM. Instead the index is kept in an on-card cache file next to
+ * the video ("<file>.fidx"):
+ *
+ *   - a small resident table with one entry per page of 2^page_shift frames
+ *     (file offset of the page's first frame + where its page block lives)
+ *   - delta-encoded page blocks (LEB128 varints of offset delta and keyframe
+ *     flag per frame), loaded on demand
+ *
+ * Any frame is reachable with at most one small read (its page block) plus a
+ * bounded scan of at most 2^page_shift deltas in RAM.
+ */
+
+#ifndef FRAME_INDEX_H
+#define FRAME_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#define FRAME_INDEX_MAGIC           0x58444946  // "FIDX"
+#define FRAME_INDEX_VERSION         1
+#define FRAME_INDEX_EXTENSION       ".fidx"
+
+// Resident table budget: page size is doubled until the table fits
+#define FRAME_INDEX_MAX_RESIDENT    4096        // bytes
+#define FRAME_INDEX_MIN_PAGE_SHIFT  6           // 64 frames per page
+#define FRAME_INDEX_MAX_PAGE_SHIFT  12          // 4096 frames per page
+
+/**
+ * Resident table entry (one per page)
+ */
+typedef struct {
+    uint32_t first_offset;      // AVI file offset of the page's first chunk header
+    uint32_t block_offset;      // Cache file offset of the page block
+} frame_index_page_t;
+
+/**
+ * Frame index handle
+ */
+typedef struct {
+    FILE *cache;                // Open cache file
+    frame_index_page_t *pages;  // Resident table
+    uint32_t page_count;
+    uint32_t total_frames;
+    uint8_t page_shift;         // Frames per page = 1 << page_shift
+    uint32_t cache_size;        // Cache file size (end of last page block)
+
+    // Currently loaded page block
+    uint8_t *block;
+    uint32_t block_capacity;
+    uint32_t block_len;
+    int32_t loaded_page;        // -1 if none
+
+    // Statistics
+    uint32_t page_loads;
+} frame_index_t;
+
+/**
+ * Frame index writer (used while building a cache file)
+ */
+typedef struct {
+    FILE *cache;
+    frame_index_page_t *pages;
+    uint32_t page_capacity;
+    uint32_t page_count;
+    uint32_t frame_count;
+    uint8_t page_shift;
+    uint32_t last_offset;
+    uint32_t avi_size;
+} frame_index_writer_t;
+
+/**
+ * Open cache file, building it from the AVI if missing or stale
+ *
+ * Uses the AVI's idx1 chunk if present, otherwise scans the movi list.
+ *
+ * @param index Index handle
+ * @param avi_path Path to AVI file (cache path is derived from it)
+ * @param avi Open AVI file (file position is preserved)
+ * @param movi_offset File offset of movi data (after the 'movi' FOURCC)
+ * @param movi_size Size of movi data
+ * @param frames_hint Expected frame count (from avih), 0 if unknown
+ * @return ESP_OK on success
+ */
+esp_err_t frame_index_open(frame_index_t *index, const char *avi_path, FILE *avi,
+                           uint32_t movi_offset, uint32_t movi_size, uint32_t frames_hint);
+
+/**
+ * Load an existing cache file
+ *
+ * @param index Index handle
+ * @param cache_path Cache file path
+ * @param avi_size Expected source AVI size (0 to skip the staleness check)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if missing,
+ *         ESP_ERR_INVALID_VERSION if stale or corrupt
+ */
+esp_err_t frame_index_load(frame_index_t *index, const char *cache_path, uint32_t avi_size);
+
+/**
+ * Close index and free resident table
+ *
+ * @param index Index handle
+ */
+void frame_index_close(frame_index_t *index);
+
+/**
+ * Look up a frame
+ *
+ * @param index Index handle
+ * @param frame_num Frame number
+ * @param offset Output AVI file offset of the frame's chunk header
+ * @param is_keyframe Output keyframe flag (optional)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if frame is out of range
+ */
+esp_err_t frame_index_lookup(frame_index_t *index, uint32_t frame_num,
+                             uint32_t *offset, bool *is_keyframe);
+
+/**
+ * Find nearest keyframe at or before a frame
+ *
+ * @param index Index handle
+ * @param frame_num Frame number
+ * @return Keyframe number (0 if none found)
+ */
+uint32_t frame_index_prev_keyframe(frame_index_t *index, uint32_t frame_num);
+
+/**
+ * Find nearest keyframe at or after a frame
+ *
+ * @param index Index handle
+ * @param frame_num Frame number
+ * @return Keyframe number (total_frames if none found)
+ */
+uint32_t frame_index_next_keyframe(frame_index_t *index, uint32_t frame_num);
+
+/**
+ * Get resident RAM used by the index (table + page block buffer)
+ *
+ * @param index Index handle
+ * @return Bytes of RAM in use
+ */
+uint32_t frame_index_get_resident_bytes(const frame_index_t *index);
+
+/**
+ * Start writing a cache file
+ *
+ * @param writer Writer handle
+ * @param cache_path Cache file path
+ * @param frames_hint Expected frame count (used to pick the page size)
+ * @param avi_size Size of the source AVI (stored for staleness check)
+ * @return ESP_OK on success
+ */
+esp_err_t frame_index_writer_begin(frame_index_writer_t *writer, const char *cache_path,
+                                   uint32_t frames_hint, uint32_t avi_size);
+
+/**
+ * Append next video frame to cache file
+ * Offsets must be strictly increasing.
+ *
+ * @param writer Writer handle
+ * @param offset AVI file offset of the frame's chunk header
+ * @param is_keyframe Keyframe flag
+ * @return ESP_OK on success
+ */
+esp_err_t frame_index_writer_add(frame_index_writer_t *writer, uint32_t offset, bool is_keyframe);
+
+/**
+ * Finish cache file (writes resident table and header)
+ *
+ * @param writer Writer handle
+ * @return ESP_OK on success
+ */
+esp_err_t frame_index_writer_finish(frame_index_writer_t *writer);
+
+/**
+ * Abort cache file writing and free writer resources
+ *
+ * @param writer Writer handle
+ */
+void frame_index_writer_abort(frame_index_writer_t *writer);
+
+/**
+ * Derive cache file path from AVI path
+ *
+ * @param avi_path AVI file path
+ * @param cache_path Output buffer
+ * @param len Output buffer length
+ */
+void frame_index_cache_path(const char *avi_path, char *cache_path, size_t len);
+
+#endif // FRAME_INDEX_H
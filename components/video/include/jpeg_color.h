@@ -0,0 +1,94 @@
+/**
+ * JPEG Color Conversion Kernels
+ * YCbCr MCU samples to RGB565 (big-endian) or packed RGB444
+ *
+ * One kernel per chroma layout and output format is generated at compile
+ * time, so the inner loop has no sampling-factor branches. Kernels walk each
+ * luma block in 2x2 quads: 4:2:0 converts one chroma sample per quad, 4:2:2
+ * one per row, 4:4:4 one per pixel and grayscale none. Chroma terms come from
+ * fixed-point (Q16) lookup tables, ITU-R BT.601 full range.
+ *
+ * Quads need at least 2x2 samples per block, so 1/8 scale (DC only) and
+ * layouts without a specialized kernel use the generic per-pixel kernel.
+ */
+
+#ifndef JPEG_COLOR_H
+#define JPEG_COLOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "jpeg_sw.h"
+
+/**
+ * Chroma layout, from the SOF sampling factors
+ */
+typedef enum {
+    JPEG_LAYOUT_GRAY = 0,   // One component
+    JPEG_LAYOUT_444,        // Luma 1x1
+    JPEG_LAYOUT_422,        // Luma 2x1
+    JPEG_LAYOUT_420,        // Luma 2x2
+    JPEG_LAYOUT_GENERIC,    // Anything else (e.g. 1x2), per-pixel path
+    JPEG_LAYOUT_COUNT,
+} jpeg_layout_t;
+
+/**
+ * Decoded MCU samples
+ */
+typedef struct {
+    const uint8_t (*blocks)[64];    // Luma blocks row by row, then Cb, Cr
+    uint8_t n;                      // Samples per block side (8 >> scale)
+    uint8_t h, v;                   // Luma blocks per MCU
+    bool gray;
+} jpeg_mcu_t;
+
+/**
+ * Color kernel: converts one whole MCU
+ * ox/oy are the MCU's output position, used for the RGB444 dither phase
+ *
+ * @param mcu MCU samples
+ * @param out First output byte of the MCU
+ * @param stride Output bytes per row
+ * @param ox Output x
+ * @param oy Output y
+ */
+typedef void (*jpeg_color_kernel_t)(const jpeg_mcu_t *mcu, uint8_t *out, uint32_t stride,
+                                    uint16_t ox, uint16_t oy);
+
+/**
+ * Classify sampling factors
+ *
+ * @param ncomp Component count (1 or 3)
+ * @param h Maximum horizontal sampling factor
+ * @param v Maximum vertical sampling factor
+ * @return Chroma layout
+ */
+jpeg_layout_t jpeg_color_layout(uint8_t ncomp, uint8_t h, uint8_t v);
+
+/**
+ * Select a kernel
+ * Full-size RGB565 gets the PIE row kernels while simd_enabled()
+ *
+ * @param layout Chroma layout
+ * @param format Output format
+ * @param n Samples per block side
+ * @return Specialized kernel, or the generic kernel if none applies
+ */
+jpeg_color_kernel_t jpeg_color_get_kernel(jpeg_layout_t layout, jpeg_pixel_format_t format, int n);
+
+/**
+ * Generic per-pixel kernel for any layout (reference and fallback)
+ *
+ * @param format Output format
+ * @return Kernel
+ */
+jpeg_color_kernel_t jpeg_color_get_generic(jpeg_pixel_format_t format);
+
+/**
+ * Layout name for logs
+ *
+ * @param layout Chroma layout
+ * @return Name such as "4:2:0"
+ */
+const char *jpeg_color_layout_name(jpeg_layout_t layout);
+
+#endif // JPEG_COLOR_H
@@ -0,0 +1,139 @@
+/**
+ * Software Baseline JPEG Decoder
+ * Compact decoder for MJPEG frames, used when no hardware/ROM JPEG decoder
+ * is available and whenever reduced-scale output is requested
+ *
+ * Supports baseline Huffman JPEG (SOF0/SOF1), 8-bit precision, grayscale or
+ * YCbCr with 4:4:4, 4:2:2 and 4:2:0 sampling, restart markers, and AVI1-style
+ * frames without DHT (standard tables are preloaded).
+ *
+ * Output is RGB565 in panel byte order (big-endian), so it can be pushed to
+ * the ST7789 without swapping, or packed RGB444 (12 bpp panel mode) with
+ * ordered dithering applied in the color conversion pass.
+ */
+
+#ifndef JPEG_SW_H
+#define JPEG_SW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/**
+ * Output scale (IDCT size per 8x8 block)
+ */
+typedef enum {
+    JPEG_SCALE_1_1 = 0,     // 8x8 IDCT
+    JPEG_SCALE_1_2 = 1,     // 4x4 IDCT
+    JPEG_SCALE_1_4 = 2,     // 2x2 IDCT
+    JPEG_SCALE_1_8 = 3,     // DC only
+} jpeg_scale_t;
+
+/**
+ * Output pixel format
+ */
+typedef enum {
+    JPEG_PIXEL_RGB565 = 0,  // Big-endian RGB565, 2 bytes per pixel
+    JPEG_PIXEL_RGB444,      // Packed RGB444 (R0G0 B0R1 G1B1), 3 bytes per 2 pixels
+} jpeg_pixel_format_t;
+
+/**
+ * Block class by nonzero coefficient extent, decides the IDCT path
+ */
+typedef enum {
+    JPEG_BLOCK_DC = 0,      // DC only: flat fill
+    JPEG_BLOCK_2X2,         // Nonzero coefficients within the top-left 2x2
+    JPEG_BLOCK_4X4,         // Within the top-left 4x4
+    JPEG_BLOCK_FULL,        // Full IDCT
+    JPEG_BLOCK_CLASS_COUNT,
+} jpeg_block_class_t;
+
+/**
+ * Decoder statistics since create or the last reset
+ */
+typedef struct {
+    uint32_t blocks[JPEG_BLOCK_CLASS_COUNT];    // Blocks decoded per class
+} jpeg_sw_stats_t;
+
+/**
+ * Decoder handle
+ */
+typedef struct jpeg_sw_s jpeg_sw_t;
+
+/**
+ * Create decoder
+ *
+ * @return Decoder handle, or NULL on failure
+ */
+jpeg_sw_t *jpeg_sw_create(void);
+
+/**
+ * Destroy decoder
+ *
+ * @param dec Decoder handle
+ */
+void jpeg_sw_destroy(jpeg_sw_t *dec);
+
+/**
+ * Set output pixel format for subsequent decodes
+ * RGB444 needs an even output width and even MCU width at the chosen scale
+ * (always true at 1/1 to 1/4 scale for even-width frames)
+ *
+ * @param dec Decoder handle
+ * @param format Output format
+ */
+void jpeg_sw_set_pixel_format(jpeg_sw_t *dec, jpeg_pixel_format_t format);
+
+/**
+ * Enable or disable the sparse IDCT paths (enabled by default)
+ * Output is identical either way; disabling is for benchmarking
+ *
+ * @param dec Decoder handle
+ * @param enable true to dispatch on block class
+ */
+void jpeg_sw_set_sparse_idct(jpeg_sw_t *dec, bool enable);
+
+/**
+ * Get block class counts
+ *
+ * @param dec Decoder handle
+ * @param stats Output statistics
+ */
+void jpeg_sw_get_stats(const jpeg_sw_t *dec, jpeg_sw_stats_t *stats);
+
+/**
+ * Reset block class counts
+ *
+ * @param dec Decoder handle
+ */
+void jpeg_sw_reset_stats(jpeg_sw_t *dec);
+
+/**
+ * Read image dimensions from SOF header without decoding
+ *
+ * @param data JPEG data
+ * @param size JPEG size in bytes
+ * @param width Output width
+ * @param height Output height
+ * @return ESP_OK on success
+ */
+esp_err_t jpeg_sw_get_info(const uint8_t *data, uint32_t size, uint16_t *width, uint16_t *height);
+
+/**
+ * Decode JPEG to RGB565 or packed RGB444
+ *
+ * @param dec Decoder handle
+ * @param data JPEG data
+ * @param size JPEG size in bytes
+ * @param scale Output scale
+ * @param output Output buffer (big-endian RGB565 or packed RGB444)
+ * @param max_pixels Output buffer capacity in RGB565 pixels
+ * @param out_width Output width after scaling
+ * @param out_height Output height after scaling
+ * @return ESP_OK on success
+ */
+esp_err_t jpeg_sw_decode(jpeg_sw_t *dec, const uint8_t *data, uint32_t size,
+                         jpeg_scale_t scale, uint16_t *output, uint32_t max_pixels,
+                         uint16_t *out_width, uint16_t *out_height);
+
+#endif // JPEG_SW_H
@@ -0,0 +1,34 @@
+/**
+ * LZ565 Video Codec
+ * Pre-decoded RGB565 frames, each compressed as one LZ4 block
+ *
+ * Frames are stored in AVI 00dc chunks with FOURCC "L565". Each chunk is a
+ * standard LZ4 block (no frame header) that expands to width * height
+ * big-endian RGB565 pixels, top-down, already in panel byte order. Decoding
+ * is a run of literal and match copies straight into the DMA frame buffer,
+ * so it costs little more than a memcpy; the trade is 3-6x larger files
+ * than MJPEG at the same resolution.
+ *
+ * Encoder: tools/host/lz565_encode.c
+ */
+
+#ifndef LZ565_H
+#define LZ565_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/**
+ * Decode one frame
+ *
+ * @param src LZ4 block
+ * @param src_size Block size in bytes
+ * @param dst Output buffer (frame buffer)
+ * @param dst_size Expected output size (width * height * 2)
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the block is malformed
+ *         or does not expand to exactly dst_size bytes
+ */
+esp_err_t lz565_decode(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size);
+
+#endif // LZ565_H
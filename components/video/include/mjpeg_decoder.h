@@ -1,6 +1,9 @@
 /**
  * MJPEG Decoder
  * Decodes Motion JPEG frames from AVI files
+ *
+ * Output is RGB565 in panel byte order (big-endian) for every backend, or
+ * packed RGB444 from the software decoder when the panel runs in 12 bpp mode.
  */
 
 #ifndef MJPEG_DECODER_H
@@ -9,6 +12,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "jpeg_sw.h"
 
 // MJPEG chunk info
 typedef struct {
@@ -55,6 +59,26 @@ esp_err_t mjpeg_decoder_decode_frame(mjpeg_decoder_t *decoder,
                                       uint16_t *output_width,
                                       uint16_t *output_height);
 
+/**
+ * Set output scale for subsequent frames
+ * Reduced scales always use the software decoder, which only computes the
+ * low-frequency IDCT terms; used for fast-forward/rewind previews
+ *
+ * @param decoder Decoder handle
+ * @param scale Output scale (JPEG_SCALE_1_1 for normal playback)
+ */
+void mjpeg_decoder_set_scale(mjpeg_decoder_t *decoder, jpeg_scale_t scale);
+
+/**
+ * Set output pixel format for subsequent frames
+ * RGB444 always uses the software decoder, which packs and dithers in its
+ * color conversion pass
+ *
+ * @param decoder Decoder handle
+ * @param format JPEG_PIXEL_RGB565 or JPEG_PIXEL_RGB444
+ */
+void mjpeg_decoder_set_pixel_format(mjpeg_decoder_t *decoder, jpeg_pixel_format_t format);
+
 /**
  * Get last decode time in milliseconds
  *
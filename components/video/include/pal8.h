@@ -0,0 +1,75 @@
+/**
+ * PAL8 Video Codec
+ * 8-bit indexed frames with a per-scene 256-color palette
+ *
+ * Retro content survives quantization to 256 colors per scene almost
+ * unchanged. Frames then need one byte per pixel, compress well, and
+ * "decoding" is a table lookup: indices are expanded to RGB565 through a
+ * 512-byte LUT strip by strip on the way to the panel, so no RGB565 frame
+ * buffer is needed. Frames are stored in AVI 00dc chunks with FOURCC "PAL8".
+ *
+ * Chunk layout (multi-byte fields little-endian, like AVI):
+ *
+ *   u8  flags          PAL8_FLAG_KEYFRAME, PAL8_FLAG_PALETTE
+ *   u8  reserved
+ *   u16 palette_count  entries that follow (PAL8_FLAG_PALETTE only)
+ *   u8  palette[palette_count * 2]   big-endian RGB565, panel byte order
+ *   u8  indices[]      one LZ4 block of width * height indices, top-down
+ *
+ * The palette is sent at scene cuts and repeated on every keyframe, so a
+ * seek to a keyframe always starts with the right colors. Entries not sent
+ * keep their previous value.
+ *
+ * Encoder: tools/host/pal8_encode.c
+ */
+
+#ifndef PAL8_H
+#define PAL8_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define PAL8_FLAG_KEYFRAME  0x01
+#define PAL8_FLAG_PALETTE   0x02
+
+#define PAL8_HEADER_SIZE    4
+#define PAL8_COLORS         256
+
+/**
+ * Update the LUT from a frame's palette, if it carries one
+ * For frames that are skipped rather than shown
+ *
+ * @param src Chunk data
+ * @param src_size Chunk size in bytes
+ * @param lut 256-entry RGB565 LUT (panel byte order), updated in place
+ * @return ESP_OK on success (also when there is no palette),
+ *         ESP_ERR_INVALID_SIZE if the chunk is malformed
+ */
+esp_err_t pal8_apply_palette(const uint8_t *src, uint32_t src_size, uint16_t *lut);
+
+/**
+ * Decode one frame to indices, updating the LUT if the frame carries a palette
+ *
+ * @param src Chunk data
+ * @param src_size Chunk size in bytes
+ * @param lut 256-entry RGB565 LUT (panel byte order), updated in place
+ * @param indices Output index buffer
+ * @param pixels Expected pixel count (width * height)
+ * @param keyframe Output keyframe flag (optional)
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the chunk is malformed
+ */
+esp_err_t pal8_decode(const uint8_t *src, uint32_t src_size, uint16_t *lut,
+                      uint8_t *indices, uint32_t pixels, bool *keyframe);
+
+/**
+ * Expand indices to RGB565 through the LUT
+ *
+ * @param indices Index data
+ * @param lut 256-entry RGB565 LUT
+ * @param dst Output pixels (panel byte order)
+ * @param count Number of pixels
+ */
+void pal8_expand(const uint8_t *indices, const uint16_t *lut, uint16_t *dst, uint32_t count);
+
+#endif // PAL8_H
@@ -0,0 +1,80 @@
+/**
+ * Rational Timebase
+ * Exact frame timing from the AVI stream rate/scale pair
+ *
+ * NTSC rates are not whole numbers (29.97 = 30000/1001, 23.976 = 24000/1001),
+ * so a rounded fps or an integer microseconds-per-frame drifts from audio by
+ * seconds per episode. Timestamps here are always computed from the frame
+ * number, never accumulated, so rounding stays below 1 us at any position.
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+#define TIMEBASE_DEFAULT_FPS    15      // Used when a file carries no usable rate
+
+/**
+ * Frame rate as rate / scale frames per second, reduced to lowest terms
+ */
+typedef struct {
+    uint32_t rate;
+    uint32_t scale;
+} timebase_t;
+
+/**
+ * Initialize from a rate/scale pair
+ * Falls back to TIMEBASE_DEFAULT_FPS if either is zero
+ *
+ * @param tb Timebase
+ * @param rate Frames per scale seconds
+ * @param scale Time unit
+ */
+void timebase_init(timebase_t *tb, uint32_t rate, uint32_t scale);
+
+/**
+ * Start time of a frame
+ *
+ * @param tb Timebase
+ * @param frame Frame number
+ * @return Microseconds from the first frame, rounded down
+ */
+uint64_t timebase_frame_to_us(const timebase_t *tb, uint64_t frame);
+
+/**
+ * Frame showing at a time
+ *
+ * @param tb Timebase
+ * @param us Microseconds from the first frame
+ * @return Frame number, rounded down
+ */
+uint64_t timebase_us_to_frame(const timebase_t *tb, uint64_t us);
+
+/**
+ * Whole seconds at the start of a frame
+ *
+ * @param tb Timebase
+ * @param frame Frame number
+ * @return Seconds, rounded down
+ */
+uint32_t timebase_frame_to_sec(const timebase_t *tb, uint32_t frame);
+
+/**
+ * First frame at or after a time in seconds
+ *
+ * @param tb Timebase
+ * @param sec Seconds
+ * @return Frame number
+ */
+uint32_t timebase_sec_to_frame(const timebase_t *tb, uint32_t sec);
+
+/**
+ * Frame rate rounded to the nearest integer, for display and estimates
+ *
+ * @param tb Timebase
+ * @return Frames per second
+ */
+uint16_t timebase_fps_rounded(const timebase_t *tb);
+
+#endif // TIMEBASE_H
@@ -9,6 +9,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "sd_profile.h"
+#include "display.h"
+#include "timebase.h"
 
 // Playback states
 typedef enum {
@@ -18,6 +21,14 @@ typedef enum {
     VIDEO_STATE_ERROR
 } video_state_t;
 
+// Playback speeds (negative values rewind)
+#define VIDEO_SPEED_NORMAL      1
+#define VIDEO_SPEED_MAX         16
+
+// Playback rate with audio, Q8 (256 = 1.0x)
+#define VIDEO_RATE_1X           256
+#define VIDEO_RATE_MAX          512
+
 /**
  * Video file information
  */
@@ -25,11 +36,47 @@ typedef struct {
     char path[256];
     uint16_t width;
     uint16_t height;
-    uint16_t fps;
+    uint16_t fps;               // Rounded, for display; timing uses timebase
+    timebase_t timebase;        // Exact frame rate (e.g. 30000/1001)
     uint32_t frame_count;
     uint32_t duration_sec;
 } video_info_t;
 
+// Stage time histograms: bucket 0 is under 1 ms, bucket i (1-6) under
+// 2^i ms, bucket 7 everything slower
+#define VIDEO_HIST_BUCKETS      8
+
+/**
+ * Per-frame pipeline stages
+ */
+typedef enum {
+    VIDEO_STAGE_READ,           // Next frame from the prefetch queue or the card
+    VIDEO_STAGE_DECODE,         // Decode (and RGB444 pack) into a frame buffer
+    VIDEO_STAGE_PUSH,           // Wait for the previous transfer, queue this one
+    VIDEO_STAGE_COUNT
+} video_stage_t;
+
+/**
+ * Playback counters since the file was opened
+ */
+typedef struct {
+    uint32_t frames;            // Frames shown
+    uint32_t late;              // Shown after the next frame was due
+    uint32_t dropped;           // Read but not shown (decode failures)
+    uint32_t underruns;         // Waits on the card for a frame
+    uint32_t hist[VIDEO_STAGE_COUNT][VIDEO_HIST_BUCKETS];
+    uint32_t max_us[VIDEO_STAGE_COUNT];
+} video_stats_t;
+
+/**
+ * One traced frame
+ */
+typedef struct {
+    uint32_t frame_num;
+    int32_t slack_us;           // Time left until the next frame was due (negative: late)
+    uint16_t stage_us[VIDEO_STAGE_COUNT];   // Saturates at 65535
+} video_trace_t;
+
 /**
  * Video player handle
  */
@@ -40,7 +87,7 @@ typedef struct video_player_s video_player_t;
  */
 typedef struct {
     void (*on_frame_decoded)(void *user_data, uint32_t frame_num);
-    void (*on_playback_complete)(void *user_data);
+    void (*on_playback_complete)(void *user_data);  // After the task has let go of the file
     void (*on_error)(void *user_data, esp_err_t error);
 } video_callbacks_t;
 
@@ -94,6 +141,7 @@ esp_err_t video_player_pause(video_player_t *player);
 
 /**
  * Stop playback
+ * Returns once the playback task and its reader have exited
  *
  * @param player Video player handle
  * @return ESP_OK on success
@@ -109,6 +157,119 @@ esp_err_t video_player_stop(video_player_t *player);
  */
 esp_err_t video_player_seek(video_player_t *player, uint32_t frame_num);
 
+/**
+ * Set playback speed (fast-forward / rewind)
+ * Trick play jumps between keyframes via the frame index and decodes at
+ * reduced scale (1/2 for 2x-4x, 1/4 for 8x-16x) with a position bar drawn
+ * into the frame, so CPU load stays at or below normal playback. No audio
+ * is produced while speed != 1; callers should pause the audio player.
+ * Setting a trick speed while paused resumes playback.
+ *
+ * @param player Video player handle
+ * @param speed VIDEO_SPEED_NORMAL, or +/-2, 4, 8, 16
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the file has no frame index
+ */
+esp_err_t video_player_set_speed(video_player_t *player, int8_t speed);
+
+/**
+ * Get playback speed
+ *
+ * @param player Video player handle
+ * @return Current speed (VIDEO_SPEED_NORMAL during normal playback)
+ */
+int8_t video_player_get_speed(const video_player_t *player);
+
+/**
+ * Set playback rate for faster viewing with audio (1.0x-2.0x)
+ * Frames are shown at the file's frame rate and selected by media time, so
+ * surplus frames are skipped (via the frame index when present) instead of
+ * decoded. Pair with audio_player_set_rate() for pitch-preserved sound.
+ *
+ * @param player Video player handle
+ * @param rate_q8 Rate in Q8, VIDEO_RATE_1X to VIDEO_RATE_MAX
+ * @return ESP_OK on success
+ */
+esp_err_t video_player_set_rate(video_player_t *player, uint16_t rate_q8);
+
+/**
+ * Get playback rate
+ *
+ * @param player Video player handle
+ * @return Rate in Q8
+ */
+uint16_t video_player_get_rate(const video_player_t *player);
+
+/**
+ * Set storage I/O tuning (from sd_card_get_tuning)
+ * The read block size applies to the next opened file and the prefetch
+ * depth to the next started playback. Files whose bitrate exceeds the
+ * card's sustainable rate are reported when opened.
+ *
+ * @param player Video player handle
+ * @param tuning I/O tuning
+ * @return ESP_OK on success
+ */
+esp_err_t video_player_set_io_tuning(video_player_t *player, const sd_io_tuning_t *tuning);
+
+/**
+ * Set panel pixel format for video frames
+ * RGB444 cuts SPI bytes per frame by 25%: full-size frames are decoded
+ * straight to packed, dithered RGB444; trick-play frames are packed after
+ * scaling. UI drawing keeps using RGB565.
+ *
+ * @param player Video player handle
+ * @param format DISPLAY_FORMAT_RGB565 or DISPLAY_FORMAT_RGB444
+ * @return ESP_OK on success
+ */
+esp_err_t video_player_set_pixel_format(video_player_t *player, display_format_t format);
+
+/**
+ * Invalidate panel contents after drawing over the video
+ * Codecs that only push changed rows (CRB) send the whole frame next, so
+ * overlays such as the OSD do not linger; other codecs are unaffected.
+ *
+ * @param player Video player handle
+ */
+void video_player_invalidate(video_player_t *player);
+
+/**
+ * Get number of times playback waited on the card for a frame
+ *
+ * @param player Video player handle
+ * @return Underrun count since the file was opened
+ */
+uint32_t video_player_get_underruns(const video_player_t *player);
+
+/**
+ * Get playback counters and stage time histograms
+ * Updated by the playback task without locking; fields are individually
+ * consistent, not as a set
+ *
+ * @param player Video player handle
+ * @param stats Output counters
+ * @return ESP_OK on success
+ */
+esp_err_t video_player_get_stats(const video_player_t *player, video_stats_t *stats);
+
+/**
+ * Record the next frames' stage times into a caller-owned buffer
+ * Recording stops when the buffer is full; the player never allocates for it
+ *
+ * @param player Video player handle
+ * @param buffer Trace buffer, NULL to stop recording
+ * @param capacity Entries in the buffer
+ * @return ESP_OK on success
+ */
+esp_err_t video_player_start_trace(video_player_t *player, video_trace_t *buffer, uint32_t capacity);
+
+/**
+ * Get number of frames recorded since video_player_start_trace
+ *
+ * @param player Video player handle
+ * @return Entries written to the trace buffer
+ */
+uint32_t video_player_get_trace_count(const video_player_t *player);
+
 /**
  * Get current playback state
  *
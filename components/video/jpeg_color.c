@@ -0,0 +1,303 @@
+/**
+ * JPEG Color Conversion Kernels Implementation
+ *
+ * convert_quads() is always inlined into one wrapper per layout and format
+ * with constant sampling shifts, so the compiler drops the unused chroma
+ * lookups and output paths from each kernel. The chroma tables are
+ * generated at build time (luts.h) from the Q14 terms in simd.h, so the PIE
+ * row kernels used for full-size RGB565 MCUs on S3 produce the same pixels
+ * as the table-driven ones.
+ */
+
+#include "jpeg_color.h"
+#include "simd.h"
+#include "luts.h"
+
+/**
+ * Chroma contribution to one pixel
+ */
+typedef struct {
+    int16_t r, g, b;
+} chroma_t;
+
+static inline uint8_t clamp_u8(int32_t v)
+{
+    return (v < 0) ? 0 : (v > 255) ? 255 : v;
+}
+
+/**
+ * Reduce an 8-bit channel to 4 bits with a dither threshold (0-15)
+ */
+static inline uint8_t dither4(uint8_t v, uint8_t d)
+{
+    return (v - (v >> 4) + d) >> 4;
+}
+
+static inline chroma_t chroma_at(const uint8_t *cb, const uint8_t *cr, int i)
+{
+    chroma_t c = {
+        .r = lut_cr_r[cr[i]],
+        .g = lut_cb_g[cb[i]] + lut_cr_g[cr[i]],
+        .b = lut_cb_b[cb[i]],
+    };
+    return c;
+}
+
+/**
+ * Store one big-endian RGB565 pixel
+ */
+static inline void put_565(uint8_t *d, int y, chroma_t c)
+{
+    uint8_t r = clamp_u8(y + c.r);
+    uint8_t g = clamp_u8(y + c.g);
+    uint8_t b = clamp_u8(y + c.b);
+
+    d[0] = (r & 0xF8) | (g >> 5);
+    d[1] = ((g << 3) & 0xE0) | (b >> 3);
+}
+
+/**
+ * Store a dithered RGB444 pixel pair (R0G0 B0R1 G1B1) starting at even x
+ */
+static inline void put_444_pair(uint8_t *d, const uint8_t *bayer, int x,
+                                int y0, chroma_t c0, int y1, chroma_t c1)
+{
+    uint8_t d0 = bayer[x & 3];
+    uint8_t d1 = bayer[(x + 1) & 3];
+
+    d[0] = (dither4(clamp_u8(y0 + c0.r), d0) << 4) | dither4(clamp_u8(y0 + c0.g), d0);
+    d[1] = (dither4(clamp_u8(y0 + c0.b), d0) << 4) | dither4(clamp_u8(y1 + c1.r), d1);
+    d[2] = (dither4(clamp_u8(y1 + c1.g), d1) << 4) | dither4(clamp_u8(y1 + c1.b), d1);
+}
+
+/**
+ * Convert one MCU in 2x2 quads
+ * h/v are luma blocks per MCU, hs/vs the chroma subsampling shifts; all are
+ * constants at each call site
+ */
+static inline __attribute__((always_inline))
+void convert_quads(const jpeg_mcu_t *mcu, uint8_t *out, uint32_t stride, uint16_t ox, uint16_t oy,
+                   const int h, const int v, const int hs, const int vs,
+                   const bool gray, const bool rgb444)
+{
+    const int n = mcu->n;
+    const uint8_t *cb = mcu->blocks[h * v];
+    const uint8_t *cr = mcu->blocks[h * v + 1];
+    const chroma_t none = {0, 0, 0};
+
+    for (int by = 0; by < v; by++) {
+        for (int bx = 0; bx < h; bx++) {
+            const uint8_t *luma = mcu->blocks[by * h + bx];
+
+            for (int qy = 0; qy < n; qy += 2) {
+                int py = by * n + qy;
+                uint8_t *row0 = out + (uint32_t)py * stride;
+                uint8_t *row1 = row0 + stride;
+                const uint8_t *bayer0 = lut_bayer4[(oy + py) & 3];
+                const uint8_t *bayer1 = lut_bayer4[(oy + py + 1) & 3];
+
+                for (int qx = 0; qx < n; qx += 2) {
+                    int px = bx * n + qx;
+                    const uint8_t *y = &luma[qy * n + qx];
+                    chroma_t c00 = none, c01 = none, c10 = none, c11 = none;
+
+                    if (!gray) {
+                        int ci = (py >> vs) * n + (px >> hs);
+                        c00 = chroma_at(cb, cr, ci);
+                        c01 = hs ? c00 : chroma_at(cb, cr, ci + 1);
+                        c10 = vs ? c00 : chroma_at(cb, cr, ci + n);
+                        c11 = hs ? c10 : vs ? c01 : chroma_at(cb, cr, ci + n + 1);
+                    }
+
+                    if (rgb444) {
+                        put_444_pair(&row0[px * 3 / 2], bayer0, ox + px, y[0], c00, y[1], c01);
+                        put_444_pair(&row1[px * 3 / 2], bayer1, ox + px, y[n], c10, y[n + 1], c11);
+                    } else {
+                        put_565(&row0[px * 2], y[0], c00);
+                        put_565(&row0[px * 2 + 2], y[1], c01);
+                        put_565(&row1[px * 2], y[n], c10);
+                        put_565(&row1[px * 2 + 2], y[n + 1], c11);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#define COLOR_KERNEL(name, h, v, hs, vs, gray, rgb444)                                  \
+    static void name(const jpeg_mcu_t *mcu, uint8_t *out, uint32_t stride,              \
+                     uint16_t ox, uint16_t oy)                                          \
+    {                                                                                   \
+        convert_quads(mcu, out, stride, ox, oy, h, v, hs, vs, gray, rgb444);            \
+    }
+
+COLOR_KERNEL(gray_565, 1, 1, 0, 0, true,  false)
+COLOR_KERNEL(yuv444_565, 1, 1, 0, 0, false, false)
+COLOR_KERNEL(yuv422_565, 2, 1, 1, 0, false, false)
+COLOR_KERNEL(yuv420_565, 2, 2, 1, 1, false, false)
+COLOR_KERNEL(gray_444, 1, 1, 0, 0, true,  true)
+COLOR_KERNEL(yuv444_444, 1, 1, 0, 0, false, true)
+COLOR_KERNEL(yuv422_444, 2, 1, 1, 0, false, true)
+COLOR_KERNEL(yuv420_444, 2, 2, 1, 1, false, true)
+
+/**
+ * Sample lookup for the generic kernels (any block size and layout)
+ */
+static inline int generic_luma(const jpeg_mcu_t *mcu, int px, int py)
+{
+    int n = mcu->n;
+    return mcu->blocks[(py / n) * mcu->h + (px / n)][(py % n) * n + (px % n)];
+}
+
+static inline chroma_t generic_chroma(const jpeg_mcu_t *mcu, int px, int py)
+{
+    if (mcu->gray) {
+        chroma_t none = {0, 0, 0};
+        return none;
+    }
+
+    int luma_blocks = mcu->h * mcu->v;
+    int ci = (py >> (mcu->v - 1)) * mcu->n + (px >> (mcu->h - 1));
+    return chroma_at(mcu->blocks[luma_blocks], mcu->blocks[luma_blocks + 1], ci);
+}
+
+static void generic_565(const jpeg_mcu_t *mcu, uint8_t *out, uint32_t stride,
+                        uint16_t ox, uint16_t oy)
+{
+    (void)ox;   // RGB565 is not dithered
+    (void)oy;
+
+    int w = mcu->h * mcu->n;
+    int h = mcu->v * mcu->n;
+
+    for (int py = 0; py < h; py++) {
+        uint8_t *d = out + (uint32_t)py * stride;
+        for (int px = 0; px < w; px++) {
+            put_565(&d[px * 2], generic_luma(mcu, px, py), generic_chroma(mcu, px, py));
+        }
+    }
+}
+
+static void generic_444(const jpeg_mcu_t *mcu, uint8_t *out, uint32_t stride,
+                        uint16_t ox, uint16_t oy)
+{
+    int w = mcu->h * mcu->n;
+    int h = mcu->v * mcu->n;
+
+    for (int py = 0; py < h; py++) {
+        uint8_t *d = out + (uint32_t)py * stride;
+        const uint8_t *bayer = lut_bayer4[(oy + py) & 3];
+        for (int px = 0; px < w; px += 2) {
+            put_444_pair(&d[px * 3 / 2], bayer, ox + px,
+                         generic_luma(mcu, px, py), generic_chroma(mcu, px, py),
+                         generic_luma(mcu, px + 1, py), generic_chroma(mcu, px + 1, py));
+        }
+    }
+}
+
+/**
+ * Full-size RGB565 MCU through the PIE row kernel, one 8-pixel block row
+ * per call; chroma row and column follow the same shifts as convert_quads()
+ */
+static inline __attribute__((always_inline))
+void convert_rows_simd(const jpeg_mcu_t *mcu, uint8_t *out, uint32_t stride,
+                       const int h, const int v, const int hs, const int vs,
+                       const simd_chroma_t chroma)
+{
+    const uint8_t *cb = mcu->blocks[h * v];
+    const uint8_t *cr = mcu->blocks[h * v + 1];
+
+    for (int by = 0; by < v; by++) {
+        for (int bx = 0; bx < h; bx++) {
+            const uint8_t *luma = mcu->blocks[by * h + bx];
+
+            for (int qy = 0; qy < 8; qy++) {
+                int py = by * 8 + qy;
+                int ci = (py >> vs) * 8 + ((bx * 8) >> hs);
+                simd_ycc_row8_rgb565(&luma[qy * 8], &cb[ci], &cr[ci], chroma,
+                                     out + (uint32_t)py * stride + bx * 16);
+            }
+        }
+    }
+}
+
+// The row kernel wants 16-byte aligned rows; other targets take the LUT path
+#define SIMD_KERNEL(name, fallback, h, v, hs, vs, chroma)                               \
+    static void name(const jpeg_mcu_t *mcu, uint8_t *out, uint32_t stride,              \
+                     uint16_t ox, uint16_t oy)                                          \
+    {                                                                                   \
+        if ((((uintptr_t)out) | stride) & 15) {                                         \
+            fallback(mcu, out, stride, ox, oy);                                         \
+            return;                                                                     \
+        }                                                                               \
+        convert_rows_simd(mcu, out, stride, h, v, hs, vs, chroma);                      \
+    }
+
+SIMD_KERNEL(gray_565_simd, gray_565, 1, 1, 0, 0, SIMD_CHROMA_NONE)
+SIMD_KERNEL(yuv444_565_simd, yuv444_565, 1, 1, 0, 0, SIMD_CHROMA_FULL)
+SIMD_KERNEL(yuv422_565_simd, yuv422_565, 2, 1, 1, 0, SIMD_CHROMA_HALF)
+SIMD_KERNEL(yuv420_565_simd, yuv420_565, 2, 2, 1, 1, SIMD_CHROMA_HALF)
+
+static const jpeg_color_kernel_t g_simd_kernels[JPEG_LAYOUT_GENERIC] = {
+    [JPEG_LAYOUT_GRAY] = gray_565_simd,
+    [JPEG_LAYOUT_444]  = yuv444_565_simd,
+    [JPEG_LAYOUT_422]  = yuv422_565_simd,
+    [JPEG_LAYOUT_420]  = yuv420_565_simd,
+};
+
+// [layout][format]
+static const jpeg_color_kernel_t g_kernels[JPEG_LAYOUT_COUNT][2] = {
+    [JPEG_LAYOUT_GRAY]    = {gray_565,    gray_444},
+    [JPEG_LAYOUT_444]     = {yuv444_565,  yuv444_444},
+    [JPEG_LAYOUT_422]     = {yuv422_565,  yuv422_444},
+    [JPEG_LAYOUT_420]     = {yuv420_565,  yuv420_444},
+    [JPEG_LAYOUT_GENERIC] = {generic_565, generic_444},
+};
+
+/**
+ * Classify sampling factors
+ */
+jpeg_layout_t jpeg_color_layout(uint8_t ncomp, uint8_t h, uint8_t v)
+{
+    if (ncomp == 1) return JPEG_LAYOUT_GRAY;
+    if (h == 1 && v == 1) return JPEG_LAYOUT_444;
+    if (h == 2 && v == 1) return JPEG_LAYOUT_422;
+    if (h == 2 && v == 2) return JPEG_LAYOUT_420;
+    return JPEG_LAYOUT_GENERIC;
+}
+
+/**
+ * Select kernel
+ */
+jpeg_color_kernel_t jpeg_color_get_kernel(jpeg_layout_t layout, jpeg_pixel_format_t format, int n)
+{
+    int f = (format == JPEG_PIXEL_RGB444) ? 1 : 0;
+
+    if (n < 2 || layout >= JPEG_LAYOUT_COUNT) layout = JPEG_LAYOUT_GENERIC;
+    if (f == 0 && n == 8 && layout < JPEG_LAYOUT_GENERIC && simd_enabled()) {
+        return g_simd_kernels[layout];
+    }
+    return g_kernels[layout][f];
+}
+
+/**
+ * Generic kernel
+ */
+jpeg_color_kernel_t jpeg_color_get_generic(jpeg_pixel_format_t format)
+{
+    return g_kernels[JPEG_LAYOUT_GENERIC][(format == JPEG_PIXEL_RGB444) ? 1 : 0];
+}
+
+/**
+ * Layout name
+ */
+const char *jpeg_color_layout_name(jpeg_layout_t layout)
+{
+    switch (layout) {
+        case JPEG_LAYOUT_GRAY: return "gray";
+        case JPEG_LAYOUT_444:  return "4:4:4";
+        case JPEG_LAYOUT_422:  return "4:2:2";
+        case JPEG_LAYOUT_420:  return "4:2:0";
+        default:               return "generic";
+    }
+}
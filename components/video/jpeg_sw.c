@@ -0,0 +1,935 @@
+/**
+ * Software Baseline JPEG Decoder Implementation
+ *
+ * Huffman decoding uses a 9-bit lookahead table with a canonical-code slow
+ * path. The tables for the standard codes (AVI1 frames carry no DHT) are
+ * generated at build time into flash by the luts component; only tables a
+ * DHT segment defines are built here. The full-size IDCT is the classic
+ * integer "islow" algorithm (LL&M, 13-bit constants); reduced sizes use
+ * small separable matrix IDCTs over the low-frequency coefficients, which is
+ * what makes 1/2 and 1/4 scale decoding cheap. Huffman decoding records the
+ * last nonzero coefficient of each block, and blocks with only DC or a
+ * 2x2/4x4 low-frequency corner take pruned variants of the same transforms
+ * (bit-exact, fewer passes and multiplies). Blocks that need the full
+ * transform go through the PIE matrix IDCT in simd.c when it is enabled
+ * (also bit-exact). Color conversion is done by the kernels in jpeg_color.c,
+ * picked once per frame from the SOF sampling factors.
+ */
+
+#include "jpeg_sw.h"
+#include "jpeg_color.h"
+#include "simd.h"
+#include "luts.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+
+static const char *TAG = "JPEG_SW";
+
+#define HUFF_LOOKAHEAD      LUT_HUFF_LOOKAHEAD
+#define MAX_COMPONENTS      3
+#define MAX_BLOCKS_PER_MCU  6   // 4 Y + Cb + Cr (4:2:0)
+#define MAX_MCU_SIZE        16
+
+// JPEG markers
+#define M_SOF0  0xC0
+#define M_SOF1  0xC1
+#define M_DHT   0xC4
+#define M_RST0  0xD0
+#define M_SOI   0xD8
+#define M_EOI   0xD9
+#define M_SOS   0xDA
+#define M_DQT   0xDB
+#define M_DRI   0xDD
+
+/**
+ * Huffman table with lookahead (same layout as the generated standard ones)
+ */
+typedef lut_huff_t huff_table_t;
+
+/**
+ * Frame component
+ */
+typedef struct {
+    uint8_t id;
+    uint8_t h, v;       // Sampling factors
+    uint8_t tq;         // Quantization table
+    uint8_t td, ta;     // DC / AC Huffman tables
+    int32_t pred;       // DC predictor
+} jpeg_component_t;
+
+/**
+ * Bit reader (MSB-aligned 32-bit buffer)
+ */
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint32_t buf;
+    int bits;
+    bool marker;        // Hit a marker, feeding zeros
+} bit_reader_t;
+
+/**
+ * Decoder structure
+ */
+struct jpeg_sw_s {
+    const huff_table_t *dc[2];  // Standard tables in flash until a DHT replaces them
+    const huff_table_t *ac[2];
+    huff_table_t *dht;          // DHT-defined tables by class and id, allocated on first DHT
+    uint16_t qt[4][64];         // Zigzag order
+
+    uint16_t width;
+    uint16_t height;
+    uint8_t ncomp;
+    uint8_t hmax, vmax;
+    jpeg_layout_t layout;
+    jpeg_component_t comp[MAX_COMPONENTS];
+    uint16_t restart_interval;
+    jpeg_pixel_format_t format;
+    bool sparse_idct;
+    uint32_t block_count[JPEG_BLOCK_CLASS_COUNT];
+
+    // 16-byte aligned for the PIE kernels (the decoder itself is allocated so)
+    int32_t coef[64] __attribute__((aligned(16)));      // Dequantized coefficients, natural order
+    uint32_t coef_mag;                                  // Sum of |coef| of the current block
+    uint8_t mcu[MAX_BLOCKS_PER_MCU][64] __attribute__((aligned(16)));
+    uint8_t edge[MAX_MCU_SIZE * MAX_MCU_SIZE * 2] __attribute__((aligned(16)));  // Partial MCUs at the right/bottom edge
+};
+
+// ============================================================================
+// Huffman tables
+// ============================================================================
+
+/**
+ * Build lookahead and slow-path tables from BITS/HUFFVAL
+ * Same construction as huff_table() in gen_luts.py
+ */
+static esp_err_t build_huff_table(huff_table_t *h, const uint8_t *bits, const uint8_t *vals)
+{
+    uint16_t count = 0;
+    for (int i = 0; i < 16; i++) count += bits[i];
+    if (count > 256) return ESP_ERR_INVALID_ARG;
+
+    memcpy(h->vals, vals, count);
+    memset(h->look_len, 0, sizeof(h->look_len));
+
+    uint32_t code = 0;
+    uint16_t k = 0;
+
+    for (int len = 1; len <= 16; len++) {
+        h->valoffset[len] = (int32_t)k - (int32_t)code;
+
+        for (int i = 0; i < bits[len - 1]; i++, k++, code++) {
+            if (len <= HUFF_LOOKAHEAD) {
+                // Every lookahead index with this code as prefix
+                int shift = HUFF_LOOKAHEAD - len;
+                uint32_t first = code << shift;
+                for (uint32_t j = 0; j < (1u << shift); j++) {
+                    h->look_len[first + j] = len;
+                    h->look_sym[first + j] = vals[k];
+                }
+            }
+        }
+
+        h->maxcode[len] = bits[len - 1] ? (int32_t)code - 1 : -1;
+        code <<= 1;
+    }
+
+    h->maxcode[17] = 0x7FFFFFFF;  // Sentinel
+
+    return ESP_OK;
+}
+
+// ============================================================================
+// Bit reader
+// ============================================================================
+
+static inline void br_fill(bit_reader_t *br)
+{
+    while (br->bits <= 24) {
+        uint32_t b = 0;
+
+        if (!br->marker && br->p < br->end) {
+            b = *br->p++;
+            if (b == 0xFF) {
+                uint8_t next = (br->p < br->end) ? *br->p : 0;
+                if (next == 0x00) {
+                    br->p++;            // Stuffed byte
+                } else {
+                    br->marker = true;  // Marker: leave it for restart handling
+                    br->p--;
+                    b = 0;
+                }
+            }
+        }
+
+        br->buf |= b << (24 - br->bits);
+        br->bits += 8;
+    }
+}
+
+static inline uint32_t br_get(bit_reader_t *br, int n)
+{
+    br_fill(br);
+    uint32_t v = br->buf >> (32 - n);
+    br->buf <<= n;
+    br->bits -= n;
+    return v;
+}
+
+/**
+ * Receive n bits and sign-extend (T.81 F.2.2.1 EXTEND)
+ */
+static inline int32_t br_receive_extend(bit_reader_t *br, int n)
+{
+    int32_t v = br_get(br, n);
+    if (v < (1 << (n - 1))) {
+        v -= (1 << n) - 1;
+    }
+    return v;
+}
+
+static inline int huff_decode(bit_reader_t *br, const huff_table_t *h)
+{
+    br_fill(br);
+
+    uint32_t look = br->buf >> (32 - HUFF_LOOKAHEAD);
+    int len = h->look_len[look];
+    if (len) {
+        br->buf <<= len;
+        br->bits -= len;
+        return h->look_sym[look];
+    }
+
+    // Codes longer than the lookahead
+    for (len = HUFF_LOOKAHEAD + 1; len <= 16; len++) {
+        int32_t code = br->buf >> (32 - len);
+        if (code <= h->maxcode[len]) {
+            br->buf <<= len;
+            br->bits -= len;
+            return h->vals[code + h->valoffset[len]];
+        }
+    }
+
+    // Corrupt data: consume a byte and return EOB
+    br->buf <<= 8;
+    br->bits -= 8;
+    return 0;
+}
+
+/**
+ * Skip to and past the next RSTn marker
+ */
+static void br_restart(bit_reader_t *br)
+{
+    br->buf = 0;
+    br->bits = 0;
+    br->marker = false;
+
+    while (br->p + 1 < br->end) {
+        if (br->p[0] == 0xFF && (br->p[1] & 0xF8) == M_RST0) {
+            br->p += 2;
+            return;
+        }
+        br->p++;
+    }
+}
+
+// ============================================================================
+// IDCT
+// ============================================================================
+
+static inline uint8_t clamp_u8(int32_t v)
+{
+    return (v < 0) ? 0 : (v > 255) ? 255 : v;
+}
+
+#define CONST_BITS  13
+#define PASS1_BITS  2
+#define DESCALE(x, n)  (((x) + (1 << ((n) - 1))) >> (n))
+
+#define FIX_0_298631336  2446
+#define FIX_0_390180644  3196
+#define FIX_0_541196100  4433
+#define FIX_0_765366865  6270
+#define FIX_0_899976223  7373
+#define FIX_1_175875602  9633
+#define FIX_1_501321110  12299
+#define FIX_1_847759065  15137
+#define FIX_1_961570560  16069
+#define FIX_2_053119869  16819
+#define FIX_2_562915447  20995
+#define FIX_3_072711026  25172
+
+/**
+ * One 8-point islow pass (LL&M even/odd butterflies), before descaling
+ * Inputs at index nz and beyond are known to be zero; nz is a constant at
+ * every call site, so the sparse variants drop those terms at compile time
+ * and stay bit-exact with the full transform.
+ */
+static inline __attribute__((always_inline))
+void idct_1d(const int32_t *in, int s, int32_t *o, const int nz)
+{
+    int32_t x0 = in[0];
+    int32_t x1 = (nz > 1) ? in[1 * s] : 0;
+    int32_t x2 = (nz > 2) ? in[2 * s] : 0;
+    int32_t x3 = (nz > 3) ? in[3 * s] : 0;
+    int32_t x4 = (nz > 4) ? in[4 * s] : 0;
+    int32_t x5 = (nz > 5) ? in[5 * s] : 0;
+    int32_t x6 = (nz > 6) ? in[6 * s] : 0;
+    int32_t x7 = (nz > 7) ? in[7 * s] : 0;
+
+    // Even part
+    int32_t z1 = (x2 + x6) * FIX_0_541196100;
+    int32_t tmp2 = z1 - x6 * FIX_1_847759065;
+    int32_t tmp3 = z1 + x2 * FIX_0_765366865;
+    int32_t tmp0 = (x0 + x4) * (1 << CONST_BITS);
+    int32_t tmp1 = (x0 - x4) * (1 << CONST_BITS);
+    int32_t tmp10 = tmp0 + tmp3, tmp13 = tmp0 - tmp3;
+    int32_t tmp11 = tmp1 + tmp2, tmp12 = tmp1 - tmp2;
+
+    // Odd part
+    tmp0 = x7; tmp1 = x5; tmp2 = x3; tmp3 = x1;
+    z1 = tmp0 + tmp3;
+    int32_t z2 = tmp1 + tmp2;
+    int32_t z3 = tmp0 + tmp2;
+    int32_t z4 = tmp1 + tmp3;
+    int32_t z5 = (z3 + z4) * FIX_1_175875602;
+    tmp0 *= FIX_0_298631336;
+    tmp1 *= FIX_2_053119869;
+    tmp2 *= FIX_3_072711026;
+    tmp3 *= FIX_1_501321110;
+    z1 *= -FIX_0_899976223;
+    z2 *= -FIX_2_562915447;
+    z3 = z3 * -FIX_1_961570560 + z5;
+    z4 = z4 * -FIX_0_390180644 + z5;
+    tmp0 += z1 + z3;
+    tmp1 += z2 + z4;
+    tmp2 += z2 + z3;
+    tmp3 += z1 + z4;
+
+    o[0] = tmp10 + tmp3;
+    o[7] = tmp10 - tmp3;
+    o[1] = tmp11 + tmp2;
+    o[6] = tmp11 - tmp2;
+    o[2] = tmp12 + tmp1;
+    o[5] = tmp12 - tmp1;
+    o[3] = tmp13 + tmp0;
+    o[4] = tmp13 - tmp0;
+}
+
+/**
+ * True if inputs 1..nz-1 are zero
+ */
+static inline __attribute__((always_inline))
+bool ac_zero(const int32_t *in, int s, const int nz)
+{
+    int32_t acc = 0;
+    for (int i = 1; i < nz; i++) acc |= in[i * s];
+    return acc == 0;
+}
+
+/**
+ * 8x8 integer IDCT (islow) with nonzero coefficients confined to the top-left
+ * nz x nz corner, output stride 8
+ */
+static inline __attribute__((always_inline))
+void idct_islow(const int32_t *in, uint8_t *out, const int nz)
+{
+    int32_t ws[64];
+    int32_t t[8];
+
+    // Pass 1: columns; columns nz..7 are all zero and never read back
+    for (int c = 0; c < nz; c++) {
+        const int32_t *col = &in[c];
+        int32_t *w = &ws[c];
+
+        if (ac_zero(col, 8, nz)) {
+            int32_t dc = col[0] * (1 << PASS1_BITS);
+            for (int r = 0; r < 8; r++) w[r * 8] = dc;
+            continue;
+        }
+
+        idct_1d(col, 8, t, nz);
+        for (int r = 0; r < 8; r++) {
+            w[r * 8] = DESCALE(t[r], CONST_BITS - PASS1_BITS);
+        }
+    }
+
+    // Pass 2: rows
+    for (int r = 0; r < 8; r++) {
+        const int32_t *row = &ws[r * 8];
+        uint8_t *o = &out[r * 8];
+
+        if (ac_zero(row, 1, nz)) {
+            uint8_t v = clamp_u8(DESCALE(row[0], PASS1_BITS + 3) + 128);
+            memset(o, v, 8);
+            continue;
+        }
+
+        idct_1d(row, 1, t, nz);
+        for (int x = 0; x < 8; x++) {
+            o[x] = clamp_u8(DESCALE(t[x], CONST_BITS + PASS1_BITS + 3) + 128);
+        }
+    }
+}
+
+static void idct_8x8(const int32_t *in, uint8_t *out)
+{
+    idct_islow(in, out, 8);
+}
+
+static void idct_8x8_from_4x4(const int32_t *in, uint8_t *out)
+{
+    idct_islow(in, out, 4);
+}
+
+static void idct_8x8_from_2x2(const int32_t *in, uint8_t *out)
+{
+    idct_islow(in, out, 2);
+}
+
+/**
+ * DC-only block: every sample is the same, matches idct_8x8 exactly
+ */
+static void idct_8x8_dc(const int32_t *in, uint8_t *out)
+{
+    memset(out, clamp_u8(DESCALE(in[0] * (1 << PASS1_BITS), PASS1_BITS + 3) + 128), 64);
+}
+
+/**
+ * Reduced NxN IDCT from the low-frequency NxN coefficients, output stride N
+ * Coefficients outside the top-left nz x nz corner are zero and skipped
+ */
+static void idct_reduced(const int32_t *in, uint8_t *out, int n, const int16_t *matrix, int nz)
+{
+    int32_t ws[16];
+
+    if (nz > n) nz = n;
+
+    // Pass 1: along u for each coefficient row v
+    for (int v = 0; v < nz; v++) {
+        for (int x = 0; x < n; x++) {
+            int32_t acc = 0;
+            for (int u = 0; u < nz; u++) {
+                acc += matrix[x * n + u] * in[v * 8 + u];
+            }
+            ws[v * n + x] = DESCALE(acc, CONST_BITS - PASS1_BITS);
+        }
+    }
+
+    // Pass 2: along v
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            int32_t acc = 0;
+            for (int v = 0; v < nz; v++) {
+                acc += matrix[y * n + v] * ws[v * n + x];
+            }
+            out[y * n + x] = clamp_u8(DESCALE(acc, CONST_BITS + PASS1_BITS) + 128);
+        }
+    }
+}
+
+/**
+ * Run the IDCT matching the output scale and the block's nonzero extent
+ */
+static void idct_scaled(const int32_t *in, uint8_t *out, jpeg_scale_t scale, int nz)
+{
+    switch (scale) {
+        case JPEG_SCALE_1_1:
+            if (nz == 1) {
+                idct_8x8_dc(in, out);
+            } else if (nz == 2) {
+                idct_8x8_from_2x2(in, out);
+            } else if (nz == 4) {
+                idct_8x8_from_4x4(in, out);
+            } else {
+                idct_8x8(in, out);
+            }
+            break;
+        case JPEG_SCALE_1_2:
+            idct_reduced(in, out, 4, &lut_idct4[0][0], nz);
+            break;
+        case JPEG_SCALE_1_4:
+            idct_reduced(in, out, 2, &lut_idct2[0][0], nz);
+            break;
+        case JPEG_SCALE_1_8:
+            out[0] = clamp_u8(DESCALE(in[0], 3) + 128);
+            break;
+    }
+}
+
+// Nonzero corner size per block class
+static const uint8_t block_size[JPEG_BLOCK_CLASS_COUNT] = {
+    [JPEG_BLOCK_DC] = 1,
+    [JPEG_BLOCK_2X2] = 2,
+    [JPEG_BLOCK_4X4] = 4,
+    [JPEG_BLOCK_FULL] = 8,
+};
+
+// ============================================================================
+// Header parsing
+// ============================================================================
+
+static inline uint16_t be16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static esp_err_t parse_dqt(jpeg_sw_t *dec, const uint8_t *p, uint16_t len)
+{
+    while (len >= 65) {
+        uint8_t pq = p[0] >> 4;
+        uint8_t tq = p[0] & 0x0F;
+        if (pq != 0 || tq > 3) return ESP_ERR_NOT_SUPPORTED;  // 8-bit tables only
+
+        for (int i = 0; i < 64; i++) {
+            dec->qt[tq][i] = p[1 + i];
+        }
+        p += 65;
+        len -= 65;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t parse_dht(jpeg_sw_t *dec, const uint8_t *p, uint16_t len)
+{
+    while (len >= 17) {
+        uint8_t tc = p[0] >> 4;
+        uint8_t th = p[0] & 0x0F;
+        if (tc > 1 || th > 1) return ESP_ERR_NOT_SUPPORTED;
+
+        uint16_t count = 0;
+        for (int i = 0; i < 16; i++) count += p[1 + i];
+        if (17 + count > len || count > 256) return ESP_ERR_INVALID_SIZE;
+
+        if (dec->dht == NULL) {
+            dec->dht = malloc(4 * sizeof(huff_table_t));
+            if (dec->dht == NULL) return ESP_ERR_NO_MEM;
+        }
+
+        huff_table_t *h = &dec->dht[tc * 2 + th];
+        esp_err_t ret = build_huff_table(h, &p[1], &p[17]);
+        if (ret != ESP_OK) return ret;
+
+        if (tc) {
+            dec->ac[th] = h;
+        } else {
+            dec->dc[th] = h;
+        }
+
+        p += 17 + count;
+        len -= 17 + count;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t parse_sof(jpeg_sw_t *dec, const uint8_t *p, uint16_t len)
+{
+    if (len < 6 || p[0] != 8) return ESP_ERR_NOT_SUPPORTED;  // 8-bit precision
+
+    dec->height = be16(&p[1]);
+    dec->width = be16(&p[3]);
+    dec->ncomp = p[5];
+
+    if ((dec->ncomp != 1 && dec->ncomp != 3) || len < 6 + dec->ncomp * 3) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    dec->hmax = 1;
+    dec->vmax = 1;
+    for (int i = 0; i < dec->ncomp; i++) {
+        jpeg_component_t *c = &dec->comp[i];
+        c->id = p[6 + i * 3];
+        c->h = p[7 + i * 3] >> 4;
+        c->v = p[7 + i * 3] & 0x0F;
+        c->tq = p[8 + i * 3] & 0x03;
+        if (c->h > dec->hmax) dec->hmax = c->h;
+        if (c->v > dec->vmax) dec->vmax = c->v;
+    }
+
+    if (dec->ncomp == 1) {
+        // Single-component scans are non-interleaved: one block per MCU
+        dec->comp[0].h = dec->comp[0].v = 1;
+        dec->hmax = dec->vmax = 1;
+    } else {
+        // Luma 1x1/2x1/2x2, chroma 1x1
+        if (dec->hmax > 2 || dec->vmax > 2 ||
+            dec->comp[1].h != 1 || dec->comp[1].v != 1 ||
+            dec->comp[2].h != 1 || dec->comp[2].v != 1) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    }
+
+    dec->layout = jpeg_color_layout(dec->ncomp, dec->hmax, dec->vmax);
+    return ESP_OK;
+}
+
+static esp_err_t parse_sos(jpeg_sw_t *dec, const uint8_t *p, uint16_t len)
+{
+    uint8_t ns = p[0];
+    if (ns != dec->ncomp || len < 1 + ns * 2) return ESP_ERR_NOT_SUPPORTED;
+
+    for (int i = 0; i < ns; i++) {
+        uint8_t id = p[1 + i * 2];
+        uint8_t tables = p[2 + i * 2];
+        for (int c = 0; c < dec->ncomp; c++) {
+            if (dec->comp[c].id == id) {
+                dec->comp[c].td = (tables >> 4) & 1;
+                dec->comp[c].ta = tables & 1;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * Walk markers up to SOS, returns pointer to entropy-coded data
+ */
+static esp_err_t parse_headers(jpeg_sw_t *dec, const uint8_t *data, uint32_t size,
+                               const uint8_t **scan)
+{
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    bool have_sof = false;
+
+    if (size < 4 || p[0] != 0xFF || p[1] != M_SOI) return ESP_ERR_INVALID_ARG;
+    p += 2;
+
+    while (p + 4 <= end) {
+        if (p[0] != 0xFF) {
+            p++;  // Tolerate garbage between segments
+            continue;
+        }
+
+        uint8_t marker = p[1];
+        if (marker == 0xFF) {
+            p++;  // Fill byte
+            continue;
+        }
+
+        uint16_t len = be16(&p[2]);
+        const uint8_t *seg = p + 4;
+        if (len < 2 || seg + len - 2 > end) return ESP_ERR_INVALID_SIZE;
+
+        esp_err_t ret = ESP_OK;
+        switch (marker) {
+            case M_SOF0:
+            case M_SOF1:
+                ret = parse_sof(dec, seg, len - 2);
+                have_sof = (ret == ESP_OK);
+                break;
+            case M_DHT:
+                ret = parse_dht(dec, seg, len - 2);
+                break;
+            case M_DQT:
+                ret = parse_dqt(dec, seg, len - 2);
+                break;
+            case M_DRI:
+                dec->restart_interval = be16(seg);
+                break;
+            case M_SOS:
+                if (!have_sof) return ESP_ERR_INVALID_STATE;
+                ret = parse_sos(dec, seg, len - 2);
+                *scan = seg + len - 2;
+                return ret;
+            default:
+                if (marker >= 0xC2 && marker <= 0xCF && marker != M_DHT && marker != 0xC8 &&
+                    marker != 0xCC) {
+                    return ESP_ERR_NOT_SUPPORTED;  // Progressive / arithmetic / lossless
+                }
+                break;  // APPn, COM, ...
+        }
+
+        if (ret != ESP_OK) return ret;
+        p = seg + len - 2;
+    }
+
+    return ESP_ERR_INVALID_SIZE;
+}
+
+// ============================================================================
+// Decoding
+// ============================================================================
+
+/**
+ * Decode one block's coefficients and dequantize into dec->coef
+ * Returns the zigzag index of the last coefficient stored (0 = DC only);
+ * dec->coef_mag gets the sum of their magnitudes
+ */
+static int decode_block(jpeg_sw_t *dec, bit_reader_t *br, jpeg_component_t *c)
+{
+    int32_t *coef = dec->coef;
+    const uint16_t *q = dec->qt[c->tq];
+    int last = 0;
+
+    memset(coef, 0, sizeof(dec->coef));
+
+    // DC
+    int s = huff_decode(br, dec->dc[c->td]);
+    if (s) {
+        c->pred += br_receive_extend(br, s);
+    }
+    coef[0] = c->pred * q[0];
+    uint32_t mag = abs(coef[0]);
+
+    // AC
+    const huff_table_t *ac = dec->ac[c->ta];
+    for (int k = 1; k < 64; ) {
+        int rs = huff_decode(br, ac);
+        int r = rs >> 4;
+        s = rs & 0x0F;
+
+        if (s) {
+            k += r;
+            if (k > 63) break;
+            int32_t v = br_receive_extend(br, s) * q[k];
+            coef[lut_zigzag[k]] = v;
+            mag += abs(v);
+            last = k++;
+        } else {
+            if (r != 15) break;  // EOB
+            k += 16;             // ZRL
+        }
+    }
+    dec->coef_mag = mag;
+    return last;
+}
+
+/**
+ * Classify a block by the last nonzero zigzag index: every zigzag position up
+ * to 2 lies in the top-left 2x2 corner, and up to 9 in the 4x4 corner
+ */
+static inline jpeg_block_class_t block_class(int last)
+{
+    if (last == 0) return JPEG_BLOCK_DC;
+    if (last <= 2) return JPEG_BLOCK_2X2;
+    if (last <= 9) return JPEG_BLOCK_4X4;
+    return JPEG_BLOCK_FULL;
+}
+
+/**
+ * Color-convert one MCU and store it; MCUs cut by the image edge are
+ * converted whole into dec->edge and the visible part copied out
+ */
+static void store_mcu(jpeg_sw_t *dec, jpeg_color_kernel_t kernel, const jpeg_mcu_t *mcu,
+                      uint16_t *output, uint16_t out_w, uint16_t out_h, uint16_t ox, uint16_t oy)
+{
+    int mcu_w = mcu->h * mcu->n;
+    int mcu_h = mcu->v * mcu->n;
+
+    // RGB444 packs a pixel pair into 3 bytes; ox and widths are even then
+    int pair_bytes = (dec->format == JPEG_PIXEL_RGB444) ? 3 : 4;
+    uint32_t stride = (uint32_t)out_w * pair_bytes / 2;
+    uint8_t *dst = (uint8_t *)output + oy * stride + ox * pair_bytes / 2;
+
+    if (ox + mcu_w <= out_w && oy + mcu_h <= out_h) {
+        kernel(mcu, dst, stride, ox, oy);
+        return;
+    }
+
+    uint32_t edge_stride = mcu_w * pair_bytes / 2;
+    int cw = (ox + mcu_w > out_w) ? out_w - ox : mcu_w;
+    int ch = (oy + mcu_h > out_h) ? out_h - oy : mcu_h;
+
+    kernel(mcu, dec->edge, edge_stride, ox, oy);
+    for (int py = 0; py < ch; py++) {
+        memcpy(dst + py * stride, &dec->edge[py * edge_stride], cw * pair_bytes / 2);
+    }
+}
+
+/**
+ * Create decoder
+ */
+jpeg_sw_t *jpeg_sw_create(void)
+{
+    jpeg_sw_t *dec = NULL;
+    if (posix_memalign((void **)&dec, 16, sizeof(jpeg_sw_t)) != 0) {
+        ESP_LOGE(TAG, "Failed to allocate decoder");
+        return NULL;
+    }
+
+    memset(dec, 0, sizeof(jpeg_sw_t));
+    dec->dc[0] = &lut_huff_std_dc_lum;
+    dec->dc[1] = &lut_huff_std_dc_chr;
+    dec->ac[0] = &lut_huff_std_ac_lum;
+    dec->ac[1] = &lut_huff_std_ac_chr;
+    dec->sparse_idct = true;
+
+    return dec;
+}
+
+/**
+ * Destroy decoder
+ */
+void jpeg_sw_destroy(jpeg_sw_t *dec)
+{
+    if (dec == NULL) return;
+
+    free(dec->dht);
+    free(dec);
+}
+
+/**
+ * Set output pixel format
+ */
+void jpeg_sw_set_pixel_format(jpeg_sw_t *dec, jpeg_pixel_format_t format)
+{
+    if (dec == NULL) return;
+
+    dec->format = format;
+}
+
+/**
+ * Enable or disable sparse IDCT dispatch
+ */
+void jpeg_sw_set_sparse_idct(jpeg_sw_t *dec, bool enable)
+{
+    if (dec == NULL) return;
+
+    dec->sparse_idct = enable;
+}
+
+/**
+ * Get block class counts
+ */
+void jpeg_sw_get_stats(const jpeg_sw_t *dec, jpeg_sw_stats_t *stats)
+{
+    if (dec == NULL || stats == NULL) return;
+
+    memcpy(stats->blocks, dec->block_count, sizeof(stats->blocks));
+}
+
+/**
+ * Reset block class counts
+ */
+void jpeg_sw_reset_stats(jpeg_sw_t *dec)
+{
+    if (dec == NULL) return;
+
+    memset(dec->block_count, 0, sizeof(dec->block_count));
+}
+
+/**
+ * Get image info
+ */
+esp_err_t jpeg_sw_get_info(const uint8_t *data, uint32_t size, uint16_t *width, uint16_t *height)
+{
+    if (data == NULL || size < 4) return ESP_ERR_INVALID_ARG;
+
+    const uint8_t *p = data + 2;
+    const uint8_t *end = data + size;
+
+    while (p + 9 <= end) {
+        if (p[0] != 0xFF || p[1] == 0xFF) {
+            p++;
+            continue;
+        }
+        if (p[1] == M_SOF0 || p[1] == M_SOF1 || p[1] == 0xC2) {
+            if (height) *height = be16(&p[5]);
+            if (width) *width = be16(&p[7]);
+            return ESP_OK;
+        }
+        if (p[1] == M_SOS) break;
+        p += 2 + be16(&p[2]);
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * Decode frame
+ */
+esp_err_t jpeg_sw_decode(jpeg_sw_t *dec, const uint8_t *data, uint32_t size,
+                         jpeg_scale_t scale, uint16_t *output, uint32_t max_pixels,
+                         uint16_t *out_width, uint16_t *out_height)
+{
+    if (dec == NULL || data == NULL || output == NULL) return ESP_ERR_INVALID_ARG;
+
+    const uint8_t *scan = NULL;
+    dec->restart_interval = 0;
+
+    esp_err_t ret = parse_headers(dec, data, size, &scan);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Header parse failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    int n = 8 >> scale;
+    uint16_t out_w = (dec->width + (1 << scale) - 1) >> scale;
+    uint16_t out_h = (dec->height + (1 << scale) - 1) >> scale;
+
+    if ((uint32_t)out_w * out_h > max_pixels) {
+        ESP_LOGE(TAG, "Output %dx%d exceeds buffer", out_w, out_h);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (dec->format == JPEG_PIXEL_RGB444 && ((out_w | (dec->hmax * n)) & 1)) {
+        ESP_LOGE(TAG, "RGB444 output needs even widths (%d, MCU %d)", out_w, dec->hmax * n);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    int mcu_px_w = 8 * dec->hmax;
+    int mcu_px_h = 8 * dec->vmax;
+    int mcus_x = (dec->width + mcu_px_w - 1) / mcu_px_w;
+    int mcus_y = (dec->height + mcu_px_h - 1) / mcu_px_h;
+
+    bit_reader_t br = {
+        .p = scan,
+        .end = data + size,
+    };
+
+    jpeg_color_kernel_t kernel = jpeg_color_get_kernel(dec->layout, dec->format, n);
+    jpeg_mcu_t mcu_samples = {
+        .blocks = (const uint8_t (*)[64])dec->mcu,
+        .n = n,
+        .h = dec->hmax,
+        .v = dec->vmax,
+        .gray = (dec->ncomp == 1),
+    };
+
+    for (int i = 0; i < dec->ncomp; i++) {
+        dec->comp[i].pred = 0;
+    }
+
+    // Full-size blocks that need all 64 coefficients can take the PIE IDCT
+    bool simd_idct = (scale == JPEG_SCALE_1_1) && simd_enabled();
+
+    int mcu = 0;
+    for (int my = 0; my < mcus_y; my++) {
+        for (int mx = 0; mx < mcus_x; mx++, mcu++) {
+            if (dec->restart_interval && mcu > 0 && (mcu % dec->restart_interval) == 0) {
+                br_restart(&br);
+                for (int i = 0; i < dec->ncomp; i++) {
+                    dec->comp[i].pred = 0;
+                }
+            }
+
+            int blk = 0;
+            for (int c = 0; c < dec->ncomp; c++) {
+                jpeg_component_t *comp = &dec->comp[c];
+                for (int by = 0; by < comp->v; by++) {
+                    for (int bx = 0; bx < comp->h; bx++) {
+                        jpeg_block_class_t cls = block_class(decode_block(dec, &br, comp));
+                        int nz = dec->sparse_idct ? block_size[cls] : 8;
+
+                        dec->block_count[cls]++;
+                        if (simd_idct && nz == 8 && dec->coef_mag <= SIMD_IDCT_MAX_ABS_SUM) {
+                            simd_idct_8x8(dec->coef, dec->mcu[blk++]);
+                        } else {
+                            idct_scaled(dec->coef, dec->mcu[blk++], scale, nz);
+                        }
+                    }
+                }
+            }
+
+            store_mcu(dec, kernel, &mcu_samples, output, out_w, out_h,
+                      mx * dec->hmax * n, my * dec->vmax * n);
+        }
+    }
+
+    if (out_width) *out_width = out_w;
+    if (out_height) *out_height = out_h;
+
+    return ESP_OK;
+}
@@ -0,0 +1,80 @@
+/**
+ * LZ565 Video Codec Implementation
+ *
+ * LZ4 block decoder with full bounds checking, so a corrupt chunk on the
+ * card can only produce a bad frame, never a write outside the buffer.
+ */
+
+#include "lz565.h"
+#include <string.h>
+
+#define LZ4_MIN_MATCH   4
+
+/**
+ * Read an LZ4 extended length (bytes of 255 terminated by a smaller one)
+ */
+static inline bool read_length(const uint8_t **ip, const uint8_t *iend, uint32_t *len)
+{
+    uint8_t b;
+
+    do {
+        if (*ip >= iend) return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+
+    return true;
+}
+
+/**
+ * Decode frame
+ */
+esp_err_t lz565_decode(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size)
+{
+    if (src == NULL || dst == NULL) return ESP_ERR_INVALID_ARG;
+
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + src_size;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + dst_size;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        // Literals
+        uint32_t lit = token >> 4;
+        if (lit == 15 && !read_length(&ip, iend, &lit)) return ESP_ERR_INVALID_SIZE;
+        if (lit > (uint32_t)(iend - ip) || lit > (uint32_t)(oend - op)) return ESP_ERR_INVALID_SIZE;
+
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        // The last sequence has literals only
+        if (ip == iend) break;
+
+        // Match
+        if (iend - ip < 2) return ESP_ERR_INVALID_SIZE;
+        uint32_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint32_t)(op - dst)) return ESP_ERR_INVALID_SIZE;
+
+        uint32_t len = token & 0x0F;
+        if (len == 15 && !read_length(&ip, iend, &len)) return ESP_ERR_INVALID_SIZE;
+        len += LZ4_MIN_MATCH;
+        if (len > (uint32_t)(oend - op)) return ESP_ERR_INVALID_SIZE;
+
+        // Overlapping matches (runs of one color have offset 2) copy the
+        // pattern in doubling chunks instead of byte by byte
+        const uint8_t *match = op - offset;
+        while (len > 0) {
+            uint32_t chunk = (uint32_t)(op - match);
+            if (chunk > len) chunk = len;
+            memcpy(op, match, chunk);
+            op += chunk;
+            len -= chunk;
+        }
+    }
+
+    return (op == oend) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
@@ -1,9 +1,10 @@
 /**
  * MJPEG Decoder Implementation
- * Uses ESP-IDF JPEG decoder component
+ * Uses ESP-IDF JPEG decoder component when available
  *
  * NOTE: esp_jpeg component may not be available in all ESP-IDF distributions.
- * This file provides stub functions when JPEG decoder is not available.
+ * The in-tree software decoder (jpeg_sw) is used when it is missing, and for
+ * all reduced-scale and RGB444 decodes.
  */
 
 #include "mjpeg_decoder.h"
@@ -35,6 +36,9 @@ struct mjpeg_decoder_s {
 #else
     void *jpeg_handle;  // Stub
 #endif
+    jpeg_sw_t *sw;      // Software decoder (fallback and scaled output)
+    jpeg_scale_t scale;
+    jpeg_pixel_format_t format;
     uint16_t max_width;
     uint16_t max_height;
     uint32_t last_decode_ms;
@@ -55,6 +59,14 @@ mjpeg_decoder_t *mjpeg_decoder_create(uint16_t max_width, uint16_t max_height)
     decoder->max_height = max_height;
     decoder->last_decode_ms = 0;
     decoder->jpeg_handle = NULL;
+    decoder->scale = JPEG_SCALE_1_1;
+    decoder->format = JPEG_PIXEL_RGB565;
+
+    decoder->sw = jpeg_sw_create();
+    if (decoder->sw == NULL) {
+        free(decoder);
+        return NULL;
+    }
 
 #if HAS_ESP_JPEG
     ESP_LOGI(TAG, "Creating MJPEG decoder (max %dx%d)", max_width, max_height);
@@ -63,21 +75,21 @@ mjpeg_decoder_t *mjpeg_decoder_create(uint16_t max_width, uint16_t max_height)
     jpeg_dec_config_t config = {
         .output_format = JPEG_DECODE_OUT_FORMAT_RGB565,
         .flags = {
-            .use_rgb565_bigendian = 0,  // Little endian for ESP32
+            .use_rgb565_bigendian = 1,  // Panel byte order, matches jpeg_sw
         },
     };
 
     esp_err_t ret = jpeg_new_decoder(&config, &decoder->jpeg_handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create JPEG decoder: %s", esp_err_to_name(ret));
+        jpeg_sw_destroy(decoder->sw);
         free(decoder);
         return NULL;
     }
 
     ESP_LOGI(TAG, "MJPEG decoder created successfully");
 #else
-    ESP_LOGW(TAG, "MJPEG decoder created (STUB - esp_jpeg not available)");
-    ESP_LOGW(TAG, "Video playback will not work without JPEG decoder");
+    ESP_LOGI(TAG, "MJPEG decoder created (software, max %dx%d)", max_width, max_height);
 #endif
 
     return decoder;
@@ -96,6 +108,8 @@ void mjpeg_decoder_destroy(mjpeg_decoder_t *decoder)
     }
 #endif
 
+    jpeg_sw_destroy(decoder->sw);
+
     free(decoder);
 
     ESP_LOGI(TAG, "MJPEG decoder destroyed");
@@ -114,37 +128,48 @@ esp_err_t mjpeg_decoder_decode_frame(mjpeg_decoder_t *decoder,
         return ESP_ERR_INVALID_ARG;
     }
 
-#if HAS_ESP_JPEG
     uint64_t start_time = esp_timer_get_time();
+    esp_err_t ret;
 
-    // Parse JPEG header to get dimensions
-    jpeg_dec_header_info_t *header_info = NULL;
-    esp_err_t ret = jpeg_decoder_get_info(frame->data, frame->size, &header_info);
+    uint16_t width, height;
+    ret = jpeg_sw_get_info(frame->data, frame->size, &width, &height);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to parse JPEG header: %s", esp_err_to_name(ret));
         return ret;
     }
 
-    uint16_t width = header_info->width;
-    uint16_t height = header_info->height;
-
     if (width > decoder->max_width || height > decoder->max_height) {
         ESP_LOGE(TAG, "Frame dimensions (%dx%d) exceed max (%dx%d)",
                  width, height, decoder->max_width, decoder->max_height);
         return ESP_ERR_INVALID_SIZE;
     }
 
-    // Decode JPEG to RGB565
-    jpeg_dec_io_t decode_io = {
-        .inbuf = frame->data,
-        .inbuf_len = frame->size,
-        .outbuf = (uint8_t *)output,
-    };
-
-    ret = jpeg_decoder_process(decoder->jpeg_handle, &decode_io);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "JPEG decode failed: %s", esp_err_to_name(ret));
-        return ret;
+#if HAS_ESP_JPEG
+    if (decoder->scale == JPEG_SCALE_1_1 && decoder->format == JPEG_PIXEL_RGB565) {
+        jpeg_dec_io_t decode_io = {
+            .inbuf = frame->data,
+            .inbuf_len = frame->size,
+            .outbuf = (uint8_t *)output,
+        };
+
+        ret = jpeg_decoder_process(decoder->jpeg_handle, &decode_io);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "JPEG decode failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    } else
+#endif
+    {
+        uint8_t s = decoder->scale;
+        uint32_t max_pixels = (uint32_t)((decoder->max_width + (1 << s) - 1) >> s) *
+                              ((decoder->max_height + (1 << s) - 1) >> s);
+
+        ret = jpeg_sw_decode(decoder->sw, frame->data, frame->size, decoder->scale,
+                             output, max_pixels, &width, &height);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "JPEG decode failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
     }
 
     // Return dimensions
@@ -156,10 +181,27 @@ esp_err_t mjpeg_decoder_decode_frame(mjpeg_decoder_t *decoder,
     decoder->last_decode_ms = (end_time - start_time) / 1000;
 
     return ESP_OK;
-#else
-    ESP_LOGE(TAG, "JPEG decoder not available - cannot decode frame");
-    return ESP_ERR_NOT_SUPPORTED;
-#endif
+}
+
+/**
+ * Set output scale
+ */
+void mjpeg_decoder_set_scale(mjpeg_decoder_t *decoder, jpeg_scale_t scale)
+{
+    if (decoder == NULL) return;
+
+    decoder->scale = scale;
+}
+
+/**
+ * Set output pixel format
+ */
+void mjpeg_decoder_set_pixel_format(mjpeg_decoder_t *decoder, jpeg_pixel_format_t format)
+{
+    if (decoder == NULL) return;
+
+    decoder->format = format;
+    jpeg_sw_set_pixel_format(decoder->sw, format);
 }
 
 /**
@@ -0,0 +1,69 @@
+/**
+ * PAL8 Video Codec Implementation
+ */
+
+#include "pal8.h"
+#include "lz565.h"
+#include <string.h>
+
+/**
+ * Apply palette
+ */
+esp_err_t pal8_apply_palette(const uint8_t *src, uint32_t src_size, uint16_t *lut)
+{
+    if (src == NULL || lut == NULL) return ESP_ERR_INVALID_ARG;
+    if (src_size < PAL8_HEADER_SIZE) return ESP_ERR_INVALID_SIZE;
+    if (!(src[0] & PAL8_FLAG_PALETTE)) return ESP_OK;
+
+    uint32_t count = src[2] | (src[3] << 8);
+    if (count > PAL8_COLORS || count * 2 > src_size - PAL8_HEADER_SIZE) return ESP_ERR_INVALID_SIZE;
+
+    // Already in panel byte order
+    memcpy(lut, src + PAL8_HEADER_SIZE, count * 2);
+    return ESP_OK;
+}
+
+/**
+ * Decode frame
+ */
+esp_err_t pal8_decode(const uint8_t *src, uint32_t src_size, uint16_t *lut,
+                      uint8_t *indices, uint32_t pixels, bool *keyframe)
+{
+    if (indices == NULL) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = pal8_apply_palette(src, src_size, lut);
+    if (ret != ESP_OK) return ret;
+
+    uint8_t flags = src[0];
+    uint32_t skip = PAL8_HEADER_SIZE;
+    if (flags & PAL8_FLAG_PALETTE) {
+        skip += (src[2] | (src[3] << 8)) * 2;
+    }
+
+    if (keyframe) *keyframe = (flags & PAL8_FLAG_KEYFRAME) != 0;
+
+    // The LZ4 block decoder is format agnostic
+    return lz565_decode(src + skip, src_size - skip, indices, pixels);
+}
+
+/**
+ * Expand indices
+ */
+void pal8_expand(const uint8_t *indices, const uint16_t *lut, uint16_t *dst, uint32_t count)
+{
+    uint32_t i = 0;
+
+    // Four lookups per 32-bit read (little-endian: lowest byte first)
+    for (; i + 4 <= count; i += 4) {
+        uint32_t q;
+        memcpy(&q, &indices[i], sizeof(q));
+        dst[i]     = lut[q & 0xFF];
+        dst[i + 1] = lut[(q >> 8) & 0xFF];
+        dst[i + 2] = lut[(q >> 16) & 0xFF];
+        dst[i + 3] = lut[q >> 24];
+    }
+
+    for (; i < count; i++) {
+        dst[i] = lut[indices[i]];
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * Rational Timebase Implementation
+ *
+ * Products are split so every intermediate fits in 64 bits for any 32-bit
+ * rate and scale.
+ */
+
+#include "timebase.h"
+
+#define US_PER_SEC  1000000ull
+
+/**
+ * Greatest common divisor
+ */
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * Initialize
+ */
+void timebase_init(timebase_t *tb, uint32_t rate, uint32_t scale)
+{
+    if (rate == 0 || scale == 0) {
+        rate = TIMEBASE_DEFAULT_FPS;
+        scale = 1;
+    }
+
+    uint32_t d = gcd(rate, scale);
+    tb->rate = rate / d;
+    tb->scale = scale / d;
+}
+
+/**
+ * Frame to microseconds: frame * scale * 1e6 / rate
+ */
+uint64_t timebase_frame_to_us(const timebase_t *tb, uint64_t frame)
+{
+    uint64_t n = frame * tb->scale;     // Frames are 32-bit in practice
+    uint64_t q = n / tb->rate;
+    uint64_t r = n % tb->rate;
+
+    return q * US_PER_SEC + r * US_PER_SEC / tb->rate;
+}
+
+/**
+ * Microseconds to frame: us * rate / (scale * 1e6)
+ */
+uint64_t timebase_us_to_frame(const timebase_t *tb, uint64_t us)
+{
+    uint64_t sec = us / US_PER_SEC;
+    uint64_t rem_us = us % US_PER_SEC;
+
+    // Whole seconds first, then the remainder of both parts together
+    uint64_t x = sec * tb->rate;
+    uint64_t q = x / tb->scale;
+    uint64_t r = x % tb->scale;
+
+    return q + (r * US_PER_SEC + rem_us * tb->rate) / (tb->scale * US_PER_SEC);
+}
+
+/**
+ * Frame to seconds
+ */
+uint32_t timebase_frame_to_sec(const timebase_t *tb, uint32_t frame)
+{
+    return (uint32_t)((uint64_t)frame * tb->scale / tb->rate);
+}
+
+/**
+ * Seconds to frame
+ */
+uint32_t timebase_sec_to_frame(const timebase_t *tb, uint32_t sec)
+{
+    return (uint32_t)(((uint64_t)sec * tb->rate + tb->scale - 1) / tb->scale);
+}
+
+/**
+ * Rounded frame rate
+ */
+uint16_t timebase_fps_rounded(const timebase_t *tb)
+{
+    return (uint16_t)((tb->rate + tb->scale / 2) / tb->scale);
+}
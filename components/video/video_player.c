@@ -6,15 +6,22 @@
 #include "video_player.h"
 #include "mjpeg_decoder.h"
 #include "avi_parser.h"
+#include "lz565.h"
+#include "crb.h"
+#include "pal8.h"
 #include "display.h"
+#include "simd.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
+#include "dlog.h"
 #include "esp_timer.h"
+#include "esp_attr.h"
 
 static const char *TAG = "VIDEO_PLAYER";
 
@@ -22,87 +29,985 @@ static const char *TAG = "VIDEO_PLAYER";
 #define PLAYBACK_TASK_PRIORITY      10
 #define PLAYBACK_TASK_CORE          0  // Core 0 for video decoding
 
+// Frame reader (prefetch) task, shares core 0 but blocks on the card
+#define READER_TASK_STACK_SIZE      4096
+#define READER_TASK_PRIORITY        11
+#define READER_IDLE_MS              10
+
+// Frame buffer size (decoder max resolution matches so frames always fit)
+#define VIDEO_FB_WIDTH              240
+#define VIDEO_FB_HEIGHT             240
+
+// Trick play: refresh at most ~15 times per second regardless of file fps
+#define TRICK_FRAME_INTERVAL_US     66667
+#define POSITION_BAR_HEIGHT         4
+
+// PAL8 expands and sends one MCU row of pixels at a time, with up to
+// PAL8_STRIPS strips in flight
+#define PAL8_STRIP_ROWS             16
+#define PAL8_STRIPS                 DISPLAY_MAX_IN_FLIGHT
+
+// Decoded frames are compared with the previous one in bands of this many rows
+#define DIFF_BAND_ROWS              16
+
+// Frame buffers hold panel byte order
+#define PANEL_COLOR(c)              ((uint16_t)(((c) >> 8) | ((c) << 8)))
+
+/**
+ * Video codec, selected per file by the stream's FOURCC
+ */
+typedef enum {
+    VIDEO_CODEC_MJPEG,
+    VIDEO_CODEC_LZ565,      // Pre-decoded RGB565, LZ4 block per frame
+    VIDEO_CODEC_CRB,        // Changed blocks only, applied to the previous frame
+    VIDEO_CODEC_PAL8,       // 8-bit indices, expanded through a palette LUT
+} video_codec_t;
+
+/**
+ * Prefetched frame (data NULL with a status on end of file or error)
+ */
+typedef struct {
+    mjpeg_frame_t frame;
+    esp_err_t status;
+    uint32_t epoch;             // seek_epoch when read; older items are stale
+} prefetch_item_t;
+
 /**
  * Video player structure
  */
 struct video_player_s {
     // State
-    video_state_t state;
+    volatile video_state_t state;
     video_info_t info;
 
     // AVI Parser
     avi_parser_t avi_parser;
 
     // Decoder
+    video_codec_t codec;
     mjpeg_decoder_t *decoder;
 
     // Frame buffers (double buffering)
     frame_buffer_t *frame_buffer[2];
     uint8_t current_buffer;
 
+    // Set whenever the panel may not match the last pushed frame; the next
+    // frame is then pushed whole instead of only its changed rows
+    volatile bool full_refresh;
+
+    // CRB keeps one persistent canvas (frame_buffer[0]); frame_buffer[1]
+    // receives the decoded JPEG tile mosaic
+    uint64_t crb_dirty;         // Block rows changed since the last push
+    uint8_t crb_block_size;
+
+    // PAL8 decodes indices into frame_buffer[0] and expands them into a
+    // ring of PAL8_STRIPS strips carved from frame_buffer[1]
+    uint16_t pal8_lut[PAL8_COLORS];
+    frame_buffer_t pal8_strip[PAL8_STRIPS];
+    uint8_t pal8_next_strip;
+
     // Playback control
     uint32_t current_frame;
+    volatile int8_t speed;
+    volatile uint16_t rate_q8;
+    uint16_t rate_accum;        // Fractional frames, Q8
+    volatile display_format_t pixel_format;
     TaskHandle_t playback_task;
 
+    // Read-ahead: a reader task keeps prefetch_depth frames queued so
+    // card latency spikes are absorbed instead of stalling the display
+    sd_io_tuning_t io_tuning;
+    QueueHandle_t prefetch_queue;
+    SemaphoreHandle_t parser_lock;
+    TaskHandle_t reader_task;
+    volatile bool reader_run;
+    volatile bool reader_eof;
+    volatile uint32_t seek_epoch;
+    volatile bool refilling;    // Queue emptied by a seek, not by the card
+    uint32_t underruns;
+
+    // Counters and stage histograms; trace entries go to a caller buffer
+    video_stats_t stats;
+    video_trace_t *volatile trace;
+    volatile uint32_t trace_capacity;
+    volatile uint32_t trace_count;
+
     // Callbacks
     video_callbacks_t callbacks;
     void *user_data;
 
     // Timing
-    uint64_t frame_time_us;  // Microseconds per frame
+    timebase_t timebase;     // Exact frame timing (rate/scale)
     uint64_t last_frame_time;
 };
 
 /**
- * Playback task
+ * Decode scale for a playback speed
  */
-static void video_playback_task(void *pvParameters)
+static jpeg_scale_t speed_to_scale(int8_t speed)
+{
+    int8_t mag = (speed < 0) ? -speed : speed;
+
+    if (mag >= 8) return JPEG_SCALE_1_4;
+    if (mag >= 2) return JPEG_SCALE_1_2;
+    return JPEG_SCALE_1_1;
+}
+
+/**
+ * Seek the parser and invalidate frames already prefetched
+ */
+static esp_err_t parser_seek(video_player_t *player, uint32_t frame_num)
+{
+    xSemaphoreTake(player->parser_lock, portMAX_DELAY);
+    esp_err_t ret = avi_parser_seek(&player->avi_parser, frame_num);
+    player->seek_epoch++;
+    player->refilling = true;
+    player->reader_eof = false;
+    xSemaphoreGive(player->parser_lock);
+
+    return ret;
+}
+
+/**
+ * Nearest keyframe at or before a frame
+ * Index pages share one block buffer and the cache file with parser seeks
+ */
+static uint32_t prev_keyframe(video_player_t *player, uint32_t frame_num)
+{
+    xSemaphoreTake(player->parser_lock, portMAX_DELAY);
+    uint32_t keyframe = frame_index_prev_keyframe(&player->avi_parser.index, frame_num);
+    xSemaphoreGive(player->parser_lock);
+
+    return keyframe;
+}
+
+/**
+ * Nearest keyframe at or after a frame (frame_count if none)
+ */
+static uint32_t next_keyframe(video_player_t *player, uint32_t frame_num)
+{
+    xSemaphoreTake(player->parser_lock, portMAX_DELAY);
+    uint32_t keyframe = frame_index_next_keyframe(&player->avi_parser.index, frame_num);
+    xSemaphoreGive(player->parser_lock);
+
+    return keyframe;
+}
+
+/**
+ * Frame reader task
+ * Reads ahead at normal speed only; trick play seeks on every frame
+ */
+static void frame_reader_task(void *pvParameters)
 {
     video_player_t *player = (video_player_t *)pvParameters;
-    esp_err_t ret;
-    mjpeg_frame_t frame = {0};
-    uint16_t width, height;
 
-    ESP_LOGI(TAG, "Playback task started on core %d", xPortGetCoreID());
+    while (player->reader_run) {
+        prefetch_item_t item = {0};
 
-    // We use the pre-allocated frame buffers for double buffering
-    // player->frame_buffer[0] and [1]
-    
-    // Ensure buffers are ready
-    if (!player->frame_buffer[0] || !player->frame_buffer[1]) {
-        ESP_LOGE(TAG, "Frame buffers not allocated");
-        player->state = VIDEO_STATE_ERROR;
-        vTaskDelete(NULL);
+        xSemaphoreTake(player->parser_lock, portMAX_DELAY);
+        if (player->reader_eof || player->speed != VIDEO_SPEED_NORMAL) {
+            xSemaphoreGive(player->parser_lock);
+            vTaskDelay(pdMS_TO_TICKS(READER_IDLE_MS));
+            continue;
+        }
+        item.epoch = player->seek_epoch;
+        item.status = avi_parser_read_video_frame(&player->avi_parser, &item.frame);
+        if (item.status != ESP_OK) {
+            item.frame.data = NULL;
+            player->reader_eof = true;
+        }
+        xSemaphoreGive(player->parser_lock);
+
+        bool queued = false;
+        while (player->reader_run && !queued) {
+            queued = (xQueueSend(player->prefetch_queue, &item, pdMS_TO_TICKS(READER_IDLE_MS * 5)) == pdTRUE);
+        }
+        if (!queued) {
+            avi_parser_free_frame(&item.frame);
+        }
+    }
+
+    player->reader_task = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * Start the reader task and its queue
+ */
+static esp_err_t start_reader(video_player_t *player)
+{
+    uint8_t depth = player->io_tuning.prefetch_depth;
+
+    player->prefetch_queue = xQueueCreate(depth, sizeof(prefetch_item_t));
+    if (player->prefetch_queue == NULL) return ESP_ERR_NO_MEM;
+
+    player->reader_eof = false;
+    player->reader_run = true;
+
+    if (xTaskCreatePinnedToCore(frame_reader_task, "video_reader", READER_TASK_STACK_SIZE,
+                                player, READER_TASK_PRIORITY, &player->reader_task,
+                                PLAYBACK_TASK_CORE) != pdPASS) {
+        player->reader_run = false;
+        vQueueDelete(player->prefetch_queue);
+        player->prefetch_queue = NULL;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Prefetching %d frames", depth);
+    return ESP_OK;
+}
+
+/**
+ * Stop the reader task and free queued frames
+ */
+static void stop_reader(video_player_t *player)
+{
+    if (player->prefetch_queue == NULL) return;
+
+    player->reader_run = false;
+    while (player->reader_task != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(READER_IDLE_MS));
+    }
+
+    prefetch_item_t item;
+    while (xQueueReceive(player->prefetch_queue, &item, 0) == pdTRUE) {
+        avi_parser_free_frame(&item.frame);
+    }
+
+    vQueueDelete(player->prefetch_queue);
+    player->prefetch_queue = NULL;
+}
+
+/**
+ * Get the next frame for display
+ * Trick play reads directly; otherwise frames come from the reader queue
+ *
+ * @return ESP_ERR_INVALID_STATE if playback stopped or paused while waiting
+ */
+static esp_err_t next_frame(video_player_t *player, bool trick, mjpeg_frame_t *frame)
+{
+    if (trick || player->prefetch_queue == NULL) {
+        xSemaphoreTake(player->parser_lock, portMAX_DELAY);
+        esp_err_t ret = avi_parser_read_video_frame(&player->avi_parser, frame);
+        xSemaphoreGive(player->parser_lock);
+        return ret;
+    }
+
+    for (;;) {
+        prefetch_item_t item;
+
+        if (uxQueueMessagesWaiting(player->prefetch_queue) == 0 && !player->reader_eof &&
+            !player->refilling) {
+            player->underruns++;
+        }
+
+        while (xQueueReceive(player->prefetch_queue, &item, pdMS_TO_TICKS(100)) != pdTRUE) {
+            if (player->state != VIDEO_STATE_PLAYING) return ESP_ERR_INVALID_STATE;
+        }
+
+        if (item.epoch != player->seek_epoch) {
+            avi_parser_free_frame(&item.frame);
+            continue;
+        }
+
+        player->refilling = false;
+        *frame = item.frame;
+        return item.status;
+    }
+}
+
+/**
+ * Move the parser to the next trick-play frame
+ * Advances by speed * elapsed frames and lands on a keyframe
+ *
+ * @return ESP_ERR_NOT_FOUND when the start or end of the file is reached
+ */
+static esp_err_t trick_seek(video_player_t *player, int8_t speed, uint64_t interval_us)
+{
+    int64_t frames = (int64_t)timebase_us_to_frame(&player->timebase,
+                                                   (uint64_t)(speed < 0 ? -speed : speed) * interval_us);
+    int64_t step = (speed < 0) ? -frames : frames;
+    int64_t target = (int64_t)player->current_frame + step;
+    uint32_t last = player->info.frame_count ? player->info.frame_count - 1 : 0;
+
+    if (target < 0) {
+        parser_seek(player, 0);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (target > last) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t frame = prev_keyframe(player, (uint32_t)target);
+
+    // Sparse keyframes: never stall on the same keyframe while moving forward.
+    // A CRB delta would land on whatever the canvas holds, so CRB steps on to
+    // the next keyframe instead of the target
+    if (speed > 0 && frame <= player->current_frame) {
+        if (player->codec == VIDEO_CODEC_CRB) {
+            frame = next_keyframe(player, player->current_frame + 1);
+            if (frame > last) return ESP_ERR_NOT_FOUND;
+        } else {
+            frame = (uint32_t)target;
+        }
+    }
+
+    return parser_seek(player, frame);
+}
+
+/**
+ * Apply a CRB frame to the canvas
+ * JPEG tiles are decoded into the second frame buffer and copied from there
+ */
+static esp_err_t decode_crb(video_player_t *player, const mjpeg_frame_t *frame)
+{
+    frame_buffer_t *canvas = player->frame_buffer[0];
+    uint16_t width = player->info.width;
+    uint16_t height = player->info.height;
+    const uint16_t *mosaic = NULL;
+    crb_frame_t crb;
+
+    if (width > VIDEO_FB_WIDTH || height > VIDEO_FB_HEIGHT) return ESP_ERR_INVALID_SIZE;
+
+    esp_err_t ret = crb_parse(frame->data, frame->size, &crb);
+    if (ret != ESP_OK) return ret;
+
+    if (crb.jpeg && crb.tile_count > 0) {
+        mjpeg_frame_t tiles = {
+            .data = (uint8_t *)crb.payload,
+            .size = crb.payload_size,
+            .frame_num = frame->frame_num,
+        };
+        uint16_t mw, mh, w, h;
+
+        crb_mosaic_size(&crb, width, &mw, &mh);
+        ret = mjpeg_decoder_decode_frame(player->decoder, &tiles, player->frame_buffer[1]->buffer, &w, &h);
+        if (ret != ESP_OK) return ret;
+        if (w != mw || h != mh) return ESP_ERR_INVALID_SIZE;
+
+        mosaic = player->frame_buffer[1]->buffer;
+    }
+
+    ret = crb_apply(&crb, mosaic, canvas->buffer, width, height, &player->crb_dirty);
+
+    canvas->width = width;
+    canvas->height = height;
+    player->crb_block_size = crb.block_size;
+    if (crb.keyframe) {
+        player->full_refresh = true;
+    }
+
+    return ret;
+}
+
+/**
+ * Push the canvas rows changed since the last push
+ * Each run of dirty block rows is one transfer; the canvas is only
+ * rewritten after the last one completes, so waiting in between is free
+ *
+ * @return true if a transfer is still in flight
+ */
+static bool push_dirty_rows(video_player_t *player, frame_buffer_t *fb, bool dma_pending)
+{
+    uint16_t bs = player->crb_block_size;
+    uint64_t dirty = player->crb_dirty;
+
+    player->crb_dirty = 0;
+
+    if (player->full_refresh || bs == 0) {
+        player->full_refresh = false;
+        if (dma_pending) display_wait_dma();
+        return display_write_frame_dma(fb) == ESP_OK;
+    }
+
+    uint16_t rows = (fb->height + bs - 1) / bs;
+    uint16_t r = 0;
+
+    while (r < rows) {
+        if (!(dirty & (1ull << r))) {
+            r++;
+            continue;
+        }
+
+        uint16_t first = r;
+        while (r < rows && (dirty & (1ull << r))) r++;
+
+        if (dma_pending) display_wait_dma();
+        dma_pending = (display_write_rows_dma(fb, first * bs, (r - first) * bs) == ESP_OK);
+    }
+
+    return dma_pending;
+}
+
+/**
+ * Check whether a band of rows differs between two frame buffers
+ */
+static bool band_changed(const frame_buffer_t *a, const frame_buffer_t *b,
+                         uint32_t row_bytes, uint16_t y, uint16_t rows)
+{
+    uint32_t offset = (uint32_t)y * row_bytes;
+
+    if (y + rows > a->height) rows = a->height - y;
+    return !simd_equal((const uint8_t *)a->buffer + offset, (const uint8_t *)b->buffer + offset,
+                       (uint32_t)rows * row_bytes);
+}
+
+/**
+ * Push a double-buffered frame, skipping bands equal to the previous frame
+ * The panel still shows the other buffer, so its unchanged bands are
+ * already on screen; each run of changed bands is one transfer
+ *
+ * @return true if a transfer is still in flight
+ */
+static bool push_changed_bands(video_player_t *player, frame_buffer_t *fb, bool dma_pending)
+{
+    const frame_buffer_t *prev = player->frame_buffer[player->current_buffer ^ 1];
+
+    if (player->full_refresh || prev->width != fb->width || prev->height != fb->height ||
+        prev->format != fb->format) {
+        player->full_refresh = false;
+        if (dma_pending) display_wait_dma();
+        dma_pending = (display_write_frame_dma(fb) == ESP_OK);
+        if (!dma_pending) player->full_refresh = true;
+        return dma_pending;
+    }
+
+    uint32_t row_bytes = display_frame_bytes(fb) / fb->height;
+    bool sent = false;
+    uint16_t y = 0;
+
+    while (y < fb->height) {
+        if (!band_changed(fb, prev, row_bytes, y, DIFF_BAND_ROWS)) {
+            y += DIFF_BAND_ROWS;
+            continue;
+        }
+
+        uint16_t first = y;
+        do {
+            y += DIFF_BAND_ROWS;
+        } while (y < fb->height && band_changed(fb, prev, row_bytes, y, DIFF_BAND_ROWS));
+
+        if (y > fb->height) y = fb->height;
+        if (dma_pending) display_wait_dma();
+        dma_pending = (display_write_rows_dma(fb, first, y - first) == ESP_OK);
+        if (!dma_pending) player->full_refresh = true;
+        sent = true;
+    }
+
+    // Nothing sent: the transfer in flight is still the previous frame's,
+    // and the next frame is decoded into that buffer
+    if (!sent && dma_pending) {
+        display_wait_dma();
+        dma_pending = false;
+    }
+
+    return dma_pending;
+}
+
+/**
+ * Skip frames that fall between displayed frames at rate > 1x
+ */
+static void skip_frames(video_player_t *player, uint32_t count)
+{
+    if (player->codec == VIDEO_CODEC_CRB) {
+        // Every frame builds on the last, so skipped frames are still
+        // applied; only their panel transfers are saved
+        for (uint32_t i = 0; i < count; i++) {
+            mjpeg_frame_t frame = {0};
+            esp_err_t ret = next_frame(player, false, &frame);
+            if (ret == ESP_OK) {
+                decode_crb(player, &frame);
+            }
+            avi_parser_free_frame(&frame);
+            if (ret != ESP_OK) break;
+        }
         return;
     }
 
-    int decode_idx = 0;  // Index of buffer we are decoding INTO
-    int display_idx = 1; // Index of buffer being displayed (initially unused)
-    bool first_frame = true;
+    if (player->codec == VIDEO_CODEC_PAL8) {
+        // Scene cuts and keyframes carry the palette the next frames are
+        // drawn with, so skipped chunks are read and their palettes applied
+        for (uint32_t i = 0; i < count; i++) {
+            mjpeg_frame_t frame = {0};
+            esp_err_t ret = next_frame(player, false, &frame);
+            if (ret == ESP_OK) {
+                pal8_apply_palette(frame.data, frame.size, player->pal8_lut);
+            }
+            avi_parser_free_frame(&frame);
+            if (ret != ESP_OK) break;
+        }
+        return;
+    }
+
+    // Skips up to the read-ahead depth come off the queue; a seek would
+    // throw the read-ahead away
+    uint32_t depth = (player->prefetch_queue != NULL) ? player->io_tuning.prefetch_depth : 0;
+    if (player->avi_parser.has_index && count > depth) {
+        // The reader may be ahead of the display, so seek from the shown frame
+        parser_seek(player, player->current_frame + 1 + count);
+        return;
+    }
+
+    // Queued or unindexed: read past the skipped chunks
+    for (uint32_t i = 0; i < count; i++) {
+        mjpeg_frame_t frame = {0};
+        esp_err_t ret = next_frame(player, false, &frame);
+        avi_parser_free_frame(&frame);
+        if (ret != ESP_OK) break;
+    }
+}
+
+/**
+ * Decode a frame into a frame buffer at the given scale
+ * Reduced-scale output is decoded into the tail of the buffer and expanded
+ * in place by pixel replication, so no extra buffer is needed
+ */
+static esp_err_t decode_to_buffer(video_player_t *player, const mjpeg_frame_t *frame,
+                                  frame_buffer_t *fb, jpeg_scale_t scale)
+{
+    uint16_t width, height;
+    esp_err_t ret;
+
+    if (player->codec == VIDEO_CODEC_CRB) {
+        // Always full size into the canvas, whatever the buffer passed
+        return decode_crb(player, frame);
+    }
+
+    if (player->codec == VIDEO_CODEC_PAL8) {
+        // Indices only; push_palettized() expands them on the way out
+        width = player->info.width;
+        height = player->info.height;
+        if (width > VIDEO_FB_WIDTH || height > VIDEO_FB_HEIGHT) return ESP_ERR_INVALID_SIZE;
+
+        ret = pal8_decode(frame->data, frame->size, player->pal8_lut, (uint8_t *)fb->buffer,
+                          (uint32_t)width * height, NULL);
+        if (ret == ESP_OK) {
+            fb->width = width;
+            fb->height = height;
+        }
+        return ret;
+    }
+
+    if (player->codec == VIDEO_CODEC_LZ565) {
+        // Full size at every speed; decoding is cheaper than scaling
+        width = player->info.width;
+        height = player->info.height;
+        if (width > VIDEO_FB_WIDTH || height > VIDEO_FB_HEIGHT) return ESP_ERR_INVALID_SIZE;
+
+        ret = lz565_decode(frame->data, frame->size, (uint8_t *)fb->buffer,
+                           (uint32_t)width * height * sizeof(uint16_t));
+        if (ret == ESP_OK) {
+            fb->width = width;
+            fb->height = height;
+        }
+        return ret;
+    }
+
+    if (scale == JPEG_SCALE_1_1) {
+        ret = mjpeg_decoder_decode_frame(player->decoder, frame, fb->buffer, &width, &height);
+        if (ret == ESP_OK) {
+            fb->width = width;
+            fb->height = height;
+        }
+        return ret;
+    }
+
+    ret = jpeg_sw_get_info(frame->data, frame->size, &width, &height);
+    if (ret != ESP_OK) return ret;
+    if (width > VIDEO_FB_WIDTH || height > VIDEO_FB_HEIGHT) return ESP_ERR_INVALID_SIZE;
+
+    int factor = 1 << scale;
+    uint16_t sw = (width + factor - 1) >> scale;
+    uint16_t sh = (height + factor - 1) >> scale;
+    uint32_t capacity = VIDEO_FB_WIDTH * VIDEO_FB_HEIGHT;
+    uint16_t *src = fb->buffer + capacity - (uint32_t)sw * sh;
+
+    ret = mjpeg_decoder_decode_frame(player->decoder, frame, src, &sw, &sh);
+    if (ret != ESP_OK) return ret;
+
+    // Top-down expansion never overtakes the unread source rows
+    uint16_t line[VIDEO_FB_WIDTH];
+    uint16_t out_w = width;
+    uint16_t out_h = height;
+
+    for (int y = 0; y < sh; y++) {
+        memcpy(line, &src[y * sw], sw * sizeof(uint16_t));
+
+        uint16_t *dst = &fb->buffer[y * factor * out_w];
+        for (int x = 0; x < out_w; x++) {
+            dst[x] = line[x >> scale];
+        }
+
+        for (int r = 1; r < factor && y * factor + r < out_h; r++) {
+            memcpy(&dst[r * out_w], dst, out_w * sizeof(uint16_t));
+        }
+    }
+
+    fb->width = out_w;
+    fb->height = out_h;
+
+    return ESP_OK;
+}
+
+/**
+ * Draw trick-play position bar into the bottom rows of a frame buffer
+ */
+static void draw_position_bar(const video_player_t *player, frame_buffer_t *fb)
+{
+    if (fb->height < POSITION_BAR_HEIGHT || player->info.frame_count == 0) return;
+
+    uint32_t filled = (uint64_t)player->current_frame * fb->width / player->info.frame_count;
+    uint16_t *row = &fb->buffer[(fb->height - POSITION_BAR_HEIGHT) * fb->width];
+
+    for (uint16_t x = 0; x < fb->width; x++) {
+        row[x] = (x < filled) ? PANEL_COLOR(COLOR_WHITE) : PANEL_COLOR(COLOR_DARK_GRAY);
+    }
+    for (int r = 1; r < POSITION_BAR_HEIGHT; r++) {
+        memcpy(&row[r * fb->width], row, fb->width * sizeof(uint16_t));
+    }
+}
+
+/**
+ * Display transfer done (SPI interrupt): wake the playback task, which may
+ * be waiting for a strip to come free
+ */
+static bool IRAM_ATTR transfer_done(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    vTaskNotifyGiveFromISR((TaskHandle_t)arg, &woken);
+    return woken == pdTRUE;
+}
+
+/**
+ * Expand PAL8 indices strip by strip and queue each strip
+ * The frame is one strip window, so strips follow each other on the bus
+ * with no window set in between; a strip is only rewritten once the
+ * transfer queued from it is done (the done callback wakes this task), so
+ * expansion overlaps up to PAL8_STRIPS - 1 transfers
+ *
+ * @return true if a transfer is still in flight
+ */
+static bool push_palettized(video_player_t *player, const frame_buffer_t *fb, bool trick, bool pack)
+{
+    const uint8_t *indices = (const uint8_t *)fb->buffer;
+    uint16_t x0 = (display_get_width() - fb->width) / 2;
+    uint16_t y0 = (display_get_height() - fb->height) / 2;
+    uint32_t strip_pixels = (uint32_t)fb->width * PAL8_STRIP_ROWS;
+    display_format_t format = pack ? DISPLAY_FORMAT_RGB444 : DISPLAY_FORMAT_RGB565;
+
+    // Waits for the previous frame's last strips
+    if (display_begin_strips_dma(x0, y0, fb->width, fb->height, format) != ESP_OK) {
+        player->full_refresh = true;
+        return display_dma_in_flight() > 0;
+    }
+
+    for (uint16_t y = 0; y < fb->height; y += PAL8_STRIP_ROWS) {
+        uint8_t n = player->pal8_next_strip;
+        frame_buffer_t *strip = &player->pal8_strip[n];
+
+        // Transfers finish in queue order: with fewer than PAL8_STRIPS in
+        // flight, the one queued from this strip is done
+        while (display_dma_in_flight() >= PAL8_STRIPS) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+
+        strip->buffer = player->frame_buffer[1]->buffer + n * strip_pixels;
+        strip->width = fb->width;
+        strip->height = (fb->height - y < PAL8_STRIP_ROWS) ? fb->height - y : PAL8_STRIP_ROWS;
+        strip->format = DISPLAY_FORMAT_RGB565;
+
+        pal8_expand(&indices[(uint32_t)y * fb->width], player->pal8_lut, strip->buffer,
+                    (uint32_t)strip->width * strip->height);
+
+        if (trick && y + strip->height == fb->height) {
+            draw_position_bar(player, strip);
+        }
+
+        // Strips start on multiples of 4 rows, so the dither pattern lines up
+        if (pack) {
+            display_pack_rgb444(strip);
+        }
+
+        if (display_queue_strip_dma(strip) != ESP_OK) {
+            player->full_refresh = true;
+            break;
+        }
+        player->pal8_next_strip = (n + 1) % PAL8_STRIPS;
+    }
+
+    return display_dma_in_flight() > 0;
+}
+
+/**
+ * Histogram bucket for a stage time
+ */
+static inline int stage_bucket(uint32_t us)
+{
+    uint32_t ms = us / 1000;
+    if (ms == 0) return 0;
+
+    int bucket = 32 - __builtin_clz(ms);
+    return (bucket < VIDEO_HIST_BUCKETS) ? bucket : VIDEO_HIST_BUCKETS - 1;
+}
+
+/**
+ * Count a shown frame in the histograms and the trace
+ */
+static void record_frame(video_player_t *player, const uint32_t stage_us[VIDEO_STAGE_COUNT],
+                         int64_t slack_us)
+{
+    video_stats_t *s = &player->stats;
+
+    s->frames++;
+    if (slack_us < 0) s->late++;
+    for (int i = 0; i < VIDEO_STAGE_COUNT; i++) {
+        s->hist[i][stage_bucket(stage_us[i])]++;
+        if (stage_us[i] > s->max_us[i]) s->max_us[i] = stage_us[i];
+    }
+
+    uint32_t n = player->trace_count;
+    video_trace_t *trace = player->trace;
+    if (trace == NULL || n >= player->trace_capacity) return;
+
+    trace[n].frame_num = player->current_frame;
+    trace[n].slack_us = (slack_us < INT32_MIN) ? INT32_MIN : (slack_us > INT32_MAX) ? INT32_MAX : (int32_t)slack_us;
+    for (int i = 0; i < VIDEO_STAGE_COUNT; i++) {
+        trace[n].stage_us[i] = (stage_us[i] > UINT16_MAX) ? UINT16_MAX : stage_us[i];
+    }
+    player->trace_count = n + 1;
+}
+
+/**
+ * Wait for the playback task to exit
+ * The task clears playback_task itself once its reader has stopped and its
+ * last transfer has finished; a reader blocked in a slow card read can take
+ * well over 100 ms
+ */
+static void wait_playback_exit(video_player_t *player)
+{
+    while (player->playback_task != NULL && player->playback_task != xTaskGetCurrentTaskHandle()) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+/**
+ * Playback task
+ */
+static void video_playback_task(void *pvParameters)
+{
+    video_player_t *player = (video_player_t *)pvParameters;
+    bool dma_pending = false;
+    bool was_trick = false;
+    bool completed = false;
+    esp_err_t error = ESP_OK;
+    jpeg_scale_t scale = JPEG_SCALE_1_1;
+    jpeg_pixel_format_t out_format = JPEG_PIXEL_RGB565;
+
+    DLOGI(TAG, "Playback task started on core %d", xPortGetCoreID());
+    display_set_done_callback(transfer_done, xTaskGetCurrentTaskHandle());
+
+    if (player->io_tuning.prefetch_depth > 0 && start_reader(player) != ESP_OK) {
+        ESP_LOGW(TAG, "Frame reader unavailable, reading inline");
+    }
+
+    // Deadlines are origin + timebase time of the frames shown since, so
+    // 29.97/23.976 fps rounding never accumulates
+    uint64_t pace_origin = esp_timer_get_time();
+    uint32_t paced_frames = 0;
+
+    // The panel shows whatever was drawn before playback started
+    player->crb_dirty = 0;
+    player->full_refresh = true;
 
     while (player->state == VIDEO_STATE_PLAYING || player->state == VIDEO_STATE_PAUSED) {
         // Handle pause state
         if (player->state == VIDEO_STATE_PAUSED) {
             vTaskDelay(pdMS_TO_TICKS(100));
+            pace_origin = esp_timer_get_time();
+            paced_frames = 0;
+            continue;
+        }
+
+        int8_t speed = player->speed;
+        bool trick = (speed != VIDEO_SPEED_NORMAL);
+        uint64_t interval_us = timebase_frame_to_us(&player->timebase, 1);
+
+        if (trick && interval_us < TRICK_FRAME_INTERVAL_US) {
+            interval_us = TRICK_FRAME_INTERVAL_US;
+        }
+
+        // Only MJPEG frames are decoded at reduced scale
+        jpeg_scale_t want_scale = (player->codec == VIDEO_CODEC_MJPEG) ? speed_to_scale(speed)
+                                                                       : JPEG_SCALE_1_1;
+        if (want_scale != scale) {
+            scale = want_scale;
+            mjpeg_decoder_set_scale(player->decoder, scale);
+        }
+
+        bool crb = (player->codec == VIDEO_CODEC_CRB);
+        bool pal8 = (player->codec == VIDEO_CODEC_PAL8);
+        if (crb) {
+            // The canvas is decoded in place, so the previous push must finish
+            if (dma_pending) {
+                display_wait_dma();
+                dma_pending = false;
+            }
+
+            // Trick play drew the position bar and may have applied frames
+            // out of order: rebuild the canvas from the current keyframe
+            if (was_trick && !trick && player->avi_parser.has_index) {
+                parser_seek(player, prev_keyframe(player, player->current_frame));
+            }
+        }
+        was_trick = trick;
+
+        // Scaled frames are expanded and overdrawn in RGB565, then packed
+        bool panel_444 = (player->pixel_format == DISPLAY_FORMAT_RGB444);
+        bool direct_444 = panel_444 && scale == JPEG_SCALE_1_1 && player->codec == VIDEO_CODEC_MJPEG;
+        jpeg_pixel_format_t want = direct_444 ? JPEG_PIXEL_RGB444 : JPEG_PIXEL_RGB565;
+        if (want != out_format) {
+            out_format = want;
+            mjpeg_decoder_set_pixel_format(player->decoder, out_format);
+        }
+
+        if (trick && trick_seek(player, speed, interval_us) != ESP_OK) {
+            if (speed > 0) {
+                // Fast-forwarded past the end
+                player->speed = VIDEO_SPEED_NORMAL;
+                player->state = VIDEO_STATE_STOPPED;
+                completed = true;
+                break;
+            }
+            // Rewound to the start: continue at normal speed
+            player->speed = VIDEO_SPEED_NORMAL;
             continue;
         }
 
-        uint64_t frame_start = esp_timer_get_time();
+        if (!trick && player->rate_q8 != VIDEO_RATE_1X) {
+            // Media time advances rate frames per displayed frame
+            player->rate_accum += player->rate_q8;
+            uint32_t advance = player->rate_accum >> 8;
+            player->rate_accum &= 0xFF;
+            if (advance > 1) {
+                skip_frames(player, advance - 1);
+            }
+        }
 
         // 1. Read next MJPEG frame from file
-        
-        // Wait, I can't abort a tool call once I've started typing it in the thought process? 
-        // No, I can just change what I send.
-        
-        // I will switch to multi_replace_file_content to:
-        // 1. Add #include "avi_parser.h"
-        // 2. Update struct video_player_s
-        // 3. Update video_player_open
-        // 4. Update video_player_close
-        // 5. Implement video_playback_task
-        
-        // Let's do that.
+        uint32_t stage_us[VIDEO_STAGE_COUNT];
+        uint64_t t0 = esp_timer_get_time();
+        mjpeg_frame_t frame = {0};
+        esp_err_t ret = next_frame(player, trick, &frame);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            continue;
+        } else if (ret == ESP_ERR_NOT_FOUND) {
+            DLOGI(TAG, "End of video at frame %lu", player->current_frame);
+            player->state = VIDEO_STATE_STOPPED;
+            completed = true;
+            break;
+        } else if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read frame: %s", esp_err_to_name(ret));
+            player->state = VIDEO_STATE_ERROR;
+            error = ret;
+            break;
+        }
+
+        uint64_t t1 = esp_timer_get_time();
+        stage_us[VIDEO_STAGE_READ] = (uint32_t)(t1 - t0);
+
+        // 2. Decode into the buffer not being transferred
+        frame_buffer_t *fb = player->frame_buffer[(crb || pal8) ? 0 : player->current_buffer];
+        ret = decode_to_buffer(player, &frame, fb, scale);
+        player->current_frame = frame.frame_num;
+        avi_parser_free_frame(&frame);
+
+        if (ret != ESP_OK) {
+            // Skip corrupt frames rather than stopping playback
+            DLOGW(TAG, "Frame %lu decode failed: %s", player->current_frame, esp_err_to_name(ret));
+            player->stats.dropped++;
+            continue;
+        }
+
+        fb->format = (out_format == JPEG_PIXEL_RGB444) ? DISPLAY_FORMAT_RGB444 : DISPLAY_FORMAT_RGB565;
+
+        if (trick && !pal8) {
+            draw_position_bar(player, fb);
+            player->full_refresh = true;
+        }
+
+        // The CRB canvas is the reference for the next frame and stays
+        // RGB565; PAL8 strips are marked and packed as they are expanded
+        if (panel_444 && fb->format == DISPLAY_FORMAT_RGB565 && !crb && !pal8) {
+            display_pack_rgb444(fb);
+        }
+
+        // 3. Push to display once the previous transfer has finished
+        uint64_t t2 = esp_timer_get_time();
+        stage_us[VIDEO_STAGE_DECODE] = (uint32_t)(t2 - t1);
+        if (pal8) {
+            dma_pending = push_palettized(player, fb, trick, panel_444);
+        } else if (crb) {
+            dma_pending = push_dirty_rows(player, fb, dma_pending);
+        } else {
+            dma_pending = push_changed_bands(player, fb, dma_pending);
+            player->current_buffer ^= 1;
+        }
+        stage_us[VIDEO_STAGE_PUSH] = (uint32_t)(esp_timer_get_time() - t2);
+
+        if (player->callbacks.on_frame_decoded) {
+            player->callbacks.on_frame_decoded(player->user_data, player->current_frame);
+        }
+
+        // 4. Frame pacing (trick play runs at its own fixed cadence)
+        if (trick) {
+            pace_origin += interval_us;
+            paced_frames = 0;
+        } else {
+            paced_frames++;
+        }
+        uint64_t next_frame_time = pace_origin + timebase_frame_to_us(&player->timebase, paced_frames);
+        uint64_t now = esp_timer_get_time();
+        player->last_frame_time = now;
+        record_frame(player, stage_us, (int64_t)(next_frame_time - now));
+
+        if (next_frame_time > now) {
+            vTaskDelay(pdMS_TO_TICKS((next_frame_time - now) / 1000));
+        } else if (now - next_frame_time > 4 * interval_us) {
+            // Far behind (slow card, seek): resync instead of racing
+            pace_origin = now;
+            paced_frames = 0;
+        }
+    }
+
+    stop_reader(player);
+
+    if (dma_pending) {
+        display_wait_dma();
     }
+    display_set_done_callback(NULL, NULL);
+
+    if (scale != JPEG_SCALE_1_1) {
+        mjpeg_decoder_set_scale(player->decoder, JPEG_SCALE_1_1);
+    }
+
+    if (out_format != JPEG_PIXEL_RGB565) {
+        mjpeg_decoder_set_pixel_format(player->decoder, JPEG_PIXEL_RGB565);
+    }
+
+    DLOGI(TAG, "Playback task exiting");
+    player->playback_task = NULL;
+
+    // Callbacks run last: the reader is stopped and the handle cleared, so
+    // they may close the file and start the next episode
+    if (completed && player->callbacks.on_playback_complete) {
+        player->callbacks.on_playback_complete(player->user_data);
+    }
+    if (error != ESP_OK && player->callbacks.on_error) {
+        player->callbacks.on_error(player->user_data, error);
+    }
+
+    vTaskDelete(NULL);
 }
 
 /**
@@ -120,6 +1025,16 @@ video_player_t *video_player_create(const video_callbacks_t *callbacks, void *us
 
     memset(player, 0, sizeof(video_player_t));
     player->state = VIDEO_STATE_STOPPED;
+    player->speed = VIDEO_SPEED_NORMAL;
+    player->rate_q8 = VIDEO_RATE_1X;
+    sd_profile_tune(NULL, &player->io_tuning);
+
+    player->parser_lock = xSemaphoreCreateMutex();
+    if (player->parser_lock == NULL) {
+        ESP_LOGE(TAG, "Failed to create parser lock");
+        free(player);
+        return NULL;
+    }
 
     // Set callbacks
     if (callbacks) {
@@ -128,16 +1043,17 @@ video_player_t *video_player_create(const video_callbacks_t *callbacks, void *us
     player->user_data = user_data;
 
     // Create MJPEG decoder
-    player->decoder = mjpeg_decoder_create(320, 240);  // Max resolution
+    player->decoder = mjpeg_decoder_create(VIDEO_FB_WIDTH, VIDEO_FB_HEIGHT);
     if (player->decoder == NULL) {
         ESP_LOGE(TAG, "Failed to create MJPEG decoder");
+        vSemaphoreDelete(player->parser_lock);
         free(player);
         return NULL;
     }
 
     // Allocate frame buffers for double buffering
     for (int i = 0; i < 2; i++) {
-        player->frame_buffer[i] = display_alloc_frame_buffer(240, 240);
+        player->frame_buffer[i] = display_alloc_frame_buffer(VIDEO_FB_WIDTH, VIDEO_FB_HEIGHT);
         if (player->frame_buffer[i] == NULL) {
             ESP_LOGE(TAG, "Failed to allocate frame buffer %d", i);
             video_player_destroy(player);
@@ -178,6 +1094,7 @@ void video_player_destroy(video_player_t *player)
         }
     }
 
+    vSemaphoreDelete(player->parser_lock);
     free(player);
 
     ESP_LOGI(TAG, "Video player destroyed");
@@ -196,7 +1113,8 @@ esp_err_t video_player_open(video_player_t *player, const char *file_path)
     video_player_close(player);
 
     // Open AVI file using parser
-    esp_err_t ret = avi_parser_open(&player->avi_parser, file_path);
+    esp_err_t ret = avi_parser_open_buffered(&player->avi_parser, file_path,
+                                             player->io_tuning.read_block_size);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to open AVI file: %s", file_path);
         return ret;
@@ -206,19 +1124,43 @@ esp_err_t video_player_open(video_player_t *player, const char *file_path)
     strncpy(player->info.path, file_path, sizeof(player->info.path) - 1);
     player->info.width = player->avi_parser.video_info.width;
     player->info.height = player->avi_parser.video_info.height;
-    player->info.fps = (uint16_t)avi_parser_get_fps(&player->avi_parser);
+    avi_parser_get_timebase(&player->avi_parser, &player->timebase);
+    player->info.timebase = player->timebase;
+    player->info.fps = timebase_fps_rounded(&player->timebase);
     player->info.frame_count = avi_parser_get_total_frames(&player->avi_parser);
-    player->info.duration_sec = player->info.frame_count / (player->info.fps > 0 ? player->info.fps : 15);
-
-    // Use default FPS if parser returned 0
-    if (player->info.fps == 0) player->info.fps = 15;
+    player->info.duration_sec = timebase_frame_to_sec(&player->timebase, player->info.frame_count);
+
+    // Unknown FOURCCs go to the JPEG decoder, as before
+    if (player->avi_parser.video_info.compression == FOURCC_L565) {
+        player->codec = VIDEO_CODEC_LZ565;
+    } else if (player->avi_parser.video_info.compression == FOURCC_CRB1) {
+        player->codec = VIDEO_CODEC_CRB;
+    } else if (player->avi_parser.video_info.compression == FOURCC_PAL8) {
+        player->codec = VIDEO_CODEC_PAL8;
+    } else {
+        player->codec = VIDEO_CODEC_MJPEG;
+    }
 
-    player->frame_time_us = 1000000 / player->info.fps;
     player->current_frame = 0;
+    player->underruns = 0;
+    memset(&player->stats, 0, sizeof(player->stats));
 
-    ESP_LOGI(TAG, "Video opened: %dx%d @ %d fps, %d frames",
+    ESP_LOGI(TAG, "Video opened: %dx%d @ %lu/%lu fps, %d frames (%s)",
              player->info.width, player->info.height,
-             player->info.fps, player->info.frame_count);
+             player->timebase.rate, player->timebase.scale, player->info.frame_count,
+             player->codec == VIDEO_CODEC_LZ565 ? "LZ565" :
+             player->codec == VIDEO_CODEC_CRB ? "CRB" :
+             player->codec == VIDEO_CODEC_PAL8 ? "PAL8" : "MJPEG");
+
+    // Average stream bitrate against what the card sustains
+    if (player->info.frame_count > 0) {
+        uint32_t kbps = (uint32_t)((uint64_t)player->avi_parser.movi_size * 8 * player->timebase.rate /
+                                   player->timebase.scale / player->info.frame_count / 1000);
+        if (kbps > player->io_tuning.max_bitrate_kbps) {
+            ESP_LOGW(TAG, "Stream bitrate %lu kbit/s exceeds card limit %lu kbit/s, expect stutter",
+                     kbps, player->io_tuning.max_bitrate_kbps);
+        }
+    }
 
     return ESP_OK;
 }
@@ -230,7 +1172,9 @@ void video_player_close(video_player_t *player)
 {
     if (player == NULL) return;
 
+    xSemaphoreTake(player->parser_lock, portMAX_DELAY);
     avi_parser_close(&player->avi_parser);
+    xSemaphoreGive(player->parser_lock);
 
     player->current_frame = 0;
 }
@@ -247,8 +1191,19 @@ esp_err_t video_player_play(video_player_t *player)
         return ESP_OK;
     }
 
+    // Resume: the playback task keeps running while paused
+    if (player->state == VIDEO_STATE_PAUSED && player->playback_task != NULL) {
+        ESP_LOGI(TAG, "Resuming playback at frame %lu", player->current_frame);
+        player->full_refresh = true;
+        player->state = VIDEO_STATE_PLAYING;
+        return ESP_OK;
+    }
+
     ESP_LOGI(TAG, "Starting playback...");
 
+    // A task that stopped on its own may still be shutting down its reader
+    wait_playback_exit(player);
+
     player->state = VIDEO_STATE_PLAYING;
     player->last_frame_time = esp_timer_get_time();
 
@@ -297,14 +1252,14 @@ esp_err_t video_player_stop(video_player_t *player)
     if (player->state == VIDEO_STATE_PLAYING || player->state == VIDEO_STATE_PAUSED) {
         ESP_LOGI(TAG, "Stopping playback");
         player->state = VIDEO_STATE_STOPPED;
+        player->speed = VIDEO_SPEED_NORMAL;
 
-        // Wait for playback task to finish
-        if (player->playback_task) {
-            vTaskDelay(pdMS_TO_TICKS(100));  // Give time for task to exit
-            player->playback_task = NULL;
-        }
-
+        wait_playback_exit(player);
         player->current_frame = 0;
+    } else {
+        // A task that stopped itself at the end of the file may still be
+        // shutting down its reader
+        wait_playback_exit(player);
     }
 
     return ESP_OK;
@@ -317,13 +1272,171 @@ esp_err_t video_player_seek(video_player_t *player, uint32_t frame_num)
 {
     if (player == NULL || !player->avi_parser.initialized) return ESP_FAIL;
 
-    esp_err_t ret = avi_parser_seek(&player->avi_parser, frame_num);
+    // CRB frames build on their predecessor, PAL8 frames on the last palette
+    if ((player->codec == VIDEO_CODEC_CRB || player->codec == VIDEO_CODEC_PAL8) &&
+        player->avi_parser.has_index) {
+        frame_num = prev_keyframe(player, frame_num);
+    }
+
+    esp_err_t ret = parser_seek(player, frame_num);
     if (ret == ESP_OK) {
         player->current_frame = frame_num;
     }
     return ret;
 }
 
+/**
+ * Set playback speed
+ */
+esp_err_t video_player_set_speed(video_player_t *player, int8_t speed)
+{
+    if (player == NULL) return ESP_ERR_INVALID_ARG;
+
+    int8_t mag = (speed < 0) ? -speed : speed;
+    if (speed != VIDEO_SPEED_NORMAL &&
+        (mag < 2 || mag > VIDEO_SPEED_MAX || (mag & (mag - 1)) != 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Trick play relies on indexed jumps; a linear rewind would rescan the file
+    if (speed != VIDEO_SPEED_NORMAL && !player->avi_parser.has_index) {
+        ESP_LOGW(TAG, "Trick play needs a frame index");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (speed != player->speed) {
+        ESP_LOGI(TAG, "Playback speed %dx", speed);
+        player->speed = speed;
+    }
+
+    if (speed != VIDEO_SPEED_NORMAL && player->state == VIDEO_STATE_PAUSED) {
+        return video_player_play(player);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Get playback speed
+ */
+int8_t video_player_get_speed(const video_player_t *player)
+{
+    return (player != NULL) ? player->speed : VIDEO_SPEED_NORMAL;
+}
+
+/**
+ * Set playback rate
+ */
+esp_err_t video_player_set_rate(video_player_t *player, uint16_t rate_q8)
+{
+    if (player == NULL || rate_q8 < VIDEO_RATE_1X || rate_q8 > VIDEO_RATE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (rate_q8 != player->rate_q8) {
+        player->rate_accum = 0;
+        player->rate_q8 = rate_q8;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Get playback rate
+ */
+uint16_t video_player_get_rate(const video_player_t *player)
+{
+    return (player != NULL) ? player->rate_q8 : VIDEO_RATE_1X;
+}
+
+/**
+ * Set I/O tuning
+ */
+esp_err_t video_player_set_io_tuning(video_player_t *player, const sd_io_tuning_t *tuning)
+{
+    if (player == NULL || tuning == NULL || tuning->prefetch_depth == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    player->io_tuning = *tuning;
+
+    ESP_LOGI(TAG, "I/O tuning: prefetch %d, read size %lu, max %lu kbit/s",
+             tuning->prefetch_depth, tuning->read_block_size, tuning->max_bitrate_kbps);
+
+    return ESP_OK;
+}
+
+/**
+ * Set panel pixel format
+ */
+esp_err_t video_player_set_pixel_format(video_player_t *player, display_format_t format)
+{
+    if (player == NULL) return ESP_ERR_INVALID_ARG;
+    if (format != DISPLAY_FORMAT_RGB565 && format != DISPLAY_FORMAT_RGB444) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "Panel pixel format %s", format == DISPLAY_FORMAT_RGB444 ? "RGB444" : "RGB565");
+    player->pixel_format = format;
+
+    return ESP_OK;
+}
+
+/**
+ * Invalidate panel contents
+ */
+void video_player_invalidate(video_player_t *player)
+{
+    if (player == NULL) return;
+
+    player->full_refresh = true;
+}
+
+/**
+ * Get underrun count
+ */
+uint32_t video_player_get_underruns(const video_player_t *player)
+{
+    return (player != NULL) ? player->underruns : 0;
+}
+
+/**
+ * Get statistics
+ */
+esp_err_t video_player_get_stats(const video_player_t *player, video_stats_t *stats)
+{
+    if (player == NULL || stats == NULL) return ESP_ERR_INVALID_ARG;
+
+    *stats = player->stats;
+    stats->underruns = player->underruns;
+
+    return ESP_OK;
+}
+
+/**
+ * Start trace
+ */
+esp_err_t video_player_start_trace(video_player_t *player, video_trace_t *buffer, uint32_t capacity)
+{
+    if (player == NULL) return ESP_ERR_INVALID_ARG;
+
+    // Recording stops while the buffer and count change
+    player->trace_capacity = 0;
+    player->trace = buffer;
+    player->trace_count = 0;
+    player->trace_capacity = buffer ? capacity : 0;
+
+    return ESP_OK;
+}
+
+/**
+ * Get trace count
+ */
+uint32_t video_player_get_trace_count(const video_player_t *player)
+{
+    return (player != NULL) ? player->trace_count : 0;
+}
+
 /**
  * Get playback state
  */
@@ -357,7 +1470,7 @@ uint32_t video_player_get_current_frame(const video_player_t *player)
  */
 uint32_t video_player_get_position_sec(const video_player_t *player)
 {
-    if (player == NULL || player->info.fps == 0) return 0;
+    if (player == NULL || !player->avi_parser.initialized) return 0;
 
-    return player->current_frame / player->info.fps;
+    return timebase_frame_to_sec(&player->timebase, player->current_frame);
 }
@@ -0,0 +1,1027 @@
+/**
+ * Performance Benchmarks Implementation
+ */
+
+#include "benchmarks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "display.h"
+#include "sd_card.h"
+#include "frame_index.h"
+#include "avi_parser.h"
+#include "mjpeg_decoder.h"
+#include "lz565.h"
+#include "crb.h"
+#include "pal8.h"
+#include "jpeg_color.h"
+#include "simd.h"
+#include "time_stretch.h"
+#include "video_player.h"
+#include "audio_player.h"
+#include "radio_player.h"
+#include "power_manager.h"
+#include "pc_profiler.h"
+
+static const char *TAG = "BENCH";
+
+static sd_card_handle_t g_bench_sd;
+
+#define BENCH_SCRATCH_INDEX     SD_MOUNT_POINT "/bench.fidx"
+#define BENCH_VIDEO_PATH        SD_MOUNT_POINT "/bench.avi"   // Any 240x240 MJPEG AVI
+#define BENCH_LZ565_PATH        SD_MOUNT_POINT "/bench_lz.avi" // Same clip via lz565_encode
+#define BENCH_CRB_PATH          SD_MOUNT_POINT "/bench_crb.avi" // Same clip via crb_encode
+#define BENCH_PAL8_PATH         SD_MOUNT_POINT "/bench_pal8.avi" // Same clip via pal8_encode
+#define BENCH_PAL8_STRIP_ROWS   16
+#define BENCH_RADIO_PATH        SD_MOUNT_POINT "/bench_radio.wav" // 22.05 kHz 16-bit mono, 30 s+
+#define BENCH_POWER_PHASE_SEC   15
+
+/**
+ * Small deterministic PRNG so every run measures the same layout
+ */
+static uint32_t bench_rand(uint32_t *state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+/**
+ * Frame index: resident RAM and random seek time for typical durations
+ * Synthesizes the chunk layout of a 24 fps MJPEG AVI with interleaved audio
+ */
+void bench_frame_index(void)
+{
+    ESP_LOGI(TAG, "Frame index benchmark (24 fps, 4-12 KB frames)");
+    ESP_LOGI(TAG, "  %-8s %8s %8s %10s %10s %10s %10s",
+             "length", "frames", "pages", "resident", "cache", "seek avg", "seek max");
+
+    const uint32_t durations_sec[] = {10 * 60, 60 * 60, 3 * 60 * 60};
+    const char *labels[] = {"10 min", "1 h", "3 h"};
+    const int seeks = 200;
+
+    for (int d = 0; d < 3; d++) {
+        uint32_t frames = durations_sec[d] * 24;
+        uint32_t seed = 1;
+        uint32_t offset = 2048;
+        frame_index_writer_t writer;
+
+        uint64_t t0 = esp_timer_get_time();
+        if (frame_index_writer_begin(&writer, BENCH_SCRATCH_INDEX, frames, 0) != ESP_OK) {
+            ESP_LOGE(TAG, "Cannot create scratch index");
+            return;
+        }
+        for (uint32_t i = 0; i < frames; i++) {
+            frame_index_writer_add(&writer, offset, true);
+            offset += 8 + 4096 + (bench_rand(&seed) % 8192);   // video chunk
+            offset += 8 + 920;                                  // audio chunk
+        }
+        frame_index_writer_finish(&writer);
+        uint32_t build_ms = (esp_timer_get_time() - t0) / 1000;
+
+        frame_index_t index;
+        if (frame_index_load(&index, BENCH_SCRATCH_INDEX, 0) != ESP_OK) {
+            ESP_LOGE(TAG, "Cannot load scratch index");
+            return;
+        }
+
+        // Random seeks, each normally a cold page
+        uint32_t total_us = 0;
+        uint32_t max_us = 0;
+        for (int i = 0; i < seeks; i++) {
+            uint32_t frame = bench_rand(&seed) % frames;
+            uint32_t off;
+            uint64_t s = esp_timer_get_time();
+            frame_index_lookup(&index, frame, &off, NULL);
+            uint32_t us = esp_timer_get_time() - s;
+            total_us += us;
+            if (us > max_us) max_us = us;
+        }
+
+        ESP_LOGI(TAG, "  %-8s %8lu %8lu %9luB %9luB %8luus %8luus  (build %lu ms)",
+                 labels[d], frames, index.page_count,
+                 frame_index_get_resident_bytes(&index),
+                 index.cache_size + index.page_count * 8,
+                 total_us / seeks, max_us, build_ms);
+
+        frame_index_close(&index);
+        remove(BENCH_SCRATCH_INDEX);
+    }
+}
+
+/**
+ * Trick play: decode cost per scale and CPU budget per second of playback
+ * 1x decodes every frame at full size; 2x-16x decode one frame per
+ * trick refresh (<= 15/s) at 1/2 or 1/4 scale
+ */
+void bench_trick_play(void)
+{
+    const int frames = 30;
+    const char *labels[] = {"1/1", "1/2", "1/4", "1/8"};
+    uint32_t avg_us[4] = {0};
+
+    avi_parser_t avi;
+    if (avi_parser_open(&avi, BENCH_VIDEO_PATH) != ESP_OK) {
+        ESP_LOGW(TAG, "Trick play benchmark skipped (no %s)", BENCH_VIDEO_PATH);
+        return;
+    }
+
+    mjpeg_decoder_t *decoder = mjpeg_decoder_create(240, 240);
+    uint16_t *output = malloc(240 * 240 * sizeof(uint16_t));
+    if (decoder == NULL || output == NULL) {
+        ESP_LOGE(TAG, "Out of memory");
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Trick play benchmark (%d frames)", frames);
+    ESP_LOGI(TAG, "  %-6s %10s", "scale", "decode");
+
+    for (int s = JPEG_SCALE_1_1; s <= JPEG_SCALE_1_8; s++) {
+        mjpeg_decoder_set_scale(decoder, s);
+        avi_parser_seek(&avi, 0);
+
+        uint64_t total = 0;
+        int decoded = 0;
+        for (int i = 0; i < frames; i++) {
+            mjpeg_frame_t frame;
+            if (avi_parser_read_video_frame(&avi, &frame) != ESP_OK) break;
+
+            uint64_t t0 = esp_timer_get_time();
+            if (mjpeg_decoder_decode_frame(decoder, &frame, output, NULL, NULL) == ESP_OK) {
+                total += esp_timer_get_time() - t0;
+                decoded++;
+            }
+            avi_parser_free_frame(&frame);
+        }
+
+        avg_us[s] = decoded ? total / decoded : 0;
+        ESP_LOGI(TAG, "  %-6s %8luus", labels[s], avg_us[s]);
+    }
+
+    float fps = avi_parser_get_fps(&avi);
+    float trick_fps = (fps < 15.0f) ? fps : 15.0f;
+    ESP_LOGI(TAG, "  CPU per second: 1x %lu ms, 2x/4x %lu ms, 8x/16x %lu ms",
+             (uint32_t)(avg_us[0] * fps / 1000),
+             (uint32_t)(avg_us[1] * trick_fps / 1000),
+             (uint32_t)(avg_us[2] * trick_fps / 1000));
+
+cleanup:
+    free(output);
+    mjpeg_decoder_destroy(decoder);
+    avi_parser_close(&avi);
+}
+
+/**
+ * WSOLA time stretch: CPU cycles per second of input audio at 1.25x-2x
+ * Input is a synthetic voiced signal (harmonics with gliding pitch)
+ */
+void bench_time_stretch(void)
+{
+    const uint32_t rate_hz = 22050;
+    const size_t block = 1024;
+    const uint16_t rates[] = {320, 384, 512};
+
+    int16_t *pcm = malloc(rate_hz * sizeof(int16_t));
+    time_stretch_t *ts = time_stretch_create(rate_hz);
+    size_t out_max = ts ? time_stretch_max_output(ts, block) : 0;
+    int16_t *out = malloc(out_max * sizeof(int16_t));
+
+    if (pcm == NULL || ts == NULL || out == NULL) {
+        ESP_LOGE(TAG, "Out of memory");
+        goto cleanup;
+    }
+
+    float phase = 0;
+    for (uint32_t i = 0; i < rate_hz; i++) {
+        float f0 = 140.0f + 40.0f * sinf(2.0f * (float)M_PI * 2.0f * i / rate_hz);
+        phase += 2.0f * (float)M_PI * f0 / rate_hz;
+        pcm[i] = (int16_t)(8000.0f * (sinf(phase) + 0.5f * sinf(2 * phase) + 0.3f * sinf(3 * phase)));
+    }
+
+    ESP_LOGI(TAG, "Time stretch benchmark (1 s at %lu Hz, %d-sample blocks)", rate_hz, (int)block);
+    ESP_LOGI(TAG, "  %-6s %14s %8s", "rate", "cycles/s", "CPU");
+
+    for (int r = 0; r < 3; r++) {
+        time_stretch_set_rate(ts, rates[r]);
+
+        uint32_t c0 = esp_cpu_get_cycle_count();
+        for (size_t pos = 0; pos < rate_hz; pos += block) {
+            size_t n = (rate_hz - pos < block) ? rate_hz - pos : block;
+            size_t produced;
+            time_stretch_process(ts, &pcm[pos], n, out, out_max, &produced);
+        }
+        uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+
+        ESP_LOGI(TAG, "  %d.%02dx %14lu %7.2f%%", rates[r] >> 8, ((rates[r] & 0xFF) * 100) >> 8,
+                 cycles, 100.0f * cycles / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000.0f));
+    }
+
+cleanup:
+    free(out);
+    time_stretch_destroy(ts);
+    free(pcm);
+}
+
+/**
+ * Panel pixel format: bytes on the wire, DMA time per 240x240 frame and the
+ * resulting fps ceiling, plus the cost of producing each format
+ */
+void bench_panel_format(void)
+{
+    const int frames = 30;
+    const char *labels[] = {"RGB565", "RGB444"};
+
+    frame_buffer_t *fb = display_alloc_frame_buffer(240, 240);
+    if (fb == NULL) {
+        ESP_LOGE(TAG, "Out of memory");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Panel format benchmark (%d frames at %d MHz)", frames, DISPLAY_SPI_CLOCK / 1000000);
+    ESP_LOGI(TAG, "  %-7s %9s %10s %8s", "format", "bytes", "frame", "max fps");
+
+    for (int f = DISPLAY_FORMAT_RGB565; f <= DISPLAY_FORMAT_RGB444; f++) {
+        // Gradient, so RGB444 exercises the dither path
+        fb->format = DISPLAY_FORMAT_RGB565;
+        for (int y = 0; y < fb->height; y++) {
+            for (int x = 0; x < fb->width; x++) {
+                uint16_t c = RGB565(x, y, 255 - x);
+                fb->buffer[y * fb->width + x] = (c >> 8) | (c << 8);
+            }
+        }
+        if (f == DISPLAY_FORMAT_RGB444) {
+            display_pack_rgb444(fb);
+        }
+
+        uint64_t t0 = esp_timer_get_time();
+        for (int i = 0; i < frames; i++) {
+            if (display_write_frame_dma(fb) == ESP_OK) {
+                display_wait_dma();
+            }
+        }
+        uint32_t frame_us = (esp_timer_get_time() - t0) / frames;
+
+        ESP_LOGI(TAG, "  %-7s %9lu %8luus %8.1f", labels[f], display_frame_bytes(fb),
+                 frame_us, frame_us ? 1000000.0f / frame_us : 0.0f);
+    }
+
+    // Producing RGB444: packing an RGB565 frame vs decoding straight to it
+    fb->format = DISPLAY_FORMAT_RGB565;
+    uint64_t t0 = esp_timer_get_time();
+    display_pack_rgb444(fb);
+    ESP_LOGI(TAG, "  RGB565 -> RGB444 pack: %lluus", esp_timer_get_time() - t0);
+
+    avi_parser_t avi;
+    mjpeg_decoder_t *decoder = NULL;
+    if (avi_parser_open(&avi, BENCH_VIDEO_PATH) == ESP_OK) {
+        decoder = mjpeg_decoder_create(240, 240);
+
+        for (int f = JPEG_PIXEL_RGB565; decoder != NULL && f <= JPEG_PIXEL_RGB444; f++) {
+            mjpeg_decoder_set_pixel_format(decoder, f);
+            avi_parser_seek(&avi, 0);
+
+            uint64_t total = 0;
+            int decoded = 0;
+            for (int i = 0; i < frames; i++) {
+                mjpeg_frame_t frame;
+                if (avi_parser_read_video_frame(&avi, &frame) != ESP_OK) break;
+
+                uint64_t d0 = esp_timer_get_time();
+                if (mjpeg_decoder_decode_frame(decoder, &frame, fb->buffer, NULL, NULL) == ESP_OK) {
+                    total += esp_timer_get_time() - d0;
+                    decoded++;
+                }
+                avi_parser_free_frame(&frame);
+            }
+
+            ESP_LOGI(TAG, "  decode to %s: %lluus", labels[f], decoded ? total / decoded : 0);
+        }
+
+        mjpeg_decoder_destroy(decoder);
+        avi_parser_close(&avi);
+    }
+
+    display_free_frame_buffer(fb);
+}
+
+/**
+ * Read and decode the first frames of one file
+ */
+static void bench_codec_file(const char *label, const char *path)
+{
+    const int frames = 60;
+
+    avi_parser_t avi;
+    if (avi_parser_open(&avi, path) != ESP_OK) {
+        ESP_LOGW(TAG, "  %-6s skipped (no %s)", label, path);
+        return;
+    }
+
+    bool lz = (avi.video_info.compression == FOURCC_L565);
+    uint32_t lz_bytes = (uint32_t)avi.video_info.width * avi.video_info.height * sizeof(uint16_t);
+    mjpeg_decoder_t *decoder = lz ? NULL : mjpeg_decoder_create(240, 240);
+    uint16_t *output = heap_caps_malloc(240 * 240 * sizeof(uint16_t), MALLOC_CAP_DMA);
+
+    if ((!lz && decoder == NULL) || output == NULL || lz_bytes > 240 * 240 * sizeof(uint16_t)) {
+        ESP_LOGE(TAG, "Out of memory or frame too large");
+        goto cleanup;
+    }
+
+    uint64_t read_us = 0, decode_us = 0, bytes = 0;
+    int decoded = 0;
+
+    for (int i = 0; i < frames; i++) {
+        mjpeg_frame_t frame;
+
+        uint64_t t0 = esp_timer_get_time();
+        if (avi_parser_read_video_frame(&avi, &frame) != ESP_OK) break;
+        uint64_t t1 = esp_timer_get_time();
+
+        esp_err_t ret = lz ? lz565_decode(frame.data, frame.size, (uint8_t *)output, lz_bytes)
+                           : mjpeg_decoder_decode_frame(decoder, &frame, output, NULL, NULL);
+        uint64_t t2 = esp_timer_get_time();
+
+        if (ret == ESP_OK) {
+            read_us += t1 - t0;
+            decode_us += t2 - t1;
+            bytes += frame.size;
+            decoded++;
+        }
+        avi_parser_free_frame(&frame);
+    }
+
+    if (decoded > 0) {
+        float fps = avi_parser_get_fps(&avi);
+        uint32_t per_frame = (read_us + decode_us) / decoded;
+
+        // Busy time per second of video; the rest can be spent in light sleep
+        ESP_LOGI(TAG, "  %-6s %6lluus %6lluus %8llu %7.2f %7.2f %6.1f%%", label,
+                 read_us / decoded, decode_us / decoded, bytes / decoded,
+                 read_us ? bytes / (float)read_us : 0.0f, bytes * fps / decoded / 1e6f,
+                 per_frame * fps / 1e4f);
+    }
+
+cleanup:
+    heap_caps_free(output);
+    mjpeg_decoder_destroy(decoder);
+    avi_parser_close(&avi);
+}
+
+/**
+ * Codec comparison on the same clip: MJPEG vs pre-decoded LZ565
+ * CPU duty (read + decode time per second of video) stands in for power,
+ * since the board has no current sensor
+ */
+void bench_codecs(void)
+{
+    ESP_LOGI(TAG, "Codec benchmark (60 frames)");
+    ESP_LOGI(TAG, "  %-6s %8s %8s %8s %7s %7s %7s", "codec", "read", "decode", "bytes",
+             "SD MB/s", "need", "CPU");
+
+    bench_codec_file("MJPEG", BENCH_VIDEO_PATH);
+    bench_codec_file("LZ565", BENCH_LZ565_PATH);
+}
+
+/**
+ * Play one file to the panel: decode time, SPI bytes and push time per frame
+ * MJPEG pushes every frame whole; CRB applies changed blocks to a persistent
+ * canvas and pushes only the dirty block rows (keyframes whole)
+ */
+static void bench_replenish_file(const char *label, const char *path)
+{
+    const int frames = 90;
+
+    avi_parser_t avi;
+    if (avi_parser_open(&avi, path) != ESP_OK) {
+        ESP_LOGW(TAG, "  %-6s skipped (no %s)", label, path);
+        return;
+    }
+
+    struct stat st;
+    uint32_t file_kb = (stat(path, &st) == 0) ? st.st_size / 1024 : 0;
+    bool crb = (avi.video_info.compression == FOURCC_CRB1);
+    uint16_t width = avi.video_info.width;
+    uint16_t height = avi.video_info.height;
+
+    mjpeg_decoder_t *decoder = mjpeg_decoder_create(240, 240);
+    frame_buffer_t *canvas = display_alloc_frame_buffer(240, 240);
+    frame_buffer_t *mosaic = display_alloc_frame_buffer(240, 240);
+
+    if (decoder == NULL || canvas == NULL || mosaic == NULL ||
+        (crb && (width > 240 || height > 240))) {
+        ESP_LOGE(TAG, "Out of memory or frame too large");
+        goto cleanup;
+    }
+
+    uint64_t decode_us = 0, push_us = 0, spi_bytes = 0;
+    int shown = 0;
+
+    for (int i = 0; i < frames; i++) {
+        mjpeg_frame_t frame;
+        if (avi_parser_read_video_frame(&avi, &frame) != ESP_OK) break;
+
+        uint64_t dirty = 0;
+        uint8_t bs = 0;
+        esp_err_t ret;
+
+        uint64_t t0 = esp_timer_get_time();
+        if (crb) {
+            crb_frame_t cf;
+            ret = crb_parse(frame.data, frame.size, &cf);
+            if (ret == ESP_OK && cf.jpeg && cf.tile_count > 0) {
+                mjpeg_frame_t tiles = {.data = (uint8_t *)cf.payload, .size = cf.payload_size};
+                ret = mjpeg_decoder_decode_frame(decoder, &tiles, mosaic->buffer, NULL, NULL);
+            }
+            if (ret == ESP_OK) {
+                ret = crb_apply(&cf, mosaic->buffer, canvas->buffer, width, height, &dirty);
+                bs = cf.block_size;
+                if (i == 0 || cf.keyframe) dirty = ~0ull;
+            }
+            canvas->width = width;
+            canvas->height = height;
+        } else {
+            ret = mjpeg_decoder_decode_frame(decoder, &frame, canvas->buffer,
+                                             &canvas->width, &canvas->height);
+        }
+        uint64_t t1 = esp_timer_get_time();
+        avi_parser_free_frame(&frame);
+
+        if (ret != ESP_OK) continue;
+
+        if (!crb || dirty == ~0ull) {
+            if (display_write_frame_dma(canvas) == ESP_OK) display_wait_dma();
+            spi_bytes += display_frame_bytes(canvas);
+        } else {
+            for (uint16_t r = 0; r * bs < height; r++) {
+                if (!(dirty & (1ull << r))) continue;
+                uint16_t rows = (r * bs + bs <= height) ? bs : height - r * bs;
+                if (display_write_rows_dma(canvas, r * bs, rows) == ESP_OK) display_wait_dma();
+                spi_bytes += (uint32_t)rows * width * sizeof(uint16_t);
+            }
+        }
+
+        decode_us += t1 - t0;
+        push_us += esp_timer_get_time() - t1;
+        shown++;
+    }
+
+    if (shown > 0) {
+        ESP_LOGI(TAG, "  %-6s %7.2fms %7.2fms %9llu %8lu", label, decode_us / 1000.0f / shown,
+                 push_us / 1000.0f / shown, spi_bytes / shown, file_kb);
+    }
+
+cleanup:
+    display_free_frame_buffer(mosaic);
+    display_free_frame_buffer(canvas);
+    mjpeg_decoder_destroy(decoder);
+    avi_parser_close(&avi);
+}
+
+/**
+ * Conditional replenishment vs MJPEG on the same clip
+ */
+void bench_replenish(void)
+{
+    ESP_LOGI(TAG, "Block replenishment benchmark (90 frames)");
+    ESP_LOGI(TAG, "  %-6s %9s %9s %9s %8s", "codec", "decode", "push", "SPI B/fr", "file KB");
+
+    bench_replenish_file("MJPEG", BENCH_VIDEO_PATH);
+    bench_replenish_file("CRB", BENCH_CRB_PATH);
+}
+
+/**
+ * Palettized video: LUT expansion throughput, then a PAL8 file decoded and
+ * pushed in 16-row strips (the player's pipeline) vs RGB565 frame memory
+ */
+void bench_palette(void)
+{
+    const int frames = 60;
+    const uint32_t pixels = 240 * 240;
+    uint32_t seed = 1;
+
+    uint8_t *indices = heap_caps_malloc(pixels, MALLOC_CAP_8BIT);
+    uint16_t *lut = heap_caps_malloc(PAL8_COLORS * sizeof(uint16_t), MALLOC_CAP_8BIT);
+    uint16_t *strips = heap_caps_malloc(2 * 240 * BENCH_PAL8_STRIP_ROWS * sizeof(uint16_t), MALLOC_CAP_DMA);
+    frame_buffer_t *fb = display_alloc_frame_buffer(240, 240);
+    avi_parser_t avi = {0};
+
+    if (indices == NULL || lut == NULL || strips == NULL || fb == NULL) {
+        ESP_LOGE(TAG, "Out of memory");
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Palette benchmark (240x240)");
+
+    for (int i = 0; i < PAL8_COLORS; i++) lut[i] = bench_rand(&seed);
+    for (uint32_t i = 0; i < pixels; i++) indices[i] = bench_rand(&seed);
+
+    uint64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < frames; i++) {
+        pal8_expand(indices, lut, fb->buffer, pixels);
+    }
+    uint32_t expand_us = (esp_timer_get_time() - t0) / frames;
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < frames; i++) {
+        memcpy(fb->buffer, indices, pixels);
+        memcpy((uint8_t *)fb->buffer + pixels, indices, pixels);
+    }
+    uint32_t copy_us = (esp_timer_get_time() - t0) / frames;
+
+    ESP_LOGI(TAG, "  LUT expand: %luus/frame (%.1f Mpixel/s), RGB565 memcpy: %luus",
+             expand_us, expand_us ? pixels / (float)expand_us : 0.0f, copy_us);
+    ESP_LOGI(TAG, "  frame memory: %lu bytes indices + %d strips vs %lu bytes RGB565 x2",
+             pixels, 2 * 240 * BENCH_PAL8_STRIP_ROWS * 2, pixels * 2 * 2);
+
+    if (avi_parser_open(&avi, BENCH_PAL8_PATH) != ESP_OK) {
+        ESP_LOGW(TAG, "  file skipped (no %s)", BENCH_PAL8_PATH);
+        goto cleanup;
+    }
+
+    uint16_t width = avi.video_info.width;
+    uint16_t height = avi.video_info.height;
+    if (width > 240 || height > 240) {
+        ESP_LOGE(TAG, "Frame too large");
+        goto cleanup;
+    }
+
+    uint16_t x0 = (display_get_width() - width) / 2;
+    uint16_t y0 = (display_get_height() - height) / 2;
+    uint64_t decode_us = 0, push_us = 0, bytes = 0;
+    bool dma_pending = false;
+    int shown = 0, n = 0;
+
+    for (int i = 0; i < frames; i++) {
+        mjpeg_frame_t frame;
+        if (avi_parser_read_video_frame(&avi, &frame) != ESP_OK) break;
+
+        t0 = esp_timer_get_time();
+        esp_err_t ret = pal8_decode(frame.data, frame.size, lut, indices, (uint32_t)width * height, NULL);
+        uint64_t t1 = esp_timer_get_time();
+        bytes += frame.size;
+        avi_parser_free_frame(&frame);
+        if (ret != ESP_OK) continue;
+
+        for (uint16_t y = 0; y < height; y += BENCH_PAL8_STRIP_ROWS, n ^= 1) {
+            frame_buffer_t strip = {
+                .buffer = &strips[n * 240 * BENCH_PAL8_STRIP_ROWS],
+                .width = width,
+                .height = (height - y < BENCH_PAL8_STRIP_ROWS) ? height - y : BENCH_PAL8_STRIP_ROWS,
+                .format = DISPLAY_FORMAT_RGB565,
+            };
+            pal8_expand(&indices[(uint32_t)y * width], lut, strip.buffer, (uint32_t)width * strip.height);
+            if (dma_pending) display_wait_dma();
+            dma_pending = (display_write_strip_dma(&strip, x0, y0 + y) == ESP_OK);
+        }
+
+        decode_us += t1 - t0;
+        push_us += esp_timer_get_time() - t1;
+        shown++;
+    }
+    if (dma_pending) display_wait_dma();
+
+    if (shown > 0) {
+        ESP_LOGI(TAG, "  file: %llu bytes/frame, LZ4 %lluus, expand + push %lluus per frame",
+                 bytes / shown, decode_us / shown, push_us / shown);
+    }
+
+cleanup:
+    avi_parser_close(&avi);
+    display_free_frame_buffer(fb);
+    heap_caps_free(strips);
+    heap_caps_free(lut);
+    heap_caps_free(indices);
+}
+
+/**
+ * Color kernels: Mpixel/s per chroma layout and output format, specialized
+ * vs the generic per-pixel path, over a 240x240 frame of random MCUs
+ */
+void bench_color(void)
+{
+    const int frames = 20;
+    static const jpeg_layout_t layouts[] = {
+        JPEG_LAYOUT_GRAY, JPEG_LAYOUT_444, JPEG_LAYOUT_422, JPEG_LAYOUT_420,
+    };
+    static uint8_t blocks[6][64];
+    uint32_t seed = 1;
+
+    uint8_t *out = heap_caps_malloc(240 * 240 * 2, MALLOC_CAP_8BIT);
+    if (out == NULL) {
+        ESP_LOGE(TAG, "Out of memory");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Color kernel benchmark (240x240, 1/1 scale)");
+
+    for (int b = 0; b < 6; b++) {
+        for (int i = 0; i < 64; i++) blocks[b][i] = bench_rand(&seed);
+    }
+
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        jpeg_mcu_t mcu = {
+            .blocks = (const uint8_t (*)[64])blocks,
+            .n = 8,
+            .h = (layouts[l] == JPEG_LAYOUT_422 || layouts[l] == JPEG_LAYOUT_420) ? 2 : 1,
+            .v = (layouts[l] == JPEG_LAYOUT_420) ? 2 : 1,
+            .gray = (layouts[l] == JPEG_LAYOUT_GRAY),
+        };
+        int mcu_w = mcu.h * 8;
+        int mcu_h = mcu.v * 8;
+
+        for (int f = 0; f < 2; f++) {
+            uint32_t stride = f ? 240 * 3 / 2 : 240 * 2;
+            uint32_t mcu_bytes = f ? mcu_w * 3 / 2 : mcu_w * 2;
+            uint32_t us[2];
+
+            for (int k = 0; k < 2; k++) {
+                jpeg_color_kernel_t kernel = k ? jpeg_color_get_generic(f)
+                                               : jpeg_color_get_kernel(layouts[l], f, 8);
+                uint64_t t0 = esp_timer_get_time();
+                for (int i = 0; i < frames; i++) {
+                    for (int oy = 0; oy < 240; oy += mcu_h) {
+                        for (int ox = 0; ox < 240; ox += mcu_w) {
+                            kernel(&mcu, out + oy * stride + (ox / mcu_w) * mcu_bytes, stride, ox, oy);
+                        }
+                    }
+                }
+                us[k] = (esp_timer_get_time() - t0) / frames;
+            }
+
+            ESP_LOGI(TAG, "  %-6s %s: %luus/frame (%.1f Mpixel/s), generic %luus (%.1f Mpixel/s)",
+                     jpeg_color_layout_name(layouts[l]), f ? "RGB444" : "RGB565",
+                     us[0], us[0] ? 240 * 240 / (float)us[0] : 0.0f,
+                     us[1], us[1] ? 240 * 240 / (float)us[1] : 0.0f);
+        }
+    }
+
+    heap_caps_free(out);
+}
+
+/**
+ * Sparse IDCT: block class histogram over the benchmark episode, then the
+ * software decode time with and without sparse dispatch
+ */
+void bench_sparse_idct(void)
+{
+    const int frames = 60;
+    static const char *class_names[JPEG_BLOCK_CLASS_COUNT] = {"DC", "2x2", "4x4", "full"};
+    uint32_t avg_us[2] = {0};
+    jpeg_sw_stats_t stats = {0};
+
+    avi_parser_t avi;
+    if (avi_parser_open(&avi, BENCH_VIDEO_PATH) != ESP_OK) {
+        ESP_LOGW(TAG, "Sparse IDCT benchmark skipped (no %s)", BENCH_VIDEO_PATH);
+        return;
+    }
+
+    jpeg_sw_t *jpeg = jpeg_sw_create();
+    uint16_t *output = malloc(240 * 240 * sizeof(uint16_t));
+    if (jpeg == NULL || output == NULL) {
+        ESP_LOGE(TAG, "Out of memory");
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Sparse IDCT benchmark (%d frames, software decoder, 1/1)", frames);
+
+    // Pass 0 with sparse dispatch (and block statistics), pass 1 full IDCT only
+    for (int pass = 0; pass < 2; pass++) {
+        jpeg_sw_set_sparse_idct(jpeg, pass == 0);
+        avi_parser_seek(&avi, 0);
+
+        uint64_t total = 0;
+        int decoded = 0;
+        for (int i = 0; i < frames; i++) {
+            mjpeg_frame_t frame;
+            if (avi_parser_read_video_frame(&avi, &frame) != ESP_OK) break;
+
+            uint64_t t0 = esp_timer_get_time();
+            if (jpeg_sw_decode(jpeg, frame.data, frame.size, JPEG_SCALE_1_1, output,
+                               240 * 240, NULL, NULL) == ESP_OK) {
+                total += esp_timer_get_time() - t0;
+                decoded++;
+            }
+            avi_parser_free_frame(&frame);
+        }
+        avg_us[pass] = decoded ? total / decoded : 0;
+
+        if (pass == 0) {
+            jpeg_sw_get_stats(jpeg, &stats);
+        }
+    }
+
+    uint32_t blocks = 0;
+    for (int c = 0; c < JPEG_BLOCK_CLASS_COUNT; c++) blocks += stats.blocks[c];
+    for (int c = 0; c < JPEG_BLOCK_CLASS_COUNT; c++) {
+        ESP_LOGI(TAG, "  %-4s %8lu blocks (%.1f%%)", class_names[c], stats.blocks[c],
+                 blocks ? 100.0f * stats.blocks[c] / blocks : 0.0f);
+    }
+    ESP_LOGI(TAG, "  decode: full IDCT %luus, sparse %luus (%.2fx)", avg_us[1], avg_us[0],
+             avg_us[0] ? (float)avg_us[1] / avg_us[0] : 0.0f);
+
+cleanup:
+    free(output);
+    jpeg_sw_destroy(jpeg);
+    avi_parser_close(&avi);
+}
+
+/**
+ * Hot code placement: each frame is decoded right after its SD read (the
+ * read path has just run through the flash cache) and again at once with a
+ * warm cache, with the PC profiler on this core. The cold/warm gap is the
+ * cache refill cost; build with and without CONFIG_WATCHMAN_HOT_CODE_IN_IRAM
+ * to compare the fps lines.
+ */
+void bench_hot_code(void)
+{
+    const int frames = 90;
+    uint64_t read_us = 0, cold_us = 0, warm_us = 0;
+    int decoded = 0;
+
+    avi_parser_t avi;
+    if (avi_parser_open(&avi, BENCH_VIDEO_PATH) != ESP_OK) {
+        ESP_LOGW(TAG, "Hot code benchmark skipped (no %s)", BENCH_VIDEO_PATH);
+        return;
+    }
+
+    jpeg_sw_t *jpeg = jpeg_sw_create();
+    uint16_t *output = malloc(240 * 240 * sizeof(uint16_t));
+    if (jpeg == NULL || output == NULL) {
+        ESP_LOGE(TAG, "Out of memory");
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Hot code benchmark (%d frames, software decoder, 1/1)", frames);
+    if (pc_profiler_start(xPortGetCoreID()) != ESP_OK) {
+        ESP_LOGW(TAG, "  PC profiler unavailable, timing only");
+    }
+
+    for (int i = 0; i < frames; i++) {
+        mjpeg_frame_t frame;
+
+        uint64_t t0 = esp_timer_get_time();
+        if (avi_parser_read_video_frame(&avi, &frame) != ESP_OK) break;
+        uint64_t t1 = esp_timer_get_time();
+        esp_err_t ret = jpeg_sw_decode(jpeg, frame.data, frame.size, JPEG_SCALE_1_1, output,
+                                       240 * 240, NULL, NULL);
+        uint64_t t2 = esp_timer_get_time();
+        jpeg_sw_decode(jpeg, frame.data, frame.size, JPEG_SCALE_1_1, output, 240 * 240, NULL, NULL);
+        uint64_t t3 = esp_timer_get_time();
+
+        if (ret == ESP_OK) {
+            read_us += t1 - t0;
+            cold_us += t2 - t1;
+            warm_us += t3 - t2;
+            decoded++;
+        }
+        avi_parser_free_frame(&frame);
+    }
+
+    if (decoded > 0) {
+        float fps = decoded * 1e6f / (read_us + cold_us);
+
+        ESP_LOGI(TAG, "  decode after SD read %lluus, warm %lluus (+%.1f%% cache refill)",
+                 cold_us / decoded, warm_us / decoded,
+                 warm_us ? 100.0f * ((float)cold_us - warm_us) / warm_us : 0.0f);
+        ESP_LOGI(TAG, "  read + decode %.1f fps", fps);
+        pc_profiler_log_report(fps);
+    }
+    pc_profiler_stop();
+
+cleanup:
+    free(output);
+    jpeg_sw_destroy(jpeg);
+    avi_parser_close(&avi);
+}
+
+/**
+ * Time one SIMD kernel over its workload; returns microseconds
+ */
+static uint32_t bench_simd_kernel(int kernel, uint8_t *a, uint8_t *b)
+{
+    uint64_t t0 = esp_timer_get_time();
+
+    switch (kernel) {
+        case 0:     // 100 x 1024 stereo frames of volume scaling
+            for (int i = 0; i < 100; i++) simd_scale_s16((int16_t *)a, 2048, 26214);
+            break;
+        case 1:     // 20 x 240x240 RGB565 frame compare (identical, so no early exit)
+            for (int i = 0; i < 20; i++) simd_equal(a, b, 240 * 240 * 2);
+            break;
+        case 2:     // 240x240 of 4:2:0 rows
+            for (int i = 0; i < 240 * 30; i++) {
+                simd_ycc_row8_rgb565(a, a + 64, a + 128, SIMD_CHROMA_HALF, b + (i % 64) * 16);
+            }
+            break;
+        case 3:     // 900 blocks, one 240x240 luma plane
+            for (int i = 0; i < 900; i++) simd_idct_8x8((const int32_t *)a, b);
+            break;
+    }
+    return esp_timer_get_time() - t0;
+}
+
+/**
+ * PIE kernels: each kernel scalar vs PIE, then the software decode of the
+ * benchmark episode with PIE off and on (S3 only)
+ */
+void bench_simd(void)
+{
+    static const char *names[] = {"volume", "frame compare", "YCbCr->RGB565", "IDCT 8x8"};
+    const int frames = 60;
+    uint32_t seed = 1;
+
+    if (!simd_available()) {
+        ESP_LOGW(TAG, "SIMD benchmark skipped (no PIE, or its self-test failed)");
+        return;
+    }
+
+    uint8_t *a = heap_caps_aligned_alloc(16, 240 * 240 * 2, MALLOC_CAP_8BIT);
+    uint8_t *b = heap_caps_aligned_alloc(16, 240 * 240 * 2, MALLOC_CAP_8BIT);
+    if (a == NULL || b == NULL) {
+        ESP_LOGE(TAG, "Out of memory");
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "SIMD benchmark (scalar vs PIE)");
+
+    for (int k = 0; k < 4; k++) {
+        uint32_t us[2];
+
+        for (int pie = 0; pie < 2; pie++) {
+            for (int i = 0; i < 240 * 240 * 2; i++) a[i] = bench_rand(&seed);
+            if (k == 1) memcpy(b, a, 240 * 240 * 2);
+            if (k == 3) {
+                // Small coefficients, well inside SIMD_IDCT_MAX_ABS_SUM
+                int32_t *coef = (int32_t *)a;
+                for (int i = 0; i < 64; i++) coef[i] = (int32_t)(bench_rand(&seed) % 129) - 64;
+            }
+            simd_set_enabled(pie);
+            us[pie] = bench_simd_kernel(k, a, b);
+        }
+        ESP_LOGI(TAG, "  %-14s scalar %6luus, PIE %6luus (%.2fx)", names[k], us[0], us[1],
+                 us[1] ? (float)us[0] / us[1] : 0.0f);
+    }
+
+    avi_parser_t avi;
+    if (avi_parser_open(&avi, BENCH_VIDEO_PATH) != ESP_OK) {
+        ESP_LOGW(TAG, "  decode skipped (no %s)", BENCH_VIDEO_PATH);
+        goto cleanup;
+    }
+
+    jpeg_sw_t *jpeg = jpeg_sw_create();
+    uint32_t avg_us[2] = {0};
+
+    for (int pie = 0; jpeg != NULL && pie < 2; pie++) {
+        uint64_t total = 0;
+        int decoded = 0;
+
+        simd_set_enabled(pie);
+        avi_parser_seek(&avi, 0);
+        for (int i = 0; i < frames; i++) {
+            mjpeg_frame_t frame;
+            if (avi_parser_read_video_frame(&avi, &frame) != ESP_OK) break;
+
+            uint64_t t0 = esp_timer_get_time();
+            if (jpeg_sw_decode(jpeg, frame.data, frame.size, JPEG_SCALE_1_1, (uint16_t *)a,
+                               240 * 240, NULL, NULL) == ESP_OK) {
+                total += esp_timer_get_time() - t0;
+                decoded++;
+            }
+            avi_parser_free_frame(&frame);
+        }
+        avg_us[pie] = decoded ? total / decoded : 0;
+    }
+    ESP_LOGI(TAG, "  decode: scalar %luus, PIE %luus (%.2fx)", avg_us[0], avg_us[1],
+             avg_us[1] ? (float)avg_us[0] / avg_us[1] : 0.0f);
+
+    jpeg_sw_destroy(jpeg);
+    avi_parser_close(&avi);
+
+cleanup:
+    simd_set_enabled(true);
+    heap_caps_free(a);
+    heap_caps_free(b);
+}
+
+/**
+ * Average battery voltage over one phase, sampled once a second
+ */
+static uint32_t bench_power_phase(power_manager_t *pm)
+{
+    uint32_t sum = 0;
+
+    for (int i = 0; i < BENCH_POWER_PHASE_SEC; i++) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        sum += power_manager_read_battery_voltage(pm);
+    }
+    return sum / BENCH_POWER_PHASE_SEC;
+}
+
+/**
+ * Radio mode vs video playback
+ * Video plays at 240 MHz with the panel lit; radio streams a WAV at 80 MHz
+ * with the panel asleep. The board has no current sensor, so each phase is
+ * bracketed by log lines for an inline USB meter, and battery sag and the
+ * radio pipeline's CPU duty stand in for current draw.
+ */
+void bench_radio(void)
+{
+    audio_player_t *audio = audio_player_init(NULL);
+    power_manager_t *pm = power_manager_init(NULL);
+    radio_player_t *radio = audio ? radio_player_create(audio, NULL, NULL) : NULL;
+    video_player_t *video = video_player_create(NULL, NULL);
+
+    if (radio == NULL || pm == NULL || video == NULL) {
+        ESP_LOGE(TAG, "Radio benchmark init failed");
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Radio benchmark (%d s per phase, meter current during each)", BENCH_POWER_PHASE_SEC);
+
+    uint32_t video_mv = 0;
+    if (video_player_open(video, BENCH_VIDEO_PATH) == ESP_OK && video_player_play(video) == ESP_OK) {
+        ESP_LOGI(TAG, "  >>> video phase start");
+        video_mv = bench_power_phase(pm);
+        ESP_LOGI(TAG, "  <<< video phase end");
+        video_player_stop(video);
+        video_player_close(video);
+    } else {
+        ESP_LOGW(TAG, "  video phase skipped (no %s)", BENCH_VIDEO_PATH);
+    }
+
+    if (radio_player_open(radio, BENCH_RADIO_PATH) != ESP_OK) {
+        ESP_LOGW(TAG, "  radio phase skipped (no %s)", BENCH_RADIO_PATH);
+        goto cleanup;
+    }
+
+    display_sleep();
+    esp_err_t pm_ret = power_manager_set_profile(pm, POWER_PROFILE_AUDIO);
+
+    radio_stats_t stats;
+    uint32_t radio_mv = 0;
+    if (radio_player_play(radio) == ESP_OK) {
+        ESP_LOGI(TAG, "  >>> radio phase start");
+        radio_mv = bench_power_phase(pm);
+        ESP_LOGI(TAG, "  <<< radio phase end");
+    }
+    radio_player_get_stats(radio, &stats);
+    radio_player_stop(radio);
+
+    power_manager_set_profile(pm, POWER_PROFILE_VIDEO);
+    display_wake();
+
+    ESP_LOGI(TAG, "  %-6s %8s %6s %9s %10s", "mode", "CPU MHz", "panel", "CPU duty", "battery mV");
+    ESP_LOGI(TAG, "  %-6s %8d %6s %9s %10lu", "video", POWER_VIDEO_CPU_MHZ, "on", "(codecs)", video_mv);
+    ESP_LOGI(TAG, "  %-6s %8d %6s %8.1f%% %10lu", "radio",
+             pm_ret == ESP_OK ? POWER_AUDIO_CPU_MHZ : POWER_VIDEO_CPU_MHZ, "asleep",
+             stats.audio_us ? stats.busy_us * 100.0f / stats.audio_us : 0.0f, radio_mv);
+
+cleanup:
+    video_player_destroy(video);
+    radio_player_destroy(radio);
+    power_manager_deinit(pm);
+    audio_player_deinit(audio);
+}
+
+/**
+ * Run all benchmarks
+ */
+void run_benchmarks(void)
+{
+    ESP_LOGI(TAG, "========================================");
+    ESP_LOGI(TAG, "  Performance Benchmarks");
+    ESP_LOGI(TAG, "========================================");
+
+    // Display owns the shared SPI bus, so it must come up first
+    if (display_init(NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "Display init failed");
+        return;
+    }
+
+    if (sd_card_init(&g_bench_sd) != ESP_OK) {
+        ESP_LOGE(TAG, "SD card required for benchmarks");
+        return;
+    }
+
+    bench_frame_index();
+    bench_trick_play();
+    bench_time_stretch();
+    bench_panel_format();
+    bench_codecs();
+    bench_replenish();
+    bench_palette();
+    bench_color();
+    bench_sparse_idct();
+    bench_simd();
+    bench_hot_code();
+    bench_radio();
+
+    ESP_LOGI(TAG, "Benchmarks complete");
+}
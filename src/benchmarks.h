@@ -0,0 +1,34 @@
+/**
+ * Performance Benchmarks
+ * On-target measurements for playback pipeline components
+ * Requires display wiring and a mounted SD card
+ */
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <stdint.h>
+
+/**
+ * Run all benchmarks once and print results
+ * Initializes display and SD card itself
+ */
+void run_benchmarks(void);
+
+/**
+ * Individual benchmarks
+ */
+void bench_frame_index(void);      // Sparse index RAM use and seek time (10 min, 1 h, 3 h)
+void bench_trick_play(void);       // Scaled decode cost and 1x vs 16x CPU budget
+void bench_time_stretch(void);     // WSOLA cycles per second of audio at 1.25x-2x
+void bench_panel_format(void);     // RGB565 vs RGB444: SPI bytes, frame time, max fps
+void bench_codecs(void);           // MJPEG vs LZ565: CPU per frame, SD MB/s, CPU duty
+void bench_replenish(void);        // MJPEG vs CRB: decode ms, SPI bytes per frame, file size
+void bench_palette(void);          // PAL8: LUT expansion Mpixel/s, strip pipeline per frame
+void bench_color(void);            // JPEG color kernels: Mpixel/s per chroma layout vs generic
+void bench_sparse_idct(void);      // Block class histogram (DC/2x2/4x4/full) and decode speedup
+void bench_simd(void);             // PIE vs scalar per kernel and for the software JPEG decode
+void bench_hot_code(void);         // Decode after SD read vs warm cache, IRAM use, PC profile
+void bench_radio(void);            // Radio vs video playback: CPU duty, battery sag, meter markers
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,212 @@
+/**
+ * Serial Command Console Implementation
+ */
+
+#include "console.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+#include "driver/usb_serial_jtag.h"
+#include "esp_vfs_usb_serial_jtag.h"
+#define PORT_NAME               "USB Serial/JTAG"
+#elif CONFIG_ESP_CONSOLE_UART
+#include "driver/uart.h"
+#include "esp_vfs_dev.h"
+#define PORT_NAME               "UART"
+#endif
+
+static const char *TAG = "CONSOLE";
+
+#define UART_RX_BUFFER_SIZE     256
+
+static const console_command_t *g_commands;
+static int g_command_count;
+static TaskHandle_t g_task = NULL;
+
+static StaticTask_t g_task_buf;
+static StackType_t g_task_stack[CONSOLE_TASK_STACK_SIZE];
+static char g_line[CONSOLE_LINE_MAX];
+static char g_out[CONSOLE_OUT_MAX];
+
+/**
+ * Print to console
+ */
+void console_printf(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int n = vsnprintf(g_out, sizeof(g_out), fmt, args);
+    va_end(args);
+
+    if (n < 0) return;
+    if (n >= (int)sizeof(g_out)) n = sizeof(g_out) - 1;
+    write(STDOUT_FILENO, g_out, n);
+}
+
+/**
+ * Install the driver for the console port so stdin reads block
+ */
+static esp_err_t open_port(void)
+{
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    usb_serial_jtag_driver_config_t cfg = USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT();
+    esp_err_t ret = usb_serial_jtag_driver_install(&cfg);
+    if (ret != ESP_OK) return ret;
+    esp_vfs_usb_serial_jtag_use_driver();
+    return ESP_OK;
+#elif CONFIG_ESP_CONSOLE_UART
+    esp_err_t ret = uart_driver_install(CONFIG_ESP_CONSOLE_UART_NUM, UART_RX_BUFFER_SIZE, 0, 0, NULL, 0);
+    if (ret != ESP_OK) return ret;
+    esp_vfs_dev_uart_use_driver(CONFIG_ESP_CONSOLE_UART_NUM);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * Read a line with echo and backspace
+ *
+ * @return Line length
+ */
+static int read_line(void)
+{
+    int len = 0;
+
+    while (1) {
+        char c;
+        if (read(STDIN_FILENO, &c, 1) != 1) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+            continue;
+        }
+
+        if (c == '\r' || c == '\n') {
+            if (len == 0) continue;     // CR LF, or an empty line
+            write(STDOUT_FILENO, "\n", 1);
+            g_line[len] = '\0';
+            return len;
+        }
+        if (c == '\b' || c == 0x7F) {
+            if (len > 0) {
+                len--;
+                write(STDOUT_FILENO, "\b \b", 3);
+            }
+            continue;
+        }
+        if (c < ' ' || len >= CONSOLE_LINE_MAX - 1) continue;
+
+        g_line[len++] = c;
+        write(STDOUT_FILENO, &c, 1);
+    }
+}
+
+/**
+ * Split the line into words in place
+ */
+static int split_line(char **argv)
+{
+    int argc = 0;
+    char *p = g_line;
+
+    while (*p && argc < CONSOLE_MAX_ARGS) {
+        while (*p == ' ' || *p == '\t') *p++ = '\0';
+        if (*p == '\0') break;
+
+        argv[argc++] = p;
+        while (*p && *p != ' ' && *p != '\t') p++;
+    }
+
+    return argc;
+}
+
+static void print_help(void)
+{
+    console_printf("  %-24s %s\n", "help", "List commands");
+    for (int i = 0; i < g_command_count; i++) {
+        char name[32];
+        const console_command_t *cmd = &g_commands[i];
+
+        snprintf(name, sizeof(name), "%s %s", cmd->name, cmd->usage ? cmd->usage : "");
+        console_printf("  %-24s %s\n", name, cmd->help);
+    }
+}
+
+/**
+ * Run one command line
+ */
+static void run_line(void)
+{
+    char *argv[CONSOLE_MAX_ARGS];
+    int argc = split_line(argv);
+    if (argc == 0) return;
+
+    if (strcmp(argv[0], "help") == 0) {
+        print_help();
+        return;
+    }
+
+    for (int i = 0; i < g_command_count; i++) {
+        const console_command_t *cmd = &g_commands[i];
+        if (strcmp(argv[0], cmd->name) != 0) continue;
+
+        esp_err_t ret = cmd->handler(argc, argv);
+        if (ret == ESP_ERR_INVALID_ARG) {
+            console_printf("usage: %s %s\n", cmd->name, cmd->usage ? cmd->usage : "");
+        } else if (ret != ESP_OK) {
+            console_printf("%s: %s\n", cmd->name, esp_err_to_name(ret));
+        }
+        return;
+    }
+
+    console_printf("unknown command '%s' (help lists them)\n", argv[0]);
+}
+
+/**
+ * Console task
+ */
+static void console_task(void *arg)
+{
+    console_printf("\nConsole ready, 'help' lists commands\n");
+
+    while (1) {
+        console_printf("> ");
+        read_line();
+        run_line();
+    }
+}
+
+/**
+ * Start console
+ */
+esp_err_t console_start(const console_command_t *commands, int count)
+{
+    if (g_task != NULL) return ESP_ERR_INVALID_STATE;
+    if (commands == NULL && count > 0) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = open_port();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Console port unavailable: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    g_commands = commands;
+    g_command_count = count;
+
+    g_task = xTaskCreateStaticPinnedToCore(console_task, "console", CONSOLE_TASK_STACK_SIZE, NULL,
+                                           CONSOLE_TASK_PRIORITY, g_task_stack, &g_task_buf,
+                                           CONSOLE_TASK_CORE);
+
+#ifdef PORT_NAME
+    ESP_LOGI(TAG, "Console on " PORT_NAME);
+#endif
+
+    return ESP_OK;
+}
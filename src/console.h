@@ -0,0 +1,66 @@
+/**
+ * Serial Command Console
+ * Line-based commands on the monitor UART or USB Serial/JTAG port
+ *
+ * Runs as a priority 1 task on core 1 with a static stack, reads one line
+ * at a time into a static buffer and splits it in place, so nothing is
+ * allocated once it has started and playback (core 0, priority 10+) never
+ * waits on it. Output is formatted into a static buffer and written
+ * straight to the console file descriptor; floating point conversions are
+ * not used, since newlib allocates for them.
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define CONSOLE_LINE_MAX        96      // Longest command line
+#define CONSOLE_MAX_ARGS        8       // Words per line, command included
+#define CONSOLE_OUT_MAX         160     // Longest output line
+#define CONSOLE_TASK_STACK_SIZE 6144    // Benchmarks run on the console task
+#define CONSOLE_TASK_PRIORITY   1
+#define CONSOLE_TASK_CORE       1       // Away from the decode core
+
+/**
+ * Command handler
+ *
+ * @param argc Number of words, command included
+ * @param argv Words, split in place in the line buffer
+ * @return ESP_OK, ESP_ERR_INVALID_ARG to print the command's usage, or an
+ *         error to report
+ */
+typedef esp_err_t (*console_handler_t)(int argc, char **argv);
+
+/**
+ * Command table entry
+ */
+typedef struct {
+    const char *name;
+    const char *usage;          // Arguments, for help (NULL if none)
+    const char *help;           // One line
+    console_handler_t handler;
+} console_command_t;
+
+/**
+ * Start the console task
+ * "help" is built in and lists the table
+ *
+ * @param commands Command table, must stay valid
+ * @param count Number of commands
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the console port is
+ *         neither a UART nor USB Serial/JTAG, ESP_ERR_INVALID_STATE if running
+ */
+esp_err_t console_start(const console_command_t *commands, int count);
+
+/**
+ * Print to the console (no floating point conversions)
+ * For command handlers, which all run on the console task; lines longer
+ * than CONSOLE_OUT_MAX are truncated
+ *
+ * @param fmt printf format
+ */
+void console_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#endif // CONSOLE_H
@@ -0,0 +1,417 @@
+/**
+ * Display Throughput Benchmarks Implementation
+ */
+
+#include "display_bench.h"
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+
+static const char *TAG = "DBENCH";
+
+#define FRAME_SIZE      240     // Video frame, centered on the panel
+#define WINDOW_CALLS    500
+#define FRAME_PUSHES    20
+#define PARTIAL_PUSHES  50
+#define STRIP_ROWS      16      // PAL8 strip height
+
+// Window set: CASET + 4, RASET + 4, RAMWR, then one RGB565 pixel
+#define WINDOW_BYTES    (1 + 4 + 1 + 4 + 1 + 2)
+
+/**
+ * Allocate a frame buffer filled with a big-endian RGB565 gradient
+ */
+static frame_buffer_t *alloc_gradient(uint16_t width, uint16_t height)
+{
+    frame_buffer_t *fb = display_alloc_frame_buffer(width, height);
+    if (fb == NULL) {
+        ESP_LOGE(TAG, "Out of memory for %ux%u frame", width, height);
+        return NULL;
+    }
+
+    fb->format = DISPLAY_FORMAT_RGB565;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint16_t c = RGB565(x, y, 255 - x);
+            fb->buffer[y * width + x] = (c >> 8) | (c << 8);
+        }
+    }
+
+    return fb;
+}
+
+/**
+ * Share of the ideal wire time (bytes x 8 at the actual SPI clock), percent
+ */
+static uint32_t wire_percent(uint32_t bytes, uint32_t us)
+{
+    int hz = display_get_spi_clock(NULL);
+    if (hz <= 0 || us == 0) return 0;
+
+    return (uint32_t)((uint64_t)bytes * 8 * 1000000 * 100 / hz / us);
+}
+
+static void print_header(void)
+{
+    ESP_LOGI(TAG, "  %-18s %8s %9s %7s %6s", "push", "bytes", "us", "MB/s", "wire");
+}
+
+/** One table row; bytes per µs is MB/s */
+static void print_row(const char *name, uint32_t bytes, uint32_t us)
+{
+    ESP_LOGI(TAG, "  %-18s %8lu %9lu %7.2f %5lu%%", name, bytes, us,
+             us ? (float)bytes / us : 0.0f, wire_percent(bytes, us));
+}
+
+/**
+ * Command overhead per window set
+ * A one-pixel push is all window set: five polled transactions and their
+ * D/C toggles, against 13 bytes on the wire
+ */
+void display_bench_window(void)
+{
+    ESP_LOGI(TAG, "Window set overhead (%d calls)", WINDOW_CALLS);
+    print_header();
+
+    uint64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < WINDOW_CALLS; i++) {
+        display_draw_pixel(i % FRAME_SIZE, i / FRAME_SIZE, COLOR_WHITE);
+    }
+    uint32_t poll_us = (esp_timer_get_time() - t0) / WINDOW_CALLS;
+    print_row("1x1 polling", WINDOW_BYTES, poll_us);
+
+    frame_buffer_t *fb = alloc_gradient(2, 2);
+    if (fb == NULL) return;
+
+    // Same window set, pixel queued for DMA and waited for
+    frame_buffer_t pixel = *fb;
+    pixel.width = 1;
+    pixel.height = 1;
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < WINDOW_CALLS; i++) {
+        if (display_write_strip_dma(&pixel, i % FRAME_SIZE, i / FRAME_SIZE) == ESP_OK) {
+            display_wait_dma();
+        }
+    }
+    uint32_t dma_us = (esp_timer_get_time() - t0) / WINDOW_CALLS;
+    print_row("1x1 DMA", WINDOW_BYTES, dma_us);
+
+    display_free_frame_buffer(fb);
+}
+
+/**
+ * Full frame: polling vs DMA push, and the panel formats
+ */
+void display_bench_frame(void)
+{
+    frame_buffer_t *fb = alloc_gradient(FRAME_SIZE, FRAME_SIZE);
+    if (fb == NULL) return;
+
+    uint16_t x = (display_get_width() - FRAME_SIZE) / 2;
+    uint16_t y = (display_get_height() - FRAME_SIZE) / 2;
+    uint32_t bytes = display_frame_bytes(fb);
+
+    ESP_LOGI(TAG, "Full frame %dx%d (%d pushes)", FRAME_SIZE, FRAME_SIZE, FRAME_PUSHES);
+    print_header();
+
+    uint64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < FRAME_PUSHES; i++) {
+        display_write_buffer(x, y, FRAME_SIZE, FRAME_SIZE, fb->buffer);
+    }
+    print_row("RGB565 polling", bytes, (esp_timer_get_time() - t0) / FRAME_PUSHES);
+
+    // DMA: the CPU is only busy for the submit, the rest overlaps decode
+    uint64_t submit = 0;
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < FRAME_PUSHES; i++) {
+        uint64_t s0 = esp_timer_get_time();
+        esp_err_t ret = display_write_frame_dma(fb);
+        submit += esp_timer_get_time() - s0;
+        if (ret == ESP_OK) {
+            display_wait_dma();
+        }
+    }
+    uint32_t frame_us = (esp_timer_get_time() - t0) / FRAME_PUSHES;
+    print_row("RGB565 DMA", bytes, frame_us);
+    ESP_LOGI(TAG, "  %-18s %8s %9lu", "  DMA submit (CPU)", "", (uint32_t)(submit / FRAME_PUSHES));
+
+    if (display_pack_rgb444(fb) == ESP_OK) {
+        bytes = display_frame_bytes(fb);
+        t0 = esp_timer_get_time();
+        for (int i = 0; i < FRAME_PUSHES; i++) {
+            if (display_write_frame_dma(fb) == ESP_OK) {
+                display_wait_dma();
+            }
+        }
+        uint32_t packed_us = (esp_timer_get_time() - t0) / FRAME_PUSHES;
+        print_row("RGB444 DMA", bytes, packed_us);
+
+        // Push time alone bounds playback, whatever the decoder manages
+        ESP_LOGI(TAG, "  fps ceiling at %d kHz: %.1f RGB565, %.1f RGB444",
+                 display_get_spi_clock(NULL) / 1000, frame_us ? 1000000.0f / frame_us : 0.0f,
+                 packed_us ? 1000000.0f / packed_us : 0.0f);
+    }
+
+    display_free_frame_buffer(fb);
+}
+
+/**
+ * Fill rates: one color from a 1024-pixel polled chunk
+ */
+void display_bench_fill(void)
+{
+    static const struct {
+        const char *name;
+        uint16_t w;
+        uint16_t h;
+    } rects[] = {
+        {"fill 16x16", 16, 16},
+        {"fill 120x120", 120, 120},
+        {"fill 240x240", 240, 240},
+    };
+
+    ESP_LOGI(TAG, "Fill rate (%d fills)", FRAME_PUSHES);
+    print_header();
+
+    uint32_t panel_bytes = (uint32_t)display_get_width() * display_get_height() * 2;
+    uint64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < FRAME_PUSHES; i++) {
+        display_clear((i & 1) ? COLOR_BLACK : COLOR_BLUE);
+    }
+    print_row("clear (panel)", panel_bytes, (esp_timer_get_time() - t0) / FRAME_PUSHES);
+
+    for (int r = 0; r < sizeof(rects) / sizeof(rects[0]); r++) {
+        t0 = esp_timer_get_time();
+        for (int i = 0; i < FRAME_PUSHES; i++) {
+            display_fill_rect(0, 0, rects[r].w, rects[r].h, (i & 1) ? COLOR_RED : COLOR_GREEN);
+        }
+        print_row(rects[r].name, (uint32_t)rects[r].w * rects[r].h * 2,
+                  (esp_timer_get_time() - t0) / FRAME_PUSHES);
+    }
+}
+
+/**
+ * Partial-window DMA pushes, window set included
+ * Small windows are dominated by the window set, which is where
+ * partial-update codecs lose to a full frame
+ */
+void display_bench_partial(void)
+{
+    static const struct {
+        const char *name;
+        uint16_t w;
+        uint16_t h;
+    } windows[] = {
+        {"16x16", 16, 16},
+        {"32x32", 32, 32},
+        {"64x64", 64, 64},
+        {"120x120", 120, 120},
+        {"240x16 (band)", 240, 16},
+        {"240x60 (band)", 240, 60},
+        {"240x120 (band)", 240, 120},
+        {"240x240 (frame)", 240, 240},
+    };
+
+    frame_buffer_t *fb = alloc_gradient(FRAME_SIZE, FRAME_SIZE);
+    if (fb == NULL) return;
+
+    ESP_LOGI(TAG, "Partial window DMA (%d pushes)", PARTIAL_PUSHES);
+    print_header();
+
+    for (int w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        // Timing-only view: reuses the 240-wide buffer with a smaller
+        // width/height, so it pushes the first w*h contiguous pixels rather
+        // than the top-left w x h region. Transfer time depends only on the
+        // byte count and the window setup, not on what is drawn.
+        frame_buffer_t strip = *fb;
+        strip.width = windows[w].w;
+        strip.height = windows[w].h;
+
+        uint64_t t0 = esp_timer_get_time();
+        for (int i = 0; i < PARTIAL_PUSHES; i++) {
+            if (display_write_strip_dma(&strip, 0, 0) == ESP_OK) {
+                display_wait_dma();
+            }
+        }
+        print_row(windows[w].name, display_frame_bytes(&strip),
+                  (esp_timer_get_time() - t0) / PARTIAL_PUSHES);
+    }
+
+    display_free_frame_buffer(fb);
+}
+
+static volatile uint32_t g_strips_done;
+
+/**
+ * Transfer done (SPI interrupt): count it and wake the bench task
+ */
+static bool IRAM_ATTR strip_done(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    g_strips_done++;
+    vTaskNotifyGiveFromISR((TaskHandle_t)arg, &woken);
+    return woken == pdTRUE;
+}
+
+/**
+ * One frame in strips through one window, up to depth strips in flight
+ */
+static void push_strips(const frame_buffer_t *fb, uint16_t x, uint16_t y, int depth)
+{
+    if (display_begin_strips_dma(x, y, fb->width, fb->height, fb->format) != ESP_OK) return;
+
+    uint32_t row_bytes = display_frame_bytes(fb) / fb->height;
+    for (uint16_t r = 0; r < fb->height; r += STRIP_ROWS) {
+        frame_buffer_t strip = *fb;
+        strip.buffer = (uint16_t *)((uint8_t *)fb->buffer + (uint32_t)r * row_bytes);
+        strip.height = (fb->height - r < STRIP_ROWS) ? fb->height - r : STRIP_ROWS;
+
+        while (display_dma_in_flight() >= (uint32_t)depth) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        if (display_queue_strip_dma(&strip) != ESP_OK) break;
+    }
+    display_wait_dma();
+}
+
+/**
+ * Strip pipeline: a window per strip (one in flight) against one window
+ * per frame with 1 to DISPLAY_MAX_IN_FLIGHT strips in flight, completion
+ * through the done callback as in PAL8 playback
+ */
+void display_bench_strips(void)
+{
+    frame_buffer_t *fb = alloc_gradient(FRAME_SIZE, FRAME_SIZE);
+    if (fb == NULL) return;
+
+    uint16_t x = (display_get_width() - FRAME_SIZE) / 2;
+    uint16_t y = (display_get_height() - FRAME_SIZE) / 2;
+    uint32_t bytes = display_frame_bytes(fb);
+    int strips = (FRAME_SIZE + STRIP_ROWS - 1) / STRIP_ROWS;
+
+    ESP_LOGI(TAG, "Strips %dx%d x %d per frame, %s (%d frames)", FRAME_SIZE, STRIP_ROWS, strips,
+             DISPLAY_BACKEND_NAME, FRAME_PUSHES);
+    print_header();
+
+    uint64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < FRAME_PUSHES; i++) {
+        for (uint16_t r = 0; r < FRAME_SIZE; r += STRIP_ROWS) {
+            frame_buffer_t strip = *fb;
+            strip.buffer = &fb->buffer[(uint32_t)r * FRAME_SIZE];
+            strip.height = STRIP_ROWS;
+            if (display_write_strip_dma(&strip, x, y + r) == ESP_OK) {
+                display_wait_dma();
+            }
+        }
+    }
+    print_row("window per strip", bytes, (esp_timer_get_time() - t0) / FRAME_PUSHES);
+
+    display_set_done_callback(strip_done, xTaskGetCurrentTaskHandle());
+    for (int depth = 1; depth <= DISPLAY_MAX_IN_FLIGHT; depth *= 2) {
+        char name[24];
+        snprintf(name, sizeof(name), "%d in flight", depth);
+
+        g_strips_done = 0;
+        t0 = esp_timer_get_time();
+        for (int i = 0; i < FRAME_PUSHES; i++) {
+            push_strips(fb, x, y, depth);
+        }
+        print_row(name, bytes, (esp_timer_get_time() - t0) / FRAME_PUSHES);
+
+        if (g_strips_done != (uint32_t)strips * FRAME_PUSHES) {
+            ESP_LOGW(TAG, "  %lu done callbacks for %d transfers", g_strips_done, strips * FRAME_PUSHES);
+        }
+    }
+    display_set_done_callback(NULL, NULL);
+
+    display_free_frame_buffer(fb);
+}
+
+/**
+ * Full-frame DMA push per SPI clock
+ * With the panel SDO wired each clock is also checked by frame memory
+ * readback ("-" without readback)
+ */
+void display_bench_clock_sweep(void)
+{
+    static const int clocks_mhz[] = {10, 20, 26, 40, 60, 80};
+
+    frame_buffer_t *fb = alloc_gradient(FRAME_SIZE, FRAME_SIZE);
+    if (fb == NULL) return;
+
+    int requested = 0;
+    display_get_spi_clock(&requested);
+    uint32_t bytes = display_frame_bytes(fb);
+
+    ESP_LOGI(TAG, "SPI clock sweep, %dx%d RGB565 DMA (%d pushes)", FRAME_SIZE, FRAME_SIZE, FRAME_PUSHES);
+    ESP_LOGI(TAG, "  %-9s %9s %9s %7s %6s %8s %8s", "requested", "actual", "us", "MB/s", "wire",
+             "max fps", "readback");
+
+    for (int c = 0; c < sizeof(clocks_mhz) / sizeof(clocks_mhz[0]); c++) {
+        esp_err_t ret = display_set_spi_clock(clocks_mhz[c] * 1000000);
+        if (ret != ESP_OK) {
+            ESP_LOGI(TAG, "  %6dMHz  rejected (%s)", clocks_mhz[c], esp_err_to_name(ret));
+            continue;
+        }
+
+        uint64_t t0 = esp_timer_get_time();
+        for (int i = 0; i < FRAME_PUSHES; i++) {
+            if (display_write_frame_dma(fb) == ESP_OK) {
+                display_wait_dma();
+            }
+        }
+        uint32_t us = (esp_timer_get_time() - t0) / FRAME_PUSHES;
+
+        esp_err_t check = display_check_spi_clock(clocks_mhz[c] * 1000000);
+        const char *readback = (check == ESP_OK) ? "ok" :
+                               (check == ESP_ERR_NOT_SUPPORTED) ? "-" : "FAIL";
+
+        ESP_LOGI(TAG, "  %6dMHz %6dkHz %9lu %7.2f %5lu%% %8.1f %8s", clocks_mhz[c],
+                 display_get_spi_clock(NULL) / 1000, us, us ? (float)bytes / us : 0.0f,
+                 wire_percent(bytes, us), us ? 1000000.0f / us : 0.0f, readback);
+    }
+
+    if (display_set_spi_clock(requested) != ESP_OK) {
+        ESP_LOGW(TAG, "Could not restore SPI clock to %d Hz", requested);
+    }
+
+    display_free_frame_buffer(fb);
+}
+
+/**
+ * Run all display benchmarks
+ */
+void run_display_bench(void)
+{
+    ESP_LOGI(TAG, "========================================");
+    ESP_LOGI(TAG, "  Display Throughput Benchmarks");
+    ESP_LOGI(TAG, "  ST7789 %dx%d at %d kHz, %s", display_get_width(), display_get_height(),
+             display_get_spi_clock(NULL) / 1000, DISPLAY_BACKEND_NAME);
+#if CONFIG_WATCHMAN_DISPLAY_PINS_IOMUX
+    ESP_LOGI(TAG, "  IOMUX pins (MOSI %d, CLK %d, MISO %d)", PIN_DISPLAY_MOSI, PIN_DISPLAY_CLK, PIN_DISPLAY_MISO);
+#else
+    ESP_LOGI(TAG, "  GPIO matrix pins (MOSI %d, CLK %d)", PIN_DISPLAY_MOSI, PIN_DISPLAY_CLK);
+#endif
+    ESP_LOGI(TAG, "========================================");
+
+    display_clock_check_t check;
+    display_get_clock_check(&check);
+    if (check.readback) {
+        ESP_LOGI(TAG, "Panel ID %06lX, clock verified by readback at %d kHz (%d tried)",
+                 check.panel_id, check.clock_hz / 1000, check.clocks_tried);
+    }
+
+    display_bench_window();
+    display_bench_frame();
+    display_bench_fill();
+    display_bench_partial();
+    display_bench_strips();
+    display_bench_clock_sweep();
+
+    ESP_LOGI(TAG, "Display benchmarks complete");
+}
@@ -0,0 +1,33 @@
+/**
+ * Display Throughput Benchmarks
+ * Measured ST7789 push costs for hardware bring-up (TEST_MODE)
+ * No SD card or other components required!
+ *
+ * Each section prints a table of µs per operation and MB/s, plus the share
+ * of the ideal wire time (bytes x 8 / SPI clock) the push achieved, so
+ * command and driver overhead show up next to raw bandwidth.
+ */
+
+#ifndef DISPLAY_BENCH_H
+#define DISPLAY_BENCH_H
+
+#include <stdint.h>
+#include "display.h"
+
+/**
+ * Run every display benchmark once and print the tables
+ * The display must be initialized; the SPI clock is restored afterwards
+ */
+void run_display_bench(void);
+
+/**
+ * Individual benchmarks
+ */
+void display_bench_window(void);       // Command overhead: window set + 1 pixel
+void display_bench_frame(void);        // Full frame: polling vs DMA, RGB565 vs RGB444, fps ceiling
+void display_bench_fill(void);         // display_clear / display_fill_rect fill rates
+void display_bench_partial(void);      // Partial-window DMA pushes from 16x16 to full frame
+void display_bench_strips(void);       // Strip window per strip vs one window, 1-4 strips in flight
+void display_bench_clock_sweep(void);  // Full-frame DMA push and readback check per SPI clock
+
+#endif // DISPLAY_BENCH_H
@@ -0,0 +1,126 @@
+/**
+ * Golden Decode Check Implementation
+ */
+
+#include "golden_check.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "display.h"
+#include "sd_card.h"
+#include "simd.h"
+#include "golden.h"
+
+static const char *TAG = "GOLDEN";
+
+static sd_card_handle_t g_golden_sd;
+
+/**
+ * Check one clip in every mode that has a golden file
+ *
+ * @return Number of failed modes, -1 if the clip has no golden files
+ */
+static int check_clip(const char *path, const char *name)
+{
+    int failures = 0;
+    int checked = 0;
+
+    for (int m = 0; m < GOLDEN_MODE_COUNT; m++) {
+        char gold[300];
+        golden_result_t r;
+
+        golden_path(path, m, gold, sizeof(gold));
+        FILE *f = fopen(gold, "rb");
+        if (f == NULL) continue;
+
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t ret = golden_check(path, m, f, &r);
+        uint32_t ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+        fclose(f);
+        checked++;
+
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "%-20s %-9s %5lu ok (%lu ms)", name, golden_mode_name(m),
+                     (unsigned long)r.count, (unsigned long)ms);
+            continue;
+        }
+
+        failures++;
+        if (ret != ESP_ERR_INVALID_CRC) {
+            ESP_LOGE(TAG, "%-20s %-9s FAILED: %s", name, golden_mode_name(m), esp_err_to_name(ret));
+        } else if (r.tile_x != GOLDEN_NONE) {
+            ESP_LOGE(TAG, "%-20s %-9s %5lu MISMATCH frame %lu MCU (%lu,%lu), %lu MCUs; %lu of %lu differ%s",
+                     name, golden_mode_name(m), (unsigned long)r.count, (unsigned long)r.first,
+                     (unsigned long)r.tile_x, (unsigned long)r.tile_y, (unsigned long)r.tiles,
+                     (unsigned long)r.mismatches, (unsigned long)r.expected,
+                     golden_mode_exact(m) ? "" : " (approximate mode)");
+        } else {
+            ESP_LOGE(TAG, "%-20s %-9s %5lu MISMATCH at %lu; %lu of %lu differ%s",
+                     name, golden_mode_name(m), (unsigned long)r.count, (unsigned long)r.first,
+                     (unsigned long)r.mismatches, (unsigned long)r.expected,
+                     golden_mode_exact(m) ? "" : " (approximate mode)");
+        }
+    }
+
+    return checked ? failures : -1;
+}
+
+/**
+ * Run golden check
+ */
+void run_golden_check(void)
+{
+    ESP_LOGI(TAG, "========================================");
+    ESP_LOGI(TAG, "  Golden Decode Check (SIMD %s)", simd_available() ? "PIE" : "scalar");
+    ESP_LOGI(TAG, "========================================");
+
+    // Display owns the shared SPI bus, so it must come up first
+    if (display_init(NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "Display init failed");
+        return;
+    }
+
+    if (sd_card_init(&g_golden_sd) != ESP_OK) {
+        ESP_LOGE(TAG, "SD card required for the golden check");
+        return;
+    }
+
+    DIR *dir = opendir(GOLDEN_CORPUS_DIR);
+    if (dir == NULL) {
+        ESP_LOGE(TAG, "No corpus in %s (copy clips and .gld files from tools/host/golden -w)",
+                 GOLDEN_CORPUS_DIR);
+        return;
+    }
+
+    int clips = 0;
+    int failures = 0;
+    struct dirent *entry;
+
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (entry->d_type != DT_REG || len < 4 || strcasecmp(entry->d_name + len - 4, ".avi") != 0) {
+            continue;
+        }
+
+        char path[300];
+        snprintf(path, sizeof(path), "%s/%s", GOLDEN_CORPUS_DIR, entry->d_name);
+
+        int ret = check_clip(path, entry->d_name);
+        if (ret < 0) {
+            ESP_LOGW(TAG, "%-20s no golden files", entry->d_name);
+            continue;
+        }
+        clips++;
+        failures += ret;
+    }
+    closedir(dir);
+
+    if (failures) {
+        ESP_LOGE(TAG, "FAILED: %d clip modes differ (%d clips checked)", failures, clips);
+    } else {
+        ESP_LOGI(TAG, "All outputs of %d clips match their goldens", clips);
+    }
+}
@@ -0,0 +1,19 @@
+/**
+ * Golden Decode Check
+ * On-target run of the golden component over the reference corpus
+ * Requires display wiring (shared SPI bus) and a mounted SD card
+ */
+
+#ifndef GOLDEN_CHECK_H
+#define GOLDEN_CHECK_H
+
+#define GOLDEN_CORPUS_DIR   "/sdcard/golden"   // Clips and their .gld files, as tools/host/golden writes them
+
+/**
+ * Check every clip in GOLDEN_CORPUS_DIR against its golden files and log
+ * one result line per clip and mode over UART
+ * Initializes display and SD card itself
+ */
+void run_golden_check(void);
+
+#endif // GOLDEN_CHECK_H
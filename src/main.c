@@ -13,8 +13,13 @@
 // CONFIGURATION: Set to 1 to enable test mode, 0 for normal operation
 // ============================================================================
 #define TEST_MODE 1  // Change to 1 for hardware testing
+#define BENCH_MODE 0 // Change to 1 to run performance benchmarks (needs SD card)
+#define PANEL_RGB444 0 // Change to 1 for 12-bit video (25% less SPI traffic, dithered)
+#define PROFILE_MODE 0 // Change to 1 to log where the decode core spends its time (every 10 s)
+#define GOLDEN_MODE 0  // Change to 1 to check decoder output against the goldens in /sdcard/golden
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -25,17 +30,39 @@
 
 // Component headers
 #include "display.h"
+#include "dlog.h"
+
+#if BENCH_MODE
+    #include "benchmarks.h"
+#endif
+
+#if GOLDEN_MODE
+    #include "golden_check.h"
+#endif
 
 #if TEST_MODE
-    #include "test_patterns.h"  // Test mode only needs display
+    #include "display_bench.h"  // Test mode only needs display
 #else
     // Full component set for normal operation
     #include "video_player.h"
     #include "audio_player.h"
+    #include "radio_player.h"
     #include "sd_card.h"
     #include "channel_manager.h"
     #include "rotary_encoder.h"
     #include "power_manager.h"
+    #include "mem_monitor.h"
+    #include "freertos/semphr.h"
+    #include "esp_heap_caps.h"
+    #include "esp_timer.h"
+    #if CONFIG_WATCHMAN_CONSOLE
+        #include "console.h"
+        #include "benchmarks.h"
+        #include "display_bench.h"
+    #endif
+    #if PROFILE_MODE
+        #include "pc_profiler.h"
+    #endif
 #endif
 
 static const char *TAG = "WATCHMAN";
@@ -50,14 +77,29 @@ static sd_card_handle_t g_sd_card;
 static channel_manager_t g_channel_mgr;
 static video_player_t *g_video_player = NULL;
 static audio_player_t *g_audio_player = NULL;
+static radio_player_t *g_radio_player = NULL;
 static encoder_t *g_encoder = NULL;
 static power_manager_t *g_power_mgr = NULL;
+static mem_monitor_t *g_mem_monitor = NULL;
+
+#if PROFILE_MODE
+#define PROFILE_CORE 0      // Core of the video_playback task
+static volatile uint32_t g_profile_frames = 0;
+#endif
 
 // State variables
 static bool g_playback_active = false;
 static uint32_t g_current_position_sec = 0;
 static nvs_handle_t g_nvs_handle;
 static bool g_channel_switching = false;
+static bool g_radio_mode = false;       // Audio-only episode: panel asleep, CPU at 80 MHz
+static sd_io_tuning_t g_io_tuning;
+
+// Held while input (encoder, console) changes what is playing
+static SemaphoreHandle_t g_control_lock = NULL;
+
+// Notified by the players at the end of an episode; advances under the lock
+static TaskHandle_t g_main_task = NULL;
 
 // OSD state
 static bool g_show_osd = false;
@@ -70,6 +112,15 @@ static uint32_t g_osd_hide_time = 0;
 #define NVS_KEY_EPISODE "episode"
 #define NVS_KEY_POSITION "position"
 
+// Memory telemetry: alarm before the largest DMA block can no longer hold a frame
+#define VIDEO_FRAME_BYTES   (240 * 240 * sizeof(uint16_t))
+
+// Tasks in the playback pipeline whose stack usage is tracked
+static const char *g_watched_tasks[] = {
+    "app_main", "video_playback", "video_reader", "radio_playback", "power_monitor", "encoder_event",
+    "console", "dlog", NULL
+};
+
 /**
  * Save current state to NVS
  */
@@ -148,6 +199,7 @@ static void draw_osd(void)
     uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
     if (now > g_osd_hide_time) {
         g_show_osd = false;
+        video_player_invalidate(g_video_player);
     }
 }
 
@@ -160,6 +212,127 @@ static void show_osd(void)
     g_osd_hide_time = (xTaskGetTickCount() * portTICK_PERIOD_MS) + OSD_DISPLAY_DURATION_MS;
 }
 
+/**
+ * Stop whichever pipeline is playing
+ */
+static void stop_playback(void)
+{
+    if (g_radio_mode) {
+        radio_player_stop(g_radio_player);
+    } else {
+        video_player_stop(g_video_player);
+        audio_player_stop(g_audio_player);
+    }
+}
+
+/**
+ * Switch between the video and radio pipelines
+ * Radio mode puts the panel to sleep with the backlight off and drops the
+ * CPU to 80 MHz with light sleep allowed while idle
+ */
+static void set_radio_mode(bool radio)
+{
+    if (radio == g_radio_mode) return;
+
+    if (radio) {
+        video_player_stop(g_video_player);
+        video_player_close(g_video_player);
+        audio_player_stop(g_audio_player);
+        g_show_osd = false;
+        display_sleep();
+        encoder_set_wakeup(g_encoder, true);
+        power_manager_set_profile(g_power_mgr, POWER_PROFILE_AUDIO);
+    } else {
+        radio_player_close(g_radio_player);
+        power_manager_set_profile(g_power_mgr, POWER_PROFILE_VIDEO);
+        encoder_set_wakeup(g_encoder, false);
+        display_wake();
+    }
+
+    g_radio_mode = radio;
+    ESP_LOGI(TAG, "%s mode", radio ? "Radio" : "Video");
+}
+
+/**
+ * Open and start an episode on the pipeline matching its content
+ */
+static esp_err_t play_episode(const episode_t *ep, uint32_t position_sec)
+{
+    set_radio_mode(ep->audio_only);
+
+    if (g_radio_mode) {
+        esp_err_t ret = radio_player_open(g_radio_player, ep->path);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to open audio: %s", ep->path);
+            return ret;
+        }
+
+        if (position_sec > 0 && radio_player_seek(g_radio_player, position_sec) == ESP_OK) {
+            ESP_LOGI(TAG, "Resumed from %lu seconds", position_sec);
+        }
+
+        return radio_player_play(g_radio_player);
+    }
+
+    video_player_close(g_video_player);
+    esp_err_t ret = video_player_open(g_video_player, ep->path);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open video: %s", ep->path);
+        return ret;
+    }
+
+    // Seek to saved position if resuming
+    if (position_sec > 0) {
+        video_info_t info;
+        if (video_player_get_info(g_video_player, &info) == ESP_OK) {
+            video_player_seek(g_video_player, timebase_sec_to_frame(&info.timebase, position_sec));
+            ESP_LOGI(TAG, "Resumed from %lu seconds", position_sec);
+        }
+    }
+
+    ret = video_player_play(g_video_player);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start video playback");
+        return ret;
+    }
+
+    if (audio_player_start(g_audio_player) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start audio playback");
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Stop playback, move to a channel and start its first episode
+ */
+static void switch_channel(uint8_t index)
+{
+    g_channel_switching = true;
+
+    // Stop current playback
+    if (g_playback_active) {
+        stop_playback();
+    }
+
+    // Switch channel
+    channel_manager_set_channel(&g_channel_mgr, index);
+    g_current_position_sec = 0;
+    save_state();
+    show_osd();
+
+    // Start new channel after brief delay
+    vTaskDelay(pdMS_TO_TICKS(200));
+
+    // Load and play first episode of new channel
+    const episode_t *ep = channel_manager_get_current_episode(&g_channel_mgr);
+    if (ep && play_episode(ep, 0) == ESP_OK) {
+        g_playback_active = true;
+    }
+
+    g_channel_switching = false;
+}
+
 /**
  * Video player callbacks
  */
@@ -167,26 +340,28 @@ static void on_frame_decoded(void *user_data, uint32_t frame_num)
 {
     // Update current frame/position
     video_info_t info;
-    if (video_player_get_info(g_video_player, &info) == ESP_OK && info.fps > 0) {
-        g_current_position_sec = frame_num / info.fps;
+    if (video_player_get_info(g_video_player, &info) == ESP_OK) {
+        g_current_position_sec = timebase_frame_to_sec(&info.timebase, frame_num);
     }
+
+#if PROFILE_MODE
+    g_profile_frames++;
+#endif
 }
 
-static void on_playback_complete(void *user_data)
+/**
+ * Start the next episode of the channel
+ * Caller holds g_control_lock
+ */
+static void advance_episode(void)
 {
-    ESP_LOGI(TAG, "Episode complete - advancing to next");
-
-    // Auto-advance to next episode
     channel_manager_next_episode(&g_channel_mgr);
     const episode_t *ep = channel_manager_get_current_episode(&g_channel_mgr);
 
     if (ep) {
         ESP_LOGI(TAG, "Starting next episode: %s", ep->name);
-        video_player_close(g_video_player);
-        if (video_player_open(g_video_player, ep->path) == ESP_OK) {
+        if (play_episode(ep, 0) == ESP_OK) {
             g_current_position_sec = 0;
-            video_player_play(g_video_player);
-            audio_player_start(g_audio_player);
             save_state();
         }
     } else {
@@ -195,90 +370,149 @@ static void on_playback_complete(void *user_data)
     }
 }
 
+/**
+ * Episode ended (on the video or radio playback task)
+ * The advance runs on app_main_task under g_control_lock, so it cannot
+ * race the encoder or the console opening another file
+ */
+static void on_playback_complete(void *user_data)
+{
+    ESP_LOGI(TAG, "Episode complete - advancing to next");
+    xTaskNotifyGive(g_main_task);
+}
+
 static void on_video_error(void *user_data, esp_err_t error)
 {
     ESP_LOGE(TAG, "Video playback error: %d", error);
     g_playback_active = false;
 }
 
+static void on_radio_error(void *user_data, esp_err_t error)
+{
+    ESP_LOGE(TAG, "Radio playback error: %d", error);
+    g_playback_active = false;
+}
+
 /**
- * Encoder event handler
+ * Shuttle positions the encoder steps through while paused
+ * Rewind is muted trick play; forward first offers faster playback with
+ * pitch-preserved audio, then muted trick play
  */
-static void encoder_callback(const encoder_event_t *event, void *user_data)
+typedef struct {
+    int8_t speed;           // Trick-play speed (VIDEO_SPEED_NORMAL if none)
+    uint16_t rate_q8;       // Audible playback rate
+} shuttle_pos_t;
+
+static const shuttle_pos_t g_shuttle[] = {
+    {-16, VIDEO_RATE_1X}, {-8, VIDEO_RATE_1X}, {-4, VIDEO_RATE_1X}, {-2, VIDEO_RATE_1X},
+    {VIDEO_SPEED_NORMAL, VIDEO_RATE_1X},
+    {VIDEO_SPEED_NORMAL, 320}, {VIDEO_SPEED_NORMAL, 384}, {VIDEO_SPEED_NORMAL, 512},
+    {4, VIDEO_RATE_1X}, {8, VIDEO_RATE_1X}, {16, VIDEO_RATE_1X},
+};
+#define SHUTTLE_COUNT           ((int)(sizeof(g_shuttle) / sizeof(g_shuttle[0])))
+#define SHUTTLE_NORMAL_INDEX    4
+
+/**
+ * Apply a playback speed/rate to video and audio
+ */
+static void apply_playback_speed(int8_t speed, uint16_t rate_q8)
 {
-    // Reset power idle timer on any input
-    power_manager_reset_idle_timer(g_power_mgr);
+    if (speed != VIDEO_SPEED_NORMAL) {
+        if (video_player_set_speed(g_video_player, speed) != ESP_OK) return;
+        video_player_set_rate(g_video_player, VIDEO_RATE_1X);
+        audio_player_pause(g_audio_player);  // Muted during trick play
+        return;
+    }
 
-    switch (event->type) {
-        case ENCODER_EVENT_ROTATE_CW:
-            ESP_LOGI(TAG, "Encoder CW - Next channel");
-            g_channel_switching = true;
+    video_player_set_speed(g_video_player, VIDEO_SPEED_NORMAL);
+    video_player_set_rate(g_video_player, rate_q8);
+    audio_player_set_rate(g_audio_player, rate_q8);
 
-            // Stop current playback
-            if (g_playback_active) {
-                video_player_stop(g_video_player);
-                audio_player_stop(g_audio_player);
-            }
+    // Drop stale samples from before the jump
+    audio_player_clear_buffer(g_audio_player);
+    audio_player_resume(g_audio_player);
 
-            // Switch channel
-            channel_manager_next_channel(&g_channel_mgr);
-            g_current_position_sec = 0;
-            save_state();
-            show_osd();
+    if (video_player_get_state(g_video_player) == VIDEO_STATE_PAUSED) {
+        video_player_play(g_video_player);
+    }
+}
 
-            // Start new channel after brief delay
-            vTaskDelay(pdMS_TO_TICKS(200));
+/**
+ * Step playback speed with the encoder
+ * Active while paused or away from 1x; otherwise rotation changes channel
+ *
+ * @param dir +1 (CW) or -1 (CCW)
+ * @return true if the rotation was consumed
+ */
+static bool shuttle_step(int dir)
+{
+    if (!g_playback_active || g_radio_mode) return false;
 
-            // Load and play first episode of new channel
-            const episode_t *ep = channel_manager_get_current_episode(&g_channel_mgr);
-            if (ep) {
-                video_player_close(g_video_player);
-                if (video_player_open(g_video_player, ep->path) == ESP_OK) {
-                    video_player_play(g_video_player);
-                    audio_player_start(g_audio_player);
-                    g_playback_active = true;
-                }
-            }
+    int8_t speed = video_player_get_speed(g_video_player);
+    uint16_t rate = video_player_get_rate(g_video_player);
 
-            g_channel_switching = false;
+    int idx = SHUTTLE_NORMAL_INDEX;
+    for (int i = 0; i < SHUTTLE_COUNT; i++) {
+        if (g_shuttle[i].speed == speed && g_shuttle[i].rate_q8 == rate) {
+            idx = i;
             break;
+        }
+    }
 
-        case ENCODER_EVENT_ROTATE_CCW:
-            ESP_LOGI(TAG, "Encoder CCW - Previous channel");
-            g_channel_switching = true;
+    if (idx == SHUTTLE_NORMAL_INDEX &&
+        video_player_get_state(g_video_player) != VIDEO_STATE_PAUSED) {
+        return false;
+    }
 
-            // Stop current playback
-            if (g_playback_active) {
-                video_player_stop(g_video_player);
-                audio_player_stop(g_audio_player);
-            }
+    idx += dir;
+    if (idx < 0 || idx >= SHUTTLE_COUNT) return true;
 
-            // Switch channel
-            channel_manager_prev_channel(&g_channel_mgr);
-            g_current_position_sec = 0;
-            save_state();
-            show_osd();
+    apply_playback_speed(g_shuttle[idx].speed, g_shuttle[idx].rate_q8);
+    show_osd();
+    return true;
+}
 
-            // Start new channel after brief delay
-            vTaskDelay(pdMS_TO_TICKS(200));
+/**
+ * Encoder event handler
+ */
+static void encoder_callback(const encoder_event_t *event, void *user_data)
+{
+    uint8_t count = g_channel_mgr.channel_count;
 
-            // Load and play first episode of new channel
-            const episode_t *ep2 = channel_manager_get_current_episode(&g_channel_mgr);
-            if (ep2) {
-                video_player_close(g_video_player);
-                if (video_player_open(g_video_player, ep2->path) == ESP_OK) {
-                    video_player_play(g_video_player);
-                    audio_player_start(g_audio_player);
-                    g_playback_active = true;
-                }
-            }
+    // Reset power idle timer on any input
+    power_manager_reset_idle_timer(g_power_mgr);
 
-            g_channel_switching = false;
+    xSemaphoreTake(g_control_lock, portMAX_DELAY);
+
+    switch (event->type) {
+        case ENCODER_EVENT_ROTATE_CW:
+            if (shuttle_step(1) || count == 0) break;
+
+            ESP_LOGI(TAG, "Encoder CW - Next channel");
+            switch_channel((g_channel_mgr.current_channel + 1) % count);
+            break;
+
+        case ENCODER_EVENT_ROTATE_CCW:
+            if (shuttle_step(-1) || count == 0) break;
+
+            ESP_LOGI(TAG, "Encoder CCW - Previous channel");
+            switch_channel((g_channel_mgr.current_channel + count - 1) % count);
             break;
 
         case ENCODER_EVENT_BUTTON_PRESS:
             ESP_LOGI(TAG, "Encoder button - Toggle pause");
-            if (g_playback_active) {
+            if (g_playback_active && g_radio_mode) {
+                if (radio_player_get_state(g_radio_player) == RADIO_STATE_PLAYING) {
+                    radio_player_pause(g_radio_player);
+                } else {
+                    radio_player_play(g_radio_player);
+                }
+            } else if (g_playback_active &&
+                (video_player_get_speed(g_video_player) != VIDEO_SPEED_NORMAL ||
+                 video_player_get_rate(g_video_player) != VIDEO_RATE_1X)) {
+                // Back to 1x at the current position
+                apply_playback_speed(VIDEO_SPEED_NORMAL, VIDEO_RATE_1X);
+            } else if (g_playback_active) {
                 video_state_t state = video_player_get_state(g_video_player);
                 if (state == VIDEO_STATE_PLAYING) {
                     video_player_pause(g_video_player);
@@ -294,13 +528,15 @@ static void encoder_callback(const encoder_event_t *event, void *user_data)
         case ENCODER_EVENT_BUTTON_LONG_PRESS:
             ESP_LOGI(TAG, "Encoder long press - Next episode");
             if (g_playback_active) {
-                on_playback_complete(NULL);  // Reuse episode advance logic
+                advance_episode();
             }
             break;
 
         default:
             break;
     }
+
+    xSemaphoreGive(g_control_lock);
 }
 
 /**
@@ -315,6 +551,7 @@ static void power_callback(battery_level_t level, void *user_data)
         save_state();
 
         // Show critical battery warning
+        if (g_radio_mode) display_wake();
         display_clear(COLOR_RED);
         vTaskDelay(pdMS_TO_TICKS(2000));
 
@@ -326,6 +563,33 @@ static void power_callback(battery_level_t level, void *user_data)
     }
 }
 
+/**
+ * Memory event handler
+ */
+static void mem_callback(const mem_event_t *event, void *user_data)
+{
+    switch (event->type) {
+        case MEM_EVENT_DMA_BLOCK_TRENDING:
+            ESP_LOGW(TAG, "DMA heap fragmenting: largest block %u, frame needs %u (~%lu s left)",
+                     event->value, event->threshold, event->eta_sec);
+            break;
+
+        case MEM_EVENT_DMA_BLOCK_LOW:
+            ESP_LOGE(TAG, "DMA heap too fragmented for a frame: largest block %u < %u",
+                     event->value, event->threshold);
+            mem_monitor_log_report(g_mem_monitor);
+            break;
+
+        case MEM_EVENT_STACK_LOW:
+            ESP_LOGW(TAG, "Task '%s' close to stack overflow (%u bytes left)",
+                     event->task_name, event->value);
+            break;
+
+        default:
+            break;
+    }
+}
+
 /**
  * Initialize all hardware components
  */
@@ -349,6 +613,24 @@ static esp_err_t init_hardware(void)
         g_nvs_handle = 0;
     }
 
+    // Start memory telemetry first so init-time allocations are covered
+    mem_monitor_config_t mem_config = {
+        .sample_period_ms = MEM_MONITOR_SAMPLE_PERIOD_MS,
+        .dma_block_threshold = VIDEO_FRAME_BYTES,
+        .predict_horizon_sec = MEM_MONITOR_HORIZON_SEC,
+        .stack_warn_bytes = MEM_MONITOR_STACK_WARN_BYTES,
+        .callback = mem_callback,
+        .user_data = NULL
+    };
+    g_mem_monitor = mem_monitor_init(&mem_config);
+    if (g_mem_monitor) {
+        for (int i = 0; g_watched_tasks[i] != NULL; i++) {
+            mem_monitor_watch_task(g_mem_monitor, g_watched_tasks[i]);
+        }
+    } else {
+        ESP_LOGW(TAG, "Memory monitor init failed, continuing without telemetry");
+    }
+
     // 1. Initialize display (show splash screen)
     ESP_LOGI(TAG, "Initializing display...");
     ret = display_init(NULL);  // Use default config
@@ -399,6 +681,12 @@ static esp_err_t init_hardware(void)
 
     // 5. Initialize rotary encoder
     ESP_LOGI(TAG, "Initializing encoder...");
+    g_control_lock = xSemaphoreCreateMutex();
+    if (g_control_lock == NULL) {
+        ESP_LOGE(TAG, "Control lock creation failed");
+        return ESP_FAIL;
+    }
+
     encoder_config_t enc_config = {
         .pin_clk = PIN_ENCODER_CLK,
         .pin_dt = PIN_ENCODER_DT,
@@ -448,6 +736,27 @@ static esp_err_t init_hardware(void)
         return ESP_FAIL;
     }
 
+    // Read size and prefetch depth from the card's measured performance
+    sd_profile_tune(NULL, &g_io_tuning);
+    if (sd_card_get_tuning(&g_sd_card, &g_io_tuning) == ESP_OK) {
+        video_player_set_io_tuning(g_video_player, &g_io_tuning);
+    }
+
+    // Audio-only episodes bypass the video pipeline
+    radio_callbacks_t radio_callbacks = {
+        .on_playback_complete = on_playback_complete,
+        .on_error = on_radio_error
+    };
+    g_radio_player = radio_player_create(g_audio_player, &radio_callbacks, NULL);
+    if (!g_radio_player) {
+        ESP_LOGE(TAG, "Radio player creation failed");
+        return ESP_FAIL;
+    }
+
+#if PANEL_RGB444
+    video_player_set_pixel_format(g_video_player, DISPLAY_FORMAT_RGB444);
+#endif
+
     ESP_LOGI(TAG, "Hardware initialization complete");
     ESP_LOGI(TAG, "Free heap: %lu bytes", esp_get_free_heap_size());
 
@@ -468,47 +777,316 @@ static esp_err_t start_playback(void)
     const channel_t *ch = channel_manager_get_current(&g_channel_mgr);
     ESP_LOGI(TAG, "Starting playback: %s - %s", ch ? ch->name : "?", ep->name);
 
-    // Open video file
-    esp_err_t ret = video_player_open(g_video_player, ep->path);
+    esp_err_t ret = play_episode(ep, g_current_position_sec);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open video: %s", ep->path);
         return ret;
     }
 
-    // Seek to saved position if resuming
-    if (g_current_position_sec > 0) {
+    g_playback_active = true;
+    show_osd();
+
+    return ESP_OK;
+}
+
+#if CONFIG_WATCHMAN_CONSOLE
+// ============================================================================
+// Serial console: live counters and control without reflashing
+// Handlers run on the console task (priority 1, core 1) and never allocate;
+// only "bench" does, through the benchmarks it runs
+// ============================================================================
+
+#define CONSOLE_TRACE_FRAMES    120     // 4 s at 30 fps, 16 bytes each
+#define CONSOLE_PREFETCH_MAX    16
+#define CONSOLE_SPI_RETRIES     5       // Waits for the last frame's DMA after a stop
+
+static video_trace_t g_trace[CONSOLE_TRACE_FRAMES];
+static uint32_t g_stats_frames;         // Frames shown at the previous "stats"
+static int64_t g_stats_time_us;
+
+static const char *g_stage_names[VIDEO_STAGE_COUNT] = {"read", "decode", "push"};
+
+/**
+ * Stop playback for a change that needs the pipeline idle
+ *
+ * @return true if playback was running and should be resumed
+ */
+static bool console_stop_playback(void)
+{
+    if (!g_playback_active) return false;
+
+    stop_playback();
+    g_playback_active = false;
+    return true;
+}
+
+/**
+ * Resume the current episode where it was stopped
+ */
+static void console_resume_playback(bool resume)
+{
+    const episode_t *ep = channel_manager_get_current_episode(&g_channel_mgr);
+
+    if (resume && ep && play_episode(ep, g_current_position_sec) == ESP_OK) {
+        g_playback_active = true;
+    }
+}
+
+/**
+ * Parse a decimal argument
+ */
+static bool parse_u32(const char *text, uint32_t max, uint32_t *value)
+{
+    char *end;
+    unsigned long v = strtoul(text, &end, 10);
+
+    if (end == text || *end != '\0' || v > max) return false;
+    *value = v;
+    return true;
+}
+
+static esp_err_t cmd_stats(int argc, char **argv)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (g_radio_mode) {
+        radio_stats_t rs;
+        radio_player_get_stats(g_radio_player, &rs);
+        console_printf("radio %lu s, CPU busy %lu per mille of audio time\n",
+                       radio_player_get_position(g_radio_player),
+                       (unsigned long)(rs.audio_us ? rs.busy_us * 1000 / rs.audio_us : 0));
+    } else {
+        video_stats_t vs;
         video_info_t info;
-        if (video_player_get_info(g_video_player, &info) == ESP_OK) {
-            uint32_t frame = g_current_position_sec * info.fps;
-            video_player_seek(g_video_player, frame);
-            ESP_LOGI(TAG, "Resumed from %lu seconds", g_current_position_sec);
+        video_player_get_stats(g_video_player, &vs);
+        video_player_get_info(g_video_player, &info);
+
+        // Rate over the frames shown since the previous call
+        uint32_t frames = (vs.frames >= g_stats_frames) ? vs.frames - g_stats_frames : vs.frames;
+        int64_t elapsed = now - g_stats_time_us;
+        uint32_t fps10 = (g_stats_time_us && elapsed > 0) ? (uint32_t)(frames * 10000000LL / elapsed) : 0;
+        g_stats_frames = vs.frames;
+        g_stats_time_us = now;
+
+        console_printf("video %lu.%lu fps, frame %lu/%lu, shown %lu, late %lu, dropped %lu, underruns %lu\n",
+                       fps10 / 10, fps10 % 10, video_player_get_current_frame(g_video_player),
+                       info.frame_count, vs.frames, vs.late, vs.dropped, vs.underruns);
+        console_printf("  %-7s %6s %6s %6s %6s %6s %6s %6s %6s %8s\n", "stage",
+                       "<1ms", "<2", "<4", "<8", "<16", "<32", "<64", "64+", "max us");
+        for (int i = 0; i < VIDEO_STAGE_COUNT; i++) {
+            const uint32_t *h = vs.hist[i];
+            console_printf("  %-7s %6lu %6lu %6lu %6lu %6lu %6lu %6lu %6lu %8lu\n", g_stage_names[i],
+                           h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7], vs.max_us[i]);
         }
     }
 
-    // Start playback
-    ret = video_player_play(g_video_player);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start video playback");
-        return ret;
+    dlog_stats_t ds;
+    dlog_get_stats(&ds);
+    int spi_requested;
+    int spi_hz = display_get_spi_clock(&spi_requested);
+
+    console_printf("heap %u free, %lu min, DMA %u free / %u largest\n",
+                   heap_caps_get_free_size(MALLOC_CAP_8BIT), esp_get_minimum_free_heap_size(),
+                   heap_caps_get_free_size(MALLOC_CAP_DMA), heap_caps_get_largest_free_block(MALLOC_CAP_DMA));
+    console_printf("spi %d kHz (asked %d), prefetch %u, dlog %lu records / %lu dropped\n",
+                   spi_hz / 1000, spi_requested / 1000, g_io_tuning.prefetch_depth,
+                   ds.records, ds.dropped);
+    return ESP_OK;
+}
+
+static esp_err_t cmd_trace(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "start") == 0) {
+        uint32_t frames = CONSOLE_TRACE_FRAMES;
+        if (argc >= 3 && !parse_u32(argv[2], CONSOLE_TRACE_FRAMES, &frames)) return ESP_ERR_INVALID_ARG;
+
+        video_player_start_trace(g_video_player, g_trace, frames);
+        console_printf("tracing the next %lu frames\n", frames);
+        return ESP_OK;
     }
 
-    ret = audio_player_start(g_audio_player);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start audio playback");
+    if (argc >= 2 && strcmp(argv[1], "dump") == 0) {
+        uint32_t count = video_player_get_trace_count(g_video_player);
+
+        console_printf("  %7s %7s %7s %7s %8s\n", "frame", "read", "decode", "push", "slack us");
+        for (uint32_t i = 0; i < count; i++) {
+            const video_trace_t *t = &g_trace[i];
+            console_printf("  %7lu %7u %7u %7u %8ld\n", t->frame_num, t->stage_us[VIDEO_STAGE_READ],
+                           t->stage_us[VIDEO_STAGE_DECODE], t->stage_us[VIDEO_STAGE_PUSH], t->slack_us);
+        }
+        console_printf("%lu frames\n", count);
+        return ESP_OK;
     }
 
-    g_playback_active = true;
-    show_osd();
+    return ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t cmd_seek(int argc, char **argv)
+{
+    if (argc != 2) return ESP_ERR_INVALID_ARG;
+    if (!g_playback_active) return ESP_ERR_INVALID_STATE;
+
+    // Absolute seconds, or relative with a sign
+    const char *arg = argv[1];
+    int sign = (arg[0] == '+') ? 1 : (arg[0] == '-') ? -1 : 0;
+    uint32_t sec;
+    if (!parse_u32(arg + (sign != 0), UINT32_MAX, &sec)) return ESP_ERR_INVALID_ARG;
+
+    if (sign < 0) {
+        sec = (sec < g_current_position_sec) ? g_current_position_sec - sec : 0;
+    } else if (sign > 0) {
+        if (sec > UINT32_MAX - g_current_position_sec) return ESP_ERR_INVALID_ARG;
+        sec += g_current_position_sec;
+    }
+
+    esp_err_t ret;
+    xSemaphoreTake(g_control_lock, portMAX_DELAY);
+    if (g_radio_mode) {
+        // The radio player seeks only while paused
+        bool playing = (radio_player_get_state(g_radio_player) == RADIO_STATE_PLAYING);
+        if (playing) radio_player_pause(g_radio_player);
+        ret = radio_player_seek(g_radio_player, sec);
+        if (playing) radio_player_play(g_radio_player);
+    } else {
+        video_info_t info;
+        video_player_get_info(g_video_player, &info);
+        ret = video_player_seek(g_video_player, timebase_sec_to_frame(&info.timebase, sec));
+        audio_player_clear_buffer(g_audio_player);
+    }
+    if (ret == ESP_OK) g_current_position_sec = sec;
+    xSemaphoreGive(g_control_lock);
+
+    if (ret == ESP_OK) console_printf("at %lu s\n", sec);
+    return ret;
+}
+
+static esp_err_t cmd_chan(int argc, char **argv)
+{
+    uint8_t count = g_channel_mgr.channel_count;
+    uint8_t current = g_channel_mgr.current_channel;
+
+    if (argc == 1) {
+        for (uint8_t i = 0; i < count; i++) {
+            const channel_t *ch = &g_channel_mgr.channels[i];
+            console_printf("%c %2d %-24s %u episodes\n", i == current ? '*' : ' ', i + 1,
+                           ch->name, ch->episode_count);
+        }
+        return ESP_OK;
+    }
+
+    if (count == 0) return ESP_ERR_INVALID_STATE;
+
+    uint32_t number;
+    uint8_t index;
+    if (strcmp(argv[1], "next") == 0) {
+        index = (current + 1) % count;
+    } else if (strcmp(argv[1], "prev") == 0) {
+        index = (current + count - 1) % count;
+    } else if (parse_u32(argv[1], count, &number) && number > 0) {
+        index = number - 1;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
 
+    xSemaphoreTake(g_control_lock, portMAX_DELAY);
+    switch_channel(index);
+    xSemaphoreGive(g_control_lock);
+
+    console_printf("channel %d: %s\n", index + 1, g_channel_mgr.channels[index].name);
     return ESP_OK;
 }
 
+static esp_err_t cmd_set(int argc, char **argv)
+{
+    uint32_t value;
+    if (argc != 3) return ESP_ERR_INVALID_ARG;
+
+    if (strcmp(argv[1], "prefetch") == 0) {
+        if (!parse_u32(argv[2], CONSOLE_PREFETCH_MAX, &value) || value == 0) return ESP_ERR_INVALID_ARG;
+
+        // The reader queue is sized when playback starts
+        xSemaphoreTake(g_control_lock, portMAX_DELAY);
+        bool resume = !g_radio_mode && console_stop_playback();
+        g_io_tuning.prefetch_depth = value;
+        video_player_set_io_tuning(g_video_player, &g_io_tuning);
+        console_resume_playback(resume);
+        xSemaphoreGive(g_control_lock);
+
+        console_printf("prefetch %lu frames\n", value);
+        return ESP_OK;
+    }
+
+    if (strcmp(argv[1], "spi_mhz") == 0) {
+        if (!parse_u32(argv[2], 80, &value) || value == 0) return ESP_ERR_INVALID_ARG;
+
+        xSemaphoreTake(g_control_lock, portMAX_DELAY);
+        bool resume = console_stop_playback();
+        esp_err_t ret = display_set_spi_clock(value * 1000000);
+        for (int i = 0; ret == ESP_ERR_INVALID_STATE && i < CONSOLE_SPI_RETRIES; i++) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            ret = display_set_spi_clock(value * 1000000);
+        }
+        console_resume_playback(resume);
+        xSemaphoreGive(g_control_lock);
+
+        if (ret == ESP_OK) console_printf("spi %d kHz\n", display_get_spi_clock(NULL) / 1000);
+        return ret;
+    }
+
+    return ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t cmd_bench(int argc, char **argv)
+{
+    if (argc != 2) return ESP_ERR_INVALID_ARG;
+
+    bool display = strcmp(argv[1], "display") == 0;
+    bool sd = strcmp(argv[1], "sd") == 0;
+    bool decode = strcmp(argv[1], "decode") == 0;
+    if (!display && !sd && !decode) return ESP_ERR_INVALID_ARG;
+    if (display && g_radio_mode) return ESP_ERR_INVALID_STATE;     // Panel is asleep
+
+    // Benchmarks own the panel and the card while they run
+    xSemaphoreTake(g_control_lock, portMAX_DELAY);
+    bool resume = console_stop_playback();
+    esp_err_t ret = ESP_OK;
+
+    if (display) {
+        bench_panel_format();
+        display_bench_strips();
+        video_player_invalidate(g_video_player);
+    } else if (decode) {
+        bench_codecs();
+    } else {
+        sd_perf_profile_t profile;
+        ret = sd_profile_probe(g_sd_card.card, &profile);
+        if (ret == ESP_OK) {
+            console_printf("sd %lu KB/s sequential, 4 KB random p50 %lu us, p99 %lu us\n",
+                           profile.seq_read_kbps, profile.rand_p50_us, profile.rand_p99_us);
+        }
+    }
+
+    console_resume_playback(resume);
+    xSemaphoreGive(g_control_lock);
+    return ret;
+}
+
+static const console_command_t g_console_commands[] = {
+    {"stats", NULL, "fps, late/dropped frames, underruns, stage histograms, heap", cmd_stats},
+    {"trace", "start [frames]|dump", "Per-frame stage times (up to 120 frames)", cmd_trace},
+    {"seek", "<sec>|+sec|-sec", "Seek the current episode", cmd_seek},
+    {"chan", "[n|next|prev]", "List channels or switch", cmd_chan},
+    {"set", "prefetch N|spi_mhz N", "Read-ahead depth, display SPI clock", cmd_set},
+    {"bench", "display|sd|decode", "Run a benchmark (stops playback meanwhile)", cmd_bench},
+};
+#endif // CONFIG_WATCHMAN_CONSOLE
+
 /**
  * Main application task
  */
 static void app_main_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "Sony Watchman starting...");
+    g_main_task = xTaskGetCurrentTaskHandle();
 
     // Initialize all hardware
     if (init_hardware() != ESP_OK) {
@@ -526,10 +1104,23 @@ static void app_main_task(void *pvParameters)
         ESP_LOGE(TAG, "Failed to start initial playback");
     }
 
+#if CONFIG_WATCHMAN_CONSOLE
+    console_start(g_console_commands, sizeof(g_console_commands) / sizeof(g_console_commands[0]));
+#endif
+
     // Main event loop
     uint32_t last_save_time = 0;
     uint32_t last_heap_check = 0;
 
+#if PROFILE_MODE
+    // PCPROF lines in the log go through tools/pcprof.py for function names
+    uint32_t profile_since = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    if (pc_profiler_start(PROFILE_CORE) != ESP_OK) {
+        ESP_LOGW(TAG, "PC profiler unavailable");
+    }
+    g_profile_frames = 0;
+#endif
+
     while (1) {
         uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
 
@@ -539,30 +1130,54 @@ static void app_main_task(void *pvParameters)
             last_save_time = current_time;
         }
 
-        // Draw OSD if needed
-        if (g_show_osd && !g_channel_switching) {
+        // Draw OSD if needed (the panel sleeps in radio mode)
+        if (g_show_osd && !g_channel_switching && !g_radio_mode) {
             draw_osd();
         }
 
-        // Monitor free heap for memory leaks (every 10 seconds)
+        if (g_radio_mode && g_playback_active) {
+            g_current_position_sec = radio_player_get_position(g_radio_player);
+        }
+
+        // Report heap fragmentation and stack usage (every 10 seconds)
         if (current_time - last_heap_check > 10000) {
             ESP_LOGI(TAG, "Free heap: %lu bytes", esp_get_free_heap_size());
+            mem_monitor_log_report(g_mem_monitor);
             last_heap_check = current_time;
 
+#if PROFILE_MODE
+            uint32_t elapsed_ms = current_time - profile_since;
+            pc_profiler_log_report(elapsed_ms ? g_profile_frames * 1000.0f / elapsed_ms : 0.0f);
+            pc_profiler_reset();
+            g_profile_frames = 0;
+            profile_since = current_time;
+#endif
+
             // Check battery
             uint8_t bat_pct = power_manager_get_battery_percentage(g_power_mgr);
             ESP_LOGI(TAG, "Battery: %d%%", bat_pct);
         }
 
-        // Check for auto-dim/sleep
+        // Check for auto-dim/sleep (backlight stays off in radio mode)
         uint32_t idle_time = power_manager_get_idle_time(g_power_mgr);
-        if (idle_time > AUTO_DIM_IDLE_MS) {
-            display_set_brightness(30);  // Dim to 30%
-        } else {
-            display_set_brightness(100);  // Full brightness
+        if (!g_radio_mode) {
+            if (idle_time > AUTO_DIM_IDLE_MS) {
+                display_set_brightness(30);  // Dim to 30%
+            } else {
+                display_set_brightness(100);  // Full brightness
+            }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // Episode ended: advance unless input restarted playback meanwhile
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)) > 0) {
+            xSemaphoreTake(g_control_lock, portMAX_DELAY);
+            bool stopped = g_radio_mode ? radio_player_get_state(g_radio_player) == RADIO_STATE_STOPPED
+                                        : video_player_get_state(g_video_player) == VIDEO_STATE_STOPPED;
+            if (g_playback_active && stopped) {
+                advance_episode();
+            }
+            xSemaphoreGive(g_control_lock);
+        }
     }
 
     vTaskDelete(NULL);
@@ -580,6 +1195,9 @@ static void app_main_task(void *pvParameters)
  */
 void app_main(void)
 {
+    // Deferred log drain, before anything logs from a hot path
+    dlog_start();
+
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "========================================");
     ESP_LOGI(TAG, "  Sony Watchman Retro Media Player");
@@ -598,6 +1216,16 @@ void app_main(void)
     ESP_LOGI(TAG, "========================================");
     ESP_LOGI(TAG, "");
 
+#if BENCH_MODE
+    run_benchmarks();
+    return;
+#endif
+
+#if GOLDEN_MODE
+    run_golden_check();
+    return;
+#endif
+
 #if TEST_MODE
     // ========================================================================
     // TEST MODE: Display testing only
@@ -610,12 +1238,12 @@ void app_main(void)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Display initialization failed: %d", ret);
         ESP_LOGE(TAG, "Check wiring:");
-        ESP_LOGE(TAG, "  MOSI: GPIO 23");
-        ESP_LOGE(TAG, "  CLK:  GPIO 18");
-        ESP_LOGE(TAG, "  CS:   GPIO 5");
-        ESP_LOGE(TAG, "  DC:   GPIO 16");
-        ESP_LOGE(TAG, "  RST:  GPIO 4");
-        ESP_LOGE(TAG, "  BL:   GPIO 15 (optional)");
+        ESP_LOGE(TAG, "  MOSI: GPIO %d", PIN_DISPLAY_MOSI);
+        ESP_LOGE(TAG, "  CLK:  GPIO %d", PIN_DISPLAY_CLK);
+        ESP_LOGE(TAG, "  CS:   GPIO %d", PIN_DISPLAY_CS);
+        ESP_LOGE(TAG, "  DC:   GPIO %d", PIN_DISPLAY_DC);
+        ESP_LOGE(TAG, "  RST:  GPIO %d", PIN_DISPLAY_RST);
+        ESP_LOGE(TAG, "  BL:   GPIO %d (optional)", PIN_DISPLAY_BL);
         return;
     }
 
@@ -651,9 +1279,9 @@ void app_main(void)
     display_clear(COLOR_BLACK);
     vTaskDelay(pdMS_TO_TICKS(5000));
 
-    // Now run full test patterns
-    ESP_LOGI(TAG, "Starting full test pattern sequence...");
-    run_display_tests();
+    // Now measure the display path
+    ESP_LOGI(TAG, "Starting display benchmarks...");
+    run_display_bench();
 
 #else
     // ========================================================================
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""
+Deferred Log Decoder
+
+Turns the "DLOG" lines printed by the deferred log
+(components/telemetry/dlog.c with CONFIG_WATCHMAN_DLOG_HOST_DECODE) back
+into the usual "I (ms) TAG: text" lines. Each DLOG line carries the address
+of its format string and tag and the raw 8-byte arguments; the strings are
+read from the build's ELF and the arguments formatted here, so the target
+never formats hot-path logs at all. Other lines pass through unchanged.
+
+%s arguments are pointers too: strings in the image (literals, tags,
+esp_err_to_name) are resolved, anything else prints as <0xADDRESS>.
+
+Usage: dlog.py [-e ELF] [-c] [LOG]
+  LOG         idf.py monitor output (default: stdin)
+  -e ELF      firmware image (default: build/sony_watchman.elf)
+  -c          prefix each decoded line with the core that logged it
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LINE = re.compile(r"DLOG ([NEWIDV?]) (\d+) (\d+) ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8})((?: [0-9a-fA-F]{16})*)")
+SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|L|q|j|z|t)?([diouxXcsfFeEgGaAp%])")
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+class Image:
+    """Allocated, file-backed sections of an ELF (32 or 64-bit, little-endian)"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[5] != 1:
+            sys.exit("dlog: %s is not a little-endian ELF" % path)
+        wide = data[4] == 2
+        if wide:
+            shoff, = struct.unpack_from("<Q", data, 0x28)
+            shentsize, shnum = struct.unpack_from("<HH", data, 0x3A)
+        else:
+            shoff, = struct.unpack_from("<I", data, 0x20)
+            shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+
+        self.data = data
+        self.sections = []
+        for i in range(shnum):
+            off = shoff + i * shentsize
+            if wide:
+                _, stype, flags, addr, foff, size = struct.unpack_from("<IIQQQQ", data, off)
+            else:
+                _, stype, flags, addr, foff, size = struct.unpack_from("<IIIIII", data, off)
+            if flags & SHF_ALLOC and stype != SHT_NOBITS and size:
+                self.sections.append((addr, size, foff))
+
+    def string(self, addr):
+        """C string at a load address, None if it is not in the image"""
+        for base, size, foff in self.sections:
+            if base <= addr < base + size:
+                start = foff + addr - base
+                end = self.data.find(b"\0", start, foff + size)
+                if end < 0:
+                    return None
+                return self.data[start:end].decode("utf-8", "replace")
+        return None
+
+
+def signed(value, bits):
+    return value - (1 << bits) if value & (1 << (bits - 1)) else value
+
+
+def format_args(image, fmt, args):
+    """printf-format the captured arguments as dlog.c would on the target"""
+    out = []
+    pos = 0
+    index = 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, precision, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if index >= len(args):
+            out.append(m.group(0))
+            continue
+
+        raw = args[index]
+        index += 1
+        wide = length in ("ll", "q", "j")
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+
+        if conv in "di":
+            out.append((spec + "d") % signed(raw if wide else raw & 0xFFFFFFFF, 64 if wide else 32))
+        elif conv in "ouxX":
+            out.append((spec + ("d" if conv == "u" else conv)) % (raw if wide else raw & 0xFFFFFFFF))
+        elif conv == "c":
+            out.append((spec + "c") % chr(raw & 0xFF))
+        elif conv in "fFeEgG":
+            out.append((spec + conv) % struct.unpack("<d", struct.pack("<Q", raw))[0])
+        elif conv in "aA":
+            out.append(float.hex(struct.unpack("<d", struct.pack("<Q", raw))[0]))
+        elif conv == "s":
+            ptr = raw & 0xFFFFFFFF
+            text = image.string(ptr) if ptr else "(null)"
+            out.append((spec + "s") % (text if text is not None else "<0x%08x>" % ptr))
+        elif conv == "p":
+            out.append("0x%x" % (raw & 0xFFFFFFFF))
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode(image, line, show_core):
+    """Decoded text for a DLOG line, or None if the line is not one"""
+    m = LINE.search(line)
+    if not m:
+        return None
+    level, core, ms, fmt_addr, tag_addr, arg_text = m.groups()
+    fmt = image.string(int(fmt_addr, 16))
+    tag = image.string(int(tag_addr, 16)) or "<0x%s>" % tag_addr
+    args = [int(a, 16) for a in arg_text.split()]
+    if fmt is None:
+        text = "<format 0x%s not in the ELF> %s" % (fmt_addr, arg_text.strip())
+    else:
+        text = format_args(image, fmt, args)
+    prefix = "[%s] " % core if show_core else ""
+    return "%s%s (%s) %s: %s" % (prefix, level, ms, tag, text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode deferred log DLOG lines")
+    parser.add_argument("log", nargs="?", help="monitor log (default: stdin)")
+    parser.add_argument("-e", "--elf", default="build/sony_watchman.elf")
+    parser.add_argument("-c", "--core", action="store_true", help="prefix lines with the logging core")
+    args = parser.parse_args()
+
+    image = Image(args.elf)
+    lines = open(args.log, errors="replace") if args.log else sys.stdin
+    for line in lines:
+        text = decode(image, line, args.core)
+        sys.stdout.write(text + "\n" if text is not None else line)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,162 @@
+/**
+ * Minimal AVI writer for the host encoders
+ */
+
+#include "avi_writer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define AVIF_HASINDEX   0x10
+#define AVIIF_KEYFRAME  0x10
+#define IDX_KEYFRAME    0x80000000u
+
+static void put16(FILE *f, uint16_t v)
+{
+    fputc(v & 0xFF, f);
+    fputc(v >> 8, f);
+}
+
+static void put32(FILE *f, uint32_t v)
+{
+    put16(f, v & 0xFFFF);
+    put16(f, v >> 16);
+}
+
+static void put4cc(FILE *f, const char *s)
+{
+    fwrite(s, 1, 4, f);
+}
+
+static void patch32(FILE *f, long pos, uint32_t v)
+{
+    fseek(f, pos, SEEK_SET);
+    put32(f, v);
+}
+
+/**
+ * Write headers; sizes and counts are patched by avi_writer_close()
+ */
+static void write_headers(FILE *f, uint32_t w, uint32_t h, uint32_t fps, const char *fourcc)
+{
+    put4cc(f, "RIFF"); put32(f, 0); put4cc(f, "AVI ");
+
+    put4cc(f, "LIST"); put32(f, 4 + 8 + 56 + 8 + 4 + 8 + 56 + 8 + 40); put4cc(f, "hdrl");
+
+    put4cc(f, "avih"); put32(f, 56);
+    put32(f, 1000000 / fps);        // us per frame
+    put32(f, 0);                    // max bytes per sec (patched)
+    put32(f, 0);                    // padding
+    put32(f, AVIF_HASINDEX);
+    put32(f, 0);                    // total frames (patched)
+    put32(f, 0);                    // initial frames
+    put32(f, 1);                    // streams
+    put32(f, w * h * 2);            // suggested buffer
+    put32(f, w);
+    put32(f, h);
+    for (int i = 0; i < 4; i++) put32(f, 0);
+
+    put4cc(f, "LIST"); put32(f, 4 + 8 + 56 + 8 + 40); put4cc(f, "strl");
+
+    put4cc(f, "strh"); put32(f, 56);
+    put4cc(f, "vids"); put4cc(f, fourcc);
+    put32(f, 0);                    // flags
+    put16(f, 0); put16(f, 0);       // priority, language
+    put32(f, 0);                    // initial frames
+    put32(f, 1);                    // scale
+    put32(f, fps);                  // rate
+    put32(f, 0);                    // start
+    put32(f, 0);                    // length (patched)
+    put32(f, w * h * 2);            // suggested buffer
+    put32(f, 0xFFFFFFFF);           // quality
+    put32(f, 0);                    // sample size
+    put16(f, 0); put16(f, 0); put16(f, w); put16(f, h);
+
+    put4cc(f, "strf"); put32(f, 40);
+    put32(f, 40);
+    put32(f, w);
+    put32(f, h);                    // top-down despite the positive sign
+    put16(f, 1);                    // planes
+    put16(f, 16);                   // bits per pixel
+    put4cc(f, fourcc);
+    put32(f, w * h * 2);            // image size
+    for (int i = 0; i < 4; i++) put32(f, 0);
+}
+
+int avi_writer_open(avi_writer_t *avi, const char *path, uint32_t width, uint32_t height,
+                    uint32_t fps, const char *fourcc)
+{
+    memset(avi, 0, sizeof(*avi));
+
+    avi->f = fopen(path, "wb");
+    if (avi->f == NULL) return -1;
+
+    // idx1 entries are kept in memory (8 bytes per frame)
+    avi->fps = fps;
+    avi->idx_cap = 1024;
+    avi->idx = malloc(avi->idx_cap * 2 * sizeof(uint32_t));
+    if (avi->idx == NULL) {
+        fclose(avi->f);
+        return -1;
+    }
+
+    write_headers(avi->f, width, height, fps, fourcc);
+    avi->movi_list = ftell(avi->f);
+    put4cc(avi->f, "LIST"); put32(avi->f, 0); put4cc(avi->f, "movi");
+
+    return 0;
+}
+
+int avi_writer_add(avi_writer_t *avi, const uint8_t *data, uint32_t size, bool keyframe)
+{
+    if (avi->frames == avi->idx_cap) {
+        uint32_t *idx = realloc(avi->idx, avi->idx_cap * 4 * sizeof(uint32_t));
+        if (idx == NULL) return -1;
+        avi->idx = idx;
+        avi->idx_cap *= 2;
+    }
+
+    // idx1 offsets are relative to the "movi" FOURCC
+    avi->idx[avi->frames * 2] = (uint32_t)(ftell(avi->f) - (avi->movi_list + 8));
+    avi->idx[avi->frames * 2 + 1] = size | (keyframe ? IDX_KEYFRAME : 0);
+
+    put4cc(avi->f, "00dc");
+    put32(avi->f, size);
+    fwrite(data, 1, size, avi->f);
+    if (size & 1) fputc(0, avi->f);
+
+    avi->total_size += size;
+    if (size > avi->max_size) avi->max_size = size;
+    avi->frames++;
+
+    return ferror(avi->f) ? -1 : 0;
+}
+
+long avi_writer_close(avi_writer_t *avi)
+{
+    FILE *f = avi->f;
+
+    long idx1_pos = ftell(f);
+    put4cc(f, "idx1");
+    put32(f, avi->frames * 16);
+    for (uint32_t i = 0; i < avi->frames; i++) {
+        uint32_t size = avi->idx[i * 2 + 1];
+        put4cc(f, "00dc");
+        put32(f, (size & IDX_KEYFRAME) ? AVIIF_KEYFRAME : 0);
+        put32(f, avi->idx[i * 2]);
+        put32(f, size & ~IDX_KEYFRAME);
+    }
+    long end = ftell(f);
+
+    patch32(f, 4, (uint32_t)(end - 8));
+    patch32(f, avi->movi_list + 4, (uint32_t)(idx1_pos - avi->movi_list - 8));
+    patch32(f, 32 + 4, (uint32_t)((uint64_t)avi->max_size * avi->fps));    // avih max bytes/s
+    patch32(f, 32 + 16, avi->frames);                                       // avih total frames
+    patch32(f, 32 + 56 + 12 + 8 + 32, avi->frames);                         // strh length
+
+    int err = ferror(f);
+    fclose(f);
+    free(avi->idx);
+    avi->idx = NULL;
+
+    return err ? -1 : end;
+}
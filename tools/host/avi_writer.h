@@ -0,0 +1,46 @@
+/**
+ * Minimal AVI writer for the host encoders
+ * One video stream, 00dc chunks, idx1 with per-frame keyframe flags
+ */
+
+#ifndef AVI_WRITER_H
+#define AVI_WRITER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    FILE *f;
+    uint32_t fps;
+    long movi_list;             // File offset of LIST movi
+    uint32_t frames;
+    uint32_t max_size;
+    uint64_t total_size;
+    uint32_t *idx;              // offset, size | keyframe flag in bit 31
+    size_t idx_cap;
+} avi_writer_t;
+
+/**
+ * Create file and write headers (patched on close)
+ *
+ * @return 0 on success
+ */
+int avi_writer_open(avi_writer_t *avi, const char *path, uint32_t width, uint32_t height,
+                    uint32_t fps, const char *fourcc);
+
+/**
+ * Append one frame
+ *
+ * @return 0 on success
+ */
+int avi_writer_add(avi_writer_t *avi, const uint8_t *data, uint32_t size, bool keyframe);
+
+/**
+ * Write idx1, patch sizes and close
+ *
+ * @return File size in bytes, or -1 on error
+ */
+long avi_writer_close(avi_writer_t *avi);
+
+#endif // AVI_WRITER_H
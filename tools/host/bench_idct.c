@@ -0,0 +1,162 @@
+/**
+ * Sparse IDCT Host Benchmark
+ *
+ * Decodes MJPEG AVI episodes (or single .jpg files) with jpeg_sw.c at full
+ * scale, once with sparse IDCT dispatch and once with the full IDCT for
+ * every block. Reports the block class histogram (DC only, 2x2, 4x4, full)
+ * and the decode speedup. Fails if the two outputs ever differ.
+ *
+ * Usage: bench_idct [-n max_frames] file.avi|file.jpg ...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "jpeg_sw.h"
+#include "avi_parser.h"
+
+#define MAX_PIXELS      (640 * 480)
+
+static const char *g_class_names[JPEG_BLOCK_CLASS_COUNT] = {"DC", "2x2", "4x4", "full"};
+
+static jpeg_sw_t *g_jpeg;
+static uint16_t g_sparse_out[MAX_PIXELS];
+static uint16_t g_full_out[MAX_PIXELS];
+
+typedef struct {
+    uint64_t sparse_ns;
+    uint64_t full_ns;
+    uint64_t blocks[JPEG_BLOCK_CLASS_COUNT];
+    uint32_t frames;
+    uint32_t mismatches;
+} totals_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Decode one frame both ways, count its blocks and compare outputs
+ */
+static void decode_frame(const uint8_t *data, uint32_t size, totals_t *t)
+{
+    uint16_t w, h;
+    jpeg_sw_stats_t stats;
+
+    jpeg_sw_reset_stats(g_jpeg);
+    jpeg_sw_set_sparse_idct(g_jpeg, true);
+    uint64_t t0 = now_ns();
+    if (jpeg_sw_decode(g_jpeg, data, size, JPEG_SCALE_1_1, g_sparse_out, MAX_PIXELS, &w, &h) != ESP_OK) {
+        return;
+    }
+    uint64_t t1 = now_ns();
+    jpeg_sw_get_stats(g_jpeg, &stats);
+
+    jpeg_sw_set_sparse_idct(g_jpeg, false);
+    uint64_t t2 = now_ns();
+    jpeg_sw_decode(g_jpeg, data, size, JPEG_SCALE_1_1, g_full_out, MAX_PIXELS, NULL, NULL);
+    uint64_t t3 = now_ns();
+
+    t->sparse_ns += t1 - t0;
+    t->full_ns += t3 - t2;
+    for (int c = 0; c < JPEG_BLOCK_CLASS_COUNT; c++) {
+        t->blocks[c] += stats.blocks[c];
+    }
+    t->frames++;
+
+    if (memcmp(g_sparse_out, g_full_out, (size_t)w * h * sizeof(uint16_t)) != 0) {
+        if (t->mismatches++ < 3) printf("  output mismatch at frame %lu\n", (unsigned long)t->frames);
+    }
+}
+
+/**
+ * Decode every video frame of an AVI, or a whole .jpg file
+ */
+static int run_file(const char *path, uint32_t max_frames, totals_t *t)
+{
+    size_t len = strlen(path);
+
+    if (len > 4 && (strcmp(path + len - 4, ".jpg") == 0 || strcmp(path + len - 4, ".JPG") == 0)) {
+        FILE *f = fopen(path, "rb");
+        if (f == NULL) return -1;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        uint8_t *data = malloc(size);
+        if (data == NULL || fread(data, 1, size, f) != (size_t)size) {
+            free(data);
+            fclose(f);
+            return -1;
+        }
+        fclose(f);
+        decode_frame(data, size, t);
+        free(data);
+        return 0;
+    }
+
+    avi_parser_t avi = {0};
+    if (avi_parser_open(&avi, path) != ESP_OK) return -1;
+
+    mjpeg_frame_t frame;
+    while (t->frames < max_frames && avi_parser_read_video_frame(&avi, &frame) == ESP_OK) {
+        decode_frame(frame.data, frame.size, t);
+        avi_parser_free_frame(&frame);
+    }
+    avi_parser_close(&avi);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t max_frames = 2000;
+    int first = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        max_frames = strtoul(argv[2], NULL, 10);
+        first = 3;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "Usage: %s [-n max_frames] file.avi|file.jpg ...\n", argv[0]);
+        return 2;
+    }
+
+    g_jpeg = jpeg_sw_create();
+    if (g_jpeg == NULL) return 1;
+
+    printf("  %-28s %6s %6s %6s %6s %6s %9s %9s %7s\n", "file", "frames",
+           g_class_names[0], g_class_names[1], g_class_names[2], g_class_names[3],
+           "full ms", "sparse ms", "speedup");
+
+    int failures = 0;
+    for (int i = first; i < argc; i++) {
+        totals_t t = {0};
+
+        if (run_file(argv[i], max_frames, &t) != 0 || t.frames == 0) {
+            printf("  %-28s unreadable\n", argv[i]);
+            failures++;
+            continue;
+        }
+
+        uint64_t total = 0;
+        for (int c = 0; c < JPEG_BLOCK_CLASS_COUNT; c++) total += t.blocks[c];
+
+        const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+        printf("  %-28.28s %6lu", name, (unsigned long)t.frames);
+        for (int c = 0; c < JPEG_BLOCK_CLASS_COUNT; c++) {
+            printf(" %5.1f%%", total ? 100.0 * t.blocks[c] / total : 0.0);
+        }
+        printf(" %9.3f %9.3f %6.2fx  %s\n", t.full_ns / 1e6 / t.frames, t.sparse_ns / 1e6 / t.frames,
+               t.sparse_ns ? (double)t.full_ns / t.sparse_ns : 0.0, t.mismatches ? "MISMATCH" : "ok");
+
+        if (t.mismatches) failures++;
+    }
+
+    jpeg_sw_destroy(g_jpeg);
+    printf("%s\n", failures ? "FAILED" : "Sparse and full IDCT outputs identical");
+    return failures ? 1 : 0;
+}
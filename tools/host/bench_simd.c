@@ -0,0 +1,242 @@
+/**
+ * SIMD Kernel Host Check
+ *
+ * Built with SIMD_PIE_EMULATE, so the PIE kernels in simd_pie.c run against
+ * the register model in pie.h. Calls every public kernel with PIE enabled
+ * and disabled on random input, lengths and alignments and compares the
+ * results; given MJPEG AVIs or .jpg files, also decodes each frame both
+ * ways. Emulated PIE is slow, so only correctness is reported here; the
+ * on-target bench_simd() has the timings. Fails on any difference.
+ *
+ * Usage: bench_simd [-n iterations] [file.avi|file.jpg ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "simd.h"
+#include "jpeg_sw.h"
+#include "avi_parser.h"
+
+#define MAX_PIXELS      (640 * 480)
+
+static uint32_t g_seed = 1;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1664525u + 1013904223u;
+    return g_seed >> 8;
+}
+
+/**
+ * Volume scaling at every head/tail split
+ */
+static int check_scale(int iterations)
+{
+    static int16_t src[512 + 8] __attribute__((aligned(16)));
+    static int16_t ref[512 + 8] __attribute__((aligned(16)));
+    static int16_t vec[512 + 8] __attribute__((aligned(16)));
+
+    for (int n = 0; n < iterations; n++) {
+        size_t offset = rnd() % 8;
+        size_t count = rnd() % 512;
+        int16_t gain = rnd() % 32768;
+
+        for (size_t i = 0; i < count; i++) src[offset + i] = (int16_t)rnd();
+        memcpy(ref, src, sizeof(src));
+        memcpy(vec, src, sizeof(src));
+
+        simd_set_enabled(false);
+        simd_scale_s16(ref + offset, count, gain);
+        simd_set_enabled(true);
+        simd_scale_s16(vec + offset, count, gain);
+        if (memcmp(ref, vec, sizeof(ref)) != 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * Buffer compare, equal and with one flipped bit
+ */
+static int check_equal(int iterations)
+{
+    static uint8_t a[4096] __attribute__((aligned(16)));
+    static uint8_t b[4096] __attribute__((aligned(16)));
+
+    simd_set_enabled(true);
+    for (int n = 0; n < iterations; n++) {
+        size_t bytes = 1 + rnd() % sizeof(a);
+
+        for (size_t i = 0; i < bytes; i++) a[i] = rnd();
+        memcpy(b, a, bytes);
+        if (!simd_equal(a, b, bytes)) return 1;
+
+        size_t pos = rnd() % bytes;
+        b[pos] ^= 1 << (rnd() % 8);
+        if (simd_equal(a, b, bytes)) return 1;
+    }
+    return 0;
+}
+
+/**
+ * Color rows in every chroma mode
+ */
+static int check_ycc(int iterations)
+{
+    static uint8_t in[3][8] __attribute__((aligned(16)));
+    uint8_t ref[16] __attribute__((aligned(16)));
+    uint8_t vec[16] __attribute__((aligned(16)));
+
+    for (int n = 0; n < iterations; n++) {
+        simd_chroma_t chroma = rnd() % 3;
+
+        for (int i = 0; i < 24; i++) in[i / 8][i % 8] = rnd();
+        simd_set_enabled(false);
+        simd_ycc_row8_rgb565(in[0], in[1], in[2], chroma, ref);
+        simd_set_enabled(true);
+        simd_ycc_row8_rgb565(in[0], in[1], in[2], chroma, vec);
+        if (memcmp(ref, vec, sizeof(ref)) != 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * IDCT on sparse and dense blocks up to the magnitude limit
+ */
+static int check_idct(int iterations)
+{
+    int32_t coef[64] __attribute__((aligned(16)));
+    uint8_t ref[64] __attribute__((aligned(16)));
+    uint8_t vec[64] __attribute__((aligned(16)));
+
+    for (int n = 0; n < iterations; n++) {
+        int budget = SIMD_IDCT_MAX_ABS_SUM;
+        int count = 1 + rnd() % 64;
+
+        memset(coef, 0, sizeof(coef));
+        for (int i = 0; i < count && budget > 0; i++) {
+            int mag = rnd() % (budget + 1);
+            coef[rnd() % 64] = (rnd() & 1) ? -mag : mag;
+            budget -= mag;
+        }
+
+        simd_set_enabled(false);
+        simd_idct_8x8(coef, ref);
+        simd_set_enabled(true);
+        simd_idct_8x8(coef, vec);
+        if (memcmp(ref, vec, sizeof(ref)) != 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * Decode one frame with PIE on and off
+ */
+static int check_frame(jpeg_sw_t *jpeg, const uint8_t *data, uint32_t size)
+{
+    static uint16_t ref[MAX_PIXELS] __attribute__((aligned(16)));
+    static uint16_t vec[MAX_PIXELS] __attribute__((aligned(16)));
+    uint16_t w, h;
+
+    simd_set_enabled(false);
+    if (jpeg_sw_decode(jpeg, data, size, JPEG_SCALE_1_1, ref, MAX_PIXELS, &w, &h) != ESP_OK) return 0;
+    simd_set_enabled(true);
+    jpeg_sw_decode(jpeg, data, size, JPEG_SCALE_1_1, vec, MAX_PIXELS, NULL, NULL);
+
+    return memcmp(ref, vec, (size_t)w * h * sizeof(uint16_t)) != 0;
+}
+
+/**
+ * Decode every frame of an AVI, or a whole .jpg file
+ * Returns the number of mismatching frames, or -1 if unreadable
+ */
+static int check_file(jpeg_sw_t *jpeg, const char *path, uint32_t *frames)
+{
+    size_t len = strlen(path);
+    int mismatches = 0;
+
+    if (len > 4 && (strcmp(path + len - 4, ".jpg") == 0 || strcmp(path + len - 4, ".JPG") == 0)) {
+        FILE *f = fopen(path, "rb");
+        if (f == NULL) return -1;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        uint8_t *data = malloc(size);
+        if (data == NULL || fread(data, 1, size, f) != (size_t)size) {
+            free(data);
+            fclose(f);
+            return -1;
+        }
+        fclose(f);
+        mismatches = check_frame(jpeg, data, size);
+        (*frames)++;
+        free(data);
+        return mismatches;
+    }
+
+    avi_parser_t avi = {0};
+    if (avi_parser_open(&avi, path) != ESP_OK) return -1;
+
+    mjpeg_frame_t frame;
+    while (avi_parser_read_video_frame(&avi, &frame) == ESP_OK) {
+        mismatches += check_frame(jpeg, frame.data, frame.size);
+        (*frames)++;
+        avi_parser_free_frame(&frame);
+    }
+    avi_parser_close(&avi);
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 20000;
+    int first = 1;
+    int failures = 0;
+
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        iterations = atoi(argv[2]);
+        first = 3;
+    }
+
+    if (!simd_available()) {
+        printf("PIE self-test failed\nFAILED\n");
+        return 1;
+    }
+
+    static const struct {
+        const char *name;
+        int (*check)(int iterations);
+    } kernels[] = {
+        {"scale_s16", check_scale},
+        {"equal", check_equal},
+        {"ycc_row8_rgb565", check_ycc},
+        {"idct_8x8", check_idct},
+    };
+
+    printf("PIE kernels (emulated) vs scalar, %d cases each\n", iterations);
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        int bad = kernels[k].check(iterations);
+        printf("  %-28s %s\n", kernels[k].name, bad ? "MISMATCH" : "ok");
+        failures += bad;
+    }
+
+    jpeg_sw_t *jpeg = (first < argc) ? jpeg_sw_create() : NULL;
+    for (int i = first; i < argc && jpeg != NULL; i++) {
+        uint32_t frames = 0;
+        int bad = check_file(jpeg, argv[i], &frames);
+        const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+
+        if (bad < 0) {
+            printf("  %-28.28s unreadable\n", name);
+            failures++;
+        } else {
+            printf("  %-28.28s %6lu frames  %s\n", name, (unsigned long)frames, bad ? "MISMATCH" : "ok");
+            failures += (bad > 0);
+        }
+    }
+    jpeg_sw_destroy(jpeg);
+
+    printf("%s\n", failures ? "FAILED" : "PIE and scalar results identical");
+    return failures ? 1 : 0;
+}
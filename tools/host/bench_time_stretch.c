@@ -0,0 +1,228 @@
+/**
+ * WSOLA Time Stretch Host Benchmark
+ *
+ * Runs time_stretch.c at 1.25x, 1.5x and 2x over a synthetic speech-like
+ * signal (or a raw s16le mono file) and reports cost per second of input
+ * audio, output length accuracy and pitch preservation.
+ *
+ * Usage: bench_time_stretch [input.raw [output_prefix]]
+ *   input.raw      s16le mono at 22050 Hz
+ *   output_prefix  writes <prefix>_<rate>.raw for listening
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "time_stretch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#define SAMPLE_RATE     22050
+#define BLOCK_SAMPLES   1024
+#define SYNTH_SECONDS   20
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t cycles(void)
+{
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Voiced syllables: harmonic series with gliding pitch, 4 Hz envelope, noise
+ */
+static int16_t *synth_speech(size_t n)
+{
+    int16_t *pcm = malloc(n * sizeof(int16_t));
+    double phase = 0;
+    uint32_t seed = 1;
+
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / SAMPLE_RATE;
+        double f0 = 140 + 40 * sin(2 * M_PI * 0.7 * t);
+        double env = 0.5 + 0.5 * sin(2 * M_PI * 4 * t);
+        phase += 2 * M_PI * f0 / SAMPLE_RATE;
+
+        double v = 0;
+        for (int h = 1; h <= 12; h++) {
+            v += sin(h * phase) / h;
+        }
+
+        seed = seed * 1664525 + 1013904223;
+        double noise = ((int32_t)(seed >> 16) - 32768) / 32768.0;
+
+        pcm[i] = (int16_t)(8000 * env * v + 300 * noise);
+    }
+
+    return pcm;
+}
+
+/**
+ * Constant 150 Hz harmonic tone for pitch measurement
+ */
+static int16_t *synth_tone(size_t n)
+{
+    int16_t *pcm = malloc(n * sizeof(int16_t));
+    for (size_t i = 0; i < n; i++) {
+        double p = 2 * M_PI * 150 * i / SAMPLE_RATE;
+        pcm[i] = (int16_t)(9000 * (sin(p) + 0.5 * sin(2 * p) + 0.3 * sin(3 * p)));
+    }
+    return pcm;
+}
+
+/**
+ * Dominant period (samples) by autocorrelation over 60-400 Hz
+ */
+static double dominant_period(const int16_t *x, size_t n)
+{
+    size_t win = 4096;
+    if (n < win + SAMPLE_RATE / 60) return 0;
+
+    const int16_t *seg = &x[n / 2 - win / 2 - SAMPLE_RATE / 120];
+    int best = 0;
+    double best_corr = -1e30;
+
+    for (int lag = SAMPLE_RATE / 400; lag <= SAMPLE_RATE / 60; lag++) {
+        double c = 0;
+        for (size_t i = 0; i < win; i++) c += (double)seg[i] * seg[i + lag];
+        if (c > best_corr) {
+            best_corr = c;
+            best = lag;
+        }
+    }
+    return best;
+}
+
+/**
+ * Stretch a whole buffer in BLOCK_SAMPLES chunks
+ */
+static int16_t *stretch_all(time_stretch_t *ts, const int16_t *in, size_t n, size_t *out_n,
+                            uint64_t *ns, uint64_t *cyc)
+{
+    size_t cap = time_stretch_max_output(ts, BLOCK_SAMPLES);
+    int16_t *out = malloc((n + cap) * sizeof(int16_t));
+    size_t total = 0;
+
+    uint64_t t0 = now_ns();
+    uint64_t c0 = cycles();
+
+    for (size_t pos = 0; pos < n; pos += BLOCK_SAMPLES) {
+        size_t len = (n - pos < BLOCK_SAMPLES) ? n - pos : BLOCK_SAMPLES;
+        size_t produced = 0;
+        if (time_stretch_process(ts, &in[pos], len, &out[total], cap, &produced) != ESP_OK) {
+            fprintf(stderr, "process failed\n");
+            exit(1);
+        }
+        total += produced;
+    }
+
+    *cyc = cycles() - c0;
+    *ns = now_ns() - t0;
+    *out_n = total;
+    return out;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n;
+    int16_t *speech;
+
+    if (argc > 1) {
+        FILE *f = fopen(argv[1], "rb");
+        if (!f) {
+            perror(argv[1]);
+            return 1;
+        }
+        fseek(f, 0, SEEK_END);
+        n = ftell(f) / sizeof(int16_t);
+        fseek(f, 0, SEEK_SET);
+        speech = malloc(n * sizeof(int16_t));
+        n = fread(speech, sizeof(int16_t), n, f);
+        fclose(f);
+    } else {
+        n = SYNTH_SECONDS * SAMPLE_RATE;
+        speech = synth_speech(n);
+    }
+
+    if (n == 0) {
+        fprintf(stderr, "No input samples\n");
+        return 1;
+    }
+
+    int16_t *tone = synth_tone(4 * SAMPLE_RATE);
+    double in_period = dominant_period(tone, 4 * SAMPLE_RATE);
+    double seconds = (double)n / SAMPLE_RATE;
+
+    const uint16_t rates[] = {320, 384, 448, 512};  // 1.25x 1.5x 1.75x 2x
+
+    time_stretch_t *ts = time_stretch_create(SAMPLE_RATE);
+    if (ts == NULL) return 1;
+
+    printf("WSOLA time stretch, %.1f s of %s audio at %d Hz, %d-sample blocks\n",
+           seconds, argc > 1 ? "input" : "synthetic", SAMPLE_RATE, BLOCK_SAMPLES);
+    printf("%-6s %10s %14s %12s %12s\n",
+           "rate", "us/s", "cycles/s", "len error", "pitch");
+
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        time_stretch_set_rate(ts, rates[r]);
+        double rate = rates[r] / 256.0;
+
+        size_t out_n;
+        uint64_t ns, cyc;
+        int16_t *out = stretch_all(ts, speech, n, &out_n, &ns, &cyc);
+
+        double expected = n / rate;
+        double len_err = 100.0 * (out_n - expected) / expected;
+
+        // Pitch: stretch a steady tone and compare periods
+        time_stretch_reset(ts);
+        size_t tone_out_n;
+        uint64_t tns, tcyc;
+        int16_t *tone_out = stretch_all(ts, tone, 4 * SAMPLE_RATE, &tone_out_n, &tns, &tcyc);
+        double out_period = dominant_period(tone_out, tone_out_n);
+
+        double us_per_sec = ns / 1000.0 / seconds;
+        double cyc_per_sec = HAVE_TSC ? cyc / seconds : 0;
+
+        printf("%-6.2f %10.0f %14.0f %+11.2f%% %5.0f->%-5.0f\n",
+               rate, us_per_sec, cyc_per_sec, len_err, in_period, out_period);
+
+        if (argc > 2) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s_%.2fx.raw", argv[2], rate);
+            FILE *f = fopen(path, "wb");
+            if (f) {
+                fwrite(out, sizeof(int16_t), out_n, f);
+                fclose(f);
+            }
+        }
+
+        free(out);
+        free(tone_out);
+        time_stretch_reset(ts);
+    }
+
+    printf("On-target cycle counts: bench_time_stretch() in src/benchmarks.c\n");
+
+    time_stretch_destroy(ts);
+    free(speech);
+    free(tone);
+    return 0;
+}
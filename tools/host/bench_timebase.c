@@ -0,0 +1,105 @@
+/**
+ * Rational Timebase Host Check
+ *
+ * Compares frame deadlines from timebase.c with the exact rational time
+ * over 100,000 frames (about 55 minutes at 29.97 fps) for common AVI
+ * rates, next to the old rounded-fps scheme. Fails if any deadline is off
+ * by 1 us or more, or if a conversion does not round-trip.
+ *
+ * Usage: bench_timebase
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "timebase.h"
+
+#define FRAMES      100000
+
+typedef struct {
+    const char *name;
+    uint32_t rate;
+    uint32_t scale;
+} rate_case_t;
+
+static const rate_case_t g_cases[] = {
+    {"23.976",      24000,   1001},
+    {"29.97",       30000,   1001},
+    {"59.94",       60000,   1001},
+    {"15",          15,      1},
+    {"25",          25,      1},
+    {"30 (us)",     1000000, 33333},    // Main header period only
+    {"12.5 (x100)", 1250,    100},      // Unreduced pair
+};
+
+/**
+ * Check one rate; returns the number of failures
+ */
+static int check_rate(const rate_case_t *c)
+{
+    timebase_t tb;
+    timebase_init(&tb, c->rate, c->scale);
+
+    // What the player did before: integer fps, integer period, accumulated
+    uint32_t old_fps = c->rate / c->scale;
+    uint64_t old_period = 1000000 / (old_fps ? old_fps : TIMEBASE_DEFAULT_FPS);
+
+    int failures = 0;
+    uint64_t max_err_ns = 0;
+
+    for (uint64_t n = 1; n <= FRAMES; n++) {
+        uint64_t us = timebase_frame_to_us(&tb, n);
+
+        // Exact time in ns, rounded down: n * scale * 1e9 / rate
+        unsigned __int128 exact_ns = (unsigned __int128)n * c->scale * 1000000000u / c->rate;
+        uint64_t err_ns = (uint64_t)(exact_ns - (unsigned __int128)us * 1000);
+
+        if ((unsigned __int128)us * 1000 > exact_ns || err_ns >= 1000) {
+            if (failures++ < 3) {
+                printf("  %s: frame %llu at %llu us, exact %llu ns\n", c->name,
+                       (unsigned long long)n, (unsigned long long)us, (unsigned long long)exact_ns);
+            }
+        }
+        if (err_ns > max_err_ns) max_err_ns = err_ns;
+
+        // The frame showing at its own start time is itself
+        if (timebase_us_to_frame(&tb, us + 1) != n && failures++ < 3) {
+            printf("  %s: us_to_frame(%llu) = %llu, want %llu\n", c->name,
+                   (unsigned long long)us + 1,
+                   (unsigned long long)timebase_us_to_frame(&tb, us + 1), (unsigned long long)n);
+        }
+    }
+
+    uint64_t end_us = timebase_frame_to_us(&tb, FRAMES);
+    double old_drift = ((double)FRAMES * old_period - (double)end_us) / 1e6;
+
+    // Resume position: seconds -> frame -> seconds
+    for (uint32_t sec = 0; sec < 4 * 3600; sec += 7) {
+        uint32_t frame = timebase_sec_to_frame(&tb, sec);
+        if (timebase_frame_to_sec(&tb, frame) != sec && failures++ < 3) {
+            printf("  %s: %u s -> frame %u -> %u s\n", c->name, sec, frame,
+                   timebase_frame_to_sec(&tb, frame));
+        }
+    }
+
+    printf("  %-12s %6lu/%-6lu %10.3f %+12.3f %10llu  %s\n", c->name,
+           (unsigned long)tb.rate, (unsigned long)tb.scale, end_us / 1e6, old_drift,
+           (unsigned long long)max_err_ns, failures ? "FAIL" : "ok");
+
+    return failures;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    printf("Frame deadlines over %d frames\n", FRAMES);
+    printf("  %-12s %13s %10s %12s %10s\n", "fps", "rate/scale", "end (s)",
+           "old drift(s)", "max err ns");
+
+    for (size_t i = 0; i < sizeof(g_cases) / sizeof(g_cases[0]); i++) {
+        failures += check_rate(&g_cases[i]);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "Zero cumulative drift");
+    return failures ? 1 : 0;
+}
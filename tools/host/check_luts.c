@@ -0,0 +1,328 @@
+/**
+ * Generated Lookup Table Host Check
+ *
+ * Recomputes every table in luts.h from its reference definition, written
+ * independently of gen_luts.py: Huffman codes per T.81 Annex C, chroma
+ * terms from simd.h, Bayer thresholds by bit interleaving, the zigzag by
+ * walking the diagonals, IDCT matrices from the islow butterflies and the
+ * cosine formula, and the volume and battery curves from the arithmetic
+ * they replaced. Fails on any difference.
+ *
+ * Usage: check_luts
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "luts.h"
+#include "simd.h"
+
+// ITU-T T.81 Annex K.3
+static const uint8_t k3_dc_lum_bits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+static const uint8_t k3_dc_chr_bits[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+static const uint8_t k3_dc_vals[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static const uint8_t k3_ac_lum_bits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D};
+static const uint8_t k3_ac_lum_vals[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+    0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+    0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+    0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA,
+};
+
+static const uint8_t k3_ac_chr_bits[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+static const uint8_t k3_ac_chr_vals[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+    0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+    0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+    0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+    0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+    0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA,
+};
+
+/**
+ * Decode one code left-aligned in 16 bits the way jpeg_sw does
+ * Returns the symbol, or -1 if no code matches; *len gets its length
+ */
+static int table_decode(const lut_huff_t *h, uint32_t bits16, int *len)
+{
+    uint32_t look = bits16 >> (16 - LUT_HUFF_LOOKAHEAD);
+
+    if (h->look_len[look]) {
+        *len = h->look_len[look];
+        return h->look_sym[look];
+    }
+    for (int l = LUT_HUFF_LOOKAHEAD + 1; l <= 16; l++) {
+        int32_t code = bits16 >> (16 - l);
+        if (code <= h->maxcode[l]) {
+            *len = l;
+            return h->vals[code + h->valoffset[l]];
+        }
+    }
+    return -1;
+}
+
+/**
+ * Every code of the table (Annex C HUFFSIZE/HUFFCODE) must decode to its
+ * symbol through both paths, and no other 9-bit prefix may hit the lookahead
+ */
+static int check_huff(const char *name, const lut_huff_t *h, const uint8_t *bits, const uint8_t *vals)
+{
+    uint8_t huffsize[257];
+    uint16_t huffcode[256];
+    uint8_t claimed[1 << LUT_HUFF_LOOKAHEAD] = {0};
+    int n = 0;
+    int bad = 0;
+
+    // C.1: sizes, C.2: codes
+    for (int l = 1; l <= 16; l++) {
+        for (int i = 0; i < bits[l - 1]; i++) huffsize[n++] = l;
+    }
+    huffsize[n] = 0;
+
+    uint16_t code = 0;
+    for (int k = 0, size = huffsize[0]; huffsize[k]; size++, code <<= 1) {
+        while (huffsize[k] == size) huffcode[k++] = code++;
+    }
+
+    for (int k = 0; k < n; k++) {
+        int size = huffsize[k];
+        uint32_t left = (uint32_t)huffcode[k] << (16 - size);
+
+        // Both the all-zero and all-one suffixes must give the same result
+        for (int fill = 0; fill < 2; fill++) {
+            uint32_t in = fill ? left | ((1u << (16 - size)) - 1) : left;
+            int len = 0;
+            int sym = table_decode(h, in, &len);
+            if (sym != vals[k] || len != size) bad++;
+        }
+        if (size <= LUT_HUFF_LOOKAHEAD) {
+            int shift = LUT_HUFF_LOOKAHEAD - size;
+            for (int j = 0; j < (1 << shift); j++) claimed[(huffcode[k] << shift) + j] = 1;
+        }
+        if (h->vals[k] != vals[k]) bad++;
+    }
+
+    for (int i = 0; i < (1 << LUT_HUFF_LOOKAHEAD); i++) {
+        if (!claimed[i] && h->look_len[i] != 0) bad++;
+    }
+    if (h->maxcode[17] != 0x7FFFFFFF) bad++;
+
+    printf("  %-18s %3d codes  %s\n", name, n, bad ? "MISMATCH" : "ok");
+    return bad != 0;
+}
+
+static int check_chroma(void)
+{
+    int bad = 0;
+
+    for (int i = 0; i < 256; i++) {
+        bad += lut_cr_r[i] != simd_cr_r(i);
+        bad += lut_cb_b[i] != simd_cb_b(i);
+        bad += lut_cb_g[i] != simd_cb_g(i);
+        bad += lut_cr_g[i] != simd_cr_g(i);
+    }
+    printf("  %-18s %s\n", "chroma", bad ? "MISMATCH" : "ok");
+    return bad != 0;
+}
+
+/**
+ * Bayer threshold: bit-reversed interleave of (x ^ y, y)
+ */
+static int check_bayer(void)
+{
+    int bad = 0;
+
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int v = 0;
+            for (int bit = 0; bit < 2; bit++) {
+                int xy = ((x ^ y) >> bit) & 1;
+                int yb = (y >> bit) & 1;
+                v |= ((xy << 1) | yb) << (2 - 2 * bit);
+            }
+            bad += lut_bayer4[y][x] != v;
+        }
+    }
+    printf("  %-18s %s\n", "bayer4", bad ? "MISMATCH" : "ok");
+    return bad != 0;
+}
+
+/**
+ * Walk the diagonals, alternating up-right and down-left
+ */
+static int check_zigzag(void)
+{
+    int x = 0, y = 0;
+    int bad = 0;
+
+    for (int k = 0; k < 64; k++) {
+        bad += lut_zigzag[k] != y * 8 + x;
+
+        if (((x + y) & 1) == 0) {
+            if (x == 7) y++;
+            else if (y == 0) x++;
+            else x++, y--;
+        } else {
+            if (y == 7) x++;
+            else if (x == 0) y++;
+            else x--, y++;
+        }
+    }
+    printf("  %-18s %s\n", "zigzag", bad ? "MISMATCH" : "ok");
+    return bad != 0;
+}
+
+/**
+ * islow 1-D pass (jpeg_sw.c idct_1d), before descaling
+ */
+static void islow_1d(const int32_t *x, int32_t *o)
+{
+    int32_t z1 = (x[2] + x[6]) * 4433;
+    int32_t tmp2 = z1 - x[6] * 15137;
+    int32_t tmp3 = z1 + x[2] * 6270;
+    int32_t tmp0 = (x[0] + x[4]) << 13;
+    int32_t tmp1 = (x[0] - x[4]) << 13;
+    int32_t tmp10 = tmp0 + tmp3, tmp13 = tmp0 - tmp3;
+    int32_t tmp11 = tmp1 + tmp2, tmp12 = tmp1 - tmp2;
+
+    tmp0 = x[7]; tmp1 = x[5]; tmp2 = x[3]; tmp3 = x[1];
+    z1 = tmp0 + tmp3;
+    int32_t z2 = tmp1 + tmp2;
+    int32_t z3 = tmp0 + tmp2;
+    int32_t z4 = tmp1 + tmp3;
+    int32_t z5 = (z3 + z4) * 9633;
+    tmp0 *= 2446;
+    tmp1 *= 16819;
+    tmp2 *= 25172;
+    tmp3 *= 12299;
+    z1 *= -7373;
+    z2 *= -20995;
+    z3 = z3 * -16069 + z5;
+    z4 = z4 * -3196 + z5;
+    tmp0 += z1 + z3;
+    tmp1 += z2 + z4;
+    tmp2 += z2 + z3;
+    tmp3 += z1 + z4;
+
+    o[0] = tmp10 + tmp3; o[7] = tmp10 - tmp3;
+    o[1] = tmp11 + tmp2; o[6] = tmp11 - tmp2;
+    o[2] = tmp12 + tmp1; o[5] = tmp12 - tmp1;
+    o[3] = tmp13 + tmp0; o[4] = tmp13 - tmp0;
+}
+
+/**
+ * LL&M matrix: must reproduce the butterflies on arbitrary inputs and stay
+ * within rounding of the exact DCT basis
+ */
+static int check_idct_llm(void)
+{
+    uint32_t seed = 1;
+    int bad = 0;
+
+    for (int n = 0; n < 10000; n++) {
+        int32_t x[8], o[8];
+
+        for (int i = 0; i < 8; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            x[i] = (int32_t)(seed >> 20) - 2048;
+        }
+        islow_1d(x, o);
+        for (int k = 0; k < 8; k++) {
+            int32_t acc = 0;
+            for (int i = 0; i < 8; i++) acc += x[i] * lut_idct_llm[i][k];
+            bad += acc != o[k];
+        }
+    }
+
+    for (int i = 0; i < 8; i++) {
+        double c = (i == 0) ? 1.0 : sqrt(2.0);
+        for (int k = 0; k < 8; k++) {
+            double exact = 8192.0 * c * cos((2 * k + 1) * i * M_PI / 16);
+            bad += fabs(lut_idct_llm[i][k] - exact) > 2.0;
+        }
+    }
+
+    if (((uintptr_t)lut_idct_llm & 15) != 0) bad++;
+
+    printf("  %-18s %s\n", "idct_llm", bad ? "MISMATCH" : "ok");
+    return bad != 0;
+}
+
+static int check_idct_reduced(const char *name, const int16_t *m, int size)
+{
+    int bad = 0;
+
+    for (int x = 0; x < size; x++) {
+        for (int u = 0; u < size; u++) {
+            double c = (u == 0) ? sqrt(0.5) : 1.0;
+            long exact = lround(c / 2 * cos((2 * x + 1) * u * M_PI / (2 * size)) * 8192);
+            bad += m[x * size + u] != exact;
+        }
+    }
+    printf("  %-18s %s\n", name, bad ? "MISMATCH" : "ok");
+    return bad != 0;
+}
+
+static int check_volume(void)
+{
+    int bad = 0;
+
+    // 100 bypasses scaling; its entry only has to be a valid gain
+    for (int v = 0; v < 100; v++) bad += lut_volume_q15[v] != (int16_t)((v * 32768) / 100);
+    bad += lut_volume_q15[100] != 32767;
+
+    printf("  %-18s %s\n", "volume_q15", bad ? "MISMATCH" : "ok");
+    return bad != 0;
+}
+
+/**
+ * Every millivolt from empty to full against the linear formula
+ */
+static int check_battery(void)
+{
+    const uint32_t range = LUT_BATTERY_FULL_MV - LUT_BATTERY_EMPTY_MV;
+    int bad = 0;
+
+    if (sizeof(lut_battery_pct) != range / LUT_BATTERY_STEP_MV + 1) bad++;
+    for (uint32_t mv = LUT_BATTERY_EMPTY_MV; mv <= LUT_BATTERY_FULL_MV; mv++) {
+        uint32_t value = mv - LUT_BATTERY_EMPTY_MV;
+        bad += lut_battery_pct[value / LUT_BATTERY_STEP_MV] != (value * 100) / range;
+    }
+    printf("  %-18s %s\n", "battery_pct", bad ? "MISMATCH" : "ok");
+    return bad != 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    printf("Generated tables vs reference math\n");
+    failures += check_huff("huff_std_dc_lum", &lut_huff_std_dc_lum, k3_dc_lum_bits, k3_dc_vals);
+    failures += check_huff("huff_std_dc_chr", &lut_huff_std_dc_chr, k3_dc_chr_bits, k3_dc_vals);
+    failures += check_huff("huff_std_ac_lum", &lut_huff_std_ac_lum, k3_ac_lum_bits, k3_ac_lum_vals);
+    failures += check_huff("huff_std_ac_chr", &lut_huff_std_ac_chr, k3_ac_chr_bits, k3_ac_chr_vals);
+    failures += check_chroma();
+    failures += check_bayer();
+    failures += check_zigzag();
+    failures += check_idct_llm();
+    failures += check_idct_reduced("idct4", &lut_idct4[0][0], 4);
+    failures += check_idct_reduced("idct2", &lut_idct2[0][0], 2);
+    failures += check_volume();
+    failures += check_battery();
+
+    printf("%s\n", failures ? "FAILED" : "All tables match");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,451 @@
+/**
+ * CRB Video Encoder
+ *
+ * Block-based conditional replenishment (see crb.h): each frame carries only
+ * the 8x8 or 16x16 blocks that differ from what the device is showing,
+ * coded as solid fills, raw RGB565 tiles or a JPEG mosaic of tiles. Skip
+ * decisions compare against the source as it was when each block was last
+ * coded, so JPEG noise does not make static blocks look changed and slow
+ * drift still gets caught. Every frame is decoded with the device code.
+ *
+ * Usage: crb_encode -w W -h H [-r fps] [-b 8|16] [-t threshold] [-k keyint]
+ *                   [-q quality] input.raw|- output.avi
+ *
+ *   -b  block size (default 16)
+ *   -t  largest per-channel change (0-255) a block may have and still be
+ *       skipped, also the spread allowed in a solid block (default 12)
+ *   -k  keyframe interval in frames (default 2 s)
+ *   -q  JPEG tile quality 1-100, 0 for raw tiles (default 80, needs libjpeg)
+ *
+ *   ffmpeg -i in.mp4 -vf "scale=240:180,fps=15" -f rawvideo -pix_fmt rgb565be - |
+ *       crb_encode -w 240 -h 180 -r 15 - out.avi
+ *
+ * With libjpeg each frame is also compressed whole at the same quality, so
+ * the summary compares file size, device-side decode time and SPI bytes per
+ * frame against plain MJPEG on the same clip.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "crb.h"
+#include "jpeg_sw.h"
+#include "avi_writer.h"
+
+#ifdef CRB_HAVE_JPEG
+#include <jpeglib.h>
+#endif
+
+#define MAX_SKIP_RUN    128
+#define MAX_CODED_RUN   64
+
+typedef enum {
+    BLOCK_SKIP,
+    BLOCK_TILE,
+    BLOCK_FILL,
+} block_kind_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Big-endian RGB565 pixel to 8-bit channels
+ */
+static void unpack(const uint8_t *p, int rgb[3])
+{
+    uint16_t v = (p[0] << 8) | p[1];
+    int r = (v >> 11) & 0x1F, g = (v >> 5) & 0x3F, b = v & 0x1F;
+
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+static int absdiff(int a, int b)
+{
+    return a > b ? a - b : b - a;
+}
+
+/**
+ * Classify one block against the source it was last coded from
+ *
+ * @param fill Output color (big-endian bytes) for BLOCK_FILL
+ */
+static block_kind_t classify(const uint8_t *src, const uint8_t *ref, uint32_t width,
+                             uint32_t bx, uint32_t by, uint32_t bw, uint32_t bh,
+                             int threshold, bool keyframe, uint8_t fill[2])
+{
+    bool changed = keyframe;
+    uint32_t sum[3] = {0};
+
+    for (uint32_t y = 0; y < bh; y++) {
+        uint32_t o = ((by + y) * width + bx) * 2;
+        for (uint32_t x = 0; x < bw; x++, o += 2) {
+            int a[3], b[3];
+            unpack(&src[o], a);
+            unpack(&ref[o], b);
+            for (int c = 0; c < 3; c++) {
+                if (absdiff(a[c], b[c]) > threshold) changed = true;
+            }
+
+            uint16_t v = (src[o] << 8) | src[o + 1];
+            sum[0] += (v >> 11) & 0x1F;
+            sum[1] += (v >> 5) & 0x3F;
+            sum[2] += v & 0x1F;
+        }
+    }
+
+    if (!changed) return BLOCK_SKIP;
+
+    uint32_t n = bw * bh;
+    uint16_t mean = (uint16_t)((((sum[0] + n / 2) / n) << 11) |
+                               (((sum[1] + n / 2) / n) << 5) |
+                               ((sum[2] + n / 2) / n));
+    uint8_t mp[2] = {mean >> 8, mean & 0xFF};
+    int m[3];
+    unpack(mp, m);
+
+    for (uint32_t y = 0; y < bh; y++) {
+        uint32_t o = ((by + y) * width + bx) * 2;
+        for (uint32_t x = 0; x < bw; x++, o += 2) {
+            int a[3];
+            unpack(&src[o], a);
+            for (int c = 0; c < 3; c++) {
+                if (absdiff(a[c], m[c]) > threshold) return BLOCK_TILE;
+            }
+        }
+    }
+
+    fill[0] = mp[0];
+    fill[1] = mp[1];
+    return BLOCK_FILL;
+}
+
+/**
+ * Copy a block into a tile, replicating edge pixels of clipped blocks
+ */
+static void copy_tile(const uint8_t *src, uint32_t width, uint32_t height,
+                      uint32_t bx, uint32_t by, uint32_t bs, uint8_t *tile, uint32_t stride)
+{
+    for (uint32_t y = 0; y < bs; y++) {
+        uint32_t sy = by + y < height ? by + y : height - 1;
+        for (uint32_t x = 0; x < bs; x++) {
+            uint32_t sx = bx + x < width ? bx + x : width - 1;
+            memcpy(&tile[(y * stride + x) * 2], &src[(sy * width + sx) * 2], 2);
+        }
+    }
+}
+
+#ifdef CRB_HAVE_JPEG
+/**
+ * Compress big-endian RGB565 pixels as a baseline JPEG
+ *
+ * @return JPEG size; *out is malloc'd by libjpeg
+ */
+static unsigned long jpeg_compress(const uint8_t *pixels, uint32_t width, uint32_t height,
+                                   int quality, bool full_chroma, unsigned char **out)
+{
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    unsigned long size = 0;
+    uint8_t *row = malloc(width * 3);
+
+    *out = NULL;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, out, &size);
+
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+
+    // 8x8 tiles must not share chroma samples with their neighbours
+    if (full_chroma) {
+        cinfo.comp_info[0].h_samp_factor = 1;
+        cinfo.comp_info[0].v_samp_factor = 1;
+    }
+
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < height) {
+        const uint8_t *p = &pixels[cinfo.next_scanline * width * 2];
+        for (uint32_t x = 0; x < width; x++) {
+            int c[3];
+            unpack(&p[x * 2], c);
+            row[x * 3] = c[0];
+            row[x * 3 + 1] = c[1];
+            row[x * 3 + 2] = c[2];
+        }
+        JSAMPROW rows[1] = {row};
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    free(row);
+    return size;
+}
+#endif
+
+/**
+ * Append one map opcode run
+ */
+static void emit_run(uint8_t *map, uint32_t *map_size, block_kind_t kind, uint32_t count,
+                     const uint8_t *colors)
+{
+    if (kind == BLOCK_SKIP) {
+        map[(*map_size)++] = CRB_OP_SKIP | (count - 1);
+        return;
+    }
+
+    map[(*map_size)++] = (kind == BLOCK_FILL ? CRB_OP_FILL : CRB_OP_TILE) | (count - 1);
+    if (kind == BLOCK_FILL) {
+        memcpy(&map[*map_size], colors, count * 2);
+        *map_size += count * 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t w = 0, h = 0, fps = 15, bs = 16, keyint = 0;
+    int threshold = 12;
+#ifdef CRB_HAVE_JPEG
+    int quality = 80;
+#else
+    int quality = 0;
+#endif
+    int opt;
+
+    while ((opt = getopt(argc, argv, "w:h:r:b:t:k:q:")) != -1) {
+        switch (opt) {
+            case 'w': w = atoi(optarg); break;
+            case 'h': h = atoi(optarg); break;
+            case 'r': fps = atoi(optarg); break;
+            case 'b': bs = atoi(optarg); break;
+            case 't': threshold = atoi(optarg); break;
+            case 'k': keyint = atoi(optarg); break;
+            case 'q': quality = atoi(optarg); break;
+            default: break;
+        }
+    }
+
+    if (w == 0 || h == 0 || fps == 0 || (bs != 8 && bs != 16) || quality < 0 || quality > 100 ||
+        argc - optind != 2) {
+        fprintf(stderr, "Usage: %s -w W -h H [-r fps] [-b 8|16] [-t threshold] [-k keyint] "
+                        "[-q quality] input.raw|- output.avi\n", argv[0]);
+        return 1;
+    }
+
+#ifndef CRB_HAVE_JPEG
+    if (quality > 0) {
+        fprintf(stderr, "Built without libjpeg: only raw tiles (-q 0)\n");
+        return 1;
+    }
+#endif
+
+    uint32_t cols = (w + bs - 1) / bs;
+    uint32_t rows = (h + bs - 1) / bs;
+    uint32_t blocks = cols * rows;
+
+    if (rows > CRB_MAX_BLOCK_ROWS) {
+        fprintf(stderr, "At most %d block rows\n", CRB_MAX_BLOCK_ROWS);
+        return 1;
+    }
+    if (keyint == 0) keyint = fps * 2;
+
+    FILE *in = strcmp(argv[optind], "-") ? fopen(argv[optind], "rb") : stdin;
+    avi_writer_t avi;
+    if (in == NULL || avi_writer_open(&avi, argv[optind + 1], w, h, fps, "CRB1") != 0) {
+        perror("open");
+        return 1;
+    }
+
+    size_t frame_bytes = (size_t)w * h * 2;
+    uint32_t mosaic_w = cols * bs;
+    size_t mosaic_pixels = (size_t)mosaic_w * rows * bs;
+    uint8_t *raw = malloc(frame_bytes);
+    uint16_t *canvas = calloc(1, frame_bytes);
+    uint8_t *coded = calloc(1, frame_bytes);
+    uint8_t *kinds = malloc(blocks);
+    uint8_t *colors = malloc(blocks * 2);
+    uint8_t *map = malloc(blocks * 3 + blocks / MAX_SKIP_RUN + 1);
+    uint8_t *tiles = malloc(mosaic_pixels * 2);
+    uint16_t *mosaic = malloc(mosaic_pixels * 2);
+    uint8_t *chunk = NULL;
+    jpeg_sw_t *jpeg = jpeg_sw_create();
+
+    uint32_t frames = 0;
+    uint64_t coded_tiles = 0, coded_fills = 0, spi_bytes = 0;
+    uint64_t decode_ns = 0, mjpeg_bytes = 0, mjpeg_decode_ns = 0;
+
+    while (fread(raw, 1, frame_bytes, in) == frame_bytes) {
+        bool keyframe = (frames % keyint) == 0;
+        uint32_t tile_count = 0;
+
+        // 1. Classify blocks against what the device shows
+        for (uint32_t b = 0; b < blocks; b++) {
+            uint32_t bx = (b % cols) * bs, by = (b / cols) * bs;
+            uint32_t bw = bx + bs <= w ? bs : w - bx;
+            uint32_t bh = by + bs <= h ? bs : h - by;
+
+            kinds[b] = classify(raw, coded, w, bx, by, bw, bh, threshold, keyframe, &colors[b * 2]);
+
+            if (kinds[b] != BLOCK_SKIP) {
+                for (uint32_t y = 0; y < bh; y++) {
+                    memcpy(&coded[((by + y) * w + bx) * 2], &raw[((by + y) * w + bx) * 2], bw * 2);
+                }
+            }
+
+            if (kinds[b] == BLOCK_TILE) {
+                uint8_t *dst = quality ? &tiles[((tile_count / cols) * bs * mosaic_w +
+                                                 (tile_count % cols) * bs) * 2]
+                                       : &tiles[tile_count * bs * bs * 2];
+                copy_tile(raw, w, h, bx, by, bs, dst, quality ? mosaic_w : bs);
+                tile_count++;
+            }
+        }
+
+        // 2. Block map: runs of one kind, trailing skips dropped
+        uint32_t map_size = 0;
+        uint32_t last = blocks;
+        while (last > 0 && kinds[last - 1] == BLOCK_SKIP) last--;
+
+        for (uint32_t b = 0; b < last;) {
+            block_kind_t kind = kinds[b];
+            uint32_t max = (kind == BLOCK_SKIP) ? MAX_SKIP_RUN : MAX_CODED_RUN;
+            uint32_t n = 1;
+            while (b + n < last && n < max && kinds[b + n] == kind) n++;
+
+            emit_run(map, &map_size, kind, n, &colors[b * 2]);
+            if (kind == BLOCK_FILL) coded_fills += n;
+            b += n;
+        }
+        coded_tiles += tile_count;
+
+        // 3. Tile payload
+        const uint8_t *payload = tiles;
+        unsigned long payload_size = (unsigned long)tile_count * bs * bs * 2;
+        unsigned char *jpeg_data = NULL;
+
+#ifdef CRB_HAVE_JPEG
+        if (quality && tile_count > 0) {
+            uint32_t mosaic_h = (tile_count + cols - 1) / cols * bs;
+            payload_size = jpeg_compress(tiles, mosaic_w, mosaic_h, quality, bs == 8, &jpeg_data);
+            payload = jpeg_data;
+        }
+#endif
+        if (quality && tile_count == 0) payload_size = 0;
+
+        uint32_t size = CRB_HEADER_SIZE + map_size + payload_size;
+        chunk = realloc(chunk, size);
+        chunk[0] = (keyframe ? CRB_FLAG_KEYFRAME : 0) | (quality ? CRB_FLAG_JPEG : 0);
+        chunk[1] = (uint8_t)bs;
+        chunk[2] = tile_count & 0xFF;
+        chunk[3] = tile_count >> 8;
+        for (int i = 0; i < 4; i++) chunk[4 + i] = (map_size >> (8 * i)) & 0xFF;
+        memcpy(&chunk[CRB_HEADER_SIZE], map, map_size);
+        memcpy(&chunk[CRB_HEADER_SIZE + map_size], payload, payload_size);
+        free(jpeg_data);
+
+        // 4. Decode with the device code; the result is the next reference
+        crb_frame_t crb;
+        uint64_t dirty = 0;
+        uint64_t t0 = now_ns();
+        esp_err_t ret = crb_parse(chunk, size, &crb);
+        if (ret == ESP_OK && crb.jpeg && crb.tile_count > 0) {
+            uint16_t dw, dh;
+            ret = jpeg_sw_decode(jpeg, crb.payload, crb.payload_size, JPEG_SCALE_1_1,
+                                 mosaic, mosaic_pixels, &dw, &dh);
+        }
+        if (ret == ESP_OK) {
+            ret = crb_apply(&crb, crb.jpeg ? mosaic : NULL, canvas, w, h, &dirty);
+        }
+        decode_ns += now_ns() - t0;
+
+        if (ret != ESP_OK || (quality == 0 && threshold == 0 && memcmp(raw, canvas, frame_bytes))) {
+            fprintf(stderr, "Frame %u failed round trip\n", frames);
+            return 1;
+        }
+
+        // Keyframes and the first frame go out whole; otherwise dirty rows only
+        uint32_t dirty_rows = 0;
+        for (uint32_t r = 0; r < rows; r++) {
+            if (dirty & (1ull << r)) dirty_rows += (r * bs + bs <= h) ? bs : h - r * bs;
+        }
+        spi_bytes += keyframe ? frame_bytes : (uint64_t)dirty_rows * w * 2;
+
+#ifdef CRB_HAVE_JPEG
+        // 5. Same frame as plain MJPEG for comparison
+        unsigned char *ref_jpeg = NULL;
+        unsigned long ref_size = jpeg_compress(raw, w, h, quality ? quality : 80, false, &ref_jpeg);
+        uint16_t dw, dh;
+
+        t0 = now_ns();
+        jpeg_sw_decode(jpeg, ref_jpeg, ref_size, JPEG_SCALE_1_1, mosaic, mosaic_pixels, &dw, &dh);
+        mjpeg_decode_ns += now_ns() - t0;
+        mjpeg_bytes += ref_size;
+        free(ref_jpeg);
+#endif
+
+        if (avi_writer_add(&avi, chunk, size, keyframe) != 0) {
+            perror("write");
+            return 1;
+        }
+        frames++;
+    }
+
+    uint64_t total = avi.total_size;
+    uint32_t max_size = avi.max_size;
+    long file_size = avi_writer_close(&avi);
+    if (file_size < 0) {
+        perror("write");
+        return 1;
+    }
+
+    if (in != stdin) fclose(in);
+
+    if (frames == 0) {
+        fprintf(stderr, "No complete %ux%u RGB565 frames in input\n", w, h);
+        return 1;
+    }
+
+    double avg = (double)total / frames;
+    printf("%u frames %ux%u @ %u fps, %ux%u blocks, %s tiles, keyframe every %u\n",
+           frames, w, h, fps, bs, bs, quality ? "JPEG" : "raw", keyint);
+    printf("  blocks coded: %.1f%% (%.1f%% tiles, %.1f%% solid)\n",
+           100.0 * (coded_tiles + coded_fills) / ((uint64_t)blocks * frames),
+           100.0 * coded_tiles / ((uint64_t)blocks * frames),
+           100.0 * coded_fills / ((uint64_t)blocks * frames));
+    printf("  frame: %.0f bytes avg, %u max; file %ld bytes\n", avg, max_size, file_size);
+    printf("  SPI: %.0f bytes/frame avg (%.1f%% of full frames)\n",
+           (double)spi_bytes / frames, 100.0 * spi_bytes / ((double)frame_bytes * frames));
+    printf("  host decode: %.3f ms/frame\n", decode_ns / 1e6 / frames);
+
+    if (mjpeg_bytes > 0) {
+        printf("  MJPEG q%d: %.0f bytes/frame (CRB %.2fx), host decode %.3f ms/frame, "
+               "SPI %zu bytes/frame\n",
+               quality ? quality : 80, (double)mjpeg_bytes / frames, (double)mjpeg_bytes / total,
+               mjpeg_decode_ns / 1e6 / frames, frame_bytes);
+    }
+
+    jpeg_sw_destroy(jpeg);
+    free(chunk);
+    free(mosaic);
+    free(tiles);
+    free(map);
+    free(colors);
+    free(kinds);
+    free(coded);
+    free(canvas);
+    free(raw);
+    return 0;
+}
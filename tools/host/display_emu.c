@@ -0,0 +1,571 @@
+/**
+ * Display Path Emulation
+ *
+ * Runs the real display component (display.c, st7789.c and the spi_master
+ * backend st7789_spi.c) against the ST7789 protocol emulator: init, clears
+ * and rectangles, buffer writes, full-frame, row-band and strip DMA in
+ * RGB565 and RGB444, queued strips with done callbacks, landscape MADCTL, vertical
+ * scroll, sleep, and SPI clock validation by readback over a link that is
+ * unwired, clean, or corrupts writes above a clock. After each scenario the emulated frame memory is compared
+ * with an independently computed reference, and the bus time is reported
+ * (bits at the real SPI clock plus per-transaction overhead). Fails on any
+ * pixel mismatch or protocol error.
+ *
+ * Usage: display_emu [-c spi_hz] [-o overhead_us] [-d out_dir]
+ *   -c  requested SPI clock (default DISPLAY_SPI_CLOCK)
+ *   -o  overhead charged per transaction, microseconds (default 10)
+ *   -d  write each scenario's panel image as out_dir/<scenario>.png
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "display.h"
+#include "st7789.h"
+#include "luts.h"
+#include "st7789_emu.h"
+#include "emu_driver.h"
+
+#define FRAME_W         240
+#define FRAME_H         180
+#define BAND_ROWS       20
+#define STRIP_ROWS      16
+
+static st7789_emu_t *g_emu;
+static const char *g_out_dir;
+static uint16_t g_ref[DISPLAY_WIDTH * DISPLAY_HEIGHT];     // Expected logical RGB565
+static int g_failures;
+
+/**
+ * Synthetic frame: gradients, color bars and a moving diagonal (RGB565)
+ */
+static void make_frame(uint16_t *px, int seed)
+{
+    static const uint16_t bars[8] = {
+        COLOR_WHITE, COLOR_YELLOW, COLOR_CYAN, COLOR_GREEN,
+        COLOR_MAGENTA, COLOR_RED, COLOR_BLUE, COLOR_BLACK,
+    };
+
+    for (int y = 0; y < FRAME_H; y++) {
+        for (int x = 0; x < FRAME_W; x++) {
+            uint16_t c;
+            if (y < 40) {
+                c = bars[x * 8 / FRAME_W];
+            } else {
+                c = RGB565(x + seed, y + seed * 3, (x ^ y) + seed * 7);
+            }
+            if (((x + seed) & 127) == (y & 127)) c = COLOR_WHITE;
+            px[y * FRAME_W + x] = c;
+        }
+    }
+}
+
+/**
+ * Reduce an 8-bit channel to 4 bits with an ordered dither threshold
+ */
+static uint8_t dither4(uint8_t v, uint8_t d)
+{
+    return (v - (v >> 4) + d) >> 4;
+}
+
+/**
+ * RGB565 pixel as the panel stores it after the RGB444 path
+ */
+static uint16_t through_444(uint16_t c, int x, int y)
+{
+    uint8_t d = lut_bayer4[y & 3][x & 3];
+    uint8_t r5 = c >> 11, g6 = (c >> 5) & 0x3F, b5 = c & 0x1F;
+    uint8_t r4 = dither4((r5 << 3) | (r5 >> 2), d);
+    uint8_t g4 = dither4((g6 << 2) | (g6 >> 4), d);
+    uint8_t b4 = dither4((b5 << 3) | (b5 >> 2), d);
+
+    // 4 -> 6 bits in the panel, 6 -> 5 for red and blue on readback
+    uint8_t r6 = (r4 << 2) | (r4 >> 2), g = (g4 << 2) | (g4 >> 2), b6 = (b4 << 2) | (b4 >> 2);
+    return ((r6 >> 1) << 11) | (g << 5) | (b6 >> 1);
+}
+
+static void ref_rect(int x, int y, int w, int h, uint16_t c)
+{
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) g_ref[j * DISPLAY_WIDTH + i] = c;
+    }
+}
+
+/**
+ * Expected contents after drawing frame rows [y0, y0 + rows) at (x, y)
+ */
+static void ref_frame(const uint16_t *px, int x, int y, int y0, int rows, bool rgb444)
+{
+    for (int j = y0; j < y0 + rows; j++) {
+        for (int i = 0; i < FRAME_W; i++) {
+            uint16_t c = px[j * FRAME_W + i];
+            g_ref[(y + j) * DISPLAY_WIDTH + x + i] = rgb444 ? through_444(c, i, j) : c;
+        }
+    }
+}
+
+/**
+ * Frame buffer loaded with a frame, big-endian as the decoders leave it
+ */
+static void load_frame(frame_buffer_t *fb, const uint16_t *px)
+{
+    for (int i = 0; i < FRAME_W * FRAME_H; i++) {
+        fb->buffer[i] = (px[i] >> 8) | (px[i] << 8);
+    }
+    fb->format = DISPLAY_FORMAT_RGB565;
+}
+
+/**
+ * Compare frame memory with the reference (portrait, logical coordinates)
+ */
+static int check_ref(void)
+{
+    int bad = 0;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            uint16_t got = st7789_emu_read565(g_emu, x, y);
+            uint16_t want = g_ref[y * DISPLAY_WIDTH + x];
+            if (got != want && bad++ == 0) {
+                fprintf(stderr, "  first mismatch at (%d, %d): 0x%04X, expected 0x%04X\n",
+                        x, y, got, want);
+            }
+        }
+    }
+    return bad;
+}
+
+/**
+ * Begin a scenario: clear the bus counters
+ */
+static void begin(void)
+{
+    st7789_emu_reset_stats(g_emu);
+}
+
+/**
+ * End a scenario: report bus time, verify, dump the panel image
+ *
+ * @param frames Frames drawn (for the fps column, 0 if not a frame test)
+ * @param bad Mismatching pixels
+ */
+static void end(const char *name, int frames, int bad)
+{
+    st7789_emu_stats_t s;
+    st7789_emu_get_stats(g_emu, &s);
+
+    double wire_ms = s.wire_ns / 1e6;
+    double total_ms = (s.wire_ns + s.overhead_ns) / 1e6;
+    bool ok = (bad == 0 && s.errors == 0 && emu_driver_in_flight() == 0);
+
+    printf("%-14s %6u %8llu %8.2f %8.2f", name, s.transactions,
+           (unsigned long long)s.data_bytes, wire_ms, total_ms);
+    if (frames > 0) {
+        printf(" %7.1f", frames * 1000.0 / total_ms);
+    } else {
+        printf(" %7s", "-");
+    }
+    if (ok) {
+        printf("  ok\n");
+    } else {
+        printf("  FAIL (%d pixels, %u protocol errors, %d uncollected)\n",
+               bad, s.errors, emu_driver_in_flight());
+        g_failures++;
+    }
+
+    if (g_out_dir) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.png", g_out_dir, name);
+        if (st7789_emu_write_png(g_emu, path) != 0) fprintf(stderr, "Cannot write %s\n", path);
+    }
+}
+
+/**
+ * Full frames by DMA, optionally packed to RGB444
+ */
+static void run_frames(const char *name, frame_buffer_t *fb, uint16_t *px, bool rgb444)
+{
+    const int frames = 4;
+    int x = (DISPLAY_WIDTH - FRAME_W) / 2, y = (DISPLAY_HEIGHT - FRAME_H) / 2;
+
+    begin();
+    for (int f = 0; f < frames; f++) {
+        make_frame(px, f);
+        load_frame(fb, px);
+        if (rgb444) display_pack_rgb444(fb);
+        if (display_write_frame_dma(fb) == ESP_OK) display_wait_dma();
+    }
+    ref_frame(px, x, y, 0, FRAME_H, rgb444);
+    end(name, frames, check_ref());
+}
+
+/**
+ * Row bands by DMA, each band waited for before the next is queued
+ */
+static void run_bands(const char *name, frame_buffer_t *fb, uint16_t *px, bool rgb444)
+{
+    int x = (DISPLAY_WIDTH - FRAME_W) / 2, y = (DISPLAY_HEIGHT - FRAME_H) / 2;
+
+    begin();
+    make_frame(px, 11);
+    load_frame(fb, px);
+    if (rgb444) display_pack_rgb444(fb);
+    bool pending = false;
+    for (int r = 0; r < FRAME_H; r += BAND_ROWS) {
+        if (pending) display_wait_dma();
+        pending = (display_write_rows_dma(fb, r, BAND_ROWS) == ESP_OK);
+    }
+    if (pending) display_wait_dma();
+    ref_frame(px, x, y, 0, FRAME_H, rgb444);
+    end(name, 1, check_ref());
+}
+
+/**
+ * Strips by DMA at explicit positions
+ */
+static void run_strips(uint16_t *px)
+{
+    frame_buffer_t *strip = display_alloc_frame_buffer(FRAME_W, STRIP_ROWS);
+    int y0 = (DISPLAY_HEIGHT - FRAME_H) / 2;
+
+    begin();
+    make_frame(px, 23);
+    for (int r = 0; r + STRIP_ROWS <= FRAME_H; r += STRIP_ROWS) {
+        for (int i = 0; i < FRAME_W * STRIP_ROWS; i++) {
+            uint16_t c = px[r * FRAME_W + i];
+            strip->buffer[i] = (c >> 8) | (c << 8);
+        }
+        strip->format = DISPLAY_FORMAT_RGB565;
+        if (display_write_strip_dma(strip, 0, y0 + r) == ESP_OK) display_wait_dma();
+        ref_frame(px, 0, y0, r, STRIP_ROWS, false);
+    }
+    end("strip_dma", 1, check_ref());
+    display_free_frame_buffer(strip);
+}
+
+static int g_done_calls;
+
+/** Done callback: count transfers */
+static bool count_done(void *arg)
+{
+    (void)arg;
+    g_done_calls++;
+    return false;
+}
+
+/**
+ * One strip window for the frame with every strip queued back to back, more
+ * than the SPI queue holds, so results are collected while queueing: one
+ * transaction per strip after the window set, the done callback once per
+ * strip, and strips that do not fit the window refused
+ */
+static void run_strip_queue(const char *name, frame_buffer_t *fb, uint16_t *px, bool rgb444)
+{
+    int x = (DISPLAY_WIDTH - FRAME_W) / 2, y = (DISPLAY_HEIGHT - FRAME_H) / 2;
+    int bad = 0, strips = 0;
+    st7789_emu_stats_t st;
+
+    begin();
+    make_frame(px, 31);
+    load_frame(fb, px);
+    if (rgb444) display_pack_rgb444(fb);
+
+    g_done_calls = 0;
+    display_set_done_callback(count_done, NULL);
+    if (display_begin_strips_dma(x, y, FRAME_W, FRAME_H, fb->format) != ESP_OK) bad++;
+
+    st7789_emu_get_stats(g_emu, &st);
+    uint32_t window_trans = st.transactions;
+
+    uint32_t row_bytes = display_frame_bytes(fb) / FRAME_H;
+    frame_buffer_t strip = *fb;
+    strip.width = FRAME_W - 2;
+    if (display_queue_strip_dma(&strip) != ESP_ERR_INVALID_SIZE) bad++;
+
+    strip.width = FRAME_W;
+    for (int r = 0; r < FRAME_H; r += STRIP_ROWS) {
+        strip.buffer = (uint16_t *)((uint8_t *)fb->buffer + r * row_bytes);
+        strip.height = (FRAME_H - r < STRIP_ROWS) ? FRAME_H - r : STRIP_ROWS;
+        if (display_queue_strip_dma(&strip) == ESP_OK) strips++;
+    }
+    if (display_queue_strip_dma(&strip) != ESP_ERR_INVALID_STATE) bad++;
+
+    display_wait_dma();
+    display_set_done_callback(NULL, NULL);
+
+    if (strips != (FRAME_H + STRIP_ROWS - 1) / STRIP_ROWS || g_done_calls != strips) {
+        fprintf(stderr, "%s: %d strips queued, %d done callbacks\n", name, strips, g_done_calls);
+        bad++;
+    }
+    st7789_emu_get_stats(g_emu, &st);
+    if (st.transactions - window_trans != (uint32_t)strips) {
+        fprintf(stderr, "%s: %u transactions for %d strips\n", name, st.transactions - window_trans, strips);
+        bad++;
+    }
+
+    ref_frame(px, x, y, 0, FRAME_H, rgb444);
+    end(name, 1, bad + check_ref());
+}
+
+/**
+ * MADCTL landscape through a second device on the bus, checked in landscape
+ * coordinates; portrait is restored and the reference resynchronized
+ */
+static void run_landscape(void)
+{
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = DISPLAY_SPI_CLOCK,
+        .spics_io_num = -1,
+        .queue_size = 1,
+    };
+    st7789_handle_t h = {.pin_dc = PIN_DISPLAY_DC, .pin_rst = -1, .pin_bl = -1};
+    spi_bus_add_device(DISPLAY_SPI_HOST, &devcfg, &h.spi);
+
+    begin();
+    st7789_set_orientation(&h, 1);
+    st7789_fill_rect(&h, 10, 20, 300, 40, COLOR_MAGENTA);
+    st7789_fill_rect(&h, 0, 200, 320, 40, COLOR_CYAN);
+
+    int bad = 0;
+    for (int y = 0; y < 240; y++) {
+        for (int x = 0; x < 320; x++) {
+            uint16_t got = st7789_emu_read565(g_emu, x, y);
+            if (y >= 20 && y < 60 && x >= 10 && x < 310) {
+                bad += (got != COLOR_MAGENTA);
+            } else if (y >= 200) {
+                bad += (got != COLOR_CYAN);
+            }
+        }
+    }
+
+    st7789_set_orientation(&h, DISPLAY_ORIENTATION);
+    end("landscape", 0, bad);
+    spi_bus_remove_device(h.spi);
+
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            g_ref[y * DISPLAY_WIDTH + x] = st7789_emu_read565(g_emu, x, y);
+        }
+    }
+}
+
+/**
+ * Render and compare one gate line with another (or with black)
+ */
+static int line_differs(const uint8_t *img, int line, int other)
+{
+    const size_t stride = ST7789_EMU_COLS * 3;
+    if (other < 0) {
+        for (size_t i = 0; i < stride; i++) {
+            if (img[line * stride + i]) return 1;
+        }
+        return 0;
+    }
+    return memcmp(img + line * stride, img + other * stride, stride) != 0;
+}
+
+/**
+ * Vertical scroll and sleep, checked on the rendered panel image
+ */
+static void run_panel_state(void)
+{
+    uint8_t *before = malloc(ST7789_EMU_COLS * ST7789_EMU_ROWS * 3);
+    uint8_t *after = malloc(ST7789_EMU_COLS * ST7789_EMU_ROWS * 3);
+    st7789_handle_t h = {.pin_dc = PIN_DISPLAY_DC};
+    spi_device_interface_config_t devcfg = {.clock_speed_hz = DISPLAY_SPI_CLOCK, .queue_size = 1};
+    spi_bus_add_device(DISPLAY_SPI_HOST, &devcfg, &h.spi);
+
+    // Whole screen scrolls by 100 lines: line L shows what line L + 100 showed
+    begin();
+    st7789_emu_render(g_emu, before);
+    uint8_t vscrdef[6] = {0, 0, DISPLAY_HEIGHT >> 8, DISPLAY_HEIGHT & 0xFF, 0, 0};
+    uint8_t vscsad[2] = {0, 100};
+    st7789_write_command(&h, ST7789_VSCRDEF);
+    st7789_write_data(&h, vscrdef, sizeof(vscrdef));
+    st7789_write_command(&h, ST7789_VSCSAD);
+    st7789_write_data(&h, vscsad, sizeof(vscsad));
+    st7789_emu_render(g_emu, after);
+
+    int bad = 0;
+    for (int line = 0; line < ST7789_EMU_ROWS; line++) {
+        const size_t stride = ST7789_EMU_COLS * 3;
+        int src = (line + 100) % ST7789_EMU_ROWS;
+        bad += memcmp(after + line * stride, before + src * stride, stride) != 0;
+    }
+    end("scroll", 0, bad);
+
+    vscsad[1] = 0;
+    st7789_write_command(&h, ST7789_VSCSAD);
+    st7789_write_data(&h, vscsad, sizeof(vscsad));
+
+    // Sleep blanks every line, wake restores the image
+    begin();
+    display_sleep();
+    st7789_emu_render(g_emu, after);
+    bad = 0;
+    for (int line = 0; line < ST7789_EMU_ROWS; line++) bad += line_differs(after, line, -1);
+    display_wake();
+    st7789_emu_render(g_emu, after);
+    bad += memcmp(before, after, ST7789_EMU_COLS * ST7789_EMU_ROWS * 3) != 0;
+    end("sleep_wake", 0, bad);
+
+    spi_bus_remove_device(h.spi);
+    free(before);
+    free(after);
+}
+
+/**
+ * One clock validation against a link model
+ *
+ * @return Mismatches against the expected outcome
+ */
+static int clock_case(bool sdo_wired, uint32_t max_write_hz, esp_err_t want_ret, int want_hz)
+{
+    display_clock_check_t check;
+    int requested = 0;
+
+    st7789_emu_set_link(g_emu, sdo_wired, max_write_hz);
+    esp_err_t ret = display_validate_spi_clock(80000000, &check);
+    display_get_spi_clock(&requested);
+
+    int bad = 0;
+    if (ret != want_ret || requested != want_hz) {
+        fprintf(stderr, "  validation returned 0x%X at %d Hz, expected 0x%X at %d Hz\n",
+                ret, requested, want_ret, want_hz);
+        bad++;
+    }
+    if (sdo_wired && (!check.readback || check.panel_id != ST7789_EMU_ID)) {
+        fprintf(stderr, "  panel ID 0x%06X not read back\n", check.panel_id);
+        bad++;
+    }
+    return bad;
+}
+
+/**
+ * SPI clock validation: the check band is cleared once a clock passes
+ */
+static void run_clock_check(void)
+{
+    const int band = DISPLAY_CHECK_ROUNDS * DISPLAY_CHECK_ROWS;
+    int requested = 0;
+    display_get_spi_clock(&requested);
+
+    begin();
+    int bad = clock_case(false, 0, ESP_ERR_NOT_SUPPORTED, 80000000);
+    end("clock_no_sdo", 0, bad + check_ref());
+
+    begin();
+    bad = clock_case(true, 0, ESP_OK, 80000000);
+    ref_rect(0, 0, DISPLAY_WIDTH, band, COLOR_BLACK);
+    end("clock_80mhz", 0, bad + check_ref());
+
+    begin();
+    bad = clock_case(true, 40000000, ESP_OK, 40000000);
+    end("clock_fallback", 0, bad + check_ref());
+
+    // Nothing passes: the slowest candidate stays, the band is left corrupt
+    begin();
+    bad = clock_case(true, 10000000, ESP_ERR_INVALID_CRC, 20000000);
+    st7789_emu_set_link(g_emu, true, 0);
+    display_fill_rect(0, 0, DISPLAY_WIDTH, band, COLOR_BLACK);
+    end("clock_all_fail", 0, bad + check_ref());
+
+    display_set_spi_clock(requested);
+}
+
+int main(int argc, char **argv)
+{
+    st7789_emu_config_t config = {
+        .spi_clock_hz = DISPLAY_SPI_CLOCK,
+        .trans_overhead_ns = 10000,
+        .ips_inverted = true,
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:o:d:")) != -1) {
+        switch (opt) {
+            case 'c': config.spi_clock_hz = atoi(optarg); break;
+            case 'o': config.trans_overhead_ns = (uint32_t)(atof(optarg) * 1000); break;
+            case 'd': g_out_dir = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-c spi_hz] [-o overhead_us] [-d out_dir]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    g_emu = st7789_emu_create(&config);
+    uint16_t *px = malloc(FRAME_W * FRAME_H * sizeof(uint16_t));
+    if (g_emu == NULL || px == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    emu_driver_attach(g_emu, PIN_DISPLAY_DC, PIN_DISPLAY_RST);
+
+    display_config_t dcfg = {
+        .pin_mosi = PIN_DISPLAY_MOSI,
+        .pin_miso = PIN_DISPLAY_MISO,
+        .pin_clk = PIN_DISPLAY_CLK,
+        .pin_cs = PIN_DISPLAY_CS,
+        .pin_dc = PIN_DISPLAY_DC,
+        .pin_rst = PIN_DISPLAY_RST,
+        .pin_bl = PIN_DISPLAY_BL,
+        .spi_clock_hz = config.spi_clock_hz,
+        .orientation = DISPLAY_ORIENTATION,
+    };
+
+    begin();
+    display_init(&dcfg);
+    printf("SPI %.2f MHz (requested %.2f), %.1f us per transaction, init delays %u ms\n\n",
+           st7789_emu_get_clock(g_emu) / 1e6, config.spi_clock_hz / 1e6,
+           config.trans_overhead_ns / 1000.0, emu_driver_delay_ms());
+    printf("%-14s %6s %8s %8s %8s %7s\n", "scenario", "trans", "bytes", "wire ms", "bus ms", "fps");
+    end("init", 0, 0);
+
+    begin();
+    display_clear(COLOR_BLUE);
+    ref_rect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, COLOR_BLUE);
+    end("clear", 1, check_ref());
+
+    begin();
+    display_fill_rect(10, 10, 100, 50, COLOR_RED);
+    display_fill_rect(200, 300, 100, 100, COLOR_GREEN);     // Clipped
+    display_draw_pixel(5, 5, COLOR_WHITE);
+    display_draw_pixel(239, 319, COLOR_YELLOW);
+    ref_rect(10, 10, 100, 50, COLOR_RED);
+    ref_rect(200, 300, 40, 20, COLOR_GREEN);
+    ref_rect(5, 5, 1, 1, COLOR_WHITE);
+    ref_rect(239, 319, 1, 1, COLOR_YELLOW);
+    end("rect_pixel", 0, check_ref());
+
+    frame_buffer_t *fb = display_alloc_frame_buffer(FRAME_W, FRAME_H);
+    if (fb == NULL) return 1;
+
+    begin();
+    make_frame(px, 5);
+    load_frame(fb, px);
+    display_write_buffer(0, 20, FRAME_W, FRAME_H, fb->buffer);
+    ref_frame(px, 0, 20, 0, FRAME_H, false);
+    end("write_buffer", 1, check_ref());
+
+    run_frames("frame_565", fb, px, false);
+    run_frames("frame_444", fb, px, true);
+    run_bands("bands_565", fb, px, false);
+    run_bands("bands_444", fb, px, true);
+    run_strip_queue("queue_565", fb, px, false);
+    run_strip_queue("queue_444", fb, px, true);
+    run_strips(px);
+    run_landscape();
+    run_panel_state();
+    run_clock_check();
+
+    display_free_frame_buffer(fb);
+    free(px);
+    st7789_emu_destroy(g_emu);
+
+    if (g_failures) {
+        printf("\n%d scenario(s) failed\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
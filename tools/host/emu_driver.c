@@ -0,0 +1,257 @@
+/**
+ * Host driver backends for the ST7789 emulator
+ */
+
+#include "emu_driver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "freertos/task.h"
+
+#define MAX_GPIO            64
+#define MAX_HOSTS           3
+#define DEFAULT_MAX_XFER    4092    // spi_master default when max_transfer_sz is 0
+#define MAX_QUEUE           16
+
+struct spi_device_t {
+    spi_host_device_t host;
+    int queue_size;
+    int clock_hz;
+    transaction_cb_t post_cb;
+};
+
+static st7789_emu_t *g_emu;
+static int g_pin_dc = -1;
+static int g_pin_rst = -1;
+static uint8_t g_levels[MAX_GPIO];
+static int g_max_xfer[MAX_HOSTS];
+static uint32_t g_delay_ms;
+static spi_device_handle_t g_acquired;
+
+// Completed queued transactions not yet collected
+static spi_transaction_t *g_queue[MAX_QUEUE];
+static int g_queued;
+
+/**
+ * Attach emulator
+ */
+void emu_driver_attach(st7789_emu_t *emu, int pin_dc, int pin_rst)
+{
+    g_emu = emu;
+    g_pin_dc = pin_dc;
+    g_pin_rst = pin_rst;
+    g_delay_ms = 0;
+    g_queued = 0;
+}
+
+/**
+ * Get delay total
+ */
+uint32_t emu_driver_delay_ms(void)
+{
+    return g_delay_ms;
+}
+
+/**
+ * Get in-flight count
+ */
+int emu_driver_in_flight(void)
+{
+    return g_queued;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= MAX_GPIO) return ESP_ERR_INVALID_ARG;
+
+    // Falling edge on RESX resets the controller
+    if (gpio_num == g_pin_rst && g_levels[gpio_num] && !level && g_emu) {
+        st7789_emu_reset(g_emu);
+    }
+    g_levels[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return (gpio_num >= 0 && gpio_num < MAX_GPIO) ? g_levels[gpio_num] : 0;
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *config)
+{
+    if (g_emu && config->channel == LEDC_CHANNEL_0) st7789_emu_set_backlight(g_emu, config->duty);
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty)
+{
+    (void)mode;
+    if (g_emu && channel == LEDC_CHANNEL_0) st7789_emu_set_backlight(g_emu, duty);
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel)
+{
+    (void)mode;
+    (void)channel;
+    return ESP_OK;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    g_delay_ms += ticks;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dma_chan)
+{
+    (void)dma_chan;
+    if (host >= MAX_HOSTS) return ESP_ERR_INVALID_ARG;
+    if (g_max_xfer[host]) return ESP_ERR_INVALID_STATE;
+
+    g_max_xfer[host] = config->max_transfer_sz ? config->max_transfer_sz : DEFAULT_MAX_XFER;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host)
+{
+    if (host >= MAX_HOSTS) return ESP_ERR_INVALID_ARG;
+    g_max_xfer[host] = 0;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config,
+                             spi_device_handle_t *handle)
+{
+    if (host >= MAX_HOSTS || !g_max_xfer[host]) return ESP_ERR_INVALID_STATE;
+
+    struct spi_device_t *dev = calloc(1, sizeof(*dev));
+    if (dev == NULL) return ESP_ERR_NO_MEM;
+
+    dev->host = host;
+    dev->queue_size = config->queue_size < MAX_QUEUE ? config->queue_size : MAX_QUEUE;
+    dev->clock_hz = config->clock_speed_hz;
+    dev->post_cb = config->post_cb;
+    if (g_emu) st7789_emu_set_clock(g_emu, config->clock_speed_hz);
+
+    *handle = dev;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    // As in ESP-IDF, uncollected results keep the device on the bus
+    if (g_queued) return ESP_ERR_INVALID_STATE;
+    free(handle);
+    return ESP_OK;
+}
+
+/**
+ * Run one transaction through the emulator
+ */
+static esp_err_t transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    if (trans->length > (size_t)g_max_xfer[handle->host] * 8) {
+        fprintf(stderr, "spi_master: transaction of %zu bytes > bus maximum %d\n",
+                (trans->length + 7) / 8, g_max_xfer[handle->host]);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // As in ESP-IDF, CS can only stay asserted while the device holds the bus
+    if ((trans->flags & SPI_TRANS_CS_KEEP_ACTIVE) && g_acquired != handle) {
+        fprintf(stderr, "spi_master: SPI_TRANS_CS_KEEP_ACTIVE without spi_device_acquire_bus\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // No TX data and somewhere to put RX data: a read
+    bool tx = (trans->flags & SPI_TRANS_USE_TXDATA) || trans->tx_buffer != NULL;
+    bool rx = (trans->flags & SPI_TRANS_USE_RXDATA) || trans->rx_buffer != NULL;
+    if (!tx && rx) {
+        uint8_t *out = (trans->flags & SPI_TRANS_USE_RXDATA) ? trans->rx_data : trans->rx_buffer;
+        size_t bits = trans->rxlength ? trans->rxlength : trans->length;
+        if (g_emu) st7789_emu_read(g_emu, out, bits);
+        return ESP_OK;
+    }
+
+    const uint8_t *data = (trans->flags & SPI_TRANS_USE_TXDATA) ? trans->tx_data : trans->tx_buffer;
+    if (g_emu) st7789_emu_transfer(g_emu, gpio_get_level(g_pin_dc), data, trans->length);
+    return ESP_OK;
+}
+
+/**
+ * As in ESP-IDF, post_cb runs after polled transactions as well as queued ones
+ */
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    esp_err_t ret = transmit(handle, trans);
+    if (ret == ESP_OK && handle->post_cb) handle->post_cb(trans);
+    return ret;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    return spi_device_polling_transmit(handle, trans);
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans,
+                                 TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    if (g_queued >= handle->queue_size) {
+        fprintf(stderr, "spi_master: queue full (%d), results never collected\n", g_queued);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_err_t ret = spi_device_polling_transmit(handle, trans);
+    if (ret == ESP_OK) g_queue[g_queued++] = trans;
+    return ret;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans,
+                                      TickType_t ticks_to_wait)
+{
+    (void)handle;
+    if (g_queued == 0) {
+        if (ticks_to_wait == 0) return ESP_ERR_TIMEOUT;
+        fprintf(stderr, "spi_master: result wait with nothing queued would block forever\n");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    *trans = g_queue[0];
+    for (int i = 1; i < g_queued; i++) g_queue[i - 1] = g_queue[i];
+    g_queued--;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_actual_freq(spi_device_handle_t handle, int *freq_khz)
+{
+    *freq_khz = handle->clock_hz / 1000;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t device, TickType_t wait)
+{
+    (void)wait;
+    if (g_acquired != NULL) return ESP_ERR_INVALID_STATE;   // Would block forever here
+    g_acquired = device;
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t dev)
+{
+    if (g_acquired == dev) g_acquired = NULL;
+}
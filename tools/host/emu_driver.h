@@ -0,0 +1,37 @@
+/**
+ * Host backends for the ESP-IDF driver calls the display component makes
+ * SPI transactions go to an ST7789 emulator as they are issued, with the
+ * DC level the driver last set; queued transactions complete at once (post_cb
+ * included) and wait for spi_device_get_trans_result like on the target.
+ */
+
+#ifndef EMU_DRIVER_H
+#define EMU_DRIVER_H
+
+#include <stdint.h>
+#include "st7789_emu.h"
+
+/**
+ * Route the SPI device and the DC/reset pins to an emulator
+ *
+ * @param emu Emulator, NULL to detach
+ * @param pin_dc Data/command pin
+ * @param pin_rst Reset pin (-1 if not wired)
+ */
+void emu_driver_attach(st7789_emu_t *emu, int pin_dc, int pin_rst);
+
+/**
+ * Get the time spent in vTaskDelay since attach
+ *
+ * @return Milliseconds
+ */
+uint32_t emu_driver_delay_ms(void);
+
+/**
+ * Get the number of queued transactions whose results were not collected
+ *
+ * @return Transactions in flight
+ */
+int emu_driver_in_flight(void);
+
+#endif // EMU_DRIVER_H
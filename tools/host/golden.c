@@ -0,0 +1,207 @@
+/**
+ * Golden Decode Checksums
+ *
+ * Decodes reference clips with the golden component (jpeg_sw, lz565, crb,
+ * pal8, time_stretch and the SIMD volume kernel, as playback runs them) and
+ * compares a 64-bit hash of every output frame and PCM block with the
+ * clip's golden files. A mismatch is reported as the first differing frame
+ * and MCU. Record goldens with -w on a known good tree, commit them with
+ * the corpus, and run the check after every decode, color or blit change;
+ * the same files are checked on target by GOLDEN_MODE in main.c.
+ *
+ * Without -m, every mode that applies to a clip is recorded, and every mode
+ * with a golden file is checked. Exact modes must never change; approximate
+ * ones (dithered RGB444, scaled decodes, time-stretched PCM) are expected to
+ * change with their rounding and are re-recorded on purpose.
+ *
+ * Usage: golden [-w] [-m mode[,mode...]] [-l] clip.avi ...
+ *   -w  record goldens (<clip>.<mode>.gld next to each clip)
+ *   -m  modes to record or check (default: all)
+ *   -l  list modes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "golden.h"
+
+#define USAGE "Usage: %s [-w] [-m mode[,mode...]] [-l] clip.avi ...\n"
+
+static bool g_write;
+static bool g_selected[GOLDEN_MODE_COUNT];
+static bool g_explicit;             // -m given: a missing golden is a failure
+
+/**
+ * Parse a comma-separated mode list
+ */
+static int select_modes(char *list)
+{
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        golden_mode_t mode = golden_mode_find(name);
+        if (mode == GOLDEN_MODE_COUNT) {
+            fprintf(stderr, "Unknown mode: %s (-l lists them)\n", name);
+            return -1;
+        }
+        g_selected[mode] = true;
+    }
+    g_explicit = true;
+    return 0;
+}
+
+static void list_modes(void)
+{
+    static const char *help[GOLDEN_MODE_COUNT] = {
+        [GOLDEN_MODE_RGB565] = "full-scale RGB565, every codec",
+        [GOLDEN_MODE_RGB444] = "MJPEG to packed RGB444, ordered dither",
+        [GOLDEN_MODE_SCALE_1_2] = "MJPEG at 1/2 scale (trick play)",
+        [GOLDEN_MODE_SCALE_1_4] = "MJPEG at 1/4 scale (trick play)",
+        [GOLDEN_MODE_SCALE_1_8] = "MJPEG at 1/8 scale, DC only (trick play)",
+        [GOLDEN_MODE_PCM] = "16-bit PCM chunks at 80% volume",
+        [GOLDEN_MODE_PCM_STRETCH] = "mono PCM chunks time-stretched to 1.5x, 80% volume",
+    };
+
+    for (int m = 0; m < GOLDEN_MODE_COUNT; m++) {
+        printf("  %-10s %-7s %s\n", golden_mode_name(m), golden_mode_exact(m) ? "exact" : "approx", help[m]);
+    }
+}
+
+/**
+ * Record one mode of a clip
+ *
+ * @return 0 on success or if the mode does not apply, 1 on failure
+ */
+static int record(const char *clip, golden_mode_t mode, const char *path, const char *name)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        printf("  %-24.24s %-10s cannot create %s\n", name, golden_mode_name(mode), path);
+        return 1;
+    }
+
+    uint32_t count = 0;
+    esp_err_t ret = golden_record(clip, mode, f, &count);
+    fclose(f);
+
+    if (ret == ESP_ERR_NOT_SUPPORTED) {
+        unlink(path);
+        if (g_explicit) printf("  %-24.24s %-10s does not apply\n", name, golden_mode_name(mode));
+        return 0;
+    }
+    if (ret != ESP_OK) {
+        unlink(path);
+        printf("  %-24.24s %-10s FAILED (error 0x%x)\n", name, golden_mode_name(mode), ret);
+        return 1;
+    }
+    printf("  %-24.24s %-10s %6lu %s\n", name, golden_mode_name(mode), (unsigned long)count, path);
+    return 0;
+}
+
+/**
+ * Check one mode of a clip
+ *
+ * @return 0 if it matches or has no golden (without -m), 1 on failure
+ */
+static int check(const char *clip, golden_mode_t mode, const char *path, const char *name, int *checked)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        if (!g_explicit) return 0;
+        printf("  %-24.24s %-10s no golden (%s)\n", name, golden_mode_name(mode), path);
+        return 1;
+    }
+
+    golden_result_t r;
+    esp_err_t ret = golden_check(clip, mode, f, &r);
+    fclose(f);
+    (*checked)++;
+
+    printf("  %-24.24s %-10s %6lu ", name, golden_mode_name(mode), (unsigned long)r.count);
+    switch (ret) {
+    case ESP_OK:
+        printf("ok\n");
+        return 0;
+    case ESP_ERR_INVALID_CRC:
+        break;
+    case ESP_ERR_INVALID_VERSION:
+        printf("FAILED: golden file is not for this mode and size\n");
+        return 1;
+    case ESP_ERR_NOT_SUPPORTED:
+        printf("FAILED: mode does not apply to the clip\n");
+        return 1;
+    default:
+        printf("FAILED (error 0x%x)\n", ret);
+        return 1;
+    }
+
+    printf("MISMATCH %s %lu", mode == GOLDEN_MODE_PCM || mode == GOLDEN_MODE_PCM_STRETCH ? "block" : "frame",
+           (unsigned long)r.first);
+    if (r.tile_x != GOLDEN_NONE) {
+        printf(" MCU (%lu,%lu), %lu MCU%s", (unsigned long)r.tile_x, (unsigned long)r.tile_y,
+               (unsigned long)r.tiles, r.tiles == 1 ? "" : "s");
+    }
+    printf("; %lu differ", (unsigned long)r.mismatches);
+    if (r.count != r.expected) printf(", %lu expected", (unsigned long)r.expected);
+    printf("%s\n", golden_mode_exact(mode) ? "" : " (approximate mode)");
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "wm:l")) != -1) {
+        switch (opt) {
+        case 'w':
+            g_write = true;
+            break;
+        case 'm':
+            if (select_modes(optarg) != 0) return 2;
+            break;
+        case 'l':
+            list_modes();
+            return 0;
+        default:
+            fprintf(stderr, USAGE, argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, USAGE, argv[0]);
+        return 2;
+    }
+    if (!g_explicit) {
+        for (int m = 0; m < GOLDEN_MODE_COUNT; m++) g_selected[m] = true;
+    }
+
+    printf("  %-24s %-10s %6s %s\n", "clip", "mode", "count", g_write ? "golden" : "result");
+
+    int failures = 0;
+    for (int i = optind; i < argc; i++) {
+        const char *clip = argv[i];
+        const char *name = strrchr(clip, '/') ? strrchr(clip, '/') + 1 : clip;
+        int checked = 0;
+
+        for (int m = 0; m < GOLDEN_MODE_COUNT; m++) {
+            char path[512];
+
+            if (!g_selected[m]) continue;
+            golden_path(clip, m, path, sizeof(path));
+            failures += g_write ? record(clip, m, path, name) : check(clip, m, path, name, &checked);
+        }
+
+        if (!g_write && !g_explicit && checked == 0) {
+            printf("  %-24.24s no goldens (record with -w)\n", name);
+            failures++;
+        }
+    }
+
+    if (g_write) {
+        printf("%s\n", failures ? "FAILED" : "Goldens recorded");
+    } else {
+        printf("%s\n", failures ? "FAILED" : "All outputs match their goldens");
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * Greedy LZ4 block compressor for the host encoders
+ * Output decodes with the device's lz565_decode()
+ */
+
+#include "lz4_compress.h"
+#include <string.h>
+
+#define HASH_BITS       16
+#define MIN_MATCH       4
+#define LAST_LITERALS   5       // LZ4: block ends with at least 5 literals
+#define MF_LIMIT        12      // LZ4: no match may start in the last 12 bytes
+#define MAX_OFFSET      65535
+
+static uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+/**
+ * Append an LZ4 length continuation (after a nibble of 15)
+ */
+static uint8_t *write_length(uint8_t *op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/**
+ * Emit one sequence: literals, then a match (match_len 0 = final literals)
+ */
+static uint8_t *emit(uint8_t *op, const uint8_t *lit, size_t lit_len, size_t offset, size_t match_len)
+{
+    uint8_t *token = op++;
+    size_t ml = match_len ? match_len - MIN_MATCH : 0;
+
+    *token = (uint8_t)(((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15));
+    if (lit_len >= 15) op = write_length(op, lit_len - 15);
+
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if (match_len) {
+        *op++ = offset & 0xFF;
+        *op++ = offset >> 8;
+        if (ml >= 15) op = write_length(op, ml - 15);
+    }
+
+    return op;
+}
+
+/**
+ * Greedy LZ4 block compressor (hash of 4-byte sequences, 64 KB window)
+ *
+ * @return Compressed size (dst must hold n + n / 255 + 16 bytes)
+ */
+size_t lz4_compress(const uint8_t *src, size_t n, uint8_t *dst)
+{
+    static int32_t table[1 << HASH_BITS];
+    uint8_t *op = dst;
+    size_t ip = 0;
+    size_t anchor = 0;
+
+    memset(table, 0xFF, sizeof(table));
+
+    if (n > MF_LIMIT) {
+        size_t limit = n - MF_LIMIT;
+
+        while (ip < limit) {
+            uint32_t seq = read32(&src[ip]);
+            uint32_t h = (seq * 2654435761u) >> (32 - HASH_BITS);
+            int32_t ref = table[h];
+            table[h] = (int32_t)ip;
+
+            if (ref < 0 || ip - ref > MAX_OFFSET || read32(&src[ref]) != seq) {
+                ip++;
+                continue;
+            }
+
+            size_t len = MIN_MATCH;
+            size_t max_len = n - LAST_LITERALS - ip;
+            while (len < max_len && src[ref + len] == src[ip + len]) len++;
+
+            op = emit(op, &src[anchor], ip - anchor, ip - ref, len);
+            ip += len;
+            anchor = ip;
+
+            // Keep the table warm inside long runs
+            if (ip >= 2 && ip - 2 < limit) {
+                table[(read32(&src[ip - 2]) * 2654435761u) >> (32 - HASH_BITS)] = (int32_t)(ip - 2);
+            }
+        }
+    }
+
+    op = emit(op, &src[anchor], n - anchor, 0, 0);
+    return op - dst;
+}
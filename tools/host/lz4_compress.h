@@ -0,0 +1,23 @@
+/**
+ * Greedy LZ4 block compressor for the host encoders
+ */
+
+#ifndef LZ4_COMPRESS_H
+#define LZ4_COMPRESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Compress one LZ4 block (no frame header)
+ *
+ * @param src Input
+ * @param n Input size
+ * @param dst Output, at least LZ4_COMPRESS_BOUND(n) bytes
+ * @return Compressed size
+ */
+size_t lz4_compress(const uint8_t *src, size_t n, uint8_t *dst);
+
+#define LZ4_COMPRESS_BOUND(n)   ((n) + (n) / 255 + 16)
+
+#endif // LZ4_COMPRESS_H
@@ -0,0 +1,117 @@
+/**
+ * LZ565 Video Encoder
+ *
+ * Wraps raw RGB565 frames into an AVI whose video stream has FOURCC "L565":
+ * each frame is one LZ4 block of big-endian RGB565 pixels (see lz565.h).
+ * Every frame is verified by decoding it with the device decoder, and a
+ * summary of compression and host decode speed is printed.
+ *
+ * Usage: lz565_encode -w W -h H [-r fps] input.raw|- output.avi
+ *
+ *   ffmpeg -i in.mp4 -vf "scale=240:180,fps=15" -f rawvideo -pix_fmt rgb565be - |
+ *       lz565_encode -w 240 -h 180 -r 15 - out.avi
+ *
+ * Video only; the player pairs it with no audio stream.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "lz565.h"
+#include "avi_writer.h"
+#include "lz4_compress.h"
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t w = 0, h = 0, fps = 15;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "w:h:r:")) != -1) {
+        switch (opt) {
+            case 'w': w = atoi(optarg); break;
+            case 'h': h = atoi(optarg); break;
+            case 'r': fps = atoi(optarg); break;
+            default: break;
+        }
+    }
+
+    if (w == 0 || h == 0 || fps == 0 || argc - optind != 2) {
+        fprintf(stderr, "Usage: %s -w W -h H [-r fps] input.raw|- output.avi\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = strcmp(argv[optind], "-") ? fopen(argv[optind], "rb") : stdin;
+    avi_writer_t avi;
+    if (in == NULL || avi_writer_open(&avi, argv[optind + 1], w, h, fps, "L565") != 0) {
+        perror("open");
+        return 1;
+    }
+
+    size_t frame_bytes = (size_t)w * h * 2;
+    uint8_t *raw = malloc(frame_bytes);
+    uint8_t *packed = malloc(LZ4_COMPRESS_BOUND(frame_bytes));
+    uint8_t *check = malloc(frame_bytes);
+
+    uint32_t frames = 0;
+    uint64_t total_packed = 0;
+    uint32_t max_packed = 0;
+    uint64_t decode_ns = 0;
+
+    while (fread(raw, 1, frame_bytes, in) == frame_bytes) {
+        size_t n = lz4_compress(raw, frame_bytes, packed);
+
+        uint64_t t0 = now_ns();
+        esp_err_t ret = lz565_decode(packed, n, check, frame_bytes);
+        decode_ns += now_ns() - t0;
+
+        if (ret != ESP_OK || memcmp(raw, check, frame_bytes) != 0) {
+            fprintf(stderr, "Frame %u failed round trip\n", frames);
+            return 1;
+        }
+
+        if (avi_writer_add(&avi, packed, (uint32_t)n, true) != 0) {
+            perror("write");
+            return 1;
+        }
+
+        total_packed += n;
+        if (n > max_packed) max_packed = n;
+        frames++;
+    }
+
+    if (avi_writer_close(&avi) < 0) {
+        perror("write");
+        return 1;
+    }
+
+    if (in != stdin) fclose(in);
+
+    if (frames == 0) {
+        fprintf(stderr, "No complete %ux%u RGB565 frames in input\n", w, h);
+        return 1;
+    }
+
+    double avg = (double)total_packed / frames;
+    printf("%u frames %ux%u @ %u fps\n", frames, w, h, fps);
+    printf("  frame: %.0f bytes avg, %u max (%.2fx vs raw)\n",
+           avg, max_packed, frame_bytes / avg);
+    printf("  stream: %.0f KB/s avg, %.0f KB/s peak\n",
+           avg * fps / 1024, (double)max_packed * fps / 1024);
+    printf("  host decode: %.1f us/frame, %.0f MB/s output\n",
+           decode_ns / 1000.0 / frames, (double)frame_bytes * frames / (decode_ns / 1e9) / 1e6);
+
+    free(check);
+    free(packed);
+    free(raw);
+    return 0;
+}
@@ -0,0 +1,394 @@
+/**
+ * PAL8 Video Encoder
+ *
+ * Quantizes raw RGB565 frames to a 256-color palette per scene (median cut
+ * over every pixel of the scene) and writes an AVI whose video stream has
+ * FOURCC "PAL8" (see pal8.h): LZ4-compressed index frames, with the palette
+ * sent at each scene cut and repeated on keyframes. Every frame is verified
+ * with the device decoder, and quality, size and host expansion speed are
+ * printed.
+ *
+ * Usage: pal8_encode -w W -h H [-r fps] [-s cut] [-k keyint] input.raw|- output.avi
+ *
+ *   -s  scene cut threshold: mean per-pixel luma change 0-255 (default 24)
+ *   -k  keyframe interval in frames (default 2 s)
+ *
+ *   ffmpeg -i in.mp4 -vf "scale=240:180,fps=15" -f rawvideo -pix_fmt rgb565be - |
+ *       pal8_encode -w 240 -h 180 -r 15 - out.avi
+ *
+ * A scene is buffered whole before it is quantized, up to MAX_SCENE_SEC.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "pal8.h"
+#include "avi_writer.h"
+#include "lz4_compress.h"
+
+#define MAX_SCENE_SEC   30
+#define COLOR_BINS      65536
+
+typedef struct {
+    uint16_t color;
+    uint32_t weight;
+} color_t;
+
+typedef struct {
+    uint32_t first;
+    uint32_t count;
+    uint64_t score;             // Widest channel range * weight, 0 = cannot split
+} box_t;
+
+static int g_sort_channel;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * RGB565 value to 8-bit channels
+ */
+static void unpack(uint16_t v, int rgb[3])
+{
+    int r = (v >> 11) & 0x1F, g = (v >> 5) & 0x3F, b = v & 0x1F;
+
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+static uint16_t pixel(const uint8_t *frame, uint32_t i)
+{
+    return (frame[i * 2] << 8) | frame[i * 2 + 1];
+}
+
+static int compare_channel(const void *a, const void *b)
+{
+    int ca[3], cb[3];
+    unpack(((const color_t *)a)->color, ca);
+    unpack(((const color_t *)b)->color, cb);
+    return ca[g_sort_channel] - cb[g_sort_channel];
+}
+
+/**
+ * Widest channel of a box and its split score
+ */
+static int measure(const color_t *colors, box_t *box)
+{
+    int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0};
+    uint64_t weight = 0;
+
+    for (uint32_t i = box->first; i < box->first + box->count; i++) {
+        int c[3];
+        unpack(colors[i].color, c);
+        for (int k = 0; k < 3; k++) {
+            if (c[k] < lo[k]) lo[k] = c[k];
+            if (c[k] > hi[k]) hi[k] = c[k];
+        }
+        weight += colors[i].weight;
+    }
+
+    int channel = 0;
+    for (int k = 1; k < 3; k++) {
+        if (hi[k] - lo[k] > hi[channel] - lo[channel]) channel = k;
+    }
+
+    box->score = (box->count > 1) ? (uint64_t)(hi[channel] - lo[channel]) * weight : 0;
+    return channel;
+}
+
+/**
+ * Median cut over a color histogram
+ *
+ * @return Palette size
+ */
+static int median_cut(const uint32_t *hist, uint16_t *palette)
+{
+    static color_t colors[COLOR_BINS];
+    static box_t boxes[PAL8_COLORS];
+    uint32_t n = 0;
+
+    for (uint32_t c = 0; c < COLOR_BINS; c++) {
+        if (hist[c]) {
+            colors[n].color = (uint16_t)c;
+            colors[n].weight = hist[c];
+            n++;
+        }
+    }
+
+    int count = 1;
+    boxes[0] = (box_t){0, n, 0};
+    measure(colors, &boxes[0]);
+
+    while (count < PAL8_COLORS) {
+        int best = -1;
+        for (int i = 0; i < count; i++) {
+            if (boxes[i].score && (best < 0 || boxes[i].score > boxes[best].score)) best = i;
+        }
+        if (best < 0) break;
+
+        box_t *box = &boxes[best];
+        g_sort_channel = measure(colors, box);
+        qsort(&colors[box->first], box->count, sizeof(color_t), compare_channel);
+
+        // Weighted median, keeping both halves non-empty
+        uint64_t total = 0, acc = 0;
+        for (uint32_t i = 0; i < box->count; i++) total += colors[box->first + i].weight;
+        uint32_t split = 1;
+        for (uint32_t i = 0; i < box->count - 1; i++) {
+            acc += colors[box->first + i].weight;
+            split = i + 1;
+            if (acc * 2 >= total) break;
+        }
+
+        boxes[count] = (box_t){box->first + split, box->count - split, 0};
+        box->count = split;
+        measure(colors, box);
+        measure(colors, &boxes[count]);
+        count++;
+    }
+
+    for (int i = 0; i < count; i++) {
+        uint64_t sum[3] = {0}, weight = 0;
+        for (uint32_t j = boxes[i].first; j < boxes[i].first + boxes[i].count; j++) {
+            int c[3];
+            unpack(colors[j].color, c);
+            for (int k = 0; k < 3; k++) sum[k] += (uint64_t)c[k] * colors[j].weight;
+            weight += colors[j].weight;
+        }
+        int r = (int)((sum[0] + weight / 2) / weight);
+        int g = (int)((sum[1] + weight / 2) / weight);
+        int b = (int)((sum[2] + weight / 2) / weight);
+        palette[i] = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+    }
+
+    return count;
+}
+
+/**
+ * Nearest palette entry for every color in the histogram
+ */
+static void build_map(const uint32_t *hist, const uint16_t *palette, int count, uint8_t *map)
+{
+    int pal[PAL8_COLORS][3];
+    for (int i = 0; i < count; i++) unpack(palette[i], pal[i]);
+
+    for (uint32_t c = 0; c < COLOR_BINS; c++) {
+        if (!hist[c]) continue;
+
+        int v[3], best = 0, best_d = INT32_MAX;
+        unpack((uint16_t)c, v);
+        for (int i = 0; i < count && best_d > 0; i++) {
+            int dr = v[0] - pal[i][0], dg = v[1] - pal[i][1], db = v[2] - pal[i][2];
+            int d = 2 * dr * dr + 4 * dg * dg + 3 * db * db;
+            if (d < best_d) {
+                best_d = d;
+                best = i;
+            }
+        }
+        map[c] = (uint8_t)best;
+    }
+}
+
+/**
+ * Mean luma change between two frames (0-255)
+ */
+static double frame_change(const uint8_t *a, const uint8_t *b, uint32_t pixels)
+{
+    uint64_t sum = 0;
+
+    for (uint32_t i = 0; i < pixels; i += 3) {
+        int ca[3], cb[3];
+        unpack(pixel(a, i), ca);
+        unpack(pixel(b, i), cb);
+        int ya = (ca[0] * 77 + ca[1] * 150 + ca[2] * 29) >> 8;
+        int yb = (cb[0] * 77 + cb[1] * 150 + cb[2] * 29) >> 8;
+        sum += ya > yb ? ya - yb : yb - ya;
+    }
+
+    return (double)sum / ((pixels + 2) / 3);
+}
+
+typedef struct {
+    avi_writer_t avi;
+    uint32_t pixels;
+    uint32_t keyint;
+    uint8_t *indices;
+    uint8_t *chunk;
+    uint8_t *check;
+    uint16_t *lut;
+    uint16_t *expanded;
+    uint32_t frames;
+    uint32_t scenes;
+    double sq_err;
+    uint64_t decode_ns;
+} encoder_t;
+
+/**
+ * Quantize and write one buffered scene
+ *
+ * @return 0 on success
+ */
+static int encode_scene(encoder_t *enc, const uint8_t *frames, uint32_t count, size_t frame_bytes)
+{
+    static uint32_t hist[COLOR_BINS];
+    static uint8_t map[COLOR_BINS];
+    uint16_t palette[PAL8_COLORS];
+
+    memset(hist, 0, sizeof(hist));
+    for (uint32_t f = 0; f < count; f++) {
+        for (uint32_t i = 0; i < enc->pixels; i++) hist[pixel(&frames[f * frame_bytes], i)]++;
+    }
+
+    int colors = median_cut(hist, palette);
+    build_map(hist, palette, colors, map);
+
+    for (uint32_t f = 0; f < count; f++) {
+        const uint8_t *src = &frames[f * frame_bytes];
+        bool keyframe = (f % enc->keyint) == 0;
+        uint8_t *op = enc->chunk;
+
+        for (uint32_t i = 0; i < enc->pixels; i++) enc->indices[i] = map[pixel(src, i)];
+
+        *op++ = keyframe ? (PAL8_FLAG_KEYFRAME | PAL8_FLAG_PALETTE) : 0;
+        *op++ = 0;
+        *op++ = keyframe ? colors & 0xFF : 0;
+        *op++ = keyframe ? colors >> 8 : 0;
+        if (keyframe) {
+            for (int i = 0; i < colors; i++) {
+                *op++ = palette[i] >> 8;
+                *op++ = palette[i] & 0xFF;
+            }
+        }
+        op += lz4_compress(enc->indices, enc->pixels, op);
+        uint32_t size = (uint32_t)(op - enc->chunk);
+
+        // Verify with the device code and measure decode + LUT expansion
+        uint64_t t0 = now_ns();
+        esp_err_t ret = pal8_decode(enc->chunk, size, enc->lut, enc->check, enc->pixels, NULL);
+        pal8_expand(enc->check, enc->lut, enc->expanded, enc->pixels);
+        enc->decode_ns += now_ns() - t0;
+
+        if (ret != ESP_OK || memcmp(enc->check, enc->indices, enc->pixels) != 0) {
+            fprintf(stderr, "Frame %u failed round trip\n", enc->frames);
+            return -1;
+        }
+
+        for (uint32_t i = 0; i < enc->pixels; i++) {
+            const uint8_t *e = (const uint8_t *)&enc->expanded[i];
+            int a[3], b[3];
+            unpack(pixel(src, i), a);
+            unpack((e[0] << 8) | e[1], b);
+            for (int k = 0; k < 3; k++) enc->sq_err += (double)(a[k] - b[k]) * (a[k] - b[k]);
+        }
+
+        if (avi_writer_add(&enc->avi, enc->chunk, size, keyframe) != 0) return -1;
+        enc->frames++;
+    }
+
+    enc->scenes++;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t w = 0, h = 0, fps = 15, keyint = 0;
+    double cut = 24.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "w:h:r:s:k:")) != -1) {
+        switch (opt) {
+            case 'w': w = atoi(optarg); break;
+            case 'h': h = atoi(optarg); break;
+            case 'r': fps = atoi(optarg); break;
+            case 's': cut = atof(optarg); break;
+            case 'k': keyint = atoi(optarg); break;
+            default: break;
+        }
+    }
+
+    if (w == 0 || h == 0 || fps == 0 || argc - optind != 2) {
+        fprintf(stderr, "Usage: %s -w W -h H [-r fps] [-s cut] [-k keyint] input.raw|- output.avi\n",
+                argv[0]);
+        return 1;
+    }
+    if (keyint == 0) keyint = fps * 2;
+
+    FILE *in = strcmp(argv[optind], "-") ? fopen(argv[optind], "rb") : stdin;
+    encoder_t enc = {0};
+    if (in == NULL || avi_writer_open(&enc.avi, argv[optind + 1], w, h, fps, "PAL8") != 0) {
+        perror("open");
+        return 1;
+    }
+
+    size_t frame_bytes = (size_t)w * h * 2;
+    uint32_t max_scene = fps * MAX_SCENE_SEC;
+    uint8_t *scene = malloc(frame_bytes * max_scene);
+
+    enc.pixels = w * h;
+    enc.keyint = keyint;
+    enc.indices = malloc(enc.pixels);
+    enc.check = malloc(enc.pixels);
+    enc.chunk = malloc(PAL8_HEADER_SIZE + PAL8_COLORS * 2 + LZ4_COMPRESS_BOUND(enc.pixels));
+    enc.lut = calloc(PAL8_COLORS, sizeof(uint16_t));
+    enc.expanded = malloc(frame_bytes);
+
+    uint32_t buffered = 0;
+    int err = 0;
+
+    while (!err && fread(&scene[buffered * frame_bytes], 1, frame_bytes, in) == frame_bytes) {
+        uint8_t *frame = &scene[buffered * frame_bytes];
+
+        if (buffered > 0 && (buffered == max_scene ||
+                             frame_change(frame - frame_bytes, frame, enc.pixels) > cut)) {
+            err = encode_scene(&enc, scene, buffered, frame_bytes);
+            memmove(scene, frame, frame_bytes);
+            buffered = 0;
+        }
+        buffered++;
+    }
+    if (!err && buffered > 0) {
+        err = encode_scene(&enc, scene, buffered, frame_bytes);
+    }
+
+    uint64_t total = enc.avi.total_size;
+    uint32_t max_size = enc.avi.max_size;
+    long file_size = avi_writer_close(&enc.avi);
+
+    if (in != stdin) fclose(in);
+
+    if (err || file_size < 0) {
+        perror("write");
+        return 1;
+    }
+    if (enc.frames == 0) {
+        fprintf(stderr, "No complete %ux%u RGB565 frames in input\n", w, h);
+        return 1;
+    }
+
+    double mse = enc.sq_err / ((double)enc.pixels * 3 * enc.frames);
+    double avg = (double)total / enc.frames;
+    printf("%u frames %ux%u @ %u fps, %u scenes, keyframe every %u\n",
+           enc.frames, w, h, fps, enc.scenes, keyint);
+    printf("  frame: %.0f bytes avg, %u max (%.2fx vs RGB565); file %ld bytes\n",
+           avg, max_size, frame_bytes / avg, file_size);
+    printf("  quality: %.2f dB PSNR vs source\n", mse > 0 ? 10 * log10(255.0 * 255.0 / mse) : 99.0);
+    printf("  host decode + expand: %.3f ms/frame, %.0f Mpixel/s\n",
+           enc.decode_ns / 1e6 / enc.frames, (double)enc.pixels * enc.frames / (enc.decode_ns / 1e3));
+
+    free(enc.expanded);
+    free(enc.lut);
+    free(enc.chunk);
+    free(enc.check);
+    free(enc.indices);
+    free(scene);
+    return 0;
+}
@@ -0,0 +1,1573 @@
+/**
+ * Playback Pipeline Simulator
+ *
+ * Deterministic virtual-time model of video playback across the two cores.
+ * It covers:
+ *  - the reader and playback tasks with their FreeRTOS priorities and
+ *    pinning, and the prefetch queue between them
+ *  - the SD card, through the card emulator (sd_emu.c): avi_parser and the
+ *    frame index read the real file through a stdio buffer of
+ *    read_block_size, and each request underneath pays the card's latency,
+ *    stalls and throughput cap, or fails
+ *  - SPI wire time of each band pushed to the panel
+ *  - an optional I2S feeder (modeled on radio_player) and the app_main loop
+ *  - channel switches through the encoder task
+ *
+ * Frames, file layout and timing come from a real AVI. Per-stage CPU
+ * costs are parameters; calibrate them from the device benchmarks
+ * (bench_codecs, bench_panel_format, bench_radio) for your board. The
+ * simulator predicts the displayed frame rate, hitches, queue and audio
+ * underruns, and switch latency. Buffer depths, priorities and core pinning
+ * can then be tuned here before anything is flashed.
+ *
+ * Same file, seed and parameters give the same result. -l lists every
+ * parameter with its default and the built-in card profiles.
+ *
+ * -a is the buffering check for a card: exit 1 on any queue underrun after
+ * the first frame, or if a read error stops playback. -m finds, for each
+ * card profile (or the -c one), the smallest prefetch depth that passes.
+ *
+ * Usage: pipeline_sim [-l] [-c card] [-f params.txt] [-s key=value]... [-t trace.csv] [-a|-m] file.avi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <unistd.h>
+#include "avi_parser.h"
+#include "timebase.h"
+#include "sd_emu.h"
+
+#define NUM_CORES           2
+#define MAX_TASKS           16
+#define MAX_QUEUE_DEPTH     16
+#define TICK_US             1000.0  // CONFIG_FREERTOS_HZ=1000
+#define EPS_US              1e-6
+
+// As in video_player.c
+#define READER_IDLE_MS      10
+#define STOP_POLL_MS        10      // video_player_stop waiting for the task to exit
+#define RECV_TIMEOUT_MS     100
+#define RESYNC_INTERVALS    4
+#define DIFF_BAND_ROWS      16
+#define PAL8_STRIP_ROWS     16
+
+#define HITCH_FACTOR        1.5     // Gap over 1.5 frame intervals counts as a hitch
+#define I2S_DMA_DESC        6       // audio_player default descriptor count
+
+/**
+ * Parameters
+ */
+typedef enum {
+    P_PREFETCH_DEPTH,
+    P_READ_BLOCK_SIZE,
+    P_READER_PRIO,
+    P_READER_CORE,
+    P_PLAYBACK_PRIO,
+    P_PLAYBACK_CORE,
+    P_READER_BASE_US,
+    P_READER_NS_PER_BYTE,
+    P_MJPEG_BASE_US,
+    P_MJPEG_NS_PER_BYTE,
+    P_LZ565_BASE_US,
+    P_LZ565_NS_PER_BYTE,
+    P_CRB_BASE_US,
+    P_CRB_NS_PER_BYTE,
+    P_PAL8_BASE_US,
+    P_PAL8_NS_PER_BYTE,
+    P_RGB444,
+    P_PACK444_US,
+    P_DIFF_US,
+    P_PUSH_FRACTION,
+    P_PUSH_RUNS,
+    P_SPI_CLOCK_HZ,
+    P_SPI_TRANS_US,
+    P_SD_SEQ_KBPS,
+    P_SD_P50_US,
+    P_SD_P99_US,
+    P_SD_SLOW_PPM,
+    P_SD_SLOW_MS,
+    P_SD_STALL_PERIOD_MS,
+    P_SD_STALL_MS,
+    P_SD_ERROR_PPM,
+    P_AUDIO,
+    P_AUDIO_PRIO,
+    P_AUDIO_CORE,
+    P_AUDIO_RATE,
+    P_AUDIO_BLOCK,
+    P_AUDIO_BYTES_PER_SAMPLE,
+    P_AUDIO_READ_BLOCK,
+    P_AUDIO_CONVERT_US,
+    P_AUDIO_RING,
+    P_UI_PRIO,
+    P_UI_CORE,
+    P_UI_PERIOD_MS,
+    P_UI_COST_US,
+    P_SWITCH_EVERY_S,
+    P_SWITCH_PRIO,
+    P_SWITCH_CORE,
+    P_SWITCH_CPU_US,
+    P_SWITCH_PAUSE_MS,
+    P_OPEN_CPU_US,
+    P_CPU_MHZ,
+    P_DURATION_S,
+    P_LOOP,
+    P_SEED,
+    P_COUNT
+} param_id_t;
+
+typedef struct {
+    const char *key;
+    double value;
+    const char *help;
+} param_t;
+
+// Placeholder calibration: ESP32 at 240 MHz, 320x240 content, 26 MHz SPI, a mid-range card
+static param_t g_params[P_COUNT] = {
+    [P_PREFETCH_DEPTH]         = {"prefetch_depth", -1, "reader queue depth, 0 = inline reads, -1 = derive from SD profile"},
+    [P_READ_BLOCK_SIZE]        = {"read_block_size", 0, "stdio buffer of the AVI file, 0 = derive from SD profile"},
+    [P_READER_PRIO]            = {"reader_prio", 11, "video_reader priority"},
+    [P_READER_CORE]            = {"reader_core", 0, "video_reader core, -1 = unpinned"},
+    [P_PLAYBACK_PRIO]          = {"playback_prio", 10, "video_playback priority"},
+    [P_PLAYBACK_CORE]          = {"playback_core", 0, "video_playback core, -1 = unpinned"},
+    [P_READER_BASE_US]         = {"reader_base_us", 60, "reader CPU per frame (parse, malloc)"},
+    [P_READER_NS_PER_BYTE]     = {"reader_ns_per_byte", 4, "reader CPU per frame byte (copy out of the stdio buffer)"},
+    [P_MJPEG_BASE_US]          = {"mjpeg_base_us", 9000, "MJPEG decode fixed cost"},
+    [P_MJPEG_NS_PER_BYTE]      = {"mjpeg_ns_per_byte", 1900, "MJPEG decode cost per compressed byte"},
+    [P_LZ565_BASE_US]          = {"lz565_base_us", 3500, "LZ565 decode fixed cost"},
+    [P_LZ565_NS_PER_BYTE]      = {"lz565_ns_per_byte", 120, "LZ565 decode cost per compressed byte"},
+    [P_CRB_BASE_US]            = {"crb_base_us", 1500, "CRB decode fixed cost"},
+    [P_CRB_NS_PER_BYTE]        = {"crb_ns_per_byte", 900, "CRB decode cost per compressed byte"},
+    [P_PAL8_BASE_US]           = {"pal8_base_us", 4500, "PAL8 decode and expand fixed cost"},
+    [P_PAL8_NS_PER_BYTE]       = {"pal8_ns_per_byte", 150, "PAL8 decode cost per compressed byte"},
+    [P_RGB444]                 = {"rgb444", 0, "panel in 12-bit mode (MJPEG decodes direct, others pack)"},
+    [P_PACK444_US]             = {"pack444_us", 1800, "RGB565 -> RGB444 pack per frame"},
+    [P_DIFF_US]                = {"diff_us", 600, "band compare per frame (MJPEG, LZ565)"},
+    [P_PUSH_FRACTION]          = {"push_fraction", 1.0, "share of each frame in changed bands or rows"},
+    [P_PUSH_RUNS]              = {"push_runs", 0, "transfers per frame, 0 = 1 (PAL8: one per strip)"},
+    [P_SPI_CLOCK_HZ]           = {"spi_clock_hz", 26666667, "SPI clock the bus runs at"},
+    [P_SPI_TRANS_US]           = {"spi_trans_us", 12, "CPU per polled transaction (window setup)"},
+    [P_SD_SEQ_KBPS]            = {"sd_seq_kbps", 9000, "card throughput cap KB/s (SD profile)"},
+    [P_SD_P50_US]              = {"sd_p50_us", 1100, "random 4 KB read median (SD profile)"},
+    [P_SD_P99_US]              = {"sd_p99_us", 9000, "random 4 KB read 99th percentile (SD profile)"},
+    [P_SD_SLOW_PPM]            = {"sd_slow_ppm", 0, "card reads per million taking sd_slow_ms extra"},
+    [P_SD_SLOW_MS]             = {"sd_slow_ms", 0, "extra time of a slow read"},
+    [P_SD_STALL_PERIOD_MS]     = {"sd_stall_period_ms", 0, "card busy for sd_stall_ms every period, 0 = never"},
+    [P_SD_STALL_MS]            = {"sd_stall_ms", 0, "length of each card stall"},
+    [P_SD_ERROR_PPM]           = {"sd_error_ppm", 0, "card reads per million failing with EIO"},
+    [P_AUDIO]                  = {"audio", 0, "run an I2S feeder task reading from the same card"},
+    [P_AUDIO_PRIO]             = {"audio_prio", 9, "audio feeder priority (radio_player)"},
+    [P_AUDIO_CORE]             = {"audio_core", 0, "audio feeder core, -1 = unpinned"},
+    [P_AUDIO_RATE]             = {"audio_rate", 22050, "I2S sample rate"},
+    [P_AUDIO_BLOCK]            = {"audio_block", 2048, "samples per feeder write"},
+    [P_AUDIO_BYTES_PER_SAMPLE] = {"audio_bytes_per_sample", 1, "source bytes per sample on the card"},
+    [P_AUDIO_READ_BLOCK]       = {"audio_read_block", 4096, "stdio buffer of the audio file"},
+    [P_AUDIO_CONVERT_US]       = {"audio_convert_us", 350, "feeder CPU per block"},
+    [P_AUDIO_RING]             = {"audio_ring", 1440, "I2S DMA samples (descriptors x frames)"},
+    [P_UI_PRIO]                = {"ui_prio", 5, "app_main loop priority"},
+    [P_UI_CORE]                = {"ui_core", 1, "app_main loop core"},
+    [P_UI_PERIOD_MS]           = {"ui_period_ms", 100, "app_main loop delay"},
+    [P_UI_COST_US]             = {"ui_cost_us", 150, "app_main CPU per iteration"},
+    [P_SWITCH_EVERY_S]         = {"switch_every_s", 0, "channel switch period, 0 = none"},
+    [P_SWITCH_PRIO]            = {"switch_prio", 5, "encoder event task priority"},
+    [P_SWITCH_CORE]            = {"switch_core", -1, "encoder event task core"},
+    [P_SWITCH_CPU_US]          = {"switch_cpu_us", 12000, "save_state and OSD CPU"},
+    [P_SWITCH_PAUSE_MS]        = {"switch_pause_ms", 200, "delay before the new channel plays"},
+    [P_OPEN_CPU_US]            = {"open_cpu_us", 8000, "CPU to open an episode"},
+    [P_CPU_MHZ]                = {"cpu_mhz", 240, "CPU clock; costs above are at 240 MHz"},
+    [P_DURATION_S]             = {"duration_s", 60, "simulated time"},
+    [P_LOOP]                   = {"loop", 1, "restart the file at its end instead of stopping"},
+    [P_SEED]                   = {"seed", 1, "random seed for card timing"},
+};
+
+#define PV(id)      (g_params[id].value)
+
+/**
+ * Content
+ */
+typedef struct {
+    const char *path;
+    uint32_t frames;
+    uint32_t compression;
+    uint16_t width;
+    uint16_t height;
+    timebase_t timebase;
+} content_t;
+
+/**
+ * Frame read result, as the reader queues it
+ */
+typedef struct {
+    uint32_t frame;
+    uint32_t size;
+    esp_err_t status;
+} queue_item_t;
+
+/**
+ * FreeRTOS queue of read results
+ */
+typedef struct {
+    queue_item_t items[MAX_QUEUE_DEPTH];
+    int head;
+    int count;
+    int depth;
+} sim_queue_t;
+
+typedef enum { TASK_DEAD, TASK_READY, TASK_BLOCKED } task_state_t;
+typedef enum { WAIT_NONE, WAIT_DELAY, WAIT_SD, WAIT_SPI, WAIT_SEND, WAIT_RECV, WAIT_I2S } wait_kind_t;
+typedef enum { ROLE_READER, ROLE_PLAYBACK, ROLE_AUDIO, ROLE_UI, ROLE_SWITCH, ROLE_COUNT } task_role_t;
+
+static const char *g_role_names[ROLE_COUNT] = {"reader", "playback", "audio", "app_main", "encoder"};
+
+typedef struct session session_t;
+typedef struct task task_t;
+typedef void (*task_step_t)(task_t *t);
+
+/**
+ * Task: a state machine resumed at pc whenever it holds a core with no CPU
+ * burst left
+ */
+struct task {
+    task_role_t role;
+    int prio;
+    int core;                   // Pinned core, -1 = either
+    task_state_t state;
+    wait_kind_t wait;
+    sim_queue_t *wait_queue;
+    double cpu_left;            // Microseconds of the current burst still to run
+    double wake_at;             // Delay end or wait timeout, < 0 = none
+    bool timed_out;
+    int last_core;
+    int pc;
+    task_step_t step;
+    session_t *session;
+    queue_item_t item;          // Frame read, received or to send
+    int run;                    // Transfer within the frame
+};
+
+/**
+ * One video_player_play .. video_player_stop
+ */
+struct session {
+    bool playing;
+    bool reader_run;
+    bool reader_eof;
+    task_t *reader;
+    task_t *playback;
+    sim_queue_t queue;
+    avi_parser_t avi;           // Opened through the card
+    double pace_origin;
+    uint32_t paced_frames;
+    double switch_at;           // Input event that started it, < 0 for the first
+    bool first_push;            // Full refresh pending
+    bool shown_any;
+};
+
+typedef struct {
+    task_t *task;
+    double service_us;
+} sd_request_t;
+
+typedef struct {
+    uint32_t shown;
+    double last_shown;
+    uint32_t hitches;
+    double max_gap;
+    uint32_t resyncs;
+    uint32_t underruns;
+    uint32_t late_underruns;    // After the session's first frame
+    uint32_t read_errors;       // Frame reads that failed and stopped playback
+    double stopped_at;
+    uint32_t open_failures;
+    uint32_t switches;
+    double switch_sum;
+    double switch_min;
+    double switch_max;
+    uint32_t overlaps;          // New session started with old tasks alive
+    uint32_t ended;
+} sim_stats_t;
+
+static content_t g_content;
+static FILE *g_trace;
+
+static double g_now;
+static double g_cpu_scale;
+static double g_interval_us;
+
+static task_t g_tasks[MAX_TASKS];
+static task_t *g_running[NUM_CORES];
+static double g_core_busy[NUM_CORES];
+static double g_role_busy[ROLE_COUNT];
+
+static sd_request_t g_sd_queue[MAX_TASKS];
+static int g_sd_len;
+static double g_sd_done_at;
+static double g_sd_busy_us;
+static uint32_t g_sd_requests;
+static sd_emu_t *g_card;
+
+static bool g_spi_busy;
+static double g_spi_done_at;
+static session_t *g_spi_session;
+static bool g_spi_frame_end;
+static int g_spi_frame;
+static double g_spi_busy_us;
+
+static struct {
+    bool started;               // Channel running (audio enabled)
+    bool starving;
+    double level;
+    double last;
+    uint32_t underruns;
+    double starved_us;
+    double pending;             // Samples of the block not yet written
+    FILE *file;                 // Source, read through the card
+    uint8_t *buf;
+} g_i2s;
+
+static session_t **g_sessions;  // Every session of the run, freed at its end
+static int g_session_count;
+static session_t *g_session;
+static session_t *g_opening;
+static double g_next_switch;
+static double g_switch_event;
+static sim_stats_t g_stats;
+
+/** Fatal error */
+static void die(const char *msg)
+{
+    fprintf(stderr, "pipeline_sim: %s\n", msg);
+    exit(2);
+}
+
+// ---------------------------------------------------------------------------
+// Parameters and content
+// ---------------------------------------------------------------------------
+
+/** Set parameter from key=value */
+static int set_param(const char *assignment)
+{
+    const char *eq = strchr(assignment, '=');
+    if (eq == NULL) return -1;
+
+    size_t len = eq - assignment;
+    while (len > 0 && (assignment[len - 1] == ' ' || assignment[len - 1] == '\t')) len--;
+    for (int i = 0; i < P_COUNT; i++) {
+        if (strlen(g_params[i].key) == len && strncmp(g_params[i].key, assignment, len) == 0) {
+            char *end;
+            double v = strtod(eq + 1, &end);
+            if (end == eq + 1) return -1;
+            g_params[i].value = v;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/** Load key=value lines, # comments */
+static int load_params(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return -1;
+
+    char line[256];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        p[strcspn(p, "#\r\n")] = '\0';
+        size_t len = strlen(p);
+        while (len > 0 && (p[len - 1] == ' ' || p[len - 1] == '\t')) p[--len] = '\0';
+        if (len == 0) continue;
+        if (set_param(p) != 0) {
+            fprintf(stderr, "%s:%d: bad parameter '%s'\n", path, lineno, p);
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+/** Derive prefetch depth and read block as sd_profile_tune does */
+static void derive_io_tuning(void)
+{
+    double kbps = PV(P_SD_SEQ_KBPS);
+    double overhead_us = PV(P_SD_P50_US) - 4.0 * 1000000 / kbps;
+    if (overhead_us < 0) overhead_us = 0;
+
+    if (PV(P_READ_BLOCK_SIZE) <= 0) {
+        uint32_t block = 4 * 1024;
+        while (block < 32 * 1024 && (double)block * 1000000 / 1024 / kbps < 3 * overhead_us) {
+            block <<= 1;
+        }
+        PV(P_READ_BLOCK_SIZE) = block;
+    }
+
+    if (PV(P_PREFETCH_DEPTH) < 0) {
+        double depth = 2 + floor(PV(P_SD_P99_US) / 33333);
+        PV(P_PREFETCH_DEPTH) = depth > 8 ? 8 : depth;
+    }
+}
+
+/** Set the sd_* parameters from a built-in card profile */
+static void apply_card(const sd_emu_card_t *card)
+{
+    PV(P_SD_SEQ_KBPS) = card->seq_kbps;
+    PV(P_SD_P50_US) = card->p50_us;
+    PV(P_SD_P99_US) = card->p99_us;
+    PV(P_SD_SLOW_PPM) = card->slow_ppm;
+    PV(P_SD_SLOW_MS) = card->slow_ms;
+    PV(P_SD_STALL_PERIOD_MS) = card->stall_period_ms;
+    PV(P_SD_STALL_MS) = card->stall_ms;
+    PV(P_SD_ERROR_PPM) = card->error_ppm;
+}
+
+/** Load stream info */
+static int load_content(const char *path)
+{
+    avi_parser_t avi;
+    if (avi_parser_open(&avi, path) != ESP_OK) return -1;
+
+    content_t *c = &g_content;
+    c->path = path;
+    c->frames = avi.total_frames;
+    c->compression = avi.video_info.compression;
+    c->width = avi.video_info.width;
+    c->height = avi.video_info.height;
+    avi_parser_get_timebase(&avi, &c->timebase);
+    avi_parser_close(&avi);
+
+    return (c->width && c->height) ? 0 : -1;
+}
+
+// ---------------------------------------------------------------------------
+// Scheduler
+// ---------------------------------------------------------------------------
+
+/** Spawn task */
+static task_t *task_spawn(task_role_t role, int prio, int core, task_step_t step, session_t *s)
+{
+    for (int i = 0; i < MAX_TASKS; i++) {
+        task_t *t = &g_tasks[i];
+        if (t->state != TASK_DEAD) continue;
+
+        memset(t, 0, sizeof(*t));
+        t->role = role;
+        t->prio = prio;
+        t->core = (core >= 0 && core < NUM_CORES) ? core : -1;
+        t->state = TASK_READY;
+        t->wake_at = -1;
+        t->last_core = -1;
+        t->step = step;
+        t->session = s;
+        return t;
+    }
+    die("out of task slots");
+    return NULL;
+}
+
+/** Make task ready */
+static void task_wake(task_t *t, bool timed_out)
+{
+    t->state = TASK_READY;
+    t->wait = WAIT_NONE;
+    t->wait_queue = NULL;
+    t->wake_at = -1;
+    t->timed_out = timed_out;
+}
+
+/** Block task */
+static void task_block(task_t *t, wait_kind_t wait, double timeout_us)
+{
+    t->state = TASK_BLOCKED;
+    t->wait = wait;
+    t->wake_at = (timeout_us >= 0) ? g_now + timeout_us : -1;
+    t->timed_out = false;
+}
+
+/** Run on the CPU (cost at 240 MHz) */
+static void task_cpu(task_t *t, double us, int next_pc)
+{
+    t->cpu_left = us * g_cpu_scale;
+    t->pc = next_pc;
+}
+
+/** vTaskDelay: wakes on a tick boundary */
+static void task_delay_ms(task_t *t, uint32_t ms, int next_pc)
+{
+    t->pc = next_pc;
+    if (ms == 0) return;
+
+    double wake = (floor(g_now / TICK_US + EPS_US) + ms) * TICK_US;
+    task_block(t, WAIT_DELAY, wake - g_now);
+}
+
+/** Task exit */
+static void task_exit(task_t *t)
+{
+    t->state = TASK_DEAD;
+    for (int c = 0; c < NUM_CORES; c++) {
+        if (g_running[c] == t) g_running[c] = NULL;
+    }
+}
+
+/** Pick the highest priority ready task per core, keeping tasks where they ran */
+static void schedule(void)
+{
+    task_t *chosen[NUM_CORES] = {NULL};
+
+    for (int c = 0; c < NUM_CORES; c++) {
+        task_t *best = NULL;
+        for (int i = 0; i < MAX_TASKS; i++) {
+            task_t *t = &g_tasks[i];
+            if (t->state != TASK_READY) continue;
+            if (t->core >= 0 && t->core != c) continue;
+            if (c > 0 && chosen[0] == t) continue;
+
+            // Unpinned tasks stay on the core they last ran on when tied
+            if (best == NULL || t->prio > best->prio ||
+                (t->prio == best->prio && t->last_core == c && best->last_core != c)) {
+                best = t;
+            }
+        }
+        chosen[c] = best;
+    }
+
+    for (int c = 0; c < NUM_CORES; c++) {
+        g_running[c] = chosen[c];
+        if (chosen[c]) chosen[c]->last_core = c;
+    }
+}
+
+/** Let running tasks step until every one is computing or blocked */
+static void dispatch(void)
+{
+    for (int guard = 0; guard < 100000; guard++) {
+        schedule();
+
+        bool stepped = false;
+        for (int c = 0; c < NUM_CORES; c++) {
+            task_t *t = g_running[c];
+            if (t && t->state == TASK_READY && t->cpu_left <= EPS_US) {
+                t->cpu_left = 0;
+                t->step(t);
+                stepped = true;
+                break;          // Re-schedule: the step may have woken a higher priority task
+            }
+        }
+        if (!stepped) return;
+    }
+    die("tasks loop without advancing time");
+}
+
+// ---------------------------------------------------------------------------
+// Queue, SD, SPI and I2S
+// ---------------------------------------------------------------------------
+
+/** Wake the highest priority task waiting on a queue */
+static void queue_wake(sim_queue_t *q, wait_kind_t wait)
+{
+    task_t *best = NULL;
+    for (int i = 0; i < MAX_TASKS; i++) {
+        task_t *t = &g_tasks[i];
+        if (t->state == TASK_BLOCKED && t->wait == wait && t->wait_queue == q &&
+            (best == NULL || t->prio > best->prio)) {
+            best = t;
+        }
+    }
+    if (best) task_wake(best, false);
+}
+
+/**
+ * xQueueSend
+ *
+ * @return true if sent, false if the task blocked (check timed_out on resume)
+ */
+static bool queue_send(task_t *t, sim_queue_t *q, const queue_item_t *item, double timeout_us)
+{
+    if (q->count < q->depth) {
+        q->items[(q->head + q->count) % MAX_QUEUE_DEPTH] = *item;
+        q->count++;
+        queue_wake(q, WAIT_RECV);
+        return true;
+    }
+    task_block(t, WAIT_SEND, timeout_us);
+    t->wait_queue = q;
+    return false;
+}
+
+/**
+ * xQueueReceive
+ *
+ * @return true if received, false if the task blocked
+ */
+static bool queue_recv(task_t *t, sim_queue_t *q, queue_item_t *item, double timeout_us)
+{
+    if (q->count > 0) {
+        *item = q->items[q->head];
+        q->head = (q->head + 1) % MAX_QUEUE_DEPTH;
+        q->count--;
+        queue_wake(q, WAIT_SEND);
+        return true;
+    }
+    task_block(t, WAIT_RECV, timeout_us);
+    t->wait_queue = q;
+    return false;
+}
+
+/** Start the next SD request */
+static void sd_start(void)
+{
+    if (g_sd_len > 0) g_sd_done_at = g_now + g_sd_queue[0].service_us;
+}
+
+/** Queue SD request (the card serves one at a time) */
+static void sd_submit(task_t *t, double service_us, int next_pc)
+{
+    if (g_sd_len == MAX_TASKS) die("SD queue overflow");
+
+    g_sd_queue[g_sd_len].task = t;
+    g_sd_queue[g_sd_len].service_us = service_us;
+    g_sd_len++;
+    g_sd_requests++;
+    if (g_sd_len == 1) sd_start();
+
+    t->pc = next_pc;
+    task_block(t, WAIT_SD, -1);
+}
+
+/** Time the card finishes the requests already queued */
+static double sd_free_at(void)
+{
+    if (g_sd_len == 0) return g_now;
+
+    double t = g_sd_done_at;
+    for (int i = 1; i < g_sd_len; i++) t += g_sd_queue[i].service_us;
+    return t;
+}
+
+/** Start a DMA transfer */
+static void spi_start(double bytes, session_t *s, int frame, bool frame_end)
+{
+    g_spi_busy = true;
+    g_spi_done_at = g_now + bytes * 8.0 * 1000000.0 / PV(P_SPI_CLOCK_HZ);
+    g_spi_session = s;
+    g_spi_frame = frame;
+    g_spi_frame_end = frame_end;
+}
+
+/** Bring the I2S level up to now */
+static void i2s_update(void)
+{
+    if (!g_i2s.started || g_now <= g_i2s.last) return;
+
+    double consumed = (g_now - g_i2s.last) * PV(P_AUDIO_RATE) / 1000000.0;
+    if (consumed > g_i2s.level + EPS_US) {
+        g_i2s.starved_us += (consumed - g_i2s.level) * 1000000.0 / PV(P_AUDIO_RATE);
+        if (!g_i2s.starving) g_i2s.underruns++;
+        g_i2s.starving = true;
+        g_i2s.level = 0;
+    } else {
+        g_i2s.level -= consumed;
+        if (g_i2s.level < 0) g_i2s.level = 0;
+    }
+    g_i2s.last = g_now;
+}
+
+/**
+ * Blocking I2S write: fills what fits and waits for room for the rest
+ *
+ * @param remaining Samples still to write, updated
+ * @return true when all written, false if the task blocked
+ */
+static bool i2s_write(task_t *t, double *remaining)
+{
+    i2s_update();
+
+    double room = PV(P_AUDIO_RING) - g_i2s.level;
+    double n = (*remaining < room) ? *remaining : room;
+    if (n > 0) {
+        g_i2s.level += n;
+        *remaining -= n;
+        g_i2s.starving = false;
+    }
+    if (*remaining <= 1e-3) return true;
+
+    // Wake when a DMA descriptor's worth (or the rest) has drained
+    double want = fmin(*remaining, PV(P_AUDIO_RING) / I2S_DMA_DESC);
+    task_block(t, WAIT_I2S, want * 1000000.0 / PV(P_AUDIO_RATE));
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// Tasks
+// ---------------------------------------------------------------------------
+
+/** Frame shown: the last transfer of a frame finished */
+static void frame_shown(session_t *s, int frame)
+{
+    double gap = 0;
+
+    if (!s->shown_any) {
+        s->shown_any = true;
+        if (s->switch_at >= 0) {
+            double latency = g_now - s->switch_at;
+            g_stats.switches++;
+            g_stats.switch_sum += latency;
+            if (g_stats.switches == 1 || latency < g_stats.switch_min) g_stats.switch_min = latency;
+            if (latency > g_stats.switch_max) g_stats.switch_max = latency;
+        }
+    } else {
+        gap = g_now - g_stats.last_shown;
+        if (gap > HITCH_FACTOR * g_interval_us) g_stats.hitches++;
+        if (gap > g_stats.max_gap) g_stats.max_gap = gap;
+    }
+
+    g_stats.last_shown = g_now;
+    g_stats.shown++;
+
+    if (g_trace) {
+        fprintf(g_trace, "%.3f,%d,%.3f,%d,%.0f\n", g_now / 1000.0, frame, gap / 1000.0,
+                s->queue.count, g_i2s.level);
+    }
+}
+
+/** Decode cost of a frame */
+static double decode_us(uint32_t size)
+{
+    switch (g_content.compression) {
+    case FOURCC_L565: return PV(P_LZ565_BASE_US) + PV(P_LZ565_NS_PER_BYTE) * size / 1000.0;
+    case FOURCC_CRB1: return PV(P_CRB_BASE_US) + PV(P_CRB_NS_PER_BYTE) * size / 1000.0;
+    case FOURCC_PAL8: return PV(P_PAL8_BASE_US) + PV(P_PAL8_NS_PER_BYTE) * size / 1000.0;
+    default:          return PV(P_MJPEG_BASE_US) + PV(P_MJPEG_NS_PER_BYTE) * size / 1000.0;
+    }
+}
+
+/** Transfers per frame */
+static int push_runs(bool full)
+{
+    if (g_content.compression == FOURCC_PAL8) {
+        return (g_content.height + PAL8_STRIP_ROWS - 1) / PAL8_STRIP_ROWS;
+    }
+    if (full || PV(P_PUSH_RUNS) < 1) return 1;
+    return (int)PV(P_PUSH_RUNS);
+}
+
+/** Bytes on the wire for a frame */
+static double push_bytes(bool full)
+{
+    double bytes = (double)g_content.width * g_content.height * (PV(P_RGB444) ? 1.5 : 2.0);
+    return full ? bytes : bytes * PV(P_PUSH_FRACTION);
+}
+
+enum { RD_LOOP, RD_CPU, RD_SEND };
+
+/**
+ * Read the next frame through the card, for the reader or inline
+ * The task then waits for the card time the reads took
+ */
+static void read_frame(task_t *t, session_t *s, int next_pc)
+{
+    mjpeg_frame_t frame;
+
+    sd_emu_begin(g_card, sd_free_at());
+    esp_err_t ret = avi_parser_read_video_frame(&s->avi, &frame);
+    if (ret == ESP_ERR_NOT_FOUND && PV(P_LOOP) && !ferror(s->avi.file) && avi_parser_seek(&s->avi, 0) == ESP_OK) {
+        ret = avi_parser_read_video_frame(&s->avi, &frame);
+    }
+    double us = sd_emu_end(g_card);
+
+    // A failed chunk header read looks like the end of the file to the
+    // parser; the stream's error flag tells them apart
+    if (ret != ESP_OK && ferror(s->avi.file)) ret = ESP_FAIL;
+
+    t->item.status = ret;
+    t->item.frame = (ret == ESP_OK) ? frame.frame_num : 0;
+    t->item.size = (ret == ESP_OK) ? frame.size : 0;
+    if (ret == ESP_OK) avi_parser_free_frame(&frame);
+
+    if (us > 0) {
+        sd_submit(t, us, next_pc);
+    } else {
+        t->pc = next_pc;
+    }
+}
+
+/** Reader CPU for a frame */
+static double reader_us(uint32_t size)
+{
+    return PV(P_READER_BASE_US) + PV(P_READER_NS_PER_BYTE) * size / 1000.0;
+}
+
+/** video_reader */
+static void reader_step(task_t *t)
+{
+    session_t *s = t->session;
+
+    switch (t->pc) {
+    case RD_LOOP:
+        if (!s->reader_run) {
+            s->reader = NULL;
+            task_exit(t);
+            return;
+        }
+        if (s->reader_eof) {
+            task_delay_ms(t, READER_IDLE_MS, RD_LOOP);
+            return;
+        }
+        read_frame(t, s, RD_CPU);
+        return;
+
+    case RD_CPU:
+        if (t->item.status != ESP_OK) {
+            // End of file or read error: queued for playback to act on
+            s->reader_eof = true;
+            t->pc = RD_SEND;
+            return;
+        }
+        task_cpu(t, reader_us(t->item.size), RD_SEND);
+        return;
+
+    case RD_SEND:
+        if (!s->reader_run) {
+            t->pc = RD_LOOP;
+            return;
+        }
+        // Retried until sent or stopped
+        if (queue_send(t, &s->queue, &t->item, READER_IDLE_MS * 5 * 1000.0)) t->pc = RD_LOOP;
+        return;
+    }
+}
+
+enum { PB_START, PB_NEXT, PB_RECV, PB_INLINE_CPU, PB_DECODE, PB_PUSH, PB_DMA, PB_PACE, PB_STOP, PB_JOIN };
+
+/** video_playback */
+static void playback_step(task_t *t)
+{
+    session_t *s = t->session;
+
+    switch (t->pc) {
+    case PB_START:
+        if (s->queue.depth > 0) {
+            s->reader_run = true;
+            s->reader = task_spawn(ROLE_READER, (int)PV(P_READER_PRIO), (int)PV(P_READER_CORE),
+                                   reader_step, s);
+        }
+        s->pace_origin = g_now;
+        s->paced_frames = 0;
+        s->first_push = true;
+        t->pc = PB_NEXT;
+        return;
+
+    case PB_NEXT:
+        if (!s->playing) {
+            t->pc = PB_STOP;
+            return;
+        }
+        if (s->queue.depth == 0) {
+            read_frame(t, s, PB_INLINE_CPU);
+            return;
+        }
+        if (s->queue.count == 0 && !s->reader_eof) {
+            g_stats.underruns++;
+            if (s->shown_any) g_stats.late_underruns++;
+        }
+        t->pc = PB_RECV;
+        return;
+
+    case PB_RECV:
+        if (t->timed_out) {
+            // State check on every receive timeout
+            t->timed_out = false;
+            if (!s->playing) {
+                t->pc = PB_STOP;
+                return;
+            }
+        }
+        if (queue_recv(t, &s->queue, &t->item, RECV_TIMEOUT_MS * 1000.0)) t->pc = PB_DECODE;
+        return;
+
+    case PB_INLINE_CPU:
+        task_cpu(t, (t->item.status == ESP_OK) ? reader_us(t->item.size) : 0, PB_DECODE);
+        return;
+
+    case PB_DECODE: {
+        if (g_content.compression == FOURCC_CRB1 && g_spi_busy) {
+            // The CRB canvas is decoded in place
+            task_block(t, WAIT_SPI, -1);
+            return;
+        }
+        if (t->item.status == ESP_ERR_NOT_FOUND) {
+            g_stats.ended++;
+            s->playing = false;
+            t->pc = PB_STOP;
+            return;
+        }
+        if (t->item.status != ESP_OK) {
+            // VIDEO_STATE_ERROR: on_error ends playback until the next channel change
+            if (g_stats.read_errors++ == 0) g_stats.stopped_at = g_now;
+            s->playing = false;
+            t->pc = PB_STOP;
+            return;
+        }
+
+        bool mjpeg = (g_content.compression == FOURCC_MJPG);
+        bool banded = mjpeg || g_content.compression == FOURCC_L565;
+        double us = decode_us(t->item.size);
+        if (PV(P_RGB444) && !mjpeg && g_content.compression != FOURCC_PAL8) us += PV(P_PACK444_US);
+        if (banded && !s->first_push) us += PV(P_DIFF_US);
+
+        t->run = 0;
+        task_cpu(t, us, PB_PUSH);
+        return;
+    }
+
+    case PB_PUSH:
+        // display_wait_dma before every transfer
+        if (g_spi_busy) {
+            task_block(t, WAIT_SPI, -1);
+            return;
+        }
+        task_cpu(t, 5 * PV(P_SPI_TRANS_US), PB_DMA);
+        return;
+
+    case PB_DMA: {
+        int runs = push_runs(s->first_push);
+        spi_start(push_bytes(s->first_push) / runs, s, (int)t->item.frame, t->run == runs - 1);
+        if (++t->run < runs) {
+            t->pc = PB_PUSH;
+            return;
+        }
+        s->first_push = false;
+        t->pc = PB_PACE;
+        return;
+    }
+
+    case PB_PACE: {
+        s->paced_frames++;
+        double next = s->pace_origin + (double)timebase_frame_to_us(&g_content.timebase, s->paced_frames);
+        if (next > g_now) {
+            task_delay_ms(t, (uint32_t)((uint64_t)(next - g_now) / 1000), PB_NEXT);
+        } else {
+            if (g_now - next > RESYNC_INTERVALS * g_interval_us) {
+                s->pace_origin = g_now;
+                s->paced_frames = 0;
+                g_stats.resyncs++;
+            }
+            t->pc = PB_NEXT;
+        }
+        return;
+    }
+
+    case PB_STOP:
+        s->reader_run = false;
+        t->pc = PB_JOIN;
+        return;
+
+    case PB_JOIN:
+        if (s->reader) {
+            task_delay_ms(t, READER_IDLE_MS, PB_JOIN);
+            return;
+        }
+        if (g_spi_busy) {
+            task_block(t, WAIT_SPI, -1);
+            return;
+        }
+        // video_player_close
+        avi_parser_close(&s->avi);
+        s->playback = NULL;
+        task_exit(t);
+        return;
+    }
+}
+
+/**
+ * Open an episode through the card (video_player_open)
+ *
+ * @return Session, NULL if the open failed
+ */
+static session_t *session_open(void)
+{
+    session_t *s = calloc(1, sizeof(*s));
+    session_t **list = realloc(g_sessions, (g_session_count + 1) * sizeof(*list));
+    if (s == NULL || list == NULL) die("out of memory");
+    g_sessions = list;
+
+    if (avi_parser_open_buffered(&s->avi, g_content.path, (uint32_t)PV(P_READ_BLOCK_SIZE)) != ESP_OK) {
+        free(s);
+        return NULL;
+    }
+    g_sessions[g_session_count++] = s;
+    return s;
+}
+
+/** Start playback of an opened session (video_player_play) */
+static void session_play(session_t *s, double switch_at)
+{
+    s->playing = true;
+    s->switch_at = switch_at;
+    s->queue.depth = (int)PV(P_PREFETCH_DEPTH);
+    s->playback = task_spawn(ROLE_PLAYBACK, (int)PV(P_PLAYBACK_PRIO), (int)PV(P_PLAYBACK_CORE),
+                             playback_step, s);
+}
+
+enum { AU_READ, AU_CONVERT, AU_WRITE };
+
+/** radio_player feeder */
+static void audio_step(task_t *t)
+{
+    switch (t->pc) {
+    case AU_READ: {
+        size_t bytes = (size_t)(PV(P_AUDIO_BLOCK) * PV(P_AUDIO_BYTES_PER_SAMPLE));
+        sd_emu_begin(g_card, sd_free_at());
+        if (fread(g_i2s.buf, 1, bytes, g_i2s.file) != bytes) {
+            // End of the source or a read error: start over
+            clearerr(g_i2s.file);
+            rewind(g_i2s.file);
+        }
+        double us = sd_emu_end(g_card);
+        if (us > 0) {
+            sd_submit(t, us, AU_CONVERT);
+        } else {
+            t->pc = AU_CONVERT;
+        }
+        return;
+    }
+
+    case AU_CONVERT:
+        g_i2s.pending = PV(P_AUDIO_BLOCK);
+        task_cpu(t, PV(P_AUDIO_CONVERT_US), AU_WRITE);
+        return;
+
+    case AU_WRITE:
+        if (i2s_write(t, &g_i2s.pending)) t->pc = AU_READ;
+        return;
+    }
+}
+
+/** app_main loop */
+static void ui_step(task_t *t)
+{
+    if (t->pc == 0) {
+        task_cpu(t, PV(P_UI_COST_US), 1);
+    } else {
+        task_delay_ms(t, (uint32_t)PV(P_UI_PERIOD_MS), 0);
+    }
+}
+
+enum { SW_WAIT, SW_STOP, SW_JOIN, SW_SAVE, SW_PAUSE, SW_OPEN, SW_OPEN_CPU, SW_PLAY };
+
+/** Encoder event task: channel switch */
+static void switch_step(task_t *t)
+{
+    switch (t->pc) {
+    case SW_WAIT:
+        if (g_now + EPS_US < g_next_switch) {
+            task_delay_ms(t, (uint32_t)ceil((g_next_switch - g_now) / 1000.0), SW_WAIT);
+            return;
+        }
+        t->pc = SW_STOP;
+        return;
+
+    case SW_STOP:
+        // video_player_stop: state to STOPPED, then wait for the task to exit
+        if (g_session) g_session->playing = false;
+        g_switch_event = g_now;
+        t->pc = SW_JOIN;
+        return;
+
+    case SW_JOIN:
+        // The playback task exits once it sees the state, its reader has
+        // finished any card request in flight and the last transfer is done
+        if (g_session && g_session->playback) {
+            task_delay_ms(t, STOP_POLL_MS, SW_JOIN);
+            return;
+        }
+        t->pc = SW_SAVE;
+        return;
+
+    case SW_SAVE:
+        task_cpu(t, PV(P_SWITCH_CPU_US), SW_PAUSE);
+        return;
+
+    case SW_PAUSE:
+        task_delay_ms(t, (uint32_t)PV(P_SWITCH_PAUSE_MS), SW_OPEN);
+        return;
+
+    case SW_OPEN: {
+        // Headers and the frame index cache, through the card
+        sd_emu_begin(g_card, sd_free_at());
+        g_opening = session_open();
+        double us = sd_emu_end(g_card);
+        if (us > 0) {
+            sd_submit(t, us, SW_OPEN_CPU);
+        } else {
+            t->pc = SW_OPEN_CPU;
+        }
+        return;
+    }
+
+    case SW_OPEN_CPU:
+        task_cpu(t, PV(P_OPEN_CPU_US), SW_PLAY);
+        return;
+
+    case SW_PLAY: {
+        session_t *old = g_session;
+        if (old && (old->playback || old->reader)) g_stats.overlaps++;
+
+        // play_episode fails: nothing plays until the next switch
+        g_session = g_opening;
+        g_opening = NULL;
+        if (g_session) {
+            session_play(g_session, g_switch_event);
+        } else {
+            g_stats.open_failures++;
+        }
+
+        g_next_switch += PV(P_SWITCH_EVERY_S) * 1000000.0;
+        while (g_next_switch <= g_now) g_next_switch += PV(P_SWITCH_EVERY_S) * 1000000.0;
+        t->pc = SW_WAIT;
+        return;
+    }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Event loop
+// ---------------------------------------------------------------------------
+
+/** Advance virtual time to the next event and handle it */
+static void advance(double end_us)
+{
+    double next = end_us;
+
+    for (int c = 0; c < NUM_CORES; c++) {
+        if (g_running[c] && g_running[c]->state == TASK_READY) {
+            double t = g_now + g_running[c]->cpu_left;
+            if (t < next) next = t;
+        }
+    }
+    for (int i = 0; i < MAX_TASKS; i++) {
+        if (g_tasks[i].state == TASK_BLOCKED && g_tasks[i].wake_at >= 0 && g_tasks[i].wake_at < next) {
+            next = g_tasks[i].wake_at;
+        }
+    }
+    if (g_sd_len > 0 && g_sd_done_at < next) next = g_sd_done_at;
+    if (g_spi_busy && g_spi_done_at < next) next = g_spi_done_at;
+    if (next < g_now) next = g_now;
+
+    double dt = next - g_now;
+    for (int c = 0; c < NUM_CORES; c++) {
+        task_t *t = g_running[c];
+        if (t && t->state == TASK_READY) {
+            t->cpu_left -= dt;
+            g_core_busy[c] += dt;
+            g_role_busy[t->role] += dt;
+        }
+    }
+    if (g_sd_len > 0) g_sd_busy_us += dt;
+    if (g_spi_busy) g_spi_busy_us += dt;
+    g_now = next;
+    i2s_update();
+
+    if (g_sd_len > 0 && g_sd_done_at <= g_now + EPS_US) {
+        task_wake(g_sd_queue[0].task, false);
+        memmove(g_sd_queue, g_sd_queue + 1, (g_sd_len - 1) * sizeof(sd_request_t));
+        g_sd_len--;
+        sd_start();
+    }
+
+    if (g_spi_busy && g_spi_done_at <= g_now + EPS_US) {
+        g_spi_busy = false;
+        if (g_spi_frame_end) frame_shown(g_spi_session, g_spi_frame);
+        for (int i = 0; i < MAX_TASKS; i++) {
+            if (g_tasks[i].state == TASK_BLOCKED && g_tasks[i].wait == WAIT_SPI) task_wake(&g_tasks[i], false);
+        }
+    }
+
+    for (int i = 0; i < MAX_TASKS; i++) {
+        task_t *t = &g_tasks[i];
+        if (t->state == TASK_BLOCKED && t->wake_at >= 0 && t->wake_at <= g_now + EPS_US) {
+            bool queue_wait = (t->wait == WAIT_SEND || t->wait == WAIT_RECV);
+            task_wake(t, queue_wait);
+        }
+    }
+}
+
+/** Clear state left by a previous run */
+static void sim_reset(void)
+{
+    g_now = 0;
+    memset(g_tasks, 0, sizeof(g_tasks));
+    memset(g_running, 0, sizeof(g_running));
+    memset(g_core_busy, 0, sizeof(g_core_busy));
+    memset(g_role_busy, 0, sizeof(g_role_busy));
+
+    g_sd_len = 0;
+    g_sd_done_at = 0;
+    g_sd_busy_us = 0;
+    g_sd_requests = 0;
+
+    g_spi_busy = false;
+    g_spi_done_at = 0;
+    g_spi_session = NULL;
+    g_spi_frame_end = false;
+    g_spi_frame = 0;
+    g_spi_busy_us = 0;
+
+    memset(&g_i2s, 0, sizeof(g_i2s));
+    g_session = NULL;
+    g_opening = NULL;
+    g_next_switch = 0;
+    g_switch_event = 0;
+    memset(&g_stats, 0, sizeof(g_stats));
+}
+
+/** Release the run's sessions, audio source and card */
+static void sim_cleanup(void)
+{
+    for (int i = 0; i < g_session_count; i++) {
+        avi_parser_close(&g_sessions[i]->avi);
+        free(g_sessions[i]);
+    }
+    free(g_sessions);
+    g_sessions = NULL;
+    g_session_count = 0;
+
+    if (g_i2s.file) fclose(g_i2s.file);
+    free(g_i2s.buf);
+    g_i2s.file = NULL;
+    g_i2s.buf = NULL;
+
+    sd_emu_destroy(g_card);
+    g_card = NULL;
+}
+
+/** Run the model */
+static void simulate(void)
+{
+    double end_us = PV(P_DURATION_S) * 1000000.0;
+
+    sim_reset();
+    g_cpu_scale = 240.0 / PV(P_CPU_MHZ);
+    g_interval_us = (double)timebase_frame_to_us(&g_content.timebase, 1);
+
+    sd_emu_card_t card = {
+        .name = "params",
+        .seq_kbps = (uint32_t)PV(P_SD_SEQ_KBPS),
+        .p50_us = (uint32_t)PV(P_SD_P50_US),
+        .p99_us = (uint32_t)PV(P_SD_P99_US),
+        .slow_ppm = (uint32_t)PV(P_SD_SLOW_PPM),
+        .slow_ms = (uint32_t)PV(P_SD_SLOW_MS),
+        .stall_period_ms = (uint32_t)PV(P_SD_STALL_PERIOD_MS),
+        .stall_ms = (uint32_t)PV(P_SD_STALL_MS),
+        .error_ppm = (uint32_t)PV(P_SD_ERROR_PPM),
+    };
+    g_card = sd_emu_create(&card, (uint64_t)PV(P_SEED));
+    if (g_card == NULL) die("out of memory");
+    sd_emu_attach(g_card);
+
+    // Boot: the first episode opens before the clock starts
+    sd_emu_begin(g_card, 0);
+    g_session = session_open();
+    sd_emu_end(g_card);
+    if (g_session) {
+        session_play(g_session, -1);
+    } else {
+        g_stats.open_failures++;
+    }
+
+    task_spawn(ROLE_UI, (int)PV(P_UI_PRIO), (int)PV(P_UI_CORE), ui_step, NULL);
+    if (PV(P_AUDIO)) {
+        g_i2s.file = fopen(g_content.path, "rb");
+        g_i2s.buf = malloc((size_t)(PV(P_AUDIO_BLOCK) * PV(P_AUDIO_BYTES_PER_SAMPLE)) + 1);
+        if (g_i2s.file == NULL || g_i2s.buf == NULL ||
+            setvbuf(g_i2s.file, NULL, _IOFBF, (size_t)PV(P_AUDIO_READ_BLOCK)) != 0) {
+            die("cannot open the audio source");
+        }
+
+        // The channel runs from the start; the first block has that long to arrive
+        g_i2s.started = true;
+        g_i2s.last = PV(P_AUDIO_BLOCK) * 1000000.0 / PV(P_AUDIO_RATE);
+        task_spawn(ROLE_AUDIO, (int)PV(P_AUDIO_PRIO), (int)PV(P_AUDIO_CORE), audio_step, NULL);
+    }
+    if (PV(P_SWITCH_EVERY_S) > 0) {
+        g_next_switch = PV(P_SWITCH_EVERY_S) * 1000000.0;
+        task_spawn(ROLE_SWITCH, (int)PV(P_SWITCH_PRIO), (int)PV(P_SWITCH_CORE), switch_step, NULL);
+    }
+
+    while (g_now < end_us) {
+        dispatch();
+        advance(end_us);
+    }
+}
+
+/** Buffering check: no underrun once playing, no read error ending playback */
+static bool sim_passed(void)
+{
+    return g_stats.late_underruns == 0 && g_stats.read_errors == 0 && g_stats.open_failures == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Report
+// ---------------------------------------------------------------------------
+
+/** FOURCC as text */
+static const char *fourcc_str(uint32_t v)
+{
+    static char s[5];
+    for (int i = 0; i < 4; i++) {
+        char ch = (char)(v >> (8 * i));
+        s[i] = (ch >= 32 && ch < 127) ? ch : '?';
+    }
+    s[4] = '\0';
+    return s;
+}
+
+/** Print parameters */
+static void print_params(bool with_help)
+{
+    for (int i = 0; i < P_COUNT; i++) {
+        if (with_help) {
+            printf("  %-24s %-10g %s\n", g_params[i].key, g_params[i].value, g_params[i].help);
+        } else {
+            printf("  %s=%g\n", g_params[i].key, g_params[i].value);
+        }
+    }
+}
+
+/** Print results */
+static void print_report(void)
+{
+    double elapsed = g_now;
+    double fps = g_content.timebase.rate / (double)g_content.timebase.scale;
+
+    printf("\nResults over %.1f s:\n", elapsed / 1000000.0);
+    printf("  Frames shown:     %u (%.2f fps, content %.3f fps)\n", g_stats.shown,
+           g_stats.shown * 1000000.0 / elapsed, fps);
+    printf("  Hitches:          %u (gap > %.1f intervals), max gap %.1f ms\n", g_stats.hitches,
+           HITCH_FACTOR, g_stats.max_gap / 1000.0);
+    printf("  Pacing resyncs:   %u\n", g_stats.resyncs);
+    printf("  Queue underruns:  %u (%u after the first frame)\n", g_stats.underruns, g_stats.late_underruns);
+    if (PV(P_AUDIO)) {
+        printf("  Audio underruns:  %u (%.1f ms starved)\n", g_i2s.underruns, g_i2s.starved_us / 1000.0);
+    }
+    if (g_stats.ended) {
+        printf("  End of file:      reached\n");
+    }
+    if (g_stats.read_errors) {
+        printf("  Read errors:      %u, first stopped playback at %.1f s\n", g_stats.read_errors,
+               g_stats.stopped_at / 1000000.0);
+    }
+    if (g_stats.open_failures) {
+        printf("  Open failures:    %u\n", g_stats.open_failures);
+    }
+    if (PV(P_SWITCH_EVERY_S) > 0) {
+        if (g_stats.switches) {
+            printf("  Switch latency:   %.1f ms avg, %.1f min, %.1f max over %u switches\n",
+                   g_stats.switch_sum / g_stats.switches / 1000.0, g_stats.switch_min / 1000.0,
+                   g_stats.switch_max / 1000.0, g_stats.switches);
+        }
+        if (g_stats.overlaps) {
+            printf("  WARNING: %u switches started playback while the old tasks were still running\n",
+                   g_stats.overlaps);
+        }
+    }
+
+    printf("\nUtilization:\n");
+    for (int c = 0; c < NUM_CORES; c++) {
+        printf("  core %d            %5.1f%%\n", c, 100.0 * g_core_busy[c] / elapsed);
+    }
+    for (int r = 0; r < ROLE_COUNT; r++) {
+        if (g_role_busy[r] > 0) {
+            printf("  %-17s %5.1f%%\n", g_role_names[r], 100.0 * g_role_busy[r] / elapsed);
+        }
+    }
+    sd_emu_stats_t card;
+    sd_emu_get_stats(g_card, &card);
+    printf("  SD card           %5.1f%% (%u card requests: %u slow, %u in stalls, %u failed, longest %.1f ms)\n",
+           100.0 * g_sd_busy_us / elapsed, card.requests, card.slow_reads, card.stall_waits, card.errors,
+           card.max_request_us / 1000.0);
+    printf("  SPI bus           %5.1f%%\n", 100.0 * g_spi_busy_us / elapsed);
+}
+
+/** Print built-in card profiles */
+static void print_cards(void)
+{
+    int count;
+    const sd_emu_card_t *cards = sd_emu_cards(&count);
+
+    for (int i = 0; i < count; i++) {
+        const sd_emu_card_t *c = &cards[i];
+        printf("  %-6s %-38s %5u KB/s, p50 %u us, p99 %u us", c->name, c->description, c->seq_kbps,
+               c->p50_us, c->p99_us);
+        if (c->slow_ppm) printf(", %u ppm +%u ms", c->slow_ppm, c->slow_ms);
+        if (c->stall_period_ms) printf(", %u ms stall every %u ms", c->stall_ms, c->stall_period_ms);
+        if (c->error_ppm) printf(", %u ppm errors", c->error_ppm);
+        printf("\n");
+    }
+}
+
+/** Smallest passing prefetch depth per card, next to what sd_profile_tune picks */
+static void find_min_depths(const sd_emu_card_t *only)
+{
+    int count;
+    const sd_emu_card_t *cards = sd_emu_cards(&count);
+    double base[P_COUNT];
+
+    for (int i = 0; i < P_COUNT; i++) base[i] = g_params[i].value;
+
+    printf("\n%-6s %-38s %6s %6s\n", "Card", "", "Tuned", "Needed");
+    for (int i = 0; i < count; i++) {
+        if (only && only != &cards[i]) continue;
+
+        for (int p = 0; p < P_COUNT; p++) g_params[p].value = base[p];
+        apply_card(&cards[i]);
+        PV(P_PREFETCH_DEPTH) = -1;
+        derive_io_tuning();
+        int tuned = (int)PV(P_PREFETCH_DEPTH);
+
+        const char *needed = "none";
+        char depth_str[8];
+        for (int depth = 1; depth <= MAX_QUEUE_DEPTH; depth++) {
+            PV(P_PREFETCH_DEPTH) = depth;
+            simulate();
+            bool passed = sim_passed();
+            bool failed_reads = g_stats.read_errors || g_stats.open_failures;
+            sim_cleanup();
+
+            if (passed) {
+                snprintf(depth_str, sizeof(depth_str), "%d", depth);
+                needed = depth_str;
+                break;
+            }
+            if (failed_reads) {
+                // Read errors end playback at any depth
+                needed = "errors";
+                break;
+            }
+        }
+        printf("%-6s %-38s %6d %6s\n", cards[i].name, cards[i].description, tuned, needed);
+    }
+
+    for (int i = 0; i < P_COUNT; i++) g_params[i].value = base[i];
+}
+
+#define USAGE "Usage: %s [-l] [-c card] [-f params.txt] [-s key=value]... [-t trace.csv] [-a|-m] file.avi\n"
+
+int main(int argc, char **argv)
+{
+    const char *trace_path = NULL;
+    const sd_emu_card_t *card = NULL;
+    bool list = false;
+    bool assert_mode = false;
+    bool min_depth_mode = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:f:s:t:lam")) != -1) {
+        switch (opt) {
+        case 'c':
+            card = sd_emu_find_card(optarg);
+            if (card == NULL) {
+                fprintf(stderr, "Unknown card profile: %s (-l lists them)\n", optarg);
+                return 2;
+            }
+            apply_card(card);
+            break;
+        case 'f':
+            if (load_params(optarg) != 0) return 2;
+            break;
+        case 's':
+            if (set_param(optarg) != 0) {
+                fprintf(stderr, "Unknown parameter or bad value: %s (-l lists them)\n", optarg);
+                return 2;
+            }
+            break;
+        case 't':
+            trace_path = optarg;
+            break;
+        case 'l':
+            list = true;
+            break;
+        case 'a':
+            assert_mode = true;
+            break;
+        case 'm':
+            min_depth_mode = true;
+            break;
+        default:
+            fprintf(stderr, USAGE, argv[0]);
+            return 2;
+        }
+    }
+
+    if (list) {
+        printf("Parameters (defaults):\n");
+        print_params(true);
+        printf("\nCard profiles (-c):\n");
+        print_cards();
+        return 0;
+    }
+
+    if (optind != argc - 1) {
+        fprintf(stderr, USAGE, argv[0]);
+        return 2;
+    }
+
+    if (load_content(argv[optind]) != 0) {
+        fprintf(stderr, "Cannot read %s\n", argv[optind]);
+        return 2;
+    }
+
+    if (PV(P_SD_SEQ_KBPS) <= 0 || PV(P_SPI_CLOCK_HZ) <= 0 || PV(P_CPU_MHZ) <= 0 || PV(P_AUDIO_RATE) <= 0) {
+        fprintf(stderr, "sd_seq_kbps, spi_clock_hz, cpu_mhz and audio_rate must be positive\n");
+        return 2;
+    }
+
+    printf("%s: %s %ux%u, %u frames at %u/%u fps\n", argv[optind], fourcc_str(g_content.compression),
+           g_content.width, g_content.height, g_content.frames, g_content.timebase.rate,
+           g_content.timebase.scale);
+
+    if (min_depth_mode) {
+        find_min_depths(card);
+        return 0;
+    }
+
+    derive_io_tuning();
+    if (PV(P_PREFETCH_DEPTH) > MAX_QUEUE_DEPTH) PV(P_PREFETCH_DEPTH) = MAX_QUEUE_DEPTH;
+
+    if (trace_path) {
+        g_trace = fopen(trace_path, "w");
+        if (g_trace == NULL) {
+            perror(trace_path);
+            return 2;
+        }
+        fprintf(g_trace, "shown_ms,frame,gap_ms,queued,audio_level\n");
+    }
+
+    printf("Parameters:\n");
+    print_params(false);
+
+    simulate();
+    print_report();
+    bool passed = sim_passed();
+    sim_cleanup();
+
+    if (g_trace) fclose(g_trace);
+
+    if (assert_mode) {
+        if (!passed) {
+            printf("\nFAIL at prefetch depth %d: %u underruns after the first frame, %u read errors, "
+                   "%u open failures\n", (int)PV(P_PREFETCH_DEPTH), g_stats.late_underruns,
+                   g_stats.read_errors, g_stats.open_failures);
+            return 1;
+        }
+        printf("\nPASS: no underruns after the first frame at prefetch depth %d\n", (int)PV(P_PREFETCH_DEPTH));
+    }
+    return 0;
+}
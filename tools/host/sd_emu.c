@@ -0,0 +1,257 @@
+/**
+ * Slow and flaky SD card emulator
+ */
+
+#define _GNU_SOURCE
+#include "sd_emu.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/types.h>
+
+#define XFER_4K         4096
+#define Z_P99           2.326   // Standard normal 99th percentile
+
+struct sd_emu {
+    sd_emu_card_t card;
+    uint64_t rng;
+    double mu;                  // Command latency lognormal
+    double sigma;
+    double cursor;              // Virtual time the next request starts
+    double charged;             // Card time since sd_emu_begin
+    sd_emu_stats_t stats;
+};
+
+typedef struct {
+    sd_emu_t *emu;
+    FILE *file;
+} cookie_t;
+
+// Representative cards; measured ones come from the sd_profile log line
+static const sd_emu_card_t g_cards[] = {
+    {"fast",  "A1 UHS-I, 4-bit SDMMC",                20000,  450,  2000,    0,   0,    0,   0,   0},
+    {"good",  "Class 10, 4-bit SDMMC",                 9000, 1100,  9000,    0,   0,    0,   0,   0},
+    {"slow",  "Class 4 on 1-bit SPI",                  2200, 2600, 24000,    0,   0,    0,   0,   0},
+    {"old",   "Worn 2 GB card, 100+ ms reads",         1500, 4000, 40000, 5000, 150,    0,   0,   0},
+    {"gc",    "Busy 80 ms every 2 s (wear leveling)",  9000, 1100,  9000,    0,   0, 2000,  80,   0},
+    {"flaky", "Marginal contacts, read errors",        9000, 1100,  9000,    0,   0,    0,   0, 2000},
+};
+
+static sd_emu_t *g_attached;
+
+FILE *__real_fopen(const char *path, const char *mode);
+
+/** xorshift64* */
+static double rand_uniform(sd_emu_t *emu)
+{
+    emu->rng ^= emu->rng >> 12;
+    emu->rng ^= emu->rng << 25;
+    emu->rng ^= emu->rng >> 27;
+    return ((emu->rng * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/** Standard normal (Box-Muller) */
+static double rand_normal(sd_emu_t *emu)
+{
+    double u = rand_uniform(emu);
+    double v = rand_uniform(emu);
+    return sqrt(-2.0 * log(u + 1e-300)) * cos(2.0 * M_PI * v);
+}
+
+/** Transfer time at the throughput cap */
+static double xfer_us(const sd_emu_t *emu, double bytes)
+{
+    return bytes * 1000000.0 / 1024.0 / emu->card.seq_kbps;
+}
+
+/**
+ * Charge one request
+ *
+ * @return false if it fails
+ */
+static bool charge_request(sd_emu_t *emu, size_t bytes)
+{
+    const sd_emu_card_t *c = &emu->card;
+    double start = emu->cursor;
+
+    if (c->stall_period_ms && c->stall_ms) {
+        double period = c->stall_period_ms * 1000.0;
+        double phase = fmod(emu->cursor, period);
+        if (phase < c->stall_ms * 1000.0) {
+            emu->cursor += c->stall_ms * 1000.0 - phase;
+            emu->stats.stall_waits++;
+        }
+    }
+
+    emu->cursor += exp(emu->mu + emu->sigma * rand_normal(emu)) + xfer_us(emu, bytes);
+    if (c->slow_ppm && rand_uniform(emu) * 1000000.0 < c->slow_ppm) {
+        emu->cursor += c->slow_ms * 1000.0;
+        emu->stats.slow_reads++;
+    }
+
+    double us = emu->cursor - start;
+    emu->charged += us;
+    emu->stats.requests++;
+    emu->stats.bytes += bytes;
+    if (us > emu->stats.max_request_us) emu->stats.max_request_us = us;
+
+    if (c->error_ppm && rand_uniform(emu) * 1000000.0 < c->error_ppm) {
+        emu->stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+/** Cookie read: one card request */
+static ssize_t cookie_read(void *cookie, char *buf, size_t size)
+{
+    cookie_t *ck = cookie;
+    size_t n = fread(buf, 1, size, ck->file);
+
+    if (n == 0) return ferror(ck->file) ? -1 : 0;
+    if (!charge_request(ck->emu, n)) {
+        errno = EIO;
+        return -1;
+    }
+    return (ssize_t)n;
+}
+
+/** Cookie seek: position only, the next read pays the command latency */
+static int cookie_seek(void *cookie, off64_t *offset, int whence)
+{
+    cookie_t *ck = cookie;
+    if (fseeko(ck->file, *offset, whence) != 0) return -1;
+    *offset = ftello(ck->file);
+    return 0;
+}
+
+/** Cookie close */
+static int cookie_close(void *cookie)
+{
+    cookie_t *ck = cookie;
+    int ret = fclose(ck->file);
+    free(ck);
+    return ret;
+}
+
+/**
+ * Get built-in profiles
+ */
+const sd_emu_card_t *sd_emu_cards(int *count)
+{
+    *count = (int)(sizeof(g_cards) / sizeof(g_cards[0]));
+    return g_cards;
+}
+
+/**
+ * Find a built-in profile
+ */
+const sd_emu_card_t *sd_emu_find_card(const char *name)
+{
+    for (size_t i = 0; i < sizeof(g_cards) / sizeof(g_cards[0]); i++) {
+        if (strcmp(g_cards[i].name, name) == 0) return &g_cards[i];
+    }
+    return NULL;
+}
+
+/**
+ * Create emulator
+ */
+sd_emu_t *sd_emu_create(const sd_emu_card_t *card, uint64_t seed)
+{
+    sd_emu_t *emu = calloc(1, sizeof(*emu));
+    if (emu == NULL) return NULL;
+
+    emu->card = *card;
+    if (emu->card.seq_kbps == 0) emu->card.seq_kbps = 1;
+    emu->rng = seed * 0x9E3779B97F4A7C15ull + 1;
+
+    // The profile's 4 KB latencies include the transfer; the rest is per command
+    double p50 = fmax(card->p50_us - xfer_us(emu, XFER_4K), 1.0);
+    double p99 = fmax(card->p99_us - xfer_us(emu, XFER_4K), p50);
+    emu->mu = log(p50);
+    emu->sigma = log(p99 / p50) / Z_P99;
+    return emu;
+}
+
+void sd_emu_destroy(sd_emu_t *emu)
+{
+    if (g_attached == emu) g_attached = NULL;
+    free(emu);
+}
+
+/**
+ * Attach emulator
+ */
+void sd_emu_attach(sd_emu_t *emu)
+{
+    g_attached = emu;
+}
+
+/**
+ * Open through the card
+ */
+FILE *sd_emu_fopen(sd_emu_t *emu, const char *path)
+{
+    cookie_t *ck = calloc(1, sizeof(*ck));
+    if (ck == NULL) return NULL;
+
+    ck->emu = emu;
+    ck->file = __real_fopen(path, "rb");
+    if (ck->file == NULL) {
+        free(ck);
+        return NULL;
+    }
+    // The card stream buffers; the host one underneath must not merge requests
+    setvbuf(ck->file, NULL, _IONBF, 0);
+
+    cookie_io_functions_t io = {
+        .read = cookie_read,
+        .write = NULL,
+        .seek = cookie_seek,
+        .close = cookie_close,
+    };
+    FILE *f = fopencookie(ck, "rb", io);
+    if (f == NULL) {
+        fclose(ck->file);
+        free(ck);
+    }
+    return f;
+}
+
+/**
+ * Begin charging
+ */
+void sd_emu_begin(sd_emu_t *emu, double now_us)
+{
+    emu->cursor = now_us;
+    emu->charged = 0;
+}
+
+/**
+ * End charging
+ */
+double sd_emu_end(sd_emu_t *emu)
+{
+    double us = emu->charged;
+    emu->charged = 0;
+    return us;
+}
+
+void sd_emu_get_stats(const sd_emu_t *emu, sd_emu_stats_t *stats)
+{
+    *stats = emu->stats;
+}
+
+/**
+ * fopen under -Wl,--wrap=fopen: reads through the attached card
+ */
+FILE *__wrap_fopen(const char *path, const char *mode)
+{
+    if (g_attached && strchr(mode, 'r') && !strchr(mode, '+') && !strchr(mode, 'w')) {
+        return sd_emu_fopen(g_attached, path);
+    }
+    return __real_fopen(path, mode);
+}
@@ -0,0 +1,114 @@
+/**
+ * Slow and flaky SD card emulator for the host tools
+ *
+ * Opens files through fopencookie so every read the stdio buffer makes
+ * underneath is one card request. Each request is charged, on a virtual
+ * clock:
+ *  - a command latency drawn from a lognormal through the card's p50 and
+ *    p99, with rare extra-slow reads on top (the 100+ ms reads old cards
+ *    take now and then)
+ *  - its bytes at the card's throughput cap
+ *  - any wait for a periodic stall (internal garbage collection) that is in
+ *    progress when it arrives
+ *
+ * A request can also fail with EIO at a configured rate. The data itself
+ * comes from the real file, so the component code reads what it would from
+ * the card.
+ *
+ * Link with -Wl,--wrap=fopen and attach an emulator: read-only fopen calls
+ * then open through the card, and writes go to the host file system.
+ */
+
+#ifndef SD_EMU_H
+#define SD_EMU_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct sd_emu sd_emu_t;
+
+/**
+ * Card profile
+ */
+typedef struct {
+    const char *name;
+    const char *description;
+    uint32_t seq_kbps;          // Throughput cap, KB/s
+    uint32_t p50_us;            // Random 4 KB read median (as sd_profile measures it)
+    uint32_t p99_us;            // Random 4 KB read 99th percentile
+    uint32_t slow_ppm;          // Reads per million that take slow_ms extra
+    uint32_t slow_ms;
+    uint32_t stall_period_ms;   // Card busy for stall_ms every period, 0 = never
+    uint32_t stall_ms;
+    uint32_t error_ppm;         // Reads per million failing with EIO
+} sd_emu_card_t;
+
+/**
+ * Card counters
+ */
+typedef struct {
+    uint32_t requests;
+    uint64_t bytes;
+    uint32_t slow_reads;
+    uint32_t stall_waits;       // Requests that arrived during a stall
+    uint32_t errors;
+    double max_request_us;
+} sd_emu_stats_t;
+
+/**
+ * Get built-in profiles
+ *
+ * @param count Output number of profiles
+ * @return Profile table
+ */
+const sd_emu_card_t *sd_emu_cards(int *count);
+
+/**
+ * Find a built-in profile
+ *
+ * @return Profile, NULL if no such name
+ */
+const sd_emu_card_t *sd_emu_find_card(const char *name);
+
+/**
+ * Create emulator
+ *
+ * @param card Profile (copied)
+ * @param seed Random seed; same seed and request sequence, same timing
+ * @return Emulator, NULL if out of memory
+ */
+sd_emu_t *sd_emu_create(const sd_emu_card_t *card, uint64_t seed);
+
+void sd_emu_destroy(sd_emu_t *emu);
+
+/**
+ * Route read-only fopen calls through an emulator
+ *
+ * @param emu Emulator, NULL to pass every fopen to the host
+ */
+void sd_emu_attach(sd_emu_t *emu);
+
+/**
+ * Open a file through the card
+ *
+ * @return Stream, NULL on failure (errno set)
+ */
+FILE *sd_emu_fopen(sd_emu_t *emu, const char *path);
+
+/**
+ * Start charging reads at a virtual time (when the card is free to serve them)
+ *
+ * @param now_us Virtual time in microseconds
+ */
+void sd_emu_begin(sd_emu_t *emu, double now_us);
+
+/**
+ * Stop charging reads
+ *
+ * @return Card time of the reads since sd_emu_begin, microseconds
+ */
+double sd_emu_end(sd_emu_t *emu);
+
+void sd_emu_get_stats(const sd_emu_t *emu, sd_emu_stats_t *stats);
+
+#endif // SD_EMU_H
@@ -0,0 +1,15 @@
+/**
+ * Host shim for dlog.h
+ * Deferred logging is a target ring buffer; on the host DLOGx is ESP_LOGx
+ */
+
+#ifndef HOST_SHIM_DLOG_H
+#define HOST_SHIM_DLOG_H
+
+#include "esp_log.h"
+
+#define DLOGW(tag, fmt, ...) ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) ESP_LOGD(tag, fmt, ##__VA_ARGS__)
+
+#endif // HOST_SHIM_DLOG_H
@@ -0,0 +1,12 @@
+/**
+ * Host shim for esp_attr.h
+ * Placement attributes expand to nothing
+ */
+
+#ifndef HOST_SHIM_ESP_ATTR_H
+#define HOST_SHIM_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#endif // HOST_SHIM_ESP_ATTR_H
@@ -0,0 +1,22 @@
+/**
+ * Host shim for freertos/FreeRTOS.h
+ * Types and tick macros only; one tick per millisecond. Interrupt callbacks
+ * run on the calling thread, so yielding from them is a no-op.
+ */
+
+#ifndef HOST_SHIM_FREERTOS_H
+#define HOST_SHIM_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define pdTRUE              1
+#define pdFALSE             0
+
+#define portYIELD_FROM_ISR()
+
+#endif // HOST_SHIM_FREERTOS_H
@@ -0,0 +1,13 @@
+/**
+ * Host shim for freertos/task.h
+ * Delays do not sleep; emu_driver.c adds them to the emulated time
+ */
+
+#ifndef HOST_SHIM_TASK_H
+#define HOST_SHIM_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+void vTaskDelay(TickType_t ticks);
+
+#endif // HOST_SHIM_TASK_H
@@ -0,0 +1,9 @@
+/**
+ * Host shim for sdkconfig.h
+ * Nothing is set: every CONFIG_ option reads as n (original display pins)
+ */
+
+#ifndef HOST_SHIM_SDKCONFIG_H
+#define HOST_SHIM_SDKCONFIG_H
+
+#endif // HOST_SHIM_SDKCONFIG_H
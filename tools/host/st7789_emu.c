@@ -0,0 +1,702 @@
+/**
+ * ST7789 protocol emulator
+ *
+ * Frame memory holds 18-bit pixels (R6 G6 B6) as on the controller: 16-bit
+ * writes copy the top bit of red and blue into their sixth bit, 12-bit
+ * writes the top two bits of each channel. Parameters are applied when the
+ * last one arrives; a command arriving before that is a protocol error.
+ * Reads follow the serial interface: RDDID sends one dummy bit before its
+ * 24 bits, RAMRD a dummy byte before three bytes per pixel (six bits per
+ * channel, left aligned).
+ */
+
+#include "st7789_emu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "st7789.h"
+
+#define PIXEL_MASK      0x3FFFF
+
+// COLMOD control interface format (low nibble)
+#define COLMOD_12BIT    0x03
+#define COLMOD_16BIT    0x05
+#define COLMOD_18BIT    0x06
+
+struct st7789_emu {
+    st7789_emu_config_t config;
+    uint32_t clock_hz;          // Actual bus clock
+    bool sdo_wired;
+    uint32_t max_write_hz;      // 0 = writes never corrupt
+    uint32_t fault_count;
+    uint32_t *gram;             // R6 << 12 | G6 << 6 | B6
+    uint8_t backlight;
+
+    // Registers
+    uint8_t madctl;
+    uint8_t colmod;
+    bool sleeping;
+    bool display_on;
+    bool inverted;
+    bool partial;
+    uint16_t xs, xe, ys, ye;    // Address window (logical)
+    uint16_t ptl_start, ptl_end;
+    uint16_t tfa, vsa, bfa;     // Scroll areas: top fixed, scrolling, bottom fixed
+    uint16_t vsp;               // Scroll start address
+
+    // Command in progress
+    int cmd;                    // -1 before the first command
+    uint8_t params[8];
+    int nparams;
+    bool writing;               // RAMWR/RAMWRC data stream
+    bool write_error;           // Out-of-window error already reported for this stream
+    uint16_t col, row;          // Write pointer (logical)
+    uint8_t pend[3];            // Bytes of an incomplete pixel (or pixel pair in 12-bit)
+    int npend;
+    int reading;                // RDDID or RAMRD whose response is being clocked out, 0 if none
+    uint32_t read_pos;          // Response bits (RDDID) or bytes (RAMRD) sent
+    uint32_t read_px;           // RAMRD pixel being sent
+
+    st7789_emu_stats_t stats;
+};
+
+/**
+ * Log and count a protocol error
+ */
+static void protocol_error(st7789_emu_t *e, const char *what)
+{
+    e->stats.errors++;
+    fprintf(stderr, "st7789_emu: %s (command 0x%02X, transaction %u)\n", what,
+            e->cmd < 0 ? 0 : e->cmd, e->stats.transactions);
+}
+
+/**
+ * Registers to their reset values
+ */
+static void reset_registers(st7789_emu_t *e)
+{
+    e->madctl = 0;
+    e->colmod = 0x66;
+    e->sleeping = true;
+    e->display_on = false;
+    e->inverted = false;
+    e->partial = false;
+    e->xs = 0;
+    e->xe = ST7789_EMU_COLS - 1;
+    e->ys = 0;
+    e->ye = ST7789_EMU_ROWS - 1;
+    e->ptl_start = 0;
+    e->ptl_end = ST7789_EMU_ROWS - 1;
+    e->tfa = 0;
+    e->vsa = ST7789_EMU_ROWS;
+    e->bfa = 0;
+    e->vsp = 0;
+    e->cmd = -1;
+    e->nparams = 0;
+    e->writing = false;
+    e->npend = 0;
+}
+
+/**
+ * Create emulator
+ */
+st7789_emu_t *st7789_emu_create(const st7789_emu_config_t *config)
+{
+    st7789_emu_t *e = calloc(1, sizeof(st7789_emu_t));
+    if (e == NULL) return NULL;
+
+    e->gram = calloc(ST7789_EMU_COLS * ST7789_EMU_ROWS, sizeof(uint32_t));
+    if (e->gram == NULL) {
+        free(e);
+        return NULL;
+    }
+
+    e->config = *config;
+    e->backlight = 255;
+    e->sdo_wired = true;
+    st7789_emu_set_clock(e, config->spi_clock_hz);
+    reset_registers(e);
+    return e;
+}
+
+/**
+ * Destroy emulator
+ */
+void st7789_emu_destroy(st7789_emu_t *emu)
+{
+    if (emu == NULL) return;
+    free(emu->gram);
+    free(emu);
+}
+
+/**
+ * Hardware reset
+ */
+void st7789_emu_reset(st7789_emu_t *emu)
+{
+    reset_registers(emu);
+}
+
+/**
+ * Set SPI clock
+ * spi_master picks the divisor of the APB clock closest to the request,
+ * above or below it; past 3/4 of APB it runs at APB
+ */
+uint32_t st7789_emu_set_clock(st7789_emu_t *emu, uint32_t hz)
+{
+    if (hz == 0 || hz >= ST7789_EMU_APB_HZ / 4 * 3) {
+        emu->clock_hz = ST7789_EMU_APB_HZ;
+    } else {
+        uint32_t div = (ST7789_EMU_APB_HZ + hz / 2) / hz;
+        if (div < 2) div = 2;
+        emu->clock_hz = ST7789_EMU_APB_HZ / div;
+    }
+    return emu->clock_hz;
+}
+
+/**
+ * Get SPI clock
+ */
+uint32_t st7789_emu_get_clock(const st7789_emu_t *emu)
+{
+    return emu->clock_hz;
+}
+
+/**
+ * Set link model
+ */
+void st7789_emu_set_link(st7789_emu_t *emu, bool sdo_wired, uint32_t max_write_hz)
+{
+    emu->sdo_wired = sdo_wired;
+    emu->max_write_hz = max_write_hz;
+    emu->fault_count = 0;
+}
+
+/**
+ * Set backlight duty
+ */
+void st7789_emu_set_backlight(st7789_emu_t *emu, uint8_t duty)
+{
+    emu->backlight = duty;
+}
+
+/**
+ * Get counters
+ */
+void st7789_emu_get_stats(const st7789_emu_t *emu, st7789_emu_stats_t *stats)
+{
+    *stats = emu->stats;
+}
+
+/**
+ * Clear counters
+ */
+void st7789_emu_reset_stats(st7789_emu_t *emu)
+{
+    memset(&emu->stats, 0, sizeof(emu->stats));
+}
+
+/**
+ * Logical (column, row) to frame memory index through MADCTL, -1 if outside
+ * MX and MY mirror the logical axes, MV then exchanges them
+ */
+static int map_address(const st7789_emu_t *e, uint16_t col, uint16_t row)
+{
+    bool mv = e->madctl & ST7789_MADCTL_MV;
+    uint16_t cols = mv ? ST7789_EMU_ROWS : ST7789_EMU_COLS;
+    uint16_t rows = mv ? ST7789_EMU_COLS : ST7789_EMU_ROWS;
+
+    if (col >= cols || row >= rows) return -1;
+    if (e->madctl & ST7789_MADCTL_MX) col = cols - 1 - col;
+    if (e->madctl & ST7789_MADCTL_MY) row = rows - 1 - row;
+
+    return mv ? col * ST7789_EMU_COLS + row : row * ST7789_EMU_COLS + col;
+}
+
+/**
+ * Store one pixel at the write pointer and advance it
+ */
+static void store_pixel(st7789_emu_t *e, uint8_t r6, uint8_t g6, uint8_t b6)
+{
+    if (e->madctl & ST7789_MADCTL_BGR) {
+        uint8_t t = r6;
+        r6 = b6;
+        b6 = t;
+    }
+
+    int idx = map_address(e, e->col, e->row);
+    if (idx >= 0) {
+        e->gram[idx] = ((uint32_t)r6 << 12) | ((uint32_t)g6 << 6) | b6;
+        e->stats.pixels++;
+    } else if (!e->write_error) {
+        protocol_error(e, "pixel outside frame memory");
+        e->write_error = true;
+    }
+
+    // Column first, then row; past the window end the pointer wraps to its start
+    if (++e->col > e->xe) {
+        e->col = e->xs;
+        if (++e->row > e->ye) e->row = e->ys;
+    }
+}
+
+/**
+ * Feed one byte of the RAMWR stream
+ */
+static void write_byte(st7789_emu_t *e, uint8_t byte)
+{
+    if (e->max_write_hz && e->clock_hz > e->max_write_hz && ++e->fault_count % 64 == 0) {
+        byte ^= 0x01;
+    }
+
+    e->pend[e->npend++] = byte;
+
+    switch (e->colmod & 0x07) {
+        case COLMOD_16BIT:
+            if (e->npend == 2) {
+                uint16_t v = (e->pend[0] << 8) | e->pend[1];
+                uint8_t r = v >> 11, g = (v >> 5) & 0x3F, b = v & 0x1F;
+                store_pixel(e, (r << 1) | (r >> 4), g, (b << 1) | (b >> 4));
+                e->npend = 0;
+            }
+            break;
+
+        case COLMOD_12BIT:
+            // R0G0 B0R1 G1B1
+            if (e->npend == 3) {
+                uint8_t c[6] = {
+                    e->pend[0] >> 4, e->pend[0] & 15, e->pend[1] >> 4,
+                    e->pend[1] & 15, e->pend[2] >> 4, e->pend[2] & 15,
+                };
+                for (int i = 0; i < 6; i++) c[i] = (c[i] << 2) | (c[i] >> 2);
+                store_pixel(e, c[0], c[1], c[2]);
+                store_pixel(e, c[3], c[4], c[5]);
+                e->npend = 0;
+            }
+            break;
+
+        case COLMOD_18BIT:
+            if (e->npend == 3) {
+                store_pixel(e, e->pend[0] >> 2, e->pend[1] >> 2, e->pend[2] >> 2);
+                e->npend = 0;
+            }
+            break;
+
+        default:
+            if (!e->write_error) {
+                protocol_error(e, "memory write with unsupported COLMOD");
+                e->write_error = true;
+            }
+            e->npend = 0;
+            break;
+    }
+}
+
+/**
+ * Parameters each command takes (0 = none or ignored)
+ */
+static int param_count(int cmd)
+{
+    switch (cmd) {
+        case ST7789_CASET:
+        case ST7789_RASET:
+        case ST7789_PTLAR:
+            return 4;
+        case ST7789_VSCRDEF:
+            return 6;
+        case ST7789_VSCSAD:
+            return 2;
+        case ST7789_MADCTL:
+        case ST7789_COLMOD:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Apply a command once all its parameters are in
+ */
+static void apply_params(st7789_emu_t *e)
+{
+    const uint8_t *p = e->params;
+    uint16_t a = (p[0] << 8) | p[1];
+    uint16_t b = (p[2] << 8) | p[3];
+
+    switch (e->cmd) {
+        case ST7789_CASET:
+            e->xs = a;
+            e->xe = b;
+            break;
+        case ST7789_RASET:
+            e->ys = a;
+            e->ye = b;
+            break;
+        case ST7789_PTLAR:
+            e->ptl_start = a;
+            e->ptl_end = b;
+            break;
+        case ST7789_VSCRDEF:
+            e->tfa = a;
+            e->vsa = b;
+            e->bfa = (p[4] << 8) | p[5];
+            if (e->tfa + e->vsa + e->bfa != ST7789_EMU_ROWS) {
+                protocol_error(e, "scroll areas do not add up to 320 lines");
+            }
+            break;
+        case ST7789_VSCSAD:
+            e->vsp = a;
+            break;
+        case ST7789_MADCTL:
+            e->madctl = p[0];
+            break;
+        case ST7789_COLMOD:
+            e->colmod = p[0];
+            break;
+    }
+}
+
+/**
+ * Start a command (DC low byte)
+ */
+static void begin_command(st7789_emu_t *e, uint8_t cmd)
+{
+    int needed = param_count(e->cmd);
+    if (needed && e->nparams < needed) protocol_error(e, "command cut short");
+    if (e->writing && e->npend) protocol_error(e, "memory write ended mid-pixel");
+
+    e->cmd = cmd;
+    e->nparams = 0;
+    e->writing = false;
+    e->npend = 0;
+    e->reading = 0;
+    e->read_pos = 0;
+    e->stats.commands++;
+
+    switch (cmd) {
+        case ST7789_SWRESET:
+            reset_registers(e);
+            e->cmd = cmd;
+            break;
+        case ST7789_SLPIN:   e->sleeping = true;    break;
+        case ST7789_SLPOUT:  e->sleeping = false;   break;
+        case ST7789_PTLON:   e->partial = true;     break;
+        case ST7789_NORON:   e->partial = false;    break;
+        case ST7789_INVOFF:  e->inverted = false;   break;
+        case ST7789_INVON:   e->inverted = true;    break;
+        case ST7789_DISPOFF: e->display_on = false; break;
+        case ST7789_DISPON:  e->display_on = true;  break;
+
+        case ST7789_RDDID:
+            e->reading = cmd;
+            break;
+
+        case ST7789_RAMRD:
+            if (e->xs > e->xe || e->ys > e->ye) protocol_error(e, "empty address window");
+            e->col = e->xs;
+            e->row = e->ys;
+            e->reading = cmd;
+            break;
+
+        case ST7789_RAMWR:
+            e->col = e->xs;
+            e->row = e->ys;
+            // Fall through
+        case ST7789_RAMWRC:
+            if (e->xs > e->xe || e->ys > e->ye) protocol_error(e, "empty address window");
+            e->writing = true;
+            e->write_error = false;
+            break;
+    }
+}
+
+/**
+ * Consume one SPI transaction
+ */
+void st7789_emu_transfer(st7789_emu_t *e, int dc, const uint8_t *data, uint32_t bits)
+{
+    uint32_t bytes = bits / 8;
+
+    e->stats.transactions++;
+    e->stats.wire_ns += ((uint64_t)bits * 1000000000ull + e->clock_hz / 2) / e->clock_hz;
+    e->stats.overhead_ns += e->config.trans_overhead_ns;
+    if (bits % 8) protocol_error(e, "transaction length not a whole number of bytes");
+
+    if (!dc) {
+        for (uint32_t i = 0; i < bytes; i++) begin_command(e, data[i]);
+        return;
+    }
+
+    e->stats.data_bytes += bytes;
+    if (e->cmd < 0) {
+        protocol_error(e, "data before any command");
+        return;
+    }
+
+    if (e->writing) {
+        for (uint32_t i = 0; i < bytes; i++) write_byte(e, data[i]);
+        return;
+    }
+
+    int needed = param_count(e->cmd);
+    for (uint32_t i = 0; i < bytes; i++) {
+        if (e->nparams < (int)sizeof(e->params)) e->params[e->nparams] = data[i];
+        e->nparams++;
+        if (e->nparams == needed) apply_params(e);
+    }
+    if (needed && e->nparams > needed) protocol_error(e, "too many parameters");
+}
+
+/**
+ * Next RAMRD response byte: dummy, then R, G, B per pixel
+ * The read pointer advances and wraps like the write pointer
+ */
+static uint8_t ramrd_byte(st7789_emu_t *e)
+{
+    uint32_t pos = e->read_pos++;
+    if (pos == 0) return 0;
+
+    int chan = (pos - 1) % 3;
+    if (chan == 0) {
+        int idx = map_address(e, e->col, e->row);
+        if (idx < 0) protocol_error(e, "read outside frame memory");
+        e->read_px = idx < 0 ? 0 : e->gram[idx];
+        if (e->madctl & ST7789_MADCTL_BGR) {
+            e->read_px = ((e->read_px & 0x3F) << 12) | (e->read_px & 0xFC0) | (e->read_px >> 12);
+        }
+
+        if (++e->col > e->xe) {
+            e->col = e->xs;
+            if (++e->row > e->ye) e->row = e->ys;
+        }
+    }
+
+    return ((e->read_px >> (12 - 6 * chan)) & 0x3F) << 2;
+}
+
+/**
+ * Clock in a read response
+ */
+void st7789_emu_read(st7789_emu_t *e, uint8_t *data, uint32_t bits)
+{
+    uint32_t bytes = (bits + 7) / 8;
+
+    e->stats.transactions++;
+    e->stats.wire_ns += ((uint64_t)bits * 1000000000ull + e->clock_hz / 2) / e->clock_hz;
+    e->stats.overhead_ns += e->config.trans_overhead_ns;
+
+    if (!e->sdo_wired) {
+        memset(data, 0xFF, bytes);
+        return;
+    }
+    memset(data, 0, bytes);
+
+    switch (e->reading) {
+        case ST7789_RDDID:
+            // One dummy bit, then the ID MSB first
+            for (uint32_t i = 0; i < bits; i++) {
+                uint32_t k = e->read_pos++;
+                if (k >= 1 && k <= 24 && ((ST7789_EMU_ID >> (24 - k)) & 1)) {
+                    data[i / 8] |= 0x80 >> (i % 8);
+                }
+            }
+            break;
+
+        case ST7789_RAMRD:
+            if (bits % 8) protocol_error(e, "transaction length not a whole number of bytes");
+            for (uint32_t i = 0; i < bytes; i++) data[i] = ramrd_byte(e);
+            break;
+
+        default:
+            protocol_error(e, "read with no read command");
+            break;
+    }
+}
+
+/**
+ * Read pixel as RGB565
+ */
+uint16_t st7789_emu_read565(const st7789_emu_t *emu, uint16_t x, uint16_t y)
+{
+    int idx = map_address(emu, x, y);
+    if (idx < 0) return 0;
+
+    uint32_t v = emu->gram[idx];
+    uint8_t r6 = v >> 12, g6 = (v >> 6) & 0x3F, b6 = v & 0x3F;
+    if (emu->madctl & ST7789_MADCTL_BGR) {
+        uint8_t t = r6;
+        r6 = b6;
+        b6 = t;
+    }
+    return ((r6 >> 1) << 11) | (g6 << 5) | (b6 >> 1);
+}
+
+/**
+ * Frame memory row shown on a gate line, -1 for a blank line
+ */
+static int shown_row(const st7789_emu_t *e, int line)
+{
+    if (e->partial) {
+        bool inside = (e->ptl_start <= e->ptl_end)
+                      ? (line >= e->ptl_start && line <= e->ptl_end)
+                      : (line >= e->ptl_start || line <= e->ptl_end);
+        if (!inside) return -1;
+    }
+
+    if (e->vsa && line >= e->tfa && line < e->tfa + e->vsa) {
+        return e->tfa + (line - e->tfa + e->vsp - e->tfa + e->vsa) % e->vsa;
+    }
+    return line;
+}
+
+/**
+ * Render panel image
+ */
+void st7789_emu_render(const st7789_emu_t *e, uint8_t *rgb)
+{
+    bool blank = e->sleeping || !e->display_on;
+    uint32_t invert = (e->inverted != e->config.ips_inverted) ? PIXEL_MASK : 0;
+
+    for (int line = 0; line < ST7789_EMU_ROWS; line++) {
+        int row = blank ? -1 : shown_row(e, line);
+
+        for (int x = 0; x < ST7789_EMU_COLS; x++) {
+            uint8_t *d = rgb + ((size_t)line * ST7789_EMU_COLS + x) * 3;
+            if (row < 0) {
+                d[0] = d[1] = d[2] = 0;
+                continue;
+            }
+
+            uint32_t v = e->gram[row * ST7789_EMU_COLS + x] ^ invert;
+            for (int c = 0; c < 3; c++) {
+                uint8_t c6 = (v >> (12 - 6 * c)) & 0x3F;
+                d[c] = ((c6 << 2) | (c6 >> 4)) * e->backlight / 255;
+            }
+        }
+    }
+}
+
+/**
+ * Render into a new buffer
+ */
+static uint8_t *render_alloc(const st7789_emu_t *emu)
+{
+    uint8_t *rgb = malloc(ST7789_EMU_COLS * ST7789_EMU_ROWS * 3);
+    if (rgb != NULL) st7789_emu_render(emu, rgb);
+    return rgb;
+}
+
+/**
+ * Write PPM
+ */
+int st7789_emu_write_ppm(const st7789_emu_t *emu, const char *path)
+{
+    uint8_t *rgb = render_alloc(emu);
+    FILE *f = fopen(path, "wb");
+    if (rgb == NULL || f == NULL) {
+        free(rgb);
+        if (f) fclose(f);
+        return -1;
+    }
+
+    fprintf(f, "P6\n%d %d\n255\n", ST7789_EMU_COLS, ST7789_EMU_ROWS);
+    fwrite(rgb, 3, ST7789_EMU_COLS * ST7789_EMU_ROWS, f);
+    free(rgb);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t n)
+{
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len)
+{
+    uint8_t hdr[8];
+    put_be32(hdr, len);
+    memcpy(hdr + 4, type, 4);
+    uint32_t crc = crc32_update(crc32_update(0, hdr + 4, 4), data, len);
+
+    uint8_t trailer[4];
+    put_be32(trailer, crc);
+    fwrite(hdr, 1, 8, f);
+    if (len) fwrite(data, 1, len, f);  // IEND has no data
+    fwrite(trailer, 1, 4, f);
+}
+
+/**
+ * Write PNG (stored deflate blocks, no compression library needed)
+ */
+int st7789_emu_write_png(const st7789_emu_t *emu, const char *path)
+{
+    const uint32_t row_len = ST7789_EMU_COLS * 3 + 1;     // Filter byte + RGB
+    const uint32_t raw_len = row_len * ST7789_EMU_ROWS;
+    const uint32_t blocks = (raw_len + 65534) / 65535;
+    const uint32_t z_len = 2 + raw_len + blocks * 5 + 4;
+
+    uint8_t *rgb = render_alloc(emu);
+    uint8_t *raw = malloc(raw_len);
+    uint8_t *z = malloc(z_len);
+    FILE *f = fopen(path, "wb");
+    int ret = -1;
+    if (rgb == NULL || raw == NULL || z == NULL || f == NULL) goto done;
+
+    for (int y = 0; y < ST7789_EMU_ROWS; y++) {
+        raw[y * row_len] = 0;
+        memcpy(raw + y * row_len + 1, rgb + y * (row_len - 1), row_len - 1);
+    }
+
+    // zlib stream: header, stored blocks, Adler-32
+    uint8_t *p = z;
+    *p++ = 0x78;
+    *p++ = 0x01;
+    uint32_t s1 = 1, s2 = 0;
+    for (uint32_t off = 0; off < raw_len; off += 65535) {
+        uint32_t n = raw_len - off < 65535 ? raw_len - off : 65535;
+        *p++ = (off + n == raw_len);
+        *p++ = n & 0xFF;
+        *p++ = n >> 8;
+        *p++ = ~n & 0xFF;
+        *p++ = (~n >> 8) & 0xFF;
+        memcpy(p, raw + off, n);
+        p += n;
+        for (uint32_t i = 0; i < n; i++) {
+            s1 = (s1 + raw[off + i]) % 65521;
+            s2 = (s2 + s1) % 65521;
+        }
+    }
+    put_be32(p, (s2 << 16) | s1);
+
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t ihdr[13] = {0};
+    put_be32(ihdr, ST7789_EMU_COLS);
+    put_be32(ihdr + 4, ST7789_EMU_ROWS);
+    ihdr[8] = 8;        // Bit depth
+    ihdr[9] = 2;        // Truecolor
+
+    fwrite(sig, 1, 8, f);
+    png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    png_chunk(f, "IDAT", z, z_len);
+    png_chunk(f, "IEND", NULL, 0);
+    ret = 0;
+
+done:
+    free(rgb);
+    free(raw);
+    free(z);
+    if (f && fclose(f) != 0) ret = -1;
+    return ret;
+}
@@ -0,0 +1,143 @@
+/**
+ * ST7789 protocol emulator for the host tools
+ *
+ * Consumes the SPI transaction stream the display driver sends (DC level,
+ * bytes) into a virtual 240x320 frame memory with 18-bit pixels, following
+ * the controller's command set: CASET/RASET windows with pointer wrap,
+ * RAMWR/RAMWRC in 12, 16 and 18-bit COLMOD, MADCTL address mapping,
+ * partial mode, vertical scrolling, inversion, sleep and display off.
+ * RDDID and RAMRD answer on SDO when it is wired, with the dummy clocks
+ * the controller sends first.
+ *
+ * Each transaction is charged its bits at the SPI clock the bus would
+ * really run at (80 MHz APB / integer divisor) plus a fixed per-transaction
+ * overhead, so a change to the display path can be checked for both pixel
+ * correctness and bus time. Protocol misuse (data with no command, windows
+ * outside the frame memory, half pixels left when a command arrives) is
+ * counted and reported. A marginal link can be modelled: above a given
+ * clock, memory write data picks up bit errors.
+ */
+
+#ifndef ST7789_EMU_H
+#define ST7789_EMU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ST7789_EMU_COLS         240     // Frame memory columns (source lines)
+#define ST7789_EMU_ROWS         320     // Frame memory rows (gate lines)
+#define ST7789_EMU_APB_HZ       80000000
+#define ST7789_EMU_ID           0x858552    // RDDID: manufacturer, version, driver
+
+typedef struct st7789_emu st7789_emu_t;
+
+/**
+ * Emulator configuration
+ */
+typedef struct {
+    uint32_t spi_clock_hz;          // Requested clock (the driver's device config overrides)
+    uint32_t trans_overhead_ns;     // CS, command setup and driver cost per transaction
+    bool ips_inverted;              // Glass shows inverted colors unless INVON (Waveshare 2")
+} st7789_emu_config_t;
+
+/**
+ * Bus and protocol counters
+ */
+typedef struct {
+    uint32_t transactions;
+    uint32_t commands;
+    uint64_t data_bytes;            // Data phase bytes, parameters and pixels
+    uint64_t pixels;                // Pixels stored to frame memory
+    uint64_t wire_ns;               // Bits at the SPI clock
+    uint64_t overhead_ns;           // Per-transaction overhead
+    uint32_t errors;                // Protocol misuse, each also logged to stderr
+} st7789_emu_stats_t;
+
+/**
+ * Create emulator in its power-on state (sleeping, display off, memory black)
+ *
+ * @return Emulator, NULL if out of memory
+ */
+st7789_emu_t *st7789_emu_create(const st7789_emu_config_t *config);
+
+void st7789_emu_destroy(st7789_emu_t *emu);
+
+/**
+ * Hardware reset (RESX low): registers to defaults, memory kept
+ */
+void st7789_emu_reset(st7789_emu_t *emu);
+
+/**
+ * Set the requested SPI clock
+ *
+ * @return Clock the bus actually runs at
+ */
+uint32_t st7789_emu_set_clock(st7789_emu_t *emu, uint32_t hz);
+
+/**
+ * Get the clock the bus runs at
+ *
+ * @return Hz
+ */
+uint32_t st7789_emu_get_clock(const st7789_emu_t *emu);
+
+/**
+ * Consume one SPI transaction
+ *
+ * @param dc DC level during the transaction (0 = command, 1 = data)
+ * @param data Bytes in wire order
+ * @param bits Transaction length in bits
+ */
+void st7789_emu_transfer(st7789_emu_t *emu, int dc, const uint8_t *data, uint32_t bits);
+
+/**
+ * Clock in a read response on SDO after RDDID or RAMRD
+ * Reads 0xFF (pulled up, nothing driving) when SDO is not wired
+ *
+ * @param data Output, bits rounded up to bytes
+ * @param bits Transaction length in bits
+ */
+void st7789_emu_read(st7789_emu_t *emu, uint8_t *data, uint32_t bits);
+
+/**
+ * Model the wiring
+ *
+ * @param sdo_wired Panel SDO reaches the bus MISO
+ * @param max_write_hz Fastest clock memory writes survive; above it one
+ *                     data byte in 64 arrives with a flipped bit (0 = any)
+ */
+void st7789_emu_set_link(st7789_emu_t *emu, bool sdo_wired, uint32_t max_write_hz);
+
+/**
+ * Set backlight duty (0-255); scales the rendered image
+ */
+void st7789_emu_set_backlight(st7789_emu_t *emu, uint8_t duty);
+
+void st7789_emu_get_stats(const st7789_emu_t *emu, st7789_emu_stats_t *stats);
+void st7789_emu_reset_stats(st7789_emu_t *emu);
+
+/**
+ * Read a pixel at logical coordinates (through the current MADCTL), as RGB565
+ * of its 18-bit frame memory value
+ *
+ * @return Pixel, 0 outside the frame memory
+ */
+uint16_t st7789_emu_read565(const st7789_emu_t *emu, uint16_t x, uint16_t y);
+
+/**
+ * Render what the panel shows, in frame memory order (row 0 at the first
+ * gate line): scroll, partial area, inversion, sleep and backlight applied
+ *
+ * @param rgb Output, ST7789_EMU_COLS * ST7789_EMU_ROWS * 3 bytes
+ */
+void st7789_emu_render(const st7789_emu_t *emu, uint8_t *rgb);
+
+/**
+ * Write the rendered panel image
+ *
+ * @return 0 on success
+ */
+int st7789_emu_write_ppm(const st7789_emu_t *emu, const char *path);
+int st7789_emu_write_png(const st7789_emu_t *emu, const char *path);
+
+#endif // ST7789_EMU_H
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+PC Profile Resolver
+
+Reads the "PCPROF" lines logged by the PC sampling profiler
+(components/telemetry/pc_profiler.c, PROFILE_MODE in src/main.c or
+bench_hot_code) from a serial log, resolves each sampled code range to its
+function with addr2line against the build's ELF, and prints the time per
+function with the memory it ran from. Functions marked "flash" near the top
+are the candidates for (noflash) placement in a component's linker.lf.
+
+Usage: pcprof.py [-e ELF] [-t TARGET] [--all] [LOG]
+  LOG         idf.py monitor output (default: stdin)
+  -e ELF      firmware image (default: build/sony_watchman.elf)
+  -t TARGET   esp32 or esp32s3, selects xtensa-TARGET-elf-addr2line
+  --all       sum every report in the log instead of using the last one
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+HEADER = re.compile(r"PCPROF samples (\d+) fps ([\d.]+) iram (\d+) flash (\d+) "
+                    r"rom (\d+) other (\d+) dropped (\d+)")
+RANGE = re.compile(r"PCPROF 0x([0-9a-fA-F]{8})\s+(\d+)\s+[\d.]+%\s+(\w+)")
+REGIONS = ("iram", "flash", "rom", "other")
+
+
+def parse_reports(lines):
+    """Split the log into reports: (totals dict, [(pc, count, region)])"""
+    reports = []
+    for line in lines:
+        m = HEADER.search(line)
+        if m:
+            samples, fps, *regions, dropped = m.groups()
+            totals = {"samples": int(samples), "fps": float(fps), "dropped": int(dropped)}
+            totals.update(zip(REGIONS, map(int, regions)))
+            reports.append((totals, []))
+            continue
+        m = RANGE.search(line)
+        if m and reports:
+            reports[-1][1].append((int(m.group(1), 16), int(m.group(2)), m.group(3)))
+    return reports
+
+
+def merge(reports):
+    """Sum several reports into one (fps averaged over reports)"""
+    totals = {k: 0 for k in ("samples", "dropped") + REGIONS}
+    ranges = []
+    for t, r in reports:
+        for k in totals:
+            totals[k] += t[k]
+        ranges.extend(r)
+    totals["fps"] = sum(t["fps"] for t, _ in reports) / len(reports)
+    return totals, ranges
+
+
+def resolve(addr2line, elf, pcs):
+    """Map each PC to a function name with one addr2line call"""
+    if not pcs:
+        return {}
+    cmd = [addr2line, "-f", "-e", elf] + ["0x%08x" % pc for pc in pcs]
+    try:
+        out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit("pcprof: %s failed: %s" % (addr2line, e))
+    names = out.splitlines()[0::2]     # function, file:line per address
+    return dict(zip(pcs, names))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Resolve PCPROF profiler lines to functions")
+    parser.add_argument("log", nargs="?", help="monitor log (default: stdin)")
+    parser.add_argument("-e", "--elf", default="build/sony_watchman.elf")
+    parser.add_argument("-t", "--target", default="esp32", choices=("esp32", "esp32s3"))
+    parser.add_argument("--addr2line", help="addr2line binary (overrides --target)")
+    parser.add_argument("--all", action="store_true", help="sum every report in the log")
+    args = parser.parse_args()
+
+    with (open(args.log, errors="replace") if args.log else sys.stdin) as f:
+        reports = parse_reports(f)
+    if not reports:
+        sys.exit("pcprof: no PCPROF report in the log")
+
+    totals, ranges = merge(reports) if args.all else reports[-1]
+    addr2line = args.addr2line or "xtensa-%s-elf-addr2line" % args.target
+    names = resolve(addr2line, args.elf, sorted({pc for pc, _, _ in ranges}))
+
+    funcs = {}
+    for pc, count, region in ranges:
+        key = (names.get(pc, "??"), region)
+        funcs[key] = funcs.get(key, 0) + count
+
+    samples = totals["samples"]
+    print("%d samples, %.2f fps%s" % (samples, totals["fps"],
+                                       ", %d reports" % len(reports) if args.all else ""))
+    print("  " + "  ".join("%s %.1f%%" % (r, 100.0 * totals[r] / samples) for r in REGIONS))
+    if totals["dropped"]:
+        print("  %d samples not bucketed (table full)" % totals["dropped"])
+    print()
+    print("%7s %6s  %-6s %s" % ("samples", "time", "region", "function"))
+    for (name, region), count in sorted(funcs.items(), key=lambda kv: -kv[1]):
+        print("%7d %5.1f%%  %-6s %s" % (count, 100.0 * count / samples, region, name))
+
+
+if __name__ == "__main__":
+    main()